@@ -50,7 +50,19 @@ import (
 	"golang.org/x/net/idna"
 ) //end import
 
-const magicNumber = 0x9601042d
+const (
+	magicNumber   = 0x9601042d
+	magicNumberV2 = 0x9601042e
+) //end const
+
+const (
+	/*
+	 * v2 sections are aligned to a cache line, so that the loader can point
+	 * straight into a read-only mapping of the file.
+	 */
+	v2Align      = 64
+	v2HeaderSize = 128
+) //end const
 
 const (
 	/* These sum of these four values must be no greater than 32. */
@@ -84,6 +96,7 @@ const (
 const (
 	defaultURL    = "https://publicsuffix.org/list/effective_tld_names.dat"
 	defaultOutput = "public_suffix_compiled.dat"
+	defaultFormat = "v1"
 ) //end const
 
 var (
@@ -101,6 +114,7 @@ var (
 
 	url    = flag.String("url", defaultURL, "URL of the publicsuffix.org list. If empty, stdin is read instead")
 	output = flag.String("output", defaultOutput, "Output filename")
+	format = flag.String("format", defaultFormat, "Output format: v1 (big-endian, copied on load), v2 (host-endian, aligned for mmap) or c (C source for e_etn_new_builtin())")
 ) //end var
 
 func main() {
@@ -117,6 +131,13 @@ func max(a, b int) int {
 	return a
 } //end max
 
+func min(a, b int) int {
+	if a > b {
+		return b
+	} //end if
+	return a
+} //end min
+
 func u32max(a, b uint32) uint32 {
 	if a < b {
 		return b
@@ -229,7 +250,19 @@ func main1() error {
 	} //end for
 	sort.Strings(labelsList)
 
-	if err := generate(printReal, &root, *output); err != nil {
+	var p func(*bytes.Buffer, *node) error
+	switch *format {
+	case "v1":
+		p = printReal
+	case "v2":
+		p = printV2
+	case "c":
+		p = printC
+	default:
+		return fmt.Errorf("unknown output format %q", *format)
+	} //end switch
+
+	if err := generate(p, &root, *output); err != nil {
 		return err
 	} //end if
 
@@ -263,25 +296,14 @@ func generate(p func(*bytes.Buffer, *node) error, root *node, filename string) e
 func printReal(buf *bytes.Buffer, n *node) error {
 	var intBuf []uint32
 
-	intBuf = append(intBuf, uint32(magicNumber))
-	intBuf = append(intBuf, nodesBitsChildren)
-	intBuf = append(intBuf, nodesBitsICANN)
-	intBuf = append(intBuf, nodesBitsTextOffset)
-	intBuf = append(intBuf, nodesBitsTextLength)
-	intBuf = append(intBuf, childrenBitsWildcard)
-	intBuf = append(intBuf, childrenBitsNodeType)
-	intBuf = append(intBuf, childrenBitsHi)
-	intBuf = append(intBuf, childrenBitsLo)
-	intBuf = append(intBuf, nodeTypeNormal)
-	intBuf = append(intBuf, nodeTypeException)
-	intBuf = append(intBuf, nodeTypeParentOnly)
-	intBuf = append(intBuf, uint32(len(n.children)))
-
-	text := combineText(labelsList)
-	if text == "" {
-		return fmt.Errorf("internal error: makeText returned no text")
+	text, nodes, children, err := encodeTables(n)
+	if err != nil {
+		return err
 	} //end if
 
+	intBuf = append(intBuf, uint32(magicNumber))
+	intBuf = append(intBuf, headerWords(n)...)
+
 	/* text len */
 	intBuf = append(intBuf, uint32(len(text)))
 
@@ -290,57 +312,206 @@ func printReal(buf *bytes.Buffer, n *node) error {
 		return err
 	} //end if
 
+	/* Write text */
+	if err := binary.Write(buf, binary.BigEndian, []byte(text)); err != nil {
+		return err
+	} //end if
+
+	/* Write node */
+	if err := binary.Write(buf, binary.BigEndian, uint32(len(nodes))); err != nil {
+		return err
+	} //end if
+	if err := binary.Write(buf, binary.BigEndian, nodes); err != nil {
+		return err
+	} //end if
+
+	/* Write children */
+	if err := binary.Write(buf, binary.BigEndian, uint32(len(children))); err != nil {
+		return err
+	} //end if
+	if err := binary.Write(buf, binary.BigEndian, children); err != nil {
+		return err
+	} //end if
+
+	return nil
+} //end printReal
+
+/*
+ * printV2 writes the tables in host byte order. A fixed size header holds the
+ * bit widths and the offset and length of every section, and each section
+ * starts on a v2Align boundary. The text section is always followed by at
+ * least one NUL byte. There is no metadata section, its header words are zero.
+ */
+func printV2(buf *bytes.Buffer, n *node) error {
+	var intBuf []uint32
+
+	text, nodes, children, err := encodeTables(n)
+	if err != nil {
+		return err
+	} //end if
+
+	order := nativeEndian()
+	textOffset := align(v2HeaderSize)
+	nodesOffset := align(textOffset + len(text) + 1)
+	childrenOffset := align(nodesOffset + len(nodes)*4)
+
+	intBuf = append(intBuf, uint32(magicNumberV2))
+	intBuf = append(intBuf, v2HeaderSize)
+	intBuf = append(intBuf, headerWords(n)...)
+	intBuf = append(intBuf, uint32(textOffset), uint32(len(text)))
+	intBuf = append(intBuf, uint32(nodesOffset), uint32(len(nodes)))
+	intBuf = append(intBuf, uint32(childrenOffset), uint32(len(children)))
+
+	/* Write header, reserved words are zero */
+	if err := binary.Write(buf, order, intBuf); err != nil {
+		return err
+	} //end if
+	pad(buf, textOffset)
+
+	/* Write text */
+	buf.WriteString(text)
+	buf.WriteByte(0)
+	pad(buf, nodesOffset)
+
+	/* Write node */
+	if err := binary.Write(buf, order, nodes); err != nil {
+		return err
+	} //end if
+	pad(buf, childrenOffset)
+
+	/* Write children */
+	if err := binary.Write(buf, order, children); err != nil {
+		return err
+	} //end if
+	pad(buf, align(buf.Len()))
+
+	return nil
+} //end printV2
+
+/*
+ * printC writes the tables as C source, to be compiled into the library by
+ * configure --enable-builtin. The header words are those of the v1 format
+ * after the magic number.
+ */
+func printC(buf *bytes.Buffer, n *node) error {
+	text, nodes, children, err := encodeTables(n)
+	if err != nil {
+		return err
+	} //end if
+
+	fmt.Fprintf(buf, "/* Generated by ci/precompile.go -format c, do not edit. */\n\n")
+	fmt.Fprintf(buf, "#include <stdint.h>\n")
+	fmt.Fprintf(buf, "#include <libetn/e_visibility.h>\n\n")
+
+	fmt.Fprintf(buf, "E_LOCAL const uint32_t e_etn_builtin_header[] = {")
+	printCWords(buf, headerWords(n), "%d")
+	fmt.Fprintf(buf, "};\n\n")
+
+	fmt.Fprintf(buf, "E_LOCAL const uint32_t e_etn_builtin_text_length = %d;\n", len(text))
+	/* validSuffixRE leaves nothing in the labels that needs escaping */
+	fmt.Fprintf(buf, "E_LOCAL const char e_etn_builtin_text[] =")
+	for i := 0; i < len(text); i += 64 {
+		fmt.Fprintf(buf, "\n    \"%s\"", text[i:i+min(64, len(text)-i)])
+	} //end for
+	fmt.Fprintf(buf, ";\n\n")
+
+	fmt.Fprintf(buf, "E_LOCAL const uint32_t e_etn_builtin_nodes_length = %d;\n", len(nodes))
+	fmt.Fprintf(buf, "E_LOCAL const uint32_t e_etn_builtin_nodes[] = {")
+	printCWords(buf, nodes, "0x%08x")
+	fmt.Fprintf(buf, "};\n\n")
+
+	fmt.Fprintf(buf, "E_LOCAL const uint32_t e_etn_builtin_children_length = %d;\n", len(children))
+	fmt.Fprintf(buf, "E_LOCAL const uint32_t e_etn_builtin_children[] = {")
+	printCWords(buf, children, "0x%08x")
+	fmt.Fprintf(buf, "};\n")
+
+	return nil
+} //end printC
+
+func printCWords(buf *bytes.Buffer, words []uint32, verb string) {
+	for i, w := range words {
+		if i%8 == 0 {
+			buf.WriteString("\n   ")
+		} //end if
+		fmt.Fprintf(buf, " "+verb+",", w)
+	} //end for
+	buf.WriteString("\n")
+} //end printCWords
+
+func headerWords(n *node) []uint32 {
+	return []uint32{
+		nodesBitsChildren,
+		nodesBitsICANN,
+		nodesBitsTextOffset,
+		nodesBitsTextLength,
+		childrenBitsWildcard,
+		childrenBitsNodeType,
+		childrenBitsHi,
+		childrenBitsLo,
+		nodeTypeNormal,
+		nodeTypeException,
+		nodeTypeParentOnly,
+		uint32(len(n.children)),
+	} //end return
+} //end headerWords
+
+/* encodeTables returns the text, nodes and children tables of the tree. */
+func encodeTables(n *node) (string, []uint32, []uint32, error) {
+	text := combineText(labelsList)
+	if text == "" {
+		return "", nil, nil, fmt.Errorf("internal error: makeText returned no text")
+	} //end if
+
 	for _, label := range labelsList {
 		offset, length := strings.Index(text, label), len(label)
 		if offset < 0 {
-			return fmt.Errorf("internal error: could not find %q in text %q", label, text)
+			return "", nil, nil, fmt.Errorf("internal error: could not find %q in text %q", label, text)
 		} //end if
 		maxTextOffset, maxTextLength = max(maxTextOffset, offset), max(maxTextLength, length)
 		if offset >= 1<<nodesBitsTextOffset {
-			return fmt.Errorf("text offset %d is too large, or nodeBitsTextOffset is too small", offset)
+			return "", nil, nil, fmt.Errorf("text offset %d is too large, or nodeBitsTextOffset is too small", offset)
 		} //end if
 		if length >= 1<<nodesBitsTextLength {
-			return fmt.Errorf("text length %d is too large, or nodeBitsTextLength is too small", length)
+			return "", nil, nil, fmt.Errorf("text length %d is too large, or nodeBitsTextLength is too small", length)
 		} //end if
 		labelEncoding[label] = uint32(offset)<<nodesBitsTextLength | uint32(length)
 	} //end for
 
-	/* Write text */
-	if err := binary.Write(buf, binary.BigEndian, []byte(text)); err != nil {
-		return err
-	} //end if
-
 	w := new(bytes.Buffer)
 	if err := n.walk(w, assignIndexes); err != nil {
-		return err
+		return "", nil, nil, err
 	} //end if
 
 	/* Calculate node */
 	if err := n.walk(w, printNode); err != nil {
-		return err
+		return "", nil, nil, err
 	} //end if
 
-	/* Write node */
-	nodeLen := (uint32)(w.Len() / (int)(unsafe.Sizeof(uint32(0))))
-	if err := binary.Write(buf, binary.BigEndian, nodeLen); err != nil {
-		return err
-	} //end if
-	if err := binary.Write(buf, binary.BigEndian, w.Bytes()); err != nil {
-		return err
+	nodes := make([]uint32, w.Len()/(int)(unsafe.Sizeof(uint32(0))))
+	if err := binary.Read(w, binary.BigEndian, nodes); err != nil {
+		return "", nil, nil, err
 	} //end if
 
-	/* Write children */
-	if err := binary.Write(buf, binary.BigEndian, uint32(len(childrenEncoding))); err != nil {
-		return err
+	return text, nodes, childrenEncoding, nil
+} //end encodeTables
+
+func nativeEndian() binary.ByteOrder {
+	x := uint16(1)
+	if *(*byte)(unsafe.Pointer(&x)) == 1 {
+		return binary.LittleEndian
 	} //end if
-	for _, c := range childrenEncoding {
-		if err := binary.Write(buf, binary.BigEndian, c); err != nil {
-			return err
-		} //end if
-	} //end for
+	return binary.BigEndian
+} //end nativeEndian
 
-	return nil
-} //end printReal
+func align(off int) int {
+	return (off + v2Align - 1) &^ (v2Align - 1)
+} //end align
+
+func pad(buf *bytes.Buffer, off int) {
+	for buf.Len() < off {
+		buf.WriteByte(0)
+	} //end for
+} //end pad
 
 type node struct {
 	label    string
@@ -0,0 +1,873 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libetn.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define DATA_FILE           "public_suffix_compiled.dat"
+#define TOP_DEFAULT         20
+
+#define PCAP_MAGIC_US       0xa1b2c3d4
+#define PCAP_MAGIC_NS       0xa1b23c4d
+#define PCAP_HEADER         24
+#define PCAP_RECORD         16
+#define PCAP_SNAPLEN_MAX    262144
+#define PCAPNG_SHB          0x0a0d0d0a
+#define PCAPNG_BYTE_ORDER   0x1a2b3c4d
+#define PCAPNG_IDB          1
+#define PCAPNG_SPB          3
+#define PCAPNG_EPB          6
+#define PCAPNG_BLOCK_MIN    12
+#define PCAPNG_EPB_HEADER   28
+#define PCAPNG_SPB_HEADER   12
+#define INTERFACES_MAX      256
+
+/* records checked in a row before a chunk is taken to start at one */
+#define SYNC_RECORDS        8
+#define SYNC_SECONDS        86400
+/* a chunk holds several of the largest records so that every one starts a record */
+#define CHUNK_MIN           (4 * PCAP_SNAPLEN_MAX)
+
+#define LINKTYPE_NULL       0
+#define LINKTYPE_ETHERNET   1
+#define LINKTYPE_RAW        101
+#define LINKTYPE_LOOP       108
+#define LINKTYPE_LINUX_SLL  113
+#define LINKTYPE_IPV4       228
+#define LINKTYPE_IPV6       229
+
+#define ETHERTYPE_IPV4      0x0800
+#define ETHERTYPE_IPV6      0x86dd
+#define ETHERTYPE_VLAN      0x8100
+#define ETHERTYPE_QINQ      0x88a8
+
+#define PROTO_HOPOPTS       0
+#define PROTO_TCP           6
+#define PROTO_UDP           17
+#define PROTO_ROUTING       43
+#define PROTO_FRAGMENT      44
+#define PROTO_DSTOPTS       60
+
+#define PORT_DNS            53
+#define DNS_HEADER          12
+
+typedef enum {
+    SOURCE_DNS = 0,
+    SOURCE_TLS,
+    SOURCE_HTTP,
+    SOURCE_MAX
+} source_t;
+
+typedef struct capture_s {
+    const uint8_t   *data;
+    size_t          len;
+    size_t          first;          /* the first record */
+    uint32_t        first_sec;      /* its timestamp, pcap only */
+    bool            ng;
+    bool            swap;           /* written in the other byte order */
+    uint32_t        snaplen;
+    uint32_t        usec_max;       /* a second in the unit of the timestamps */
+    uint32_t        interfaces;
+    uint16_t        linktypes[INTERFACES_MAX];
+} capture_t;
+
+typedef struct entry_s {
+    uint64_t    key;                /* 0 is empty */
+    uint64_t    count;
+    uint32_t    name_off;           /* into the names of the table */
+    uint32_t    name_len;
+} entry_t;
+
+typedef struct table_s {
+    entry_t     *entries;
+    size_t      mask;
+    size_t      n;
+    char        *names;
+    size_t      names_len;
+    size_t      names_size;
+} table_t;
+
+/* a thread and the records that start in its chunk, [begin, end) of the file */
+typedef struct worker_s {
+    pthread_t   thread;
+    capture_t   *capture;
+    e_etn_t     *etn;
+    size_t      begin;
+    size_t      end;
+    size_t      start;              /* the first record it found */
+    size_t      stop;               /* where its last record ended */
+    bool        known;              /* begin is a record, it needs no sync */
+    uint64_t    packets;
+    uint64_t    skipped;            /* records of unknown links or malformed */
+    uint64_t    names[SOURCE_MAX];
+    table_t     registrable;
+    table_t     suffixes;
+} worker_t;
+
+static inline e_errno_t capture_open(capture_t *capture, const char *filename);
+static inline uint32_t capture_u32(const capture_t *capture, const uint8_t *p);
+static inline uint16_t capture_u16(const capture_t *capture, const uint8_t *p);
+static inline size_t capture_next(const capture_t *capture, size_t off, uint32_t *linktype, const uint8_t **packet, size_t *caplen);
+static inline size_t capture_sync(const capture_t *capture, size_t begin, size_t end);
+static void *work(void *arg);
+static inline void packet_link(worker_t *worker, uint32_t linktype, const uint8_t *p, size_t len);
+static inline void packet_ip(worker_t *worker, const uint8_t *p, size_t len);
+static inline void packet_transport(worker_t *worker, uint8_t proto, const uint8_t *p, size_t len);
+static inline void packet_dns(worker_t *worker, const uint8_t *msg, size_t len);
+static inline void packet_name(worker_t *worker, source_t source, const char *name, size_t len);
+static inline void count(worker_t *worker, uint64_t hash, const char *name, size_t len, uint32_t suffix_id, e_etn_rule_t rule, uint64_t n);
+static inline bool table_add(table_t *table, uint64_t key, const char *name, size_t len, uint64_t n);
+static inline void table_merge(table_t *dst, const table_t *src);
+static inline void table_free(table_t *table);
+static inline entry_t **table_top(const table_t *table, size_t top, size_t *n);
+static inline size_t wire_name(const uint8_t *msg, size_t msg_len, size_t off, char *buf);
+static inline uint16_t be16(const uint8_t *p);
+static int entry_cmp(const void *a, const void *b);
+static inline void usage(const char *cmd) E_NO_RETURN;
+
+int main(int argc, char *argv[]) {
+    int         c;
+    char        name[E_STRBUF];
+    double      spent;
+    size_t      i, k, n, threads, top, chunk;
+    e_etn_t     *etn;
+    entry_t     **entries;
+    uint64_t    packets, skipped, lookups, retries, names[SOURCE_MAX];
+    worker_t    *workers;
+    capture_t   capture;
+    e_timer_t   *timer;
+    const char  *file, *suffix;
+
+    opterr = 0;
+    file = DATA_FILE;
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+    top = TOP_DEFAULT;
+    while((c = getopt(argc, argv, "d:t:n:")) != EOF) {
+        switch(c) {
+            case 'd':
+                file = optarg;
+                break;
+            case 't':
+                threads = strtoul(optarg, NULL, 10);
+                break;
+            case 'n':
+                top = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }//end switch
+    }//end while
+    if(optind != argc - 1 || threads == 0) {
+        usage(argv[0]);
+    }//end if
+
+    etn = e_etn_new(file);
+    if(E_UNLIKELY(!etn)) {
+        fprintf(stderr, "Failed to create etn\n");
+        return 1;
+    }//end if
+
+    if(E_UNLIKELY(capture_open(&capture, argv[optind]) != E_OK)) {
+        fprintf(stderr, "Failed to read '%s' as pcap or pcapng\n", argv[optind]);
+        e_etn_free(etn);
+        return 1;
+    }//end if
+
+    /* one chunk of the file for every thread, none too small to hold a record */
+    chunk = (capture.len - capture.first + threads - 1) / threads;
+    if(chunk < CHUNK_MIN) {
+        chunk = CHUNK_MIN;
+        threads = (capture.len - capture.first + chunk - 1) / chunk;
+        threads = threads > 0 ? threads : 1;
+    }//end if
+
+    workers = e_calloc(threads, sizeof(worker_t));
+    timer = e_timer_new();
+    if(E_UNLIKELY(!workers || !timer)) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return 1;
+    }//end if
+
+    for(i = 0 ; i < threads ; i++) {
+        workers[i].capture = &capture;
+        workers[i].etn = etn;
+        workers[i].begin = capture.first + i * chunk;
+        workers[i].end = i == threads - 1 ? capture.len : capture.first + (i + 1) * chunk;
+        workers[i].known = i == 0;
+        if(E_UNLIKELY(pthread_create(&workers[i].thread, NULL, work, &workers[i]) != 0)) {
+            fprintf(stderr, "Failed to create thread\n");
+            return 1;
+        }//end if
+    }//end for
+
+    packets = skipped = lookups = retries = 0;
+    memset(names, 0, sizeof(names));
+    for(i = 0 ; i < threads ; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }//end for
+
+    /* a chunk must start where the one before stopped, or one was found at a wrong offset */
+    for(i = 0 ; i < threads ; i++) {
+        if(i > 0 && workers[i].start != workers[i - 1].stop) {
+            /* synced at a wrong offset, the chunk is read again from where the one before stopped */
+            table_free(&workers[i].registrable);
+            table_free(&workers[i].suffixes);
+            memset(&workers[i].packets, 0, sizeof(worker_t) - offsetof(worker_t, packets));
+            workers[i].begin = workers[i - 1].stop;
+            workers[i].known = true;
+            work(&workers[i]);
+            retries++;
+        }//end if
+
+        packets += workers[i].packets;
+        skipped += workers[i].skipped;
+        for(k = 0 ; k < SOURCE_MAX ; k++) {
+            names[k] += workers[i].names[k];
+            lookups += workers[i].names[k];
+        }//end for
+        if(i > 0) {
+            table_merge(&workers[0].registrable, &workers[i].registrable);
+            table_merge(&workers[0].suffixes, &workers[i].suffixes);
+        }//end if
+    }//end for
+
+    e_timer_elapsed(timer, &spent, NULL);
+
+    printf("Read '%s', %zu bytes in %f seconds with %zu threads, %.2f GB/s\n",
+        argv[optind], capture.len, spent, threads, capture.len / spent / 1e9);
+    printf("%" PRIu64 " packets, %.0f packets/s, %" PRIu64 " skipped, %" PRIu64 " chunks read again\n", packets, packets / spent, skipped, retries);
+    printf("%" PRIu64 " lookups, %.0f lookups/s, %" PRIu64 " DNS questions, %" PRIu64 " TLS server names, %" PRIu64 " HTTP hosts\n",
+        lookups, lookups / spent, names[SOURCE_DNS], names[SOURCE_TLS], names[SOURCE_HTTP]);
+
+    printf("\n%12s  %s\n", "Count", "eTLD+1");
+    entries = table_top(&workers[0].registrable, top, &n);
+    for(i = 0 ; i < n ; i++) {
+        printf("%12" PRIu64 "  %.*s\n", entries[i]->count, (int)entries[i]->name_len, workers[0].registrable.names + entries[i]->name_off);
+    }//end for
+    e_free(entries);
+
+    printf("\n%12s  %s\n", "Count", "Public suffix");
+    entries = table_top(&workers[0].suffixes, top, &n);
+    for(i = 0 ; i < n ; i++) {
+        /* the key is the suffix_id and whether a wildcard matched under it, plus one */
+        k = entries[i]->key - 1;
+        suffix = "(not in the list)";
+        if((k >> 1) != E_ETN_SUFFIX_NONE && e_etn_suffix_name(etn, k >> 1, name + 2, sizeof(name) - 2) == E_OK) {
+            /* a wildcard matched one label more than its node */
+            memcpy(name, "*.", 2);
+            suffix = k & 1 ? name : name + 2;
+        }//end if
+        printf("%12" PRIu64 "  %s\n", entries[i]->count, suffix);
+    }//end for
+    e_free(entries);
+
+    for(i = 0 ; i < threads ; i++) {
+        table_free(&workers[i].registrable);
+        table_free(&workers[i].suffixes);
+    }//end for
+    e_free(workers);
+    e_timer_free(timer);
+    munmap((void *)capture.data, capture.len);
+    e_etn_free(etn);
+    return 0;
+}//end main
+
+
+/* ===== private function ===== */
+static inline e_errno_t capture_open(capture_t *capture, const char *filename) {
+    int             fd;
+    size_t          off, len;
+    uint32_t        magic, type;
+    struct stat     st;
+    const uint8_t   *p;
+
+    memset(capture, 0, sizeof(capture_t));
+    fd = open(filename, O_RDONLY);
+    if(E_UNLIKELY(fd < 0)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    if(E_UNLIKELY(fstat(fd, &st) < 0 || st.st_size < PCAP_HEADER)) {
+        close(fd);
+        return E_ERR_INVAL;
+    }//end if
+
+    capture->len = st.st_size;
+    capture->data = mmap(NULL, capture->len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(E_UNLIKELY(capture->data == MAP_FAILED)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    p = capture->data;
+    memcpy(&magic, p, sizeof(magic));
+    if(magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS || __builtin_bswap32(magic) == PCAP_MAGIC_US || __builtin_bswap32(magic) == PCAP_MAGIC_NS) {
+        capture->swap = magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS;
+        capture->usec_max = (magic == PCAP_MAGIC_US || __builtin_bswap32(magic) == PCAP_MAGIC_US) ? 1000000 : 1000000000;
+        capture->snaplen = capture_u32(capture, p + 16);
+        if(capture->snaplen == 0 || capture->snaplen > PCAP_SNAPLEN_MAX) {
+            capture->snaplen = PCAP_SNAPLEN_MAX;
+        }//end if
+        capture->interfaces = 1;
+        capture->linktypes[0] = capture_u32(capture, p + 20) & 0xffff;
+        capture->first = PCAP_HEADER;
+        if(capture->len >= PCAP_HEADER + PCAP_RECORD) {
+            capture->first_sec = capture_u32(capture, p + PCAP_HEADER);
+        }//end if
+        return E_OK;
+    }//end if
+
+    if(magic != PCAPNG_SHB) {
+        munmap((void *)p, capture->len);
+        return E_ERR_INVAL;
+    }//end if
+
+    /* the interfaces of the first section, up to its first packet */
+    memcpy(&magic, p + 8, sizeof(magic));
+    capture->ng = true;
+    capture->swap = magic != PCAPNG_BYTE_ORDER;
+    capture->snaplen = PCAP_SNAPLEN_MAX;
+    for(off = 0 ; capture->len - off >= PCAPNG_BLOCK_MIN ; off += len) {
+        type = capture_u32(capture, p + off);
+        len = capture_u32(capture, p + off + 4);
+        if(E_UNLIKELY(len < PCAPNG_BLOCK_MIN || (len & 3) || len > capture->len - off)) {
+            munmap((void *)p, capture->len);
+            return E_ERR_INVAL;
+        }//end if
+
+        if(type == PCAPNG_EPB || type == PCAPNG_SPB) {
+            break;
+        }//end if
+        if(type == PCAPNG_IDB && len >= 16 && capture->interfaces < INTERFACES_MAX) {
+            capture->linktypes[capture->interfaces++] = capture_u16(capture, p + off + 8);
+        }//end if
+    }//end for
+
+    capture->first = off;
+    return E_OK;
+}//end capture_open
+
+static inline uint32_t capture_u32(const capture_t *capture, const uint8_t *p) {
+    uint32_t    v;
+
+    memcpy(&v, p, sizeof(v));
+    return capture->swap ? __builtin_bswap32(v) : v;
+}//end capture_u32
+
+static inline uint16_t capture_u16(const capture_t *capture, const uint8_t *p) {
+    uint16_t    v;
+
+    memcpy(&v, p, sizeof(v));
+    return capture->swap ? __builtin_bswap16(v) : v;
+}//end capture_u16
+
+/* the record at off, its end or 0 if it is not one. packet is NULL for blocks without a packet */
+static inline size_t capture_next(const capture_t *capture, size_t off, uint32_t *linktype, const uint8_t **packet, size_t *caplen) {
+    size_t          len, left;
+    uint32_t        type, iface;
+    const uint8_t   *p;
+
+    p = capture->data + off;
+    left = capture->len - off;
+    *packet = NULL;
+    if(!capture->ng) {
+        if(E_UNLIKELY(left < PCAP_RECORD)) {
+            return 0;
+        }//end if
+
+        len = capture_u32(capture, p + 8);
+        if(E_UNLIKELY(len > capture->snaplen || len > capture_u32(capture, p + 12) || len > left - PCAP_RECORD ||
+            capture_u32(capture, p + 4) >= capture->usec_max)) {
+            return 0;
+        }//end if
+
+        *linktype = capture->linktypes[0];
+        *packet = p + PCAP_RECORD;
+        *caplen = len;
+        return off + PCAP_RECORD + len;
+    }//end if
+
+    if(E_UNLIKELY(left < PCAPNG_BLOCK_MIN)) {
+        return 0;
+    }//end if
+
+    type = capture_u32(capture, p);
+    len = capture_u32(capture, p + 4);
+    if(E_UNLIKELY(len < PCAPNG_BLOCK_MIN || (len & 3) || len > left || capture_u32(capture, p + len - 4) != len)) {
+        return 0;
+    }//end if
+
+    if(type == PCAPNG_EPB && len >= PCAPNG_EPB_HEADER + 4) {
+        iface = capture_u32(capture, p + 8);
+        *caplen = capture_u32(capture, p + 20);
+        if(iface < capture->interfaces && *caplen <= len - PCAPNG_EPB_HEADER - 4) {
+            *linktype = capture->linktypes[iface];
+            *packet = p + PCAPNG_EPB_HEADER;
+        }//end if
+    }//end if
+    else if(type == PCAPNG_SPB && len >= PCAPNG_SPB_HEADER + 4 && capture->interfaces > 0) {
+        *caplen = capture_u32(capture, p + 8);
+        if(*caplen > len - PCAPNG_SPB_HEADER - 4) {
+            *caplen = len - PCAPNG_SPB_HEADER - 4;
+        }//end if
+        *linktype = capture->linktypes[0];
+        *packet = p + PCAPNG_SPB_HEADER;
+    }//end if
+
+    return off + len;
+}//end capture_next
+
+/*
+ * The first record that starts in [begin, end). Records have no marker, an offset
+ * is taken when SYNC_RECORDS records in a row parse from it, with timestamps of
+ * pcap records close together, or the file ends exactly after them.
+ */
+static inline size_t capture_sync(const capture_t *capture, size_t begin, size_t end) {
+    size_t          off, next, caplen, k;
+    uint32_t        linktype, sec, prev;
+    const uint8_t   *packet;
+
+    for(off = capture->ng ? (begin + 3) & ~(size_t)3 : begin ; off < end ; off += capture->ng ? 4 : 1) {
+        prev = 0;
+        for(next = off, k = 0 ; k < SYNC_RECORDS && next < capture->len ; k++) {
+            if(!capture->ng) {
+                if(capture->len - next < PCAP_RECORD) {
+                    break;
+                }//end if
+                /* padding of zeros parses as empty records, the first record is only read once it fits */
+                sec = capture_u32(capture, capture->data + next);
+                if(k == 0) {
+                    prev = sec;
+                }//end if
+                if((sec > prev ? sec - prev : prev - sec) > SYNC_SECONDS || (uint64_t)sec + SYNC_SECONDS < capture->first_sec ||
+                    capture_u32(capture, capture->data + next + 8) == 0) {
+                    break;
+                }//end if
+                prev = sec;
+            }//end if
+            else if(capture->len - next < PCAPNG_BLOCK_MIN ||
+                (capture_u32(capture, capture->data + next) > PCAPNG_EPB && capture_u32(capture, capture->data + next) != PCAPNG_SHB)) {
+                break;
+            }//end if
+
+            next = capture_next(capture, next, &linktype, &packet, &caplen);
+            if(next == 0) {
+                break;
+            }//end if
+        }//end for
+
+        if(k == SYNC_RECORDS || next == capture->len) {
+            return off;
+        }//end if
+    }//end for
+
+    return end;
+}//end capture_sync
+
+static void *work(void *arg) {
+    size_t          off, next, caplen;
+    uint32_t        linktype;
+    uintptr_t       page;
+    worker_t        *worker;
+    capture_t       *capture;
+    const uint8_t   *packet;
+
+    worker = arg;
+    capture = worker->capture;
+    off = worker->known ? worker->begin : capture_sync(capture, worker->begin, worker->end);
+    worker->start = off;
+    page = (uintptr_t)(capture->data + worker->begin) & ~(uintptr_t)(getpagesize() - 1);
+    madvise((void *)page, (uintptr_t)(capture->data + worker->end) - page, MADV_WILLNEED);
+
+    /* the last record may end in the next chunk */
+    while(off < worker->end) {
+        next = capture_next(capture, off, &linktype, &packet, &caplen);
+        if(E_UNLIKELY(next == 0)) {
+            /* a damaged record, on to the next that parses */
+            worker->skipped++;
+            off = capture_sync(capture, off + 1, worker->end);
+            continue;
+        }//end if
+
+        if(packet) {
+            worker->packets++;
+            packet_link(worker, linktype, packet, caplen);
+        }//end if
+        off = next;
+    }//end while
+
+    worker->stop = off;
+    return NULL;
+}//end work
+
+static inline void packet_link(worker_t *worker, uint32_t linktype, const uint8_t *p, size_t len) {
+    uint16_t    type;
+
+    switch(linktype) {
+        case LINKTYPE_ETHERNET:
+            if(E_UNLIKELY(len < 14)) {
+                break;
+            }//end if
+            type = be16(p + 12);
+            p += 14;
+            len -= 14;
+            while((type == ETHERTYPE_VLAN || type == ETHERTYPE_QINQ) && len >= 4) {
+                type = be16(p + 2);
+                p += 4;
+                len -= 4;
+            }//end while
+            if(type == ETHERTYPE_IPV4 || type == ETHERTYPE_IPV6) {
+                packet_ip(worker, p, len);
+                return;
+            }//end if
+            break;
+        case LINKTYPE_LINUX_SLL:
+            if(E_UNLIKELY(len < 16)) {
+                break;
+            }//end if
+            packet_ip(worker, p + 16, len - 16);
+            return;
+        case LINKTYPE_NULL:
+        case LINKTYPE_LOOP:
+            /* the address family in the byte order of the host that captured, the IP version tells the same */
+            if(E_UNLIKELY(len < 4)) {
+                break;
+            }//end if
+            packet_ip(worker, p + 4, len - 4);
+            return;
+        case LINKTYPE_RAW:
+        case LINKTYPE_IPV4:
+        case LINKTYPE_IPV6:
+            packet_ip(worker, p, len);
+            return;
+        default:
+            break;
+    }//end switch
+
+    worker->skipped++;
+}//end packet_link
+
+static inline void packet_ip(worker_t *worker, const uint8_t *p, size_t len) {
+    size_t      hlen, total;
+    uint8_t     proto;
+
+    if(E_UNLIKELY(len < 1)) {
+        worker->skipped++;
+        return;
+    }//end if
+
+    if((p[0] >> 4) == 4) {
+        hlen = (p[0] & 0xf) * 4;
+        if(E_UNLIKELY(len < 20 || hlen < 20 || hlen > len)) {
+            worker->skipped++;
+            return;
+        }//end if
+
+        /* only the first fragment has the transport header */
+        if(be16(p + 6) & 0x1fff) {
+            return;
+        }//end if
+
+        total = be16(p + 2);
+        if(total >= hlen && total < len) {
+            len = total;
+        }//end if
+        packet_transport(worker, p[9], p + hlen, len - hlen);
+        return;
+    }//end if
+
+    if((p[0] >> 4) == 6 && len >= 40) {
+        total = be16(p + 4);
+        proto = p[6];
+        len = total < len - 40 ? total : len - 40;
+        p += 40;
+        while(proto == PROTO_HOPOPTS || proto == PROTO_ROUTING || proto == PROTO_DSTOPTS || proto == PROTO_FRAGMENT) {
+            hlen = proto == PROTO_FRAGMENT ? 8 : (size_t)(len >= 2 ? p[1] + 1 : 1) * 8;
+            if(E_UNLIKELY(len < hlen)) {
+                worker->skipped++;
+                return;
+            }//end if
+            if(proto == PROTO_FRAGMENT && (be16(p + 2) & 0xfff8)) {
+                return;
+            }//end if
+
+            proto = p[0];
+            p += hlen;
+            len -= hlen;
+        }//end while
+        packet_transport(worker, proto, p, len);
+        return;
+    }//end if
+
+    worker->skipped++;
+}//end packet_ip
+
+static inline void packet_transport(worker_t *worker, uint8_t proto, const uint8_t *p, size_t len) {
+    size_t      hlen;
+    uint16_t    sport, dport;
+    const char  *name;
+    size_t      name_len;
+
+    if(proto == PROTO_UDP) {
+        if(E_UNLIKELY(len < 8)) {
+            worker->skipped++;
+            return;
+        }//end if
+
+        sport = be16(p);
+        dport = be16(p + 2);
+        if(dport == PORT_DNS || sport == PORT_DNS) {
+            packet_dns(worker, p + 8, len - 8);
+        }//end if
+        return;
+    }//end if
+
+    if(proto != PROTO_TCP) {
+        return;
+    }//end if
+
+    /* the data offset is in the 13th byte, there must be a whole header to read it */
+    if(E_UNLIKELY(len < 20)) {
+        worker->skipped++;
+        return;
+    }//end if
+    hlen = (p[12] >> 4) * 4;
+    if(E_UNLIKELY(hlen < 20 || hlen > len)) {
+        worker->skipped++;
+        return;
+    }//end if
+
+    sport = be16(p);
+    dport = be16(p + 2);
+    p += hlen;
+    len -= hlen;
+    if(len == 0) {
+        return;
+    }//end if
+
+    /* a whole message over TCP after its length */
+    if(dport == PORT_DNS || sport == PORT_DNS) {
+        if(len > 2 && be16(p) == len - 2) {
+            packet_dns(worker, p + 2, len - 2);
+        }//end if
+        return;
+    }//end if
+
+    if(p[0] == 22) {
+        if(e_tls_sni_extract(p, len, &name, &name_len) == E_OK) {
+            packet_name(worker, SOURCE_TLS, name, name_len);
+        }//end if
+        return;
+    }//end if
+
+    /* requests start with an upper case method */
+    if(p[0] >= 'A' && p[0] <= 'Z' && e_http_host_extract((const char *)p, len, &name, &name_len) == E_OK) {
+        packet_name(worker, SOURCE_HTTP, name, name_len);
+    }//end if
+}//end packet_transport
+
+static inline void packet_dns(worker_t *worker, const uint8_t *msg, size_t len) {
+    char                name[E_STRBUF];
+    size_t              name_len;
+    e_etn_wire_result_t r;
+
+    /* questions of standard queries, the answers would count them twice */
+    if(len < DNS_HEADER || (msg[2] & 0xf8) != 0 || be16(msg + 4) == 0) {
+        return;
+    }//end if
+
+    if(e_etn_public_suffix_wire(worker->etn, msg, len, DNS_HEADER, &r) != E_OK) {
+        worker->skipped++;
+        return;
+    }//end if
+
+    worker->names[SOURCE_DNS]++;
+    name_len = r.registrable_hash ? wire_name(msg, len, r.registrable_off, name) : 0;
+    count(worker, r.registrable_hash, name, name_len, r.suffix_id, r.rule, 1);
+}//end packet_dns
+
+static inline void packet_name(worker_t *worker, source_t source, const char *name, size_t len) {
+    size_t          end;
+    e_etn_result_t  r;
+
+    if(e_etn_lookup(worker->etn, name, len, &r) != E_OK) {
+        worker->skipped++;
+        return;
+    }//end if
+
+    worker->names[source]++;
+    end = len > 0 && name[len - 1] == '.' ? len - 1 : len;
+    count(worker, r.registrable_hash, name + r.registrable_off, end - r.registrable_off, r.suffix_id, r.rule, 1);
+}//end packet_name
+
+/* name is the eTLD+1 as it was seen, the first spelling of a hash is the one shown */
+static inline void count(worker_t *worker, uint64_t hash, const char *name, size_t len, uint32_t suffix_id, e_etn_rule_t rule, uint64_t n) {
+    if(hash) {
+        table_add(&worker->registrable, hash, name, len, n);
+    }//end if
+
+    table_add(&worker->suffixes, (((uint64_t)suffix_id << 1) | (rule == E_ETN_RULE_WILDCARD)) + 1, NULL, 0, n);
+}//end count
+
+static inline bool table_add(table_t *table, uint64_t key, const char *name, size_t len, uint64_t n) {
+    size_t      i, k, size;
+    char        *names;
+    entry_t     *entries, *e;
+
+    if(E_UNLIKELY(2 * (table->n + 1) > table->mask + 1 || !table->entries)) {
+        size = table->entries ? 2 * (table->mask + 1) : 1024;
+        entries = e_calloc(size, sizeof(entry_t));
+        if(E_UNLIKELY(!entries)) {
+            return false;
+        }//end if
+
+        for(i = 0 ; table->entries && i <= table->mask ; i++) {
+            if(table->entries[i].key) {
+                for(k = table->entries[i].key & (size - 1) ; entries[k].key ; k = (k + 1) & (size - 1));
+                entries[k] = table->entries[i];
+            }//end if
+        }//end for
+        e_free(table->entries);
+        table->entries = entries;
+        table->mask = size - 1;
+    }//end if
+
+    for(i = key & table->mask ; table->entries[i].key && table->entries[i].key != key ; i = (i + 1) & table->mask);
+    e = &table->entries[i];
+    if(e->key) {
+        e->count += n;
+        return true;
+    }//end if
+
+    if(table->names_size - table->names_len < len) {
+        size = table->names_size ? 2 * table->names_size : 64 * 1024;
+        size = size >= table->names_len + len ? size : table->names_len + len;
+        names = e_realloc(table->names, size);
+        if(E_UNLIKELY(!names)) {
+            return false;
+        }//end if
+        table->names = names;
+        table->names_size = size;
+    }//end if
+
+    /* lower case as the hash is */
+    for(i = 0 ; i < len ; i++) {
+        table->names[table->names_len + i] = name[i] >= 'A' && name[i] <= 'Z' ? name[i] | 0x20 : name[i];
+    }//end for
+
+    e->key = key;
+    e->count = n;
+    e->name_off = table->names_len;
+    e->name_len = len;
+    table->names_len += len;
+    table->n++;
+    return true;
+}//end table_add
+
+static inline void table_merge(table_t *dst, const table_t *src) {
+    size_t      i;
+
+    for(i = 0 ; src->entries && i <= src->mask ; i++) {
+        if(src->entries[i].key) {
+            table_add(dst, src->entries[i].key, src->names + src->entries[i].name_off, src->entries[i].name_len, src->entries[i].count);
+        }//end if
+    }//end for
+}//end table_merge
+
+static inline void table_free(table_t *table) {
+    e_free(table->entries);
+    e_free(table->names);
+}//end table_free
+
+static inline entry_t **table_top(const table_t *table, size_t top, size_t *n) {
+    size_t      i;
+    entry_t     **entries;
+
+    *n = 0;
+    entries = e_malloc((table->n + 1) * sizeof(entry_t *));
+    if(E_UNLIKELY(!entries)) {
+        return NULL;
+    }//end if
+
+    for(i = 0 ; table->entries && i <= table->mask ; i++) {
+        if(table->entries[i].key) {
+            entries[(*n)++] = &table->entries[i];
+        }//end if
+    }//end for
+
+    qsort(entries, *n, sizeof(entry_t *), entry_cmp);
+    *n = *n < top ? *n : top;
+    return entries;
+}//end table_top
+
+/* the text of the name at msg[off], e_etn_public_suffix_wire() has checked it */
+static inline size_t wire_name(const uint8_t *msg, size_t msg_len, size_t off, char *buf) {
+    size_t      len, n;
+
+    len = 0;
+    while(off < msg_len && msg[off] != 0) {
+        if(msg[off] >= 0xc0) {
+            off = ((msg[off] & 0x3f) << 8) | msg[off + 1];
+            continue;
+        }//end if
+
+        n = msg[off];
+        if(len > 0) {
+            buf[len++] = '.';
+        }//end if
+        memcpy(buf + len, msg + off + 1, n);
+        len += n;
+        off += n + 1;
+    }//end while
+
+    return len;
+}//end wire_name
+
+static inline uint16_t be16(const uint8_t *p) {
+    return ((uint16_t)p[0] << 8) | p[1];
+}//end be16
+
+static int entry_cmp(const void *a, const void *b) {
+    const entry_t   *x = *(const entry_t * const *)a;
+    const entry_t   *y = *(const entry_t * const *)b;
+
+    return x->count < y->count ? 1 : x->count > y->count ? -1 : 0;
+}//end entry_cmp
+
+static inline void usage(const char *cmd) {
+    fprintf(stderr, "%s [-d public suffix compiled file] [-t threads] [-n top] capture.pcap|capture.pcapng\n", cmd);
+    exit(1);
+}//end usage
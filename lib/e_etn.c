@@ -32,10 +32,22 @@
 #include <libetn/e_refcount.h>
 #include <libetn/e_mem.h>
 #include <libetn/e_strfuncs.h>
+#include "e_etn_builder.h"
 #include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <string.h>
 
-#define E_ETN_MAGIC 0x9601042d
+#define E_ETN_MAGIC         0x9601042d
+#define E_ETN_MAGIC_V2      0x9601042e
+#define E_ETN_MAGIC_WIDE    0x9601042f
+
+/* sections of a v2 file start on this boundary, the header has room to grow */
+#define E_ETN_V2_ALIGN          64
+#define E_ETN_V2_HEADER_SIZE    128
+#define E_ETN_V2_ROUND(off)     (((off) + E_ETN_V2_ALIGN - 1) & ~((size_t)E_ETN_V2_ALIGN - 1))
 
 /**
  * RFC 1035: 2.3.4
@@ -46,6 +58,21 @@
  */
 #define E_ETN_DOMAIN_MAX 255
 
+/* RFC 1035: 4.1.4, a pointer is two bytes with the top bits set, a label at most 63 bytes */
+#define E_ETN_WIRE_POINTER  0xC0
+#define E_ETN_WIRE_LABELS   (E_ETN_DOMAIN_MAX / 2)
+
+#ifdef HAVE_ETN_BUILTIN
+/* generated by ci/precompile.go -format c */
+extern E_LOCAL const uint32_t e_etn_builtin_header[];
+extern E_LOCAL const uint32_t e_etn_builtin_text_length;
+extern E_LOCAL const char e_etn_builtin_text[];
+extern E_LOCAL const uint32_t e_etn_builtin_nodes_length;
+extern E_LOCAL const uint32_t e_etn_builtin_nodes[];
+extern E_LOCAL const uint32_t e_etn_builtin_children_length;
+extern E_LOCAL const uint32_t e_etn_builtin_children[];
+#endif
+
 #define E_ETN_GET_UINT32(buf, off)              \
     E_GNUC_EXTENSION({                          \
         uint32_t v;                             \
@@ -56,6 +83,190 @@
 
 #define E_ETN_NOT_FOUND 0xFFFFFFFF
 
+/* a field of a wide word, widths are at most 32 bits */
+#define E_ETN_MASK(bits) (((uint64_t)1 << (bits)) - 1)
+
+/*
+ * The v2 compiled format is written in host byte order by
+ * "precompile.go -format v2". Every section starts on an E_ETN_V2_ALIGN
+ * boundary, so a read-only mapping of the file can be used in place.
+ */
+typedef struct e_etn_header_v2_s {
+    uint32_t    magic;
+    uint32_t    header_size;
+    uint32_t    nodes_bits_children;
+    uint32_t    nodes_bits_ICANN;
+    uint32_t    nodes_bits_text_offset;
+    uint32_t    nodes_bits_text_length;
+    uint32_t    children_bits_wildcard;
+    uint32_t    children_bits_node_type;
+    uint32_t    children_bits_hi;
+    uint32_t    children_bits_lo;
+    uint32_t    node_type_normal;
+    uint32_t    node_type_exception;
+    uint32_t    node_type_parent_only;
+    uint32_t    num_TLD;
+    uint32_t    text_offset;
+    uint32_t    text_length;
+    uint32_t    nodes_offset;
+    uint32_t    nodes_length;
+    uint32_t    children_offset;
+    uint32_t    children_length;
+    uint32_t    metadata_offset;        /* 0 if there are no metadata words */
+    uint32_t    metadata_length;
+} e_etn_header_v2_t;
+
+/*
+ * The root table is a minimal perfect hash over the TLD labels built with
+ * "hash and displace": a label falls into a bucket by its hash, and every
+ * bucket stores the displacement that moves its labels onto free slots.
+ */
+#define E_ETN_ROOT_BUCKET_SIZE  2
+#define E_ETN_ROOT_MAX_DISP     (1 << 16)
+
+/*
+ * The Bloom filter holds a (children range, label) pair for every child of a
+ * range that is large enough, so a label that is not there is mostly turned
+ * away with one cache line instead of a binary search. Every pair sets
+ * E_ETN_BLOOM_K bits in one 64-byte block, with E_ETN_BLOOM_BITS bits per
+ * pair that misses less than 1%. Smaller ranges are searched in about as
+ * many compares as the filter costs.
+ */
+#define E_ETN_BLOOM_MIN_RANGE   8
+#define E_ETN_BLOOM_BITS        16
+#define E_ETN_BLOOM_K           4
+#define E_ETN_BLOOM_BLOCK       8       /* 64-bit words, 512 bits */
+
+/* children ranges up to this size stay sorted and are scanned, larger ones are in Eytzinger order */
+#define E_ETN_INLINE_SCAN_MAX   4
+
+/* what e_etn_lookup() needs from a walk down the trie, start is where the last label walked begins */
+typedef struct e_etn_walk_s {
+    size_t          suffix;
+    size_t          tld;
+    size_t          start;
+    size_t          depth;
+    uint32_t        suffix_labels;
+    uint32_t        suffix_id;
+    uint64_t        hash;           /* the labels of the suffix as e_etn_hash_update() left it */
+    e_etn_rule_t    rule;
+    bool            icann;
+} e_etn_walk_t;
+
+/* a table of a stack, the suffix ids of its nodes start at id_off. The base is the first */
+typedef struct e_etn_stacked_s {
+    e_etn_t     *etn;
+    int         priority;
+    bool        icann;
+    uint32_t    id_off;
+} e_etn_stacked_t;
+
+/* e_etn_walk_iov() of one table of a stack, kept between labels */
+typedef struct e_etn_layer_walk_s {
+    uint32_t        lo;
+    uint32_t        hi;
+    uint32_t        parent;
+    uint32_t        suffix_labels;
+    uint32_t        suffix_id;
+    e_etn_rule_t    rule;
+    bool            icann;
+    bool            wildcard;
+    bool            done;
+} e_etn_layer_walk_t;
+
+/* the walks of every table of a stack down to some label */
+typedef struct e_etn_walks_s {
+    uint32_t            n;
+    uint32_t            live;
+    e_etn_layer_walk_t  walks[E_ETN_STACK_MAX];
+} e_etn_walks_t;
+
+/*
+ * The DFA reads a domain from right to left a byte at a time. Bytes are mapped
+ * to classes first, upper case folds into lower case and bytes that appear in
+ * no label share class 0. Every state has a row of next states and an info
+ * byte that tells what the label just read means once a dot or the start of
+ * the domain ends it. The dot column of a state that matched a node leads to
+ * the state for the children of that node. Nodes whose subtrees read alike share
+ * their states, so the node a walk ends on is found afterwards by the hash of
+ * its suffix labels, which the walk keeps anyway.
+ */
+#define E_ETN_DFA_DEAD          0       /* nothing more can match, stop */
+#define E_ETN_DFA_ANY           1       /* any label under a wildcard */
+#define E_ETN_DFA_CLASS_DOT     1
+#define E_ETN_DFA_WILDCARD      0x01    /* the parent has a wildcard, any label here is a suffix */
+#define E_ETN_DFA_MATCH         0x02    /* the label is a node */
+#define E_ETN_DFA_ICANN         0x04
+#define E_ETN_DFA_NORMAL        0x08
+#define E_ETN_DFA_EXCEPTION     0x10
+
+/* a node by the hash of its suffix labels, an empty slot has no node */
+typedef struct e_etn_dfa_id_s {
+    uint64_t    key;
+    uint32_t    node;
+} e_etn_dfa_id_t;
+
+typedef struct e_etn_dfa_s {
+    uint32_t    start;
+    uint32_t    num_classes;
+    uint32_t    num_states;
+    uint32_t    capacity;
+    uint8_t     classes[256];
+    uint32_t    ids_mask;
+    uint8_t     *info;
+    uint32_t    *trans;
+    e_etn_dfa_id_t *ids;
+} e_etn_dfa_t;
+
+/* states are built bottom up, a failed allocation comes back as E_ETN_NOT_FOUND */
+typedef struct e_etn_dfa_builder_s {
+    e_etn_t     *etn;
+    e_etn_dfa_t *dfa;
+    uint32_t    *hash;
+    uint32_t    hash_size;
+    e_errno_t   err;
+} e_etn_dfa_builder_t;
+
+/* a node label with its first bytes inline, big endian so the prefixes compare as the labels */
+typedef struct e_etn_key_s {
+    uint64_t    prefix;
+    uint32_t    len;
+    uint32_t    node;
+} e_etn_key_t;
+
+/* the walk before a label, offsets count back from the end of the domain so they hold for any domain that ends the same */
+typedef struct e_etn_frame_s {
+    uint32_t        lo;
+    uint32_t        hi;
+    uint32_t        node;           /* the next label matched it, E_ETN_NOT_FOUND if none did */
+    uint32_t        suffix_labels;
+    uint32_t        suffix_id;
+    uint16_t        pos_back;       /* the next label ends end - pos_back */
+    uint16_t        suffix_back;    /* the suffix starts end + 1 - suffix_back */
+    uint8_t         rule;
+    bool            icann;
+    bool            wildcard;
+} e_etn_frame_t;
+
+#define E_ETN_CURSOR_DEPTH (E_ETN_DOMAIN_MAX / 2 + 2)
+
+/*
+ * frames[k] is the walk of the previous domain before its label k + 1, any
+ * domain that shares its last k labels resumes from there. A walk that broke
+ * off at label depth, stopped, ends in last whatever labels come before.
+ */
+struct e_etn_cursor_s {
+    e_etn_t         *etn;
+    bool            sorted;
+    bool            stopped;
+    uint32_t        depth;
+    uint16_t        tld_back;
+    size_t          len;
+    e_etn_frame_t   last;
+    char            prev[E_ETN_DOMAIN_MAX];     /* the previous domain folded to lower case, right aligned */
+    e_etn_frame_t   frames[E_ETN_CURSOR_DEPTH];
+};
+
 struct e_etn_s {
     uint32_t            nodes_bits_children;
     uint32_t            nodes_bits_ICANN;
@@ -75,32 +286,275 @@ struct e_etn_s {
     uint32_t            *nodes;
     uint32_t            children_length;
     uint32_t            *children;
+    bool                wide;
+    uint64_t            *nodes_wide;
+    uint64_t            *children_wide;
+    void                *map;
+    size_t              map_length;
+    bool                borrowed;       /* the tables are the library's data or someone's mapping */
+    uint32_t            root_buckets;
+    uint32_t            *root_disp;
+    uint32_t            *root_table;
+    uint32_t            bloom_blocks;
+    uint64_t            *bloom;
+    e_etn_engine_t      engine;
+    e_etn_key_t         *keys;
+    e_etn_dfa_t         *dfa;
+    const uint32_t      *metadata;      /* a word per node, metadata_buf or in the mapping */
+    uint32_t            *metadata_buf;
+    e_etn_stacked_t     *stacked;       /* a stack has no tables of its own, it walks these */
+    uint32_t            num_stacked;
+    uint64_t            serial;
     e_atomic_refcount_t ref_count;
 };
 
+/* every table gets its own serial, a pointer can be reused after a free */
+static e_atomic_uint_t e_etn_serials;
+
+static inline void e_etn_lookup_finish(const char *domain, size_t len, size_t end, e_etn_walk_t *w, e_etn_result_t *result);
+static inline e_errno_t e_etn_lookup_stack(e_etn_t *etn, const char *domain, size_t len, size_t end, e_etn_result_t *result);
+static inline void e_etn_walk_stack(e_etn_t *etn, const char **labels, const uint8_t *lens, uint32_t n, e_etn_walk_t *w);
+static inline void e_etn_walks_init(e_etn_t *etn, e_etn_walks_t *ws);
+static inline void e_etn_walks_step(e_etn_t *etn, e_etn_walks_t *ws, const char *label, size_t len, uint32_t d);
+static inline void e_etn_walks_merge(e_etn_t *etn, const e_etn_walks_t *ws, uint32_t n, e_etn_walk_t *w);
+static inline e_errno_t e_etn_split_labels(const char *name, size_t *len, const char **labels, uint8_t *lens, uint32_t *n);
+static inline uint32_t e_etn_shared_labels(const char **a, const uint8_t *a_lens, uint32_t a_n, const char **b, const uint8_t *b_lens, uint32_t b_n);
+static inline bool e_etn_is_ip(const char *host, size_t len, const char *last, size_t last_len);
 static inline e_errno_t e_etn_load_file(e_etn_t *etn, const char *filename);
+static inline e_errno_t e_etn_map_file(e_etn_t *etn, const char *filename);
+static inline e_errno_t e_etn_check_bits(e_etn_t *etn);
+static inline e_etn_t *e_etn_init(void);
+static inline e_etn_t *e_etn_finish(e_etn_t *etn, e_errno_t err);
+static inline e_errno_t e_etn_validate(e_etn_t *etn);
+static inline e_errno_t e_etn_read_wide(e_etn_t *etn, FILE *fp);
+static inline e_errno_t e_etn_read_metadata(e_etn_t *etn, FILE *fp);
+static inline e_errno_t e_etn_write_metadata(e_etn_t *etn, FILE *fp);
+static inline uint32_t e_etn_metadata(e_etn_t *etn, uint32_t id);
+static inline uint32_t e_etn_find_node(e_etn_t *etn, const char *name, size_t len);
+static inline void e_etn_copy_range(e_etn_t *dst, e_etn_t *src, uint32_t dst_lo, uint32_t dst_hi, uint32_t src_lo, uint32_t src_hi);
+static inline e_errno_t e_etn_narrow(e_etn_t *etn);
+static inline e_errno_t e_etn_load_builtin(e_etn_t *etn);
+static inline e_errno_t e_etn_load_psl(e_etn_t *etn, const char *psl, size_t len);
+static inline e_errno_t e_etn_take_tables(e_etn_t *etn, e_etn_tables_t *tables);
+static inline e_errno_t e_etn_set_view(e_etn_t *etn, const e_etn_view_t *view);
+static inline void e_etn_set_header(e_etn_t *etn, const uint32_t *words);
+static inline void e_etn_get_header(e_etn_t *etn, uint32_t *words);
+static inline e_errno_t e_etn_save_v1(e_etn_t *etn, FILE *fp);
+static inline e_errno_t e_etn_save_v2(e_etn_t *etn, FILE *fp);
+static inline e_errno_t e_etn_save_wide(e_etn_t *etn, FILE *fp);
+static inline e_errno_t e_etn_write_words(FILE *fp, const uint32_t *words, size_t n, bool big_endian);
+static inline e_errno_t e_etn_write_pad(FILE *fp, size_t n);
+static inline e_errno_t e_etn_root_build(e_etn_t *etn);
+static inline bool e_etn_root_try(e_etn_t *etn, const uint64_t *hashes, uint32_t *order, uint8_t *used);
+static inline uint64_t e_etn_root_hash(const char *label, size_t len);
+static inline uint32_t e_etn_root_slot(uint64_t h, uint32_t disp, uint32_t n);
+static inline uint32_t e_etn_find_root(e_etn_t *etn, const char *label, size_t label_len, bool wide) E_ALWAYS_INLINE;
+static inline e_errno_t e_etn_bloom_build(e_etn_t *etn);
+static inline uint64_t e_etn_hash(const char *s, size_t len, uint32_t seed) E_ALWAYS_INLINE;
+static inline uint64_t e_etn_hash_init(uint32_t seed) E_ALWAYS_INLINE;
+static inline uint64_t e_etn_hash_update(uint64_t h, const char *s, size_t len) E_ALWAYS_INLINE;
+static inline uint64_t e_etn_hash_final(uint64_t h) E_ALWAYS_INLINE;
+static inline uint64_t e_etn_hash_labels(const char *domain, size_t start, size_t end);
+static inline void e_etn_walk_hash(const char *domain, size_t end, e_etn_walk_t *w);
+static inline uint64_t e_etn_hash_fold(uint64_t w) E_ALWAYS_INLINE;
+static inline bool e_etn_bloom_check(e_etn_t *etn, const char *label, size_t len, uint32_t lo);
+static inline e_errno_t e_etn_inline_build(e_etn_t *etn);
+static inline e_errno_t e_etn_inline_range(e_etn_t *etn, uint32_t lo, uint32_t hi, uint32_t *owner, e_etn_key_t *tmp);
+static inline void e_etn_inline_fill(e_etn_key_t *dst, uint32_t k, uint32_t i, const e_etn_key_t *src, uint32_t *next);
+static inline uint64_t e_etn_inline_prefix(const char *label, size_t len);
+static inline int e_etn_inline_cmp(e_etn_t *etn, const e_etn_key_t *key, uint64_t prefix, const char *label, size_t label_len);
+static inline uint32_t e_etn_find_inline(e_etn_t *etn, const char *label, size_t label_len, uint32_t lo, uint32_t hi);
+static inline void e_etn_walk_search(e_etn_t *etn, const char *domain, size_t end, e_etn_walk_t *w, bool wide) E_ALWAYS_INLINE;
+static inline void e_etn_walk_dfa(e_etn_dfa_t *dfa, const char *domain, size_t end, e_etn_walk_t *w);
+static inline e_errno_t e_etn_wire_labels(const uint8_t *msg, size_t msg_len, size_t name_off, uint16_t *offs, uint32_t *n, size_t *wire_len);
+static inline void e_etn_walk_wire(e_etn_t *etn, const uint8_t *msg, const uint16_t *offs, uint32_t n, e_etn_wire_result_t *result, bool wide) E_ALWAYS_INLINE;
+static inline e_errno_t e_etn_iov_labels(const struct iovec *iov, int iovcnt, char *scratch, const char **labels, uint8_t *lens, uint16_t *starts, uint32_t *n, size_t *len);
+static inline void e_etn_iov_position(const struct iovec *iov, int iovcnt, size_t pos, int *seg, size_t *off);
+static inline void e_etn_walk_iov(e_etn_t *etn, const char **labels, const uint8_t *lens, uint32_t n, e_etn_iov_result_t *result, bool wide) E_ALWAYS_INLINE;
+static inline uint32_t e_etn_parent(e_etn_t *etn, uint32_t id, bool wide);
+static inline void e_etn_walk_cursor(e_etn_cursor_t *cursor, const char *domain, size_t end, e_etn_walk_t *w, bool wide) E_ALWAYS_INLINE;
+static inline void e_etn_cursor_frame(e_etn_frame_t *frame, const e_etn_walk_t *w, size_t end, size_t pos_back, uint32_t lo, uint32_t hi, bool wildcard);
+static inline void e_etn_cursor_restore(const e_etn_frame_t *frame, e_etn_walk_t *w, size_t end);
+static inline e_errno_t e_etn_dfa_build(e_etn_t *etn);
+static inline void e_etn_dfa_free(e_etn_dfa_t *dfa);
+static inline uint32_t e_etn_dfa_children(e_etn_dfa_builder_t *b, uint32_t node, uint64_t h);
+static inline uint32_t e_etn_dfa_trie(e_etn_dfa_builder_t *b, uint32_t *items, uint32_t n, size_t k, bool wildcard, uint64_t h);
+static inline uint32_t e_etn_dfa_state(e_etn_dfa_builder_t *b, uint8_t info, const uint32_t *row);
+static inline bool e_etn_dfa_id_add(e_etn_dfa_t *dfa, uint64_t h, uint32_t node);
+static inline uint32_t e_etn_dfa_id(const e_etn_dfa_t *dfa, uint64_t h);
 static inline int e_etn_strncmp(const char *s1, size_t s1_len, const char *s2, size_t s2_len);
-static inline uint32_t e_etn_find(e_etn_t *etn, const char *label, uint32_t lo, uint32_t hi);
-static inline const char *e_etn_node_label(e_etn_t *etn, uint32_t i, size_t *len);
+static inline uint32_t e_etn_find(e_etn_t *etn, const char *label, size_t label_len, uint32_t lo, uint32_t hi, bool wide) E_ALWAYS_INLINE;
+static inline uint32_t e_etn_find_range(e_etn_t *etn, const char *label, size_t label_len, uint32_t lo, uint32_t hi, bool wide) E_ALWAYS_INLINE;
+static inline uint32_t e_etn_find_after(e_etn_t *etn, const char *label, size_t label_len, uint32_t lo, uint32_t hi, uint32_t from, bool wide);
+static inline const char *e_etn_node_label(e_etn_t *etn, uint32_t i, size_t *len, bool wide) E_ALWAYS_INLINE;
+static inline uint32_t e_etn_node_children(e_etn_t *etn, uint32_t i, bool *icann, bool wide) E_ALWAYS_INLINE;
+static inline void e_etn_children_decode(e_etn_t *etn, uint32_t i, uint32_t *lo, uint32_t *hi, uint32_t *type, bool *wildcard, bool wide) E_ALWAYS_INLINE;
 
 e_etn_t *e_etn_new(const char *filename) {
     e_etn_t     *etn;
-    e_errno_t   err;
 
-    etn = e_calloc(1, sizeof(e_etn_t));
+    etn = e_etn_init();
     if(E_UNLIKELY(!etn)) {
         return NULL;
     }//end if
-    e_atomic_refcount_init(&(etn->ref_count));
 
-    err = e_etn_load_file(etn, filename);
-    if(E_UNLIKELY(err != E_OK)) {
-        e_etn_free(etn);
+    return e_etn_finish(etn, e_etn_load_file(etn, filename));
+}//end e_etn_new
+
+e_etn_t *e_etn_new_mmap(const char *filename) {
+    e_etn_t     *etn;
+
+    etn = e_etn_init();
+    if(E_UNLIKELY(!etn)) {
+        return NULL;
+    }//end if
+
+    return e_etn_finish(etn, e_etn_map_file(etn, filename));
+}//end e_etn_new_mmap
+
+e_etn_t *e_etn_new_builtin(void) {
+    e_etn_t     *etn;
+
+    etn = e_etn_init();
+    if(E_UNLIKELY(!etn)) {
         return NULL;
     }//end if
 
+    return e_etn_finish(etn, e_etn_load_builtin(etn));
+}//end e_etn_new_builtin
+
+e_etn_t *e_etn_new_from_psl(const char *filename) {
+    int         fd;
+    void        *map;
+    e_etn_t     *etn;
+    struct stat st;
+
+    fd = open(filename, O_RDONLY);
+    if(fd == -1) {
+        return NULL;
+    }//end if
+
+    if(E_UNLIKELY(fstat(fd, &st) == -1 || st.st_size == 0)) {
+        close(fd);
+        return NULL;
+    }//end if
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(E_UNLIKELY(map == MAP_FAILED)) {
+        return NULL;
+    }//end if
+
+    etn = e_etn_new_from_psl_buffer((const char *)map, (size_t)st.st_size);
+    munmap(map, (size_t)st.st_size);
+
     return etn;
-}//end e_etn_new
+}//end e_etn_new_from_psl
+
+e_etn_t *e_etn_new_from_psl_buffer(const char *psl, size_t len) {
+    e_etn_t     *etn;
+
+    etn = e_etn_init();
+    if(E_UNLIKELY(!etn)) {
+        return NULL;
+    }//end if
+
+    return e_etn_finish(etn, e_etn_load_psl(etn, psl, len));
+}//end e_etn_new_from_psl_buffer
+
+e_etn_t *e_etn_new_stack(e_etn_t *base, const e_etn_layer_t *layers, size_t n) {
+    size_t          i, num;
+    uint64_t        id_off;
+    e_etn_t         *etn;
+    e_etn_stacked_t *stacked;
+
+    /* the layers of a stack go on top of those it has */
+    num = base->stacked ? base->num_stacked : 1;
+    if(E_UNLIKELY(n > E_ETN_STACK_MAX - num)) {
+        return NULL;
+    }//end if
+    for(i = 0 ; i < n ; i++) {
+        if(E_UNLIKELY(!layers[i].etn || layers[i].etn->stacked)) {
+            return NULL;
+        }//end if
+    }//end for
+
+    etn = e_etn_init();
+    if(E_UNLIKELY(!etn)) {
+        return NULL;
+    }//end if
+    stacked = e_calloc(num + n, sizeof(e_etn_stacked_t));
+    if(E_UNLIKELY(!stacked)) {
+        e_free(etn);
+        return NULL;
+    }//end if
+
+    if(base->stacked) {
+        memcpy(stacked, base->stacked, num * sizeof(e_etn_stacked_t));
+    }//end if
+    else {
+        stacked[0].etn = base;
+    }//end else
+    for(i = 0 ; i < n ; i++) {
+        stacked[num + i].etn = layers[i].etn;
+        stacked[num + i].priority = layers[i].priority;
+        stacked[num + i].icann = layers[i].icann;
+    }//end for
+
+    /* suffix ids of every table get a range of their own */
+    for(i = 0, id_off = 0 ; i < num + n ; i++) {
+        if(E_UNLIKELY(id_off + stacked[i].etn->nodes_length >= E_ETN_SUFFIX_NONE)) {
+            e_free(stacked);
+            e_free(etn);
+            return NULL;
+        }//end if
+        stacked[i].id_off = (uint32_t)id_off;
+        id_off += stacked[i].etn->nodes_length;
+    }//end for
+
+    for(i = 0 ; i < num + n ; i++) {
+        e_etn_ref(stacked[i].etn);
+    }//end for
+    etn->stacked = stacked;
+    etn->num_stacked = (uint32_t)(num + n);
+    etn->engine = stacked[0].etn->engine;
+
+    return etn;
+}//end e_etn_new_stack
+
+e_etn_t *e_etn_new_tables(e_etn_tables_t *tables) {
+    e_etn_t     *etn;
+
+    etn = e_etn_init();
+    if(E_UNLIKELY(!etn)) {
+        e_etn_free_tables(tables);
+        return NULL;
+    }//end if
+
+    return e_etn_finish(etn, e_etn_take_tables(etn, tables));
+}//end e_etn_new_tables
+
+e_etn_t *e_etn_new_view(const e_etn_view_t *view) {
+    e_etn_t     *etn;
+
+    etn = e_etn_init();
+    if(E_UNLIKELY(!etn)) {
+        return NULL;
+    }//end if
+
+    return e_etn_finish(etn, e_etn_set_view(etn, view));
+}//end e_etn_new_view
+
+void e_etn_get_view(e_etn_t *etn, e_etn_view_t *view) {
+    e_etn_get_header(etn, view->header);
+    view->wide = etn->wide;
+    view->text = etn->text;
+    view->text_length = etn->text_length;
+    view->nodes = etn->wide ? (const void *)etn->nodes_wide : (const void *)etn->nodes;
+    view->nodes_length = etn->nodes_length;
+    view->children = etn->wide ? (const void *)etn->children_wide : (const void *)etn->children;
+    view->children_length = etn->children_length;
+}//end e_etn_get_view
 
 void e_etn_free(e_etn_t *etn) {
     e_etn_unref(etn);
@@ -112,7 +566,48 @@ e_etn_t *e_etn_ref(e_etn_t *etn) {
 }//end e_etn_ref
 
 void e_etn_unref(e_etn_t *etn) {
+    uint32_t i;
+
     if(E_LIKELY(etn) && e_atomic_refcount_dec(&(etn->ref_count))) {
+        if(etn->stacked) {
+            for(i = 0 ; i < etn->num_stacked ; i++) {
+                e_etn_unref(etn->stacked[i].etn);
+            }//end for
+            e_free(etn->stacked);
+            e_free(etn);
+            return;
+        }//end if
+        if(etn->metadata_buf) {
+            e_free(etn->metadata_buf);
+        }//end if
+        if(etn->root_disp) {
+            e_free(etn->root_disp);
+        }//end if
+        if(etn->bloom) {
+            e_free(etn->bloom);
+        }//end if
+        if(etn->keys) {
+            e_free(etn->keys);
+        }//end if
+        if(etn->dfa) {
+            e_etn_dfa_free(etn->dfa);
+        }//end if
+        if(etn->map) {
+            /* text, nodes and children point into the mapping */
+            munmap(etn->map, etn->map_length);
+            e_free(etn);
+            return;
+        }//end if
+        if(etn->borrowed) {
+            e_free(etn);
+            return;
+        }//end if
+        if(etn->children_wide) {
+            e_free(etn->children_wide);
+        }//end if
+        if(etn->nodes_wide) {
+            e_free(etn->nodes_wide);
+        }//end if
         if(E_LIKELY(etn->children)) {
             e_free(etn->children);
         }//end if
@@ -126,287 +621,3171 @@ void e_etn_unref(e_etn_t *etn) {
     }//end if
 }//end e_etn_unref
 
-void e_etn_public_suffix(e_etn_t *etn, const char *domain, const char **ps, bool *icann) {
-    char        *s, *tmp;
-    bool        wildcard;
-    size_t      suffix, len;
-    ssize_t     dot;
-    uint32_t    lo, hi, f, u, type;
+e_errno_t e_etn_set_engine(e_etn_t *etn, e_etn_engine_t engine) {
+    e_errno_t err;
 
-    suffix = len = strlen(domain);
-    if(E_UNLIKELY(len > E_ETN_DOMAIN_MAX)) {
-        return;
+    /* the tables of a stack may be shared, each keeps the engine it has */
+    if(E_UNLIKELY(etn->stacked)) {
+        return E_ERR_NOTSUP;
     }//end if
 
-    s = e_strndupa(domain, len);
-    lo = 0;
-    hi = etn->num_TLD;
-    wildcard = false;
-
-    while(true) {
-        tmp = strrchr(s, '.');
-        dot = tmp ? tmp - s : -1;
+    if(engine == etn->engine) {
+        return E_OK;
+    }//end if
 
-        if(wildcard) {
-            suffix = 1 + dot;
-        }//end if
-        if(lo == hi) {
+    switch(engine) {
+        case E_ETN_ENGINE_SEARCH:
             break;
-        }//end if
-
-        f = e_etn_find(etn, s + 1 + dot, lo, hi);
-        if(f == E_ETN_NOT_FOUND) {
+        case E_ETN_ENGINE_INLINE:
+            err = e_etn_inline_build(etn);
+            if(E_UNLIKELY(err != E_OK)) {
+                return err;
+            }//end if
             break;
-        }//end if
+        case E_ETN_ENGINE_DFA:
+            err = e_etn_dfa_build(etn);
+            if(E_UNLIKELY(err != E_OK)) {
+                return err;
+            }//end if
+            break;
+        default:
+            return E_ERR_INVAL;
+    }//end switch
+
+    /* drop what the previous engine built */
+    if(etn->keys && engine != E_ETN_ENGINE_INLINE) {
+        e_free(etn->keys);
+        etn->keys = NULL;
+    }//end if
+    if(etn->dfa && engine != E_ETN_ENGINE_DFA) {
+        e_etn_dfa_free(etn->dfa);
+        etn->dfa = NULL;
+    }//end if
+    etn->engine = engine;
 
-        u = etn->nodes[f] >> (etn->nodes_bits_text_offset + etn->nodes_bits_text_length);
-        *icann = (u & ((1 << etn->nodes_bits_ICANN) - 1)) != 0 ? true : false;
-        u >>= etn->nodes_bits_ICANN;
-        u = etn->children[u & ((1 << etn->nodes_bits_children) - 1)];
-        lo = u & ((1 << etn->children_bits_lo) - 1);
-        u >>= etn->children_bits_lo;
-        hi = u & ((1 << etn->children_bits_hi) - 1);
-        u >>= etn->children_bits_hi;
+    return E_OK;
+}//end e_etn_set_engine
 
-        type = u & ((1 << etn->children_bits_node_type) - 1);
-        if(type == etn->node_type_normal) {
-            suffix = 1 + dot;
-        }//end if
-        else if(type == etn->node_type_exception) {
-            suffix = 1 + strlen(s);
-            break;
-        }//end if
+e_etn_engine_t e_etn_get_engine(e_etn_t *etn) {
+    return etn->engine;
+}//end e_etn_get_engine
 
-        u >>= etn->children_bits_node_type;
-        wildcard = (u & ((1 << etn->children_bits_wildcard) - 1)) != 0 ? true : false;
+uint64_t e_etn_get_serial(e_etn_t *etn) {
+    return etn->serial;
+}//end e_etn_get_serial
 
-        if(dot == -1) {
-            break;
-        }//end if
-        s[dot] = '\0';
-    }//end while
+e_errno_t e_etn_set_metadata(e_etn_t *etn, const char *suffix, size_t len, uint32_t metadata) {
+    uint32_t    i, id;
+    uint32_t    *buf;
 
-    if(suffix == len) {
-        /* if no rules match, the prevailing rule is "*" */
-        tmp = strrchr(domain, '.');
-        *ps = tmp ? domain + 1 + (tmp - domain) : domain;
-        return;
+    if(E_UNLIKELY(etn->stacked)) {
+        return E_ERR_NOTSUP;
     }//end if
 
-    *ps = domain + suffix;
-}//end e_etn_public_suffix
+    id = e_etn_find_node(etn, suffix, len);
+    if(id == E_ETN_NOT_FOUND) {
+        return E_ERR_NOFOUND;
+    }//end if
 
-void e_etn_eTLD_plus_one(e_etn_t *etn, const char *domain, const char **eTLD) {
-    bool        icann;
-    char        *s, *tmp;
-    size_t      domain_len, suffix_len, i;
-    const char  *suffix;
+    /* words of a mapped file are copied before the first change */
+    if(!etn->metadata_buf) {
+        buf = e_calloc(etn->nodes_length, sizeof(uint32_t));
+        if(E_UNLIKELY(!buf)) {
+            return E_ERR_FAMEM;
+        }//end if
+        for(i = 0 ; etn->metadata && i < etn->nodes_length ; i++) {
+            buf[i] = etn->metadata[i];
+        }//end for
+        etn->metadata_buf = buf;
+        etn->metadata = buf;
+    }//end if
+    etn->metadata_buf[id] = metadata;
 
-    e_etn_public_suffix(etn, domain, &suffix, &icann);
+    /* results cached by the serial no longer hold */
+    etn->serial = e_atomic_inc(&e_etn_serials) + 1;
 
-    domain_len = strlen(domain);
-    suffix_len = strlen(suffix);
+    return E_OK;
+}//end e_etn_set_metadata
 
-    if(E_UNLIKELY(domain_len <= suffix_len)) {
-        *eTLD = "";
-        return;
-    }//end if
+e_errno_t e_etn_copy_metadata(e_etn_t *dst, e_etn_t *src) {
+    uint32_t i, *buf;
 
-    i = domain_len - suffix_len - 1;
-    if(domain[i] != '.') {
-        *eTLD = "";
-        return;
+    /* the words of a stack are in its tables, it has none of its own to give */
+    if(E_UNLIKELY(dst->stacked)) {
+        return E_ERR_NOTSUP;
+    }//end if
+    if(src->stacked || !src->metadata) {
+        return E_OK;
     }//end if
 
-    s = e_strndupa(domain, domain_len);
-    s[i] = '\0';
-    tmp = strrchr(s, '.');
+    if(!dst->metadata_buf) {
+        buf = e_calloc(dst->nodes_length, sizeof(uint32_t));
+        if(E_UNLIKELY(!buf)) {
+            return E_ERR_FAMEM;
+        }//end if
+        for(i = 0 ; dst->metadata && i < dst->nodes_length ; i++) {
+            buf[i] = dst->metadata[i];
+        }//end for
+        dst->metadata_buf = buf;
+        dst->metadata = buf;
+    }//end if
 
-    *eTLD = tmp ? domain + 1 + (tmp - s) : domain;
-}//end e_etn_eTLD_plus_one
+    /* node ids differ between the tables, both are walked down from their TLDs together */
+    e_etn_copy_range(dst, src, 0, dst->num_TLD, 0, src->num_TLD);
+    dst->serial = e_atomic_inc(&e_etn_serials) + 1;
 
+    return E_OK;
+}//end e_etn_copy_metadata
 
-/* ===== private function ===== */
-static inline e_errno_t e_etn_load_file(e_etn_t *etn, const char *filename) {
-    FILE        *fp;
-    off_t       off;
-    size_t      nread, i;
-    uint8_t     buf[4096];
-    uint32_t    magic;
+e_errno_t e_etn_suffix_name(e_etn_t *etn, uint32_t id, char *buf, size_t size) {
+    size_t      len, off;
+    uint32_t    i;
+    const char  *s;
 
-    fp = fopen(filename, "rb");
-    if(!fp) {
-        return E_ERR_INVAL;
+    /* the id is in the range of one table of a stack */
+    if(etn->stacked) {
+        for(i = etn->num_stacked ; i > 0 ; i--) {
+            if(id >= etn->stacked[i - 1].id_off) {
+                return e_etn_suffix_name(etn->stacked[i - 1].etn, id - etn->stacked[i - 1].id_off, buf, size);
+            }//end if
+        }//end for
     }//end if
 
-    memset(buf, 0, sizeof(buf));
-    off = 0;
-    nread = fread(buf, sizeof(uint32_t), 14, fp);
-    if(nread != 14) {
-        fclose(fp);
+    if(E_UNLIKELY(id >= etn->nodes_length || size == 0)) {
         return E_ERR_INVAL;
     }//end if
 
-    /* check magic number */
-    magic = E_ETN_GET_UINT32(buf, off);
-    if(magic != E_ETN_MAGIC) {
-        fclose(fp);
-        return E_ERR_INVAL;
-    }//end if
+    /* labels from id up to its TLD are the name from left to right */
+    for(off = 0 ; id != E_ETN_NOT_FOUND ; ) {
+        s = e_etn_node_label(etn, id, &len, etn->wide);
+        if(E_UNLIKELY(off + len + 1 > size)) {
+            return E_ERR_NOBUFS;
+        }//end if
+        if(off > 0) {
+            buf[off - 1] = '.';
+        }//end if
+        memcpy(buf + off, s, len);
+        off += len + 1;
+        id = id < etn->num_TLD ? E_ETN_NOT_FOUND : e_etn_parent(etn, id, etn->wide);
+    }//end for
+    buf[off - 1] = '\0';
 
-    /* start to read simple integer part */
-    etn->nodes_bits_children = E_ETN_GET_UINT32(buf, off);
-    etn->nodes_bits_ICANN = E_ETN_GET_UINT32(buf, off);
-    etn->nodes_bits_text_offset = E_ETN_GET_UINT32(buf, off);
-    etn->nodes_bits_text_length = E_ETN_GET_UINT32(buf, off);
-    etn->children_bits_wildcard = E_ETN_GET_UINT32(buf, off);
-    etn->children_bits_node_type = E_ETN_GET_UINT32(buf, off);
-    etn->children_bits_hi = E_ETN_GET_UINT32(buf, off);
-    etn->children_bits_lo = E_ETN_GET_UINT32(buf, off);
-    etn->node_type_normal = E_ETN_GET_UINT32(buf, off);
-    etn->node_type_exception = E_ETN_GET_UINT32(buf, off);
-    etn->node_type_parent_only = E_ETN_GET_UINT32(buf, off);
-    etn->num_TLD = E_ETN_GET_UINT32(buf, off);
+    return E_OK;
+}//end e_etn_suffix_name
 
-    /* check */
-    if(E_UNLIKELY(etn->nodes_bits_text_length + etn->nodes_bits_text_offset + etn->nodes_bits_ICANN + etn->nodes_bits_children > 32)) {
-        fclose(fp);
+e_errno_t e_etn_save(e_etn_t *etn, const char *filename, e_etn_format_t format) {
+    FILE        *fp;
+    char        *tmp;
+    e_errno_t   err;
+
+    if(E_UNLIKELY(format != E_ETN_FORMAT_V1 && format != E_ETN_FORMAT_V2 && format != E_ETN_FORMAT_WIDE)) {
         return E_ERR_INVAL;
     }//end if
 
-    if(E_UNLIKELY(etn->children_bits_lo + etn->children_bits_hi + etn->children_bits_node_type + etn->children_bits_wildcard > 32)) {
-        fclose(fp);
-        return E_ERR_INVAL;
+    /* tables past the narrow widths only fit the wide format, a stack has none of its own */
+    if(E_UNLIKELY((etn->wide && format != E_ETN_FORMAT_WIDE) || etn->stacked)) {
+        return E_ERR_NOTSUP;
     }//end if
 
-    if(E_UNLIKELY(etn->nodes_bits_children != 10 ||
-        etn->nodes_bits_ICANN != 1 ||
-        etn->nodes_bits_text_offset != 15 ||
-        etn->nodes_bits_text_length != 6 ||
-        etn->children_bits_wildcard != 1 ||
-        etn->children_bits_node_type != 2 ||
-        etn->children_bits_hi != 14 ||
-        etn->children_bits_lo != 14||
-        etn->node_type_normal != 0 ||
-        etn->node_type_exception != 1 ||
-        etn->node_type_parent_only != 2)) {
-        fclose(fp);
-        return E_ERR_INVAL;
+    err = e_etn_save_begin(filename, &fp, &tmp);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
     }//end if
 
-    /* read text */
-    etn->text_length = E_ETN_GET_UINT32(buf, off);
-    if(E_UNLIKELY(etn->text_length == 0)) {
-        fclose(fp);
-        return E_ERR_INVAL;
+    if(format == E_ETN_FORMAT_V1) {
+        err = e_etn_save_v1(etn, fp);
     }//end if
+    else if(format == E_ETN_FORMAT_V2) {
+        err = e_etn_save_v2(etn, fp);
+    }//end if
+    else {
+        err = e_etn_save_wide(etn, fp);
+    }//end else
 
-    etn->text = e_malloc(etn->text_length + 1);
-    if(E_UNLIKELY(!etn->text)) {
-        fclose(fp);
+    return e_etn_save_end(filename, fp, tmp, err);
+}//end e_etn_save
+
+e_errno_t e_etn_save_begin(const char *filename, FILE **fp, char **tmp) {
+    int     fd;
+    size_t  len;
+
+    /* written aside and renamed over, a mapping of the old file stays valid */
+    len = strlen(filename);
+    *tmp = e_malloc(len + sizeof(".XXXXXX"));
+    if(E_UNLIKELY(!*tmp)) {
         return E_ERR_FAMEM;
     }//end if
-    nread = fread(etn->text, sizeof(char), etn->text_length, fp);
-    if(E_UNLIKELY(nread != etn->text_length)) {
-        fclose(fp);
+    memcpy(*tmp, filename, len);
+    memcpy(*tmp + len, ".XXXXXX", sizeof(".XXXXXX"));
+
+    fd = mkstemp(*tmp);
+    if(fd == -1) {
+        e_free(*tmp);
         return E_ERR_C_ERR;
     }//end if
-    etn->text[etn->text_length] = '\0';
-    off += etn->text_length;
 
-    /* read node */
-    memset(buf, 0, sizeof(buf));
-    nread = fread(buf, sizeof(uint32_t), 1, fp);
-    if(nread != 1) {
-        fclose(fp);
-        return E_ERR_INVAL;
+    *fp = fdopen(fd, "wb");
+    if(E_UNLIKELY(!*fp)) {
+        close(fd);
+        unlink(*tmp);
+        e_free(*tmp);
+        return E_ERR_C_ERR;
     }//end if
-    off = 0;
 
-    etn->nodes_length = E_ETN_GET_UINT32(buf, off);
-    if(E_UNLIKELY(etn->nodes_length == 0)) {
-        fclose(fp);
-        return E_ERR_INVAL;
-    }//end if
+    return E_OK;
+}//end e_etn_save_begin
 
-    etn->nodes = e_malloc(etn->nodes_length * sizeof(uint32_t));
-    if(E_UNLIKELY(!etn->nodes)) {
-        fclose(fp);
-        return E_ERR_FAMEM;
+e_errno_t e_etn_save_end(const char *filename, FILE *fp, char *tmp, e_errno_t err) {
+    if(err == E_OK && fchmod(fileno(fp), 0644) == -1) {
+        err = E_ERR_C_ERR;
     }//end if
-
-    nread = fread(etn->nodes, sizeof(uint32_t), etn->nodes_length, fp);
-    if(nread != etn->nodes_length) {
-        fclose(fp);
-        return E_ERR_INVAL;
+    if(fclose(fp) != 0 && err == E_OK) {
+        err = E_ERR_C_ERR;
+    }//end if
+    if(err == E_OK && rename(tmp, filename) == -1) {
+        err = E_ERR_C_ERR;
+    }//end if
+    if(err != E_OK) {
+        unlink(tmp);
     }//end if
 
-    for(i = 0 ; i < nread ; i++) {
-        etn->nodes[i] = htonl(etn->nodes[i]);
-    }//end for
+    e_free(tmp);
+    return err;
+}//end e_etn_save_end
 
-    /* read children */
-    memset(buf, 0, sizeof(buf));
-    nread = fread(buf, sizeof(uint32_t), 1, fp);
-    if(nread != 1) {
+void e_etn_public_suffix(e_etn_t *etn, const char *domain, const char **ps, bool *icann) {
+    e_etn_result_t result;
+
+    if(E_UNLIKELY(e_etn_lookup(etn, domain, strlen(domain), &result) != E_OK)) {
+        return;
+    }//end if
+
+    *ps = domain + result.suffix_off;
+    *icann = result.icann;
+}//end e_etn_public_suffix
+
+void e_etn_eTLD_plus_one(e_etn_t *etn, const char *domain, const char **eTLD) {
+    size_t          len;
+    e_etn_result_t  result;
+
+    len = strlen(domain);
+    if(E_UNLIKELY(e_etn_lookup(etn, domain, len, &result) != E_OK)) {
+        return;
+    }//end if
+
+    *eTLD = result.registrable_off == len ? "" : domain + result.registrable_off;
+}//end e_etn_eTLD_plus_one
+
+bool e_etn_same_site(e_etn_t *etn, const char *a, size_t a_len, const char *b, size_t b_len) {
+    uint8_t         a_lens[E_ETN_DOMAIN_MAX + 1], b_lens[E_ETN_DOMAIN_MAX + 1];
+    uint32_t        a_n, b_n, m, d;
+    e_etn_walk_t    wa, wb;
+    e_etn_walks_t   ws, wt;
+    const char      *a_labels[E_ETN_DOMAIN_MAX + 1], *b_labels[E_ETN_DOMAIN_MAX + 1];
+
+    if(E_UNLIKELY(e_etn_split_labels(a, &a_len, a_labels, a_lens, &a_n) != E_OK ||
+        e_etn_split_labels(b, &b_len, b_labels, b_lens, &b_n) != E_OK)) {
+        return false;
+    }//end if
+
+    /* a host is its own site, whatever its suffix */
+    m = e_etn_shared_labels(a_labels, a_lens, a_n, b_labels, b_lens, b_n);
+    if(m == a_n && m == b_n) {
+        return true;
+    }//end if
+    if(m == 0) {
+        return false;
+    }//end if
+
+    /* the shared labels decide the suffix of both, unless the walk can go on past them */
+    e_etn_walks_init(etn, &ws);
+    for(d = 1 ; d <= m && ws.live > 0 ; d++) {
+        e_etn_walks_step(etn, &ws, a_labels[a_n - d], a_lens[a_n - d], d);
+    }//end for
+    if(ws.live == 0) {
+        e_etn_walks_merge(etn, &ws, m, &wa);
+        return wa.suffix_labels < m;
+    }//end if
+
+    /* each name goes on from there, the same eTLD+1 has to be within the shared labels */
+    wt.n = ws.n;
+    wt.live = ws.live;
+    memcpy(wt.walks, ws.walks, ws.n * sizeof(e_etn_layer_walk_t));
+    for(d = m + 1 ; d <= a_n && ws.live > 0 ; d++) {
+        e_etn_walks_step(etn, &ws, a_labels[a_n - d], a_lens[a_n - d], d);
+    }//end for
+    for(d = m + 1 ; d <= b_n && wt.live > 0 ; d++) {
+        e_etn_walks_step(etn, &wt, b_labels[b_n - d], b_lens[b_n - d], d);
+    }//end for
+    e_etn_walks_merge(etn, &ws, a_n, &wa);
+    e_etn_walks_merge(etn, &wt, b_n, &wb);
+
+    return wa.suffix_labels == wb.suffix_labels && wa.suffix_labels < m;
+}//end e_etn_same_site
+
+bool e_etn_cookie_domain_allowed(e_etn_t *etn, const char *host, size_t host_len, const char *domain, size_t domain_len) {
+    uint8_t         h_lens[E_ETN_DOMAIN_MAX + 1], d_lens[E_ETN_DOMAIN_MAX + 1];
+    uint32_t        h_n, d_n, d;
+    e_etn_walk_t    w;
+    e_etn_walks_t   ws;
+    const char      *h_labels[E_ETN_DOMAIN_MAX + 1], *d_labels[E_ETN_DOMAIN_MAX + 1];
+
+    /* RFC 6265 5.2.3, a leading dot is not part of the domain */
+    if(domain_len > 0 && domain[0] == '.') {
+        domain++;
+        domain_len--;
+    }//end if
+
+    if(E_UNLIKELY(e_etn_split_labels(host, &host_len, h_labels, h_lens, &h_n) != E_OK ||
+        e_etn_split_labels(domain, &domain_len, d_labels, d_lens, &d_n) != E_OK || domain_len == 0)) {
+        return false;
+    }//end if
+
+    /* 5.1.3, the host ends with every label of the domain and is not an IP address unless it is the domain */
+    if(e_etn_shared_labels(h_labels, h_lens, h_n, d_labels, d_lens, d_n) < d_n) {
+        return false;
+    }//end if
+    if(h_n == d_n) {
+        return true;
+    }//end if
+    if(e_etn_is_ip(host, host_len, h_labels[h_n - 1], h_lens[h_n - 1])) {
+        return false;
+    }//end if
+
+    /* 5.3 step 5, a public suffix is only the domain of the host itself */
+    e_etn_walks_init(etn, &ws);
+    for(d = 1 ; d <= d_n && ws.live > 0 ; d++) {
+        e_etn_walks_step(etn, &ws, d_labels[d_n - d], d_lens[d_n - d], d);
+    }//end for
+    e_etn_walks_merge(etn, &ws, d_n, &w);
+
+    return w.suffix_labels < d_n;
+}//end e_etn_cookie_domain_allowed
+
+e_errno_t e_etn_public_suffix_len(e_etn_t *etn, const char *domain, size_t len, size_t *suffix_off, bool *icann) {
+    e_errno_t       err;
+    e_etn_result_t  result;
+
+    err = e_etn_lookup(etn, domain, len, &result);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    *suffix_off = result.suffix_off;
+    *icann = result.icann;
+    return E_OK;
+}//end e_etn_public_suffix_len
+
+e_errno_t e_etn_lookup(e_etn_t *etn, const char *domain, size_t len, e_etn_result_t *result) {
+    size_t          end;
+    e_etn_walk_t    w;
+
+    if(E_UNLIKELY(len > E_ETN_DOMAIN_MAX)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    /* a trailing root dot is not part of any label */
+    end = len;
+    if(end > 0 && domain[end - 1] == '.') {
+        end--;
+    }//end if
+
+    if(E_UNLIKELY(etn->stacked)) {
+        return e_etn_lookup_stack(etn, domain, len, end, result);
+    }//end if
+
+    w.icann = false;
+    w.suffix = end;
+    w.suffix_labels = 0;
+    w.suffix_id = E_ETN_SUFFIX_NONE;
+    w.rule = E_ETN_RULE_DEFAULT;
+    w.tld = 0;
+    w.depth = 0;
+    if(etn->dfa) {
+        e_etn_walk_dfa(etn->dfa, domain, end, &w);
+    }//end if
+    else if(E_UNLIKELY(etn->wide)) {
+        e_etn_walk_search(etn, domain, end, &w, true);
+    }//end if
+    else {
+        e_etn_walk_search(etn, domain, end, &w, false);
+    }//end else
+
+    e_etn_lookup_finish(domain, len, end, &w, result);
+    result->metadata = etn->metadata && w.suffix_id != E_ETN_SUFFIX_NONE ? etn->metadata[w.suffix_id] : 0;
+    return E_OK;
+}//end e_etn_lookup
+
+e_errno_t e_etn_lookup_levels(e_etn_t *etn, const char *domain, size_t len, e_etn_result_t *result, e_etn_level_t *levels, size_t max, size_t *n) {
+    size_t          end;
+    uint8_t         lens[E_ETN_DOMAIN_MAX + 1];
+    uint32_t        m, d;
+    e_errno_t       err;
+    e_etn_walk_t    w;
+    e_etn_walks_t   ws;
+    e_etn_level_t   *level;
+    const char      *labels[E_ETN_DOMAIN_MAX + 1];
+
+    end = len;
+    err = e_etn_split_labels(domain, &end, labels, lens, &m);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    /* an empty name has no labels, as e_etn_lookup() counts them */
+    if(end == 0) {
+        *n = 0;
+        return e_etn_lookup(etn, domain, len, result);
+    }//end if
+    if(E_UNLIKELY(m > max)) {
+        return E_ERR_NOBUFS;
+    }//end if
+
+    /* every level is what a walk of its labels merges to, once no table can match more the rest get the same */
+    e_etn_walks_init(etn, &ws);
+    d = 0;
+    do {
+        d++;
+        if(ws.live > 0) {
+            e_etn_walks_step(etn, &ws, labels[m - d], lens[m - d], d);
+        }//end if
+        e_etn_walks_merge(etn, &ws, d, &w);
+        level = &(levels[d - 1]);
+        level->off = (size_t)(labels[m - d] - domain);
+        level->labels = d;
+        level->suffix_labels = w.suffix_labels;
+        level->suffix_id = w.suffix_id;
+        level->metadata = e_etn_metadata(etn, w.suffix_id);
+        level->icann = w.icann;
+        level->rule = w.rule;
+    } while(d < m);
+
+    /* the last level is the name, as e_etn_lookup_stack() finishes it */
+    w.depth = m;
+    w.start = 0;
+    w.tld = levels[0].off;
+    w.suffix = w.rule == E_ETN_RULE_DEFAULT ? end : (w.suffix_labels > 0 ? levels[w.suffix_labels - 1].off : end + 1);
+    e_etn_walk_hash(domain, end, &w);
+    e_etn_lookup_finish(domain, len, end, &w, result);
+    result->metadata = levels[m - 1].metadata;
+
+    for(d = 0 ; d < m ; d++) {
+        level = &(levels[d]);
+        if(level->off >= result->suffix_off) {
+            level->kind = E_ETN_LEVEL_SUFFIX;
+        }//end if
+        else if(level->off == result->registrable_off) {
+            level->kind = E_ETN_LEVEL_REGISTRABLE;
+        }//end if
+        else {
+            level->kind = E_ETN_LEVEL_DEEPER;
+        }//end else
+    }//end for
+    *n = m;
+
+    return E_OK;
+}//end e_etn_lookup_levels
+
+e_errno_t e_etn_public_suffix_wire(e_etn_t *etn, const uint8_t *msg, size_t msg_len, size_t name_off, e_etn_wire_result_t *result) {
+    size_t      wire_len;
+    uint8_t     lens[E_ETN_WIRE_LABELS + 1];
+    uint16_t    offs[E_ETN_WIRE_LABELS + 1];
+    uint32_t    n, i;
+    uint64_t    h;
+    e_errno_t   err;
+    e_etn_walk_t w;
+    const char  *labels[E_ETN_WIRE_LABELS + 1];
+
+    err = e_etn_wire_labels(msg, msg_len, name_off, offs, &n, &wire_len);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    /* the labels are matched where they are in the message, the DFA engine is not used */
+    if(E_UNLIKELY(etn->stacked)) {
+        for(i = 0 ; i < n ; i++) {
+            labels[i] = (const char *)msg + offs[i] + 1;
+            lens[i] = msg[offs[i]];
+        }//end for
+        e_etn_walk_stack(etn, labels, lens, n, &w);
+        result->suffix_labels = w.suffix_labels;
+        result->suffix_id = w.suffix_id;
+        result->rule = w.rule;
+        result->icann = w.icann;
+    }//end if
+    else if(E_UNLIKELY(etn->wide)) {
+        e_etn_walk_wire(etn, msg, offs, n, result, true);
+    }//end if
+    else {
+        e_etn_walk_wire(etn, msg, offs, n, result, false);
+    }//end else
+    result->wire_len = wire_len;
+    result->labels = n;
+    result->metadata = e_etn_metadata(etn, result->suffix_id);
+
+    /* the suffix and the eTLD+1 are the names that start at their first label */
+    result->suffix_label = n - result->suffix_labels;
+    result->suffix_off = offs[result->suffix_label];
+    if(result->suffix_label == 0 || result->suffix_labels == 0) {
+        result->registrable_label = n;
+        result->registrable_off = msg_len;
+        result->registrable_hash = 0;
+        return E_OK;
+    }//end if
+    result->registrable_label = result->suffix_label - 1;
+    result->registrable_off = offs[result->registrable_label];
+
+    /* the hash e_etn_lookup() gives for the same eTLD+1 in text, the labels are read where they are */
+    for(i = n, h = e_etn_hash_init(0) ; i > result->registrable_label ; i--) {
+        h = e_etn_hash_update(h, (const char *)msg + offs[i - 1] + 1, msg[offs[i - 1]]);
+    }//end for
+    result->registrable_hash = e_etn_hash_final(h);
+
+    return E_OK;
+}//end e_etn_public_suffix_wire
+
+e_errno_t e_etn_lookup_iov(e_etn_t *etn, const struct iovec *iov, int iovcnt, e_etn_iov_result_t *result) {
+    char        scratch[E_ETN_DOMAIN_MAX];
+    size_t      len;
+    uint8_t     lens[E_ETN_DOMAIN_MAX + 1];
+    uint16_t    starts[E_ETN_DOMAIN_MAX + 1];
+    uint32_t    n, i, first;
+    uint64_t    h;
+    e_errno_t   err;
+    e_etn_walk_t w;
+    const char  *labels[E_ETN_DOMAIN_MAX + 1];
+
+    err = e_etn_iov_labels(iov, iovcnt, scratch, labels, lens, starts, &n, &len);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    /* as a name in wire format, the DFA engine is not used */
+    if(E_UNLIKELY(etn->stacked)) {
+        e_etn_walk_stack(etn, labels, lens, n, &w);
+        result->suffix_labels = w.suffix_labels;
+        result->suffix_id = w.suffix_id;
+        result->rule = w.rule;
+        result->icann = w.icann;
+    }//end if
+    else if(E_UNLIKELY(etn->wide)) {
+        e_etn_walk_iov(etn, labels, lens, n, result, true);
+    }//end if
+    else {
+        e_etn_walk_iov(etn, labels, lens, n, result, false);
+    }//end else
+    result->len = len;
+    result->labels = n;
+    result->metadata = e_etn_metadata(etn, result->suffix_id);
+
+    /* starts[n] is where the labels end, at the root dot if there is one */
+    first = n - result->suffix_labels;
+    e_etn_iov_position(iov, iovcnt, starts[first], &result->suffix_seg, &result->suffix_off);
+    if(first == 0 || result->suffix_labels == 0) {
+        result->registrable_seg = iovcnt;
+        result->registrable_off = 0;
+        result->registrable_hash = 0;
+        return E_OK;
+    }//end if
+    e_etn_iov_position(iov, iovcnt, starts[first - 1], &result->registrable_seg, &result->registrable_off);
+
+    /* the hash e_etn_lookup() gives for the same eTLD+1 in one piece, fed from the segments */
+    for(i = n, h = e_etn_hash_init(0) ; i > first - 1 ; i--) {
+        h = e_etn_hash_update(h, labels[i - 1], lens[i - 1]);
+    }//end for
+    result->registrable_hash = e_etn_hash_final(h);
+
+    return E_OK;
+}//end e_etn_lookup_iov
+
+e_errno_t e_etn_public_suffix_batch(e_etn_t *etn, const char **domains, const size_t *lens, size_t n, size_t *suffix_offs, bool *icanns) {
+    size_t      i;
+    e_errno_t   err;
+
+    /* one lookup at a time, interleaving them never beat the engines' own walks */
+    for(i = 0, err = E_OK ; i < n ; i++) {
+        if(E_UNLIKELY(e_etn_public_suffix_len(etn, domains[i], lens[i], &suffix_offs[i], &icanns[i]) != E_OK)) {
+            suffix_offs[i] = lens[i];
+            icanns[i] = false;
+            err = E_ERR_INVAL;
+        }//end if
+    }//end for
+
+    return err;
+}//end e_etn_public_suffix_batch
+
+e_etn_cursor_t *e_etn_cursor_new(e_etn_t *etn, bool sorted) {
+    e_etn_cursor_t *cursor;
+
+    cursor = e_calloc(1, sizeof(e_etn_cursor_t));
+    if(E_UNLIKELY(!cursor)) {
+        return NULL;
+    }//end if
+    cursor->etn = e_etn_ref(etn);
+    cursor->sorted = sorted;
+
+    /* nothing walked yet, only the root can be resumed from */
+    cursor->frames[0].lo = 0;
+    cursor->frames[0].hi = etn->num_TLD;
+    cursor->frames[0].node = E_ETN_NOT_FOUND;
+    cursor->frames[0].suffix_id = E_ETN_SUFFIX_NONE;
+    cursor->frames[0].suffix_back = 1;
+
+    return cursor;
+}//end e_etn_cursor_new
+
+void e_etn_cursor_free(e_etn_cursor_t *cursor) {
+    if(E_LIKELY(cursor)) {
+        e_etn_unref(cursor->etn);
+        e_free(cursor);
+    }//end if
+}//end e_etn_cursor_free
+
+e_errno_t e_etn_cursor_lookup(e_etn_cursor_t *cursor, const char *domain, size_t len, e_etn_result_t *result) {
+    size_t          end;
+    e_etn_walk_t    w;
+
+    /* a stack has no frames to resume from */
+    if(E_UNLIKELY(cursor->etn->stacked)) {
+        return e_etn_lookup(cursor->etn, domain, len, result);
+    }//end if
+
+    if(E_UNLIKELY(len > E_ETN_DOMAIN_MAX)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    end = len;
+    if(end > 0 && domain[end - 1] == '.') {
+        end--;
+    }//end if
+
+    if(E_UNLIKELY(cursor->etn->wide)) {
+        e_etn_walk_cursor(cursor, domain, end, &w, true);
+    }//end if
+    else {
+        e_etn_walk_cursor(cursor, domain, end, &w, false);
+    }//end else
+
+    e_etn_walk_hash(domain, end, &w);
+    e_etn_lookup_finish(domain, len, end, &w, result);
+    result->metadata = e_etn_metadata(cursor->etn, w.suffix_id);
+    return E_OK;
+}//end e_etn_cursor_lookup
+
+
+
+/* ===== private function ===== */
+static inline e_etn_t *e_etn_init(void) {
+    e_etn_t *etn;
+
+    etn = e_calloc(1, sizeof(e_etn_t));
+    if(E_UNLIKELY(!etn)) {
+        return NULL;
+    }//end if
+    e_atomic_refcount_init(&(etn->ref_count));
+    etn->serial = e_atomic_inc(&e_etn_serials) + 1;
+
+    return etn;
+}//end e_etn_init
+
+/* err is what loading the tables returned, a table that failed to load is freed */
+static inline e_etn_t *e_etn_finish(e_etn_t *etn, e_errno_t err) {
+    if(E_UNLIKELY(err != E_OK)) {
+        e_etn_free(etn);
+        return NULL;
+    }//end if
+
+    err = e_etn_validate(etn);
+    if(E_UNLIKELY(err != E_OK)) {
+        e_etn_free(etn);
+        return NULL;
+    }//end if
+
+    err = e_etn_root_build(etn);
+    if(E_UNLIKELY(err != E_OK)) {
+        e_etn_free(etn);
+        return NULL;
+    }//end if
+
+    err = e_etn_bloom_build(etn);
+    if(E_UNLIKELY(err != E_OK)) {
+        e_etn_free(etn);
+        return NULL;
+    }//end if
+
+    return etn;
+}//end e_etn_finish
+
+/* the tables can come from a file or a mapping, every label and range must be in them before a lookup trusts it */
+static inline e_errno_t e_etn_validate(e_etn_t *etn) {
+    bool        icann, wildcard;
+    size_t      i, len;
+    uint32_t    u, lo, hi, type;
+    const char  *s;
+
+    for(i = 0 ; i < etn->nodes_length ; i++) {
+        s = e_etn_node_label(etn, i, &len, etn->wide);
+        if(E_UNLIKELY((size_t)(s - etn->text) + len > etn->text_length)) {
+            return E_ERR_INVAL;
+        }//end if
+        u = e_etn_node_children(etn, i, &icann, etn->wide);
+        if(E_UNLIKELY(u >= etn->children_length)) {
+            return E_ERR_INVAL;
+        }//end if
+    }//end for
+
+    for(i = 0 ; i < etn->children_length ; i++) {
+        e_etn_children_decode(etn, i, &lo, &hi, &type, &wildcard, etn->wide);
+        if(E_UNLIKELY(lo > hi || hi > etn->nodes_length)) {
+            return E_ERR_INVAL;
+        }//end if
+    }//end for
+
+    return E_OK;
+}//end e_etn_validate
+
+static inline void e_etn_lookup_finish(const char *domain, size_t len, size_t end, e_etn_walk_t *w, e_etn_result_t *result) {
+    size_t i;
+
+    if(w->suffix == end) {
+        /* if no rules match, the prevailing rule is "*" */
+        w->suffix = w->tld;
+        w->suffix_labels = 1;
+        w->suffix_id = E_ETN_SUFFIX_NONE;
+        w->rule = E_ETN_RULE_DEFAULT;
+        w->hash = e_etn_hash_update(e_etn_hash_init(0), domain + w->tld, end - w->tld);
+    }//end if
+
+    /* count the labels left of the last one walked */
+    if(end == 0) {
+        w->depth = w->suffix_labels = 0;
+    }//end if
+    else if(w->start > 0) {
+        for(i = 0, w->depth++ ; i < w->start - 1 ; i++) {
+            if(domain[i] == '.') {
+                w->depth++;
+            }//end if
+        }//end for
+    }//end if
+
+    result->icann = w->icann;
+    result->suffix_off = w->suffix;
+    result->suffix_labels = w->suffix_labels;
+    result->suffix_id = w->suffix_id;
+    result->labels = (uint32_t)w->depth;
+    result->rule = w->rule;
+
+    /* eTLD+1 is the suffix and one more label */
+    if(w->suffix == 0 || w->suffix > end || domain[w->suffix - 1] != '.') {
+        result->registrable_off = len;
+        result->subdomain_len = 0;
+        result->registrable_hash = 0;
+        return;
+    }//end if
+
+    for(i = w->suffix - 1 ; i > 0 && domain[i - 1] != '.' ; i--);
+    result->registrable_off = i;
+    result->subdomain_len = i > 0 ? i - 1 : 0;
+    /* the walk hashed the suffix, the label left of it completes the eTLD+1 */
+    result->registrable_hash = e_etn_hash_final(e_etn_hash_update(w->hash, domain + i, w->suffix - 1 - i));
+}//end e_etn_lookup_finish
+
+static inline e_errno_t e_etn_lookup_stack(e_etn_t *etn, const char *domain, size_t len, size_t end, e_etn_result_t *result) {
+    size_t          start;
+    uint8_t         lens[E_ETN_DOMAIN_MAX + 1];
+    uint16_t        starts[E_ETN_DOMAIN_MAX + 2];
+    uint32_t        n;
+    e_etn_walk_t    w;
+    const char      *labels[E_ETN_DOMAIN_MAX + 1], *dot;
+
+    /* the labels are found once and walked in every table, an empty name is one empty label as e_etn_walk_search() has it */
+    n = 0;
+    for(start = 0 ; ; start = dot - domain + 1) {
+        dot = memchr(domain + start, '.', end - start);
+        labels[n] = domain + start;
+        lens[n] = (uint8_t)((dot ? (size_t)(dot - domain) : end) - start);
+        starts[n++] = (uint16_t)start;
+        if(!dot) {
+            break;
+        }//end if
+    }//end for
+    starts[n] = (uint16_t)(end + 1);
+
+    e_etn_walk_stack(etn, labels, lens, n, &w);
+
+    /* as e_etn_walk_search() leaves it, every label was walked */
+    w.depth = n;
+    w.start = 0;
+    w.tld = starts[n - 1];
+    w.suffix = w.rule == E_ETN_RULE_DEFAULT ? end : starts[n - w.suffix_labels];
+    e_etn_walk_hash(domain, end, &w);
+    e_etn_lookup_finish(domain, len, end, &w, result);
+    result->metadata = e_etn_metadata(etn, w.suffix_id);
+
+    return E_OK;
+}//end e_etn_lookup_stack
+
+static inline void e_etn_walk_stack(e_etn_t *etn, const char **labels, const uint8_t *lens, uint32_t n, e_etn_walk_t *w) {
+    uint32_t        d;
+    e_etn_walks_t   ws;
+
+    /* e_etn_walk_iov() in every table a label at a time, until none of them can match more */
+    e_etn_walks_init(etn, &ws);
+    for(d = 1 ; d <= n && ws.live > 0 ; d++) {
+        e_etn_walks_step(etn, &ws, labels[n - d], lens[n - d], d);
+    }//end for
+    e_etn_walks_merge(etn, &ws, n, w);
+}//end e_etn_walk_stack
+
+static inline e_errno_t e_etn_split_labels(const char *name, size_t *len, const char **labels, uint8_t *lens, uint32_t *n) {
+    size_t      start, end;
+    const char  *dot;
+
+    if(E_UNLIKELY(*len > E_ETN_DOMAIN_MAX)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    end = *len;
+    if(end > 0 && name[end - 1] == '.') {
+        end--;
+    }//end if
+    *len = end;
+
+    /* from left to right, an empty name is one empty label as e_etn_lookup_stack() has it */
+    *n = 0;
+    for(start = 0 ; ; start = dot - name + 1) {
+        dot = memchr(name + start, '.', end - start);
+        labels[*n] = name + start;
+        lens[(*n)++] = (uint8_t)((dot ? (size_t)(dot - name) : end) - start);
+        if(!dot) {
+            break;
+        }//end if
+    }//end for
+
+    return E_OK;
+}//end e_etn_split_labels
+
+static inline uint32_t e_etn_shared_labels(const char **a, const uint8_t *a_lens, uint32_t a_n, const char **b, const uint8_t *b_lens, uint32_t b_n) {
+    uint32_t    m, i, j, k;
+
+    /* the labels both end with, folded to lower case */
+    for(m = 0 ; m < a_n && m < b_n ; m++) {
+        i = a_n - 1 - m;
+        j = b_n - 1 - m;
+        if(a_lens[i] != b_lens[j]) {
+            break;
+        }//end if
+        for(k = 0 ; k < a_lens[i] && e_ascii_tolower(a[i][k]) == e_ascii_tolower(b[j][k]) ; k++);
+        if(k < a_lens[i]) {
+            break;
+        }//end if
+    }//end for
+
+    return m;
+}//end e_etn_shared_labels
+
+static inline bool e_etn_is_ip(const char *host, size_t len, const char *last, size_t last_len) {
+    size_t i;
+
+    if(memchr(host, ':', len)) {
+        return true;
+    }//end if
+
+    /* a host that ends in a number is an IPv4 address, as the URL standard parses it */
+    if(last_len == 0) {
+        return false;
+    }//end if
+    if(last_len >= 2 && last[0] == '0' && (last[1] == 'x' || last[1] == 'X')) {
+        for(i = 2 ; i < last_len && ((last[i] >= '0' && last[i] <= '9') || (e_ascii_tolower(last[i]) >= 'a' && e_ascii_tolower(last[i]) <= 'f')) ; i++);
+    }//end if
+    else {
+        for(i = 0 ; i < last_len && last[i] >= '0' && last[i] <= '9' ; i++);
+    }//end else
+
+    return i == last_len;
+}//end e_etn_is_ip
+
+static inline void e_etn_walks_init(e_etn_t *etn, e_etn_walks_t *ws) {
+    uint32_t            k;
+    e_etn_layer_walk_t  *lw;
+
+    /* a table that is not a stack is the only table of its walk */
+    ws->n = etn->stacked ? etn->num_stacked : 1;
+    ws->live = ws->n;
+    for(k = 0 ; k < ws->n ; k++) {
+        lw = &(ws->walks[k]);
+        lw->lo = 0;
+        lw->hi = (etn->stacked ? etn->stacked[k].etn : etn)->num_TLD;
+        lw->parent = E_ETN_NOT_FOUND;
+        lw->suffix_labels = 0;
+        lw->suffix_id = E_ETN_NOT_FOUND;
+        lw->rule = E_ETN_RULE_DEFAULT;
+        lw->icann = false;
+        lw->wildcard = false;
+        lw->done = false;
+    }//end for
+}//end e_etn_walks_init
+
+static inline void e_etn_walks_step(e_etn_t *etn, e_etn_walks_t *ws, const char *label, size_t len, uint32_t d) {
+    bool                icann;
+    uint32_t            k, f, u, type;
+    e_etn_t             *t;
+    e_etn_layer_walk_t  *lw;
+
+    /* label is the d-th from the right */
+    for(k = 0 ; k < ws->n ; k++) {
+        lw = &(ws->walks[k]);
+        if(lw->done) {
+            continue;
+        }//end if
+
+        if(lw->wildcard) {
+            lw->suffix_labels = d;
+            lw->suffix_id = lw->parent;
+            lw->rule = E_ETN_RULE_WILDCARD;
+        }//end if
+
+        t = etn->stacked ? etn->stacked[k].etn : etn;
+        f = lw->lo == lw->hi ? E_ETN_NOT_FOUND : e_etn_find(t, label, len, lw->lo, lw->hi, t->wide);
+        if(f == E_ETN_NOT_FOUND) {
+            lw->done = true;
+            ws->live--;
+            continue;
+        }//end if
+
+        u = e_etn_node_children(t, f, &icann, t->wide);
+        e_etn_children_decode(t, u, &lw->lo, &lw->hi, &type, &lw->wildcard, t->wide);
+        lw->icann = k == 0 ? icann : etn->stacked[k].icann;
+        if(type == t->node_type_normal) {
+            lw->suffix_labels = d;
+            lw->suffix_id = f;
+            lw->rule = E_ETN_RULE_NORMAL;
+        }//end if
+        else if(type == t->node_type_exception) {
+            lw->suffix_labels = d - 1;
+            lw->suffix_id = lw->parent;
+            lw->rule = E_ETN_RULE_EXCEPTION;
+            lw->done = true;
+            ws->live--;
+            continue;
+        }//end if
+        lw->parent = f;
+    }//end for
+}//end e_etn_walks_step
+
+static inline void e_etn_walks_merge(e_etn_t *etn, const e_etn_walks_t *ws, uint32_t n, e_etn_walk_t *w) {
+    uint32_t                    k;
+    const e_etn_layer_walk_t    *lw, *best;
+
+    /* as if the rules were in one list, ties go to the priority and then to the later table */
+    best = NULL;
+    for(k = 0 ; k < ws->n ; k++) {
+        lw = &(ws->walks[k]);
+        if(lw->rule == E_ETN_RULE_DEFAULT) {
+            continue;
+        }//end if
+        if(best && (best->rule == E_ETN_RULE_EXCEPTION) != (lw->rule == E_ETN_RULE_EXCEPTION)) {
+            if(best->rule == E_ETN_RULE_EXCEPTION) {
+                continue;
+            }//end if
+        }//end if
+        else if(best && (lw->suffix_labels < best->suffix_labels || (lw->suffix_labels == best->suffix_labels && etn->stacked[k].priority < etn->stacked[best - ws->walks].priority))) {
+            continue;
+        }//end if
+        best = lw;
+    }//end for
+
+    if(!best) {
+        /* if no rules match, the prevailing rule is "*", the flag is what the base says */
+        w->suffix_labels = n > 0 ? 1 : 0;
+        w->suffix_id = E_ETN_SUFFIX_NONE;
+        w->rule = E_ETN_RULE_DEFAULT;
+        w->icann = ws->walks[0].icann;
+        return;
+    }//end if
+
+    k = (uint32_t)(best - ws->walks);
+    w->suffix_labels = best->suffix_labels;
+    w->suffix_id = best->suffix_id == E_ETN_NOT_FOUND ? E_ETN_SUFFIX_NONE : best->suffix_id + (etn->stacked ? etn->stacked[k].id_off : 0);
+    w->rule = best->rule;
+    w->icann = best->icann;
+}//end e_etn_walks_merge
+
+static inline e_errno_t e_etn_load_file(e_etn_t *etn, const char *filename) {
+    FILE        *fp;
+    off_t       off;
+    size_t      nread, i;
+    uint8_t     buf[4096];
+    uint32_t    magic;
+    e_errno_t   err;
+
+    fp = fopen(filename, "rb");
+    if(!fp) {
+        return E_ERR_INVAL;
+    }//end if
+
+    memset(buf, 0, sizeof(buf));
+    off = 0;
+    nread = fread(buf, sizeof(uint32_t), 14, fp);
+    if(nread != 14) {
+        fclose(fp);
+        return E_ERR_INVAL;
+    }//end if
+
+    /* check magic number, a v2 file is mapped instead of copied */
+    if(*((uint32_t *)buf) == E_ETN_MAGIC_V2) {
+        fclose(fp);
+        return e_etn_map_file(etn, filename);
+    }//end if
+
+    magic = E_ETN_GET_UINT32(buf, off);
+    if(magic == E_ETN_MAGIC_WIDE) {
+        etn->wide = true;
+    }//end if
+    else if(magic != E_ETN_MAGIC) {
         fclose(fp);
         return E_ERR_INVAL;
     }//end if
-    off = 0;
 
-    etn->children_length = E_ETN_GET_UINT32(buf, off);
-    if(E_UNLIKELY(etn->children_length == 0)) {
-        fclose(fp);
+    /* start to read simple integer part */
+    etn->nodes_bits_children = E_ETN_GET_UINT32(buf, off);
+    etn->nodes_bits_ICANN = E_ETN_GET_UINT32(buf, off);
+    etn->nodes_bits_text_offset = E_ETN_GET_UINT32(buf, off);
+    etn->nodes_bits_text_length = E_ETN_GET_UINT32(buf, off);
+    etn->children_bits_wildcard = E_ETN_GET_UINT32(buf, off);
+    etn->children_bits_node_type = E_ETN_GET_UINT32(buf, off);
+    etn->children_bits_hi = E_ETN_GET_UINT32(buf, off);
+    etn->children_bits_lo = E_ETN_GET_UINT32(buf, off);
+    etn->node_type_normal = E_ETN_GET_UINT32(buf, off);
+    etn->node_type_exception = E_ETN_GET_UINT32(buf, off);
+    etn->node_type_parent_only = E_ETN_GET_UINT32(buf, off);
+    etn->num_TLD = E_ETN_GET_UINT32(buf, off);
+
+    /* check */
+    if(E_UNLIKELY(e_etn_check_bits(etn) != E_OK)) {
+        fclose(fp);
+        return E_ERR_INVAL;
+    }//end if
+
+    /* read text */
+    etn->text_length = E_ETN_GET_UINT32(buf, off);
+    if(E_UNLIKELY(etn->text_length == 0)) {
+        fclose(fp);
+        return E_ERR_INVAL;
+    }//end if
+
+    etn->text = e_malloc(etn->text_length + 1);
+    if(E_UNLIKELY(!etn->text)) {
+        fclose(fp);
+        return E_ERR_FAMEM;
+    }//end if
+    nread = fread(etn->text, sizeof(char), etn->text_length, fp);
+    if(E_UNLIKELY(nread != etn->text_length)) {
+        fclose(fp);
+        return E_ERR_C_ERR;
+    }//end if
+    etn->text[etn->text_length] = '\0';
+    off += etn->text_length;
+
+    if(etn->wide) {
+        err = e_etn_read_wide(etn, fp);
+        if(err == E_OK) {
+            err = e_etn_read_metadata(etn, fp);
+        }//end if
+        fclose(fp);
+        return err == E_OK ? e_etn_narrow(etn) : err;
+    }//end if
+
+    /* read node */
+    memset(buf, 0, sizeof(buf));
+    nread = fread(buf, sizeof(uint32_t), 1, fp);
+    if(nread != 1) {
+        fclose(fp);
+        return E_ERR_INVAL;
+    }//end if
+    off = 0;
+
+    etn->nodes_length = E_ETN_GET_UINT32(buf, off);
+    if(E_UNLIKELY(etn->nodes_length == 0)) {
+        fclose(fp);
+        return E_ERR_INVAL;
+    }//end if
+
+    etn->nodes = e_malloc(etn->nodes_length * sizeof(uint32_t));
+    if(E_UNLIKELY(!etn->nodes)) {
+        fclose(fp);
+        return E_ERR_FAMEM;
+    }//end if
+
+    nread = fread(etn->nodes, sizeof(uint32_t), etn->nodes_length, fp);
+    if(nread != etn->nodes_length) {
+        fclose(fp);
+        return E_ERR_INVAL;
+    }//end if
+
+    for(i = 0 ; i < nread ; i++) {
+        etn->nodes[i] = htonl(etn->nodes[i]);
+    }//end for
+
+    /* read children */
+    memset(buf, 0, sizeof(buf));
+    nread = fread(buf, sizeof(uint32_t), 1, fp);
+    if(nread != 1) {
+        fclose(fp);
+        return E_ERR_INVAL;
+    }//end if
+    off = 0;
+
+    etn->children_length = E_ETN_GET_UINT32(buf, off);
+    if(E_UNLIKELY(etn->children_length == 0)) {
+        fclose(fp);
+        return E_ERR_INVAL;
+    }//end if
+
+    etn->children = e_malloc(etn->children_length * sizeof(uint32_t));
+    if(E_UNLIKELY(!etn->children)) {
+        fclose(fp);
+        return E_ERR_FAMEM;
+    }//end if
+
+    nread = fread(etn->children, sizeof(uint32_t), etn->children_length, fp);
+    if(nread != etn->children_length) {
+        fclose(fp);
+        return E_ERR_INVAL;
+    }//end if
+
+    for(i = 0 ; i < nread ; i++) {
+        etn->children[i] = htonl(etn->children[i]);
+    }//end for
+
+    err = e_etn_read_metadata(etn, fp);
+    fclose(fp);
+    return err;
+}//end e_etn_load_file
+
+/*
+ * The wide format is v1 with 64-bit node and children words, the widths in
+ * its header can be anything that fits. Tables that fit the narrow widths
+ * are narrowed when they are loaded, the narrow words are decoded with the
+ * E_ETN_BITS_* constants.
+ */
+static inline e_errno_t e_etn_read_wide(e_etn_t *etn, FILE *fp) {
+    size_t      i;
+    uint32_t    n, *words;
+    uint64_t    **tables[2];
+    uint32_t    *lengths[2];
+    int         k;
+
+    /* nodes then children, a length word and big endian 64-bit words */
+    tables[0] = &(etn->nodes_wide);
+    tables[1] = &(etn->children_wide);
+    lengths[0] = &(etn->nodes_length);
+    lengths[1] = &(etn->children_length);
+    for(k = 0 ; k < 2 ; k++) {
+        if(fread(&n, sizeof(uint32_t), 1, fp) != 1) {
+            return E_ERR_INVAL;
+        }//end if
+        n = htonl(n);
+        if(E_UNLIKELY(n == 0)) {
+            return E_ERR_INVAL;
+        }//end if
+
+        *tables[k] = e_malloc(n * sizeof(uint64_t));
+        if(E_UNLIKELY(!*tables[k])) {
+            return E_ERR_FAMEM;
+        }//end if
+        if(fread(*tables[k], sizeof(uint64_t), n, fp) != n) {
+            return E_ERR_INVAL;
+        }//end if
+
+        words = (uint32_t *)*tables[k];
+        for(i = 0 ; i < n ; i++) {
+            (*tables[k])[i] = ((uint64_t)htonl(words[2 * i]) << 32) | htonl(words[2 * i + 1]);
+        }//end for
+        *lengths[k] = n;
+    }//end for
+
+    return E_OK;
+}//end e_etn_read_wide
+
+/*
+ * v1 and wide files can end with the metadata words of the nodes, a length
+ * word and big endian words. precompile.go writes none, and readers that
+ * predate them stop after the children.
+ */
+static inline e_errno_t e_etn_read_metadata(e_etn_t *etn, FILE *fp) {
+    size_t      i;
+    uint32_t    n;
+
+    /* the file may end with the children */
+    if(fread(&n, sizeof(uint32_t), 1, fp) != 1) {
+        return E_OK;
+    }//end if
+    if(E_UNLIKELY(htonl(n) != etn->nodes_length)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    etn->metadata_buf = e_malloc(etn->nodes_length * sizeof(uint32_t));
+    if(E_UNLIKELY(!etn->metadata_buf)) {
+        return E_ERR_FAMEM;
+    }//end if
+    if(fread(etn->metadata_buf, sizeof(uint32_t), etn->nodes_length, fp) != etn->nodes_length) {
+        return E_ERR_INVAL;
+    }//end if
+
+    for(i = 0 ; i < etn->nodes_length ; i++) {
+        etn->metadata_buf[i] = htonl(etn->metadata_buf[i]);
+    }//end for
+    etn->metadata = etn->metadata_buf;
+
+    return E_OK;
+}//end e_etn_read_metadata
+
+static inline e_errno_t e_etn_write_metadata(e_etn_t *etn, FILE *fp) {
+    if(!etn->metadata) {
+        return E_OK;
+    }//end if
+
+    if(E_UNLIKELY(e_etn_write_words(fp, &(etn->nodes_length), 1, true) != E_OK ||
+        e_etn_write_words(fp, etn->metadata, etn->nodes_length, true) != E_OK)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    return E_OK;
+}//end e_etn_write_metadata
+
+/* move wide tables that fit the narrow widths to narrow words, otherwise keep them wide */
+static inline e_errno_t e_etn_narrow(e_etn_t *etn) {
+    bool        wildcard, icann;
+    size_t      len;
+    uint32_t    i, lo, hi, type, u, *nodes, *children;
+    const char  *s;
+
+    if(etn->children_length > E_ETN_MASK(E_ETN_BITS_CHILDREN) + 1 ||
+        etn->text_length > E_ETN_MASK(E_ETN_BITS_TEXT_OFFSET) + 1 ||
+        etn->nodes_length > E_ETN_MASK(E_ETN_BITS_LO) + 1) {
+        return E_OK;
+    }//end if
+
+    nodes = e_malloc(etn->nodes_length * sizeof(uint32_t));
+    children = e_malloc(etn->children_length * sizeof(uint32_t));
+    if(E_UNLIKELY(!nodes || !children)) {
+        e_free(nodes);
+        e_free(children);
+        return E_ERR_FAMEM;
+    }//end if
+
+    for(i = 0 ; i < etn->nodes_length ; i++) {
+        s = e_etn_node_label(etn, i, &len, true);
+        u = e_etn_node_children(etn, i, &icann, true);
+        if(len > E_ETN_MASK(E_ETN_BITS_TEXT_LENGTH) || (size_t)(s - etn->text) > E_ETN_MASK(E_ETN_BITS_TEXT_OFFSET) ||
+            u > E_ETN_MASK(E_ETN_BITS_CHILDREN)) {
+            goto wide;
+        }//end if
+        nodes[i] = u << (E_ETN_BITS_ICANN + E_ETN_BITS_TEXT_OFFSET + E_ETN_BITS_TEXT_LENGTH) |
+            (uint32_t)icann << (E_ETN_BITS_TEXT_OFFSET + E_ETN_BITS_TEXT_LENGTH) |
+            (uint32_t)(s - etn->text) << E_ETN_BITS_TEXT_LENGTH | (uint32_t)len;
+    }//end for
+
+    for(i = 0 ; i < etn->children_length ; i++) {
+        e_etn_children_decode(etn, i, &lo, &hi, &type, &wildcard, true);
+        if(hi > E_ETN_MASK(E_ETN_BITS_HI) || lo > E_ETN_MASK(E_ETN_BITS_LO) || type >= E_ETN_NUM_TYPE) {
+            goto wide;
+        }//end if
+        children[i] = (uint32_t)wildcard << (E_ETN_BITS_NODE_TYPE + E_ETN_BITS_HI + E_ETN_BITS_LO) |
+            type << (E_ETN_BITS_HI + E_ETN_BITS_LO) | hi << E_ETN_BITS_LO | lo;
+    }//end for
+
+    etn->nodes_bits_children = E_ETN_BITS_CHILDREN;
+    etn->nodes_bits_ICANN = E_ETN_BITS_ICANN;
+    etn->nodes_bits_text_offset = E_ETN_BITS_TEXT_OFFSET;
+    etn->nodes_bits_text_length = E_ETN_BITS_TEXT_LENGTH;
+    etn->children_bits_wildcard = E_ETN_BITS_WILDCARD;
+    etn->children_bits_node_type = E_ETN_BITS_NODE_TYPE;
+    etn->children_bits_hi = E_ETN_BITS_HI;
+    etn->children_bits_lo = E_ETN_BITS_LO;
+    e_free(etn->nodes_wide);
+    e_free(etn->children_wide);
+    etn->nodes_wide = NULL;
+    etn->children_wide = NULL;
+    etn->nodes = nodes;
+    etn->children = children;
+    etn->wide = false;
+
+    return E_OK;
+
+wide:
+    e_free(nodes);
+    e_free(children);
+    return E_OK;
+}//end e_etn_narrow
+
+static inline e_errno_t e_etn_map_file(e_etn_t *etn, const char *filename) {
+    int                     fd;
+    void                    *map;
+    struct stat             st;
+    const e_etn_header_v2_t *hdr;
+
+    fd = open(filename, O_RDONLY);
+    if(fd == -1) {
+        return E_ERR_INVAL;
+    }//end if
+
+    if(E_UNLIKELY(fstat(fd, &st) == -1)) {
+        close(fd);
+        return E_ERR_C_ERR;
+    }//end if
+
+    if(E_UNLIKELY((size_t)st.st_size < sizeof(e_etn_header_v2_t))) {
+        close(fd);
+        return E_ERR_INVAL;
+    }//end if
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(E_UNLIKELY(map == MAP_FAILED)) {
+        return E_ERR_C_ERR;
+    }//end if
+    etn->map = map;
+    etn->map_length = (size_t)st.st_size;
+
+    /* check magic number, a byte-swapped one means a foreign host wrote it */
+    hdr = (const e_etn_header_v2_t *)map;
+    if(hdr->magic != E_ETN_MAGIC_V2) {
+        return E_ERR_INVAL;
+    }//end if
+
+    if(E_UNLIKELY(hdr->header_size < sizeof(e_etn_header_v2_t) || hdr->header_size > etn->map_length)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    etn->nodes_bits_children = hdr->nodes_bits_children;
+    etn->nodes_bits_ICANN = hdr->nodes_bits_ICANN;
+    etn->nodes_bits_text_offset = hdr->nodes_bits_text_offset;
+    etn->nodes_bits_text_length = hdr->nodes_bits_text_length;
+    etn->children_bits_wildcard = hdr->children_bits_wildcard;
+    etn->children_bits_node_type = hdr->children_bits_node_type;
+    etn->children_bits_hi = hdr->children_bits_hi;
+    etn->children_bits_lo = hdr->children_bits_lo;
+    etn->node_type_normal = hdr->node_type_normal;
+    etn->node_type_exception = hdr->node_type_exception;
+    etn->node_type_parent_only = hdr->node_type_parent_only;
+    etn->num_TLD = hdr->num_TLD;
+
+    if(E_UNLIKELY(e_etn_check_bits(etn) != E_OK)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    /* check sections, text must be followed by a NUL byte inside the file */
+    if(E_UNLIKELY(hdr->text_length == 0 || hdr->nodes_length == 0 || hdr->children_length == 0)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    if(E_UNLIKELY((uint64_t)hdr->text_offset + hdr->text_length >= etn->map_length ||
+        (uint64_t)hdr->nodes_offset + (uint64_t)hdr->nodes_length * sizeof(uint32_t) > etn->map_length ||
+        (uint64_t)hdr->children_offset + (uint64_t)hdr->children_length * sizeof(uint32_t) > etn->map_length)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    if(E_UNLIKELY(hdr->nodes_offset % E_ETN_V2_ALIGN != 0 || hdr->children_offset % E_ETN_V2_ALIGN != 0)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    etn->text = (char *)map + hdr->text_offset;
+    if(E_UNLIKELY(etn->text[hdr->text_length] != '\0')) {
+        return E_ERR_INVAL;
+    }//end if
+
+    etn->text_length = hdr->text_length;
+    etn->nodes = (uint32_t *)((char *)map + hdr->nodes_offset);
+    etn->nodes_length = hdr->nodes_length;
+    etn->children = (uint32_t *)((char *)map + hdr->children_offset);
+    etn->children_length = hdr->children_length;
+
+    /* files of precompile.go have no metadata, the header words are zero */
+    if(hdr->metadata_length == 0) {
+        return E_OK;
+    }//end if
+    if(E_UNLIKELY(hdr->metadata_length != hdr->nodes_length || hdr->metadata_offset % E_ETN_V2_ALIGN != 0 ||
+        (uint64_t)hdr->metadata_offset + (uint64_t)hdr->metadata_length * sizeof(uint32_t) > etn->map_length)) {
+        return E_ERR_INVAL;
+    }//end if
+    etn->metadata = (const uint32_t *)((char *)map + hdr->metadata_offset);
+
+    return E_OK;
+}//end e_etn_map_file
+
+static inline e_errno_t e_etn_load_builtin(e_etn_t *etn) {
+#ifdef HAVE_ETN_BUILTIN
+    /* the tables are read-only data of the library, shared by every process */
+    e_etn_set_header(etn, e_etn_builtin_header);
+    etn->text_length = e_etn_builtin_text_length;
+    etn->text = (char *)e_etn_builtin_text;
+    etn->nodes_length = e_etn_builtin_nodes_length;
+    etn->nodes = (uint32_t *)e_etn_builtin_nodes;
+    etn->children_length = e_etn_builtin_children_length;
+    etn->children = (uint32_t *)e_etn_builtin_children;
+    etn->borrowed = true;
+
+    return e_etn_check_bits(etn);
+#else
+    return E_ERR_NOTSUP;
+#endif
+}//end e_etn_load_builtin
+
+static inline e_errno_t e_etn_load_psl(e_etn_t *etn, const char *psl, size_t len) {
+    e_errno_t       err;
+    e_etn_tables_t  tables;
+
+    err = e_etn_build_tables(psl, len, &tables);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    return e_etn_take_tables(etn, &tables);
+}//end e_etn_load_psl
+
+static inline e_errno_t e_etn_take_tables(e_etn_t *etn, e_etn_tables_t *tables) {
+    e_errno_t err;
+
+    /* etn owns the tables from here on, they are built wide and narrowed when they fit */
+    e_etn_set_header(etn, tables->header);
+    etn->wide = true;
+    etn->text_length = tables->text_length;
+    etn->text = tables->text;
+    etn->nodes_length = tables->nodes_length;
+    etn->nodes_wide = tables->nodes;
+    etn->children_length = tables->children_length;
+    etn->children_wide = tables->children;
+
+    err = e_etn_check_bits(etn);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    return e_etn_narrow(etn);
+}//end e_etn_take_tables
+
+static inline e_errno_t e_etn_set_view(e_etn_t *etn, const e_etn_view_t *view) {
+    /* used in place and never freed, the text must be followed by a NUL byte */
+    if(E_UNLIKELY(view->text_length == 0 || view->nodes_length == 0 || view->children_length == 0 ||
+        view->text[view->text_length] != '\0')) {
+        return E_ERR_INVAL;
+    }//end if
+
+    e_etn_set_header(etn, view->header);
+    etn->wide = view->wide;
+    etn->text_length = view->text_length;
+    etn->text = (char *)view->text;
+    etn->nodes_length = view->nodes_length;
+    etn->children_length = view->children_length;
+    if(view->wide) {
+        etn->nodes_wide = (uint64_t *)view->nodes;
+        etn->children_wide = (uint64_t *)view->children;
+    }//end if
+    else {
+        etn->nodes = (uint32_t *)view->nodes;
+        etn->children = (uint32_t *)view->children;
+    }//end else
+    etn->borrowed = true;
+
+    return e_etn_check_bits(etn);
+}//end e_etn_set_view
+
+/* words are the header of the v1 format after the magic number */
+static inline void e_etn_set_header(e_etn_t *etn, const uint32_t *words) {
+    etn->nodes_bits_children = words[0];
+    etn->nodes_bits_ICANN = words[1];
+    etn->nodes_bits_text_offset = words[2];
+    etn->nodes_bits_text_length = words[3];
+    etn->children_bits_wildcard = words[4];
+    etn->children_bits_node_type = words[5];
+    etn->children_bits_hi = words[6];
+    etn->children_bits_lo = words[7];
+    etn->node_type_normal = words[8];
+    etn->node_type_exception = words[9];
+    etn->node_type_parent_only = words[10];
+    etn->num_TLD = words[11];
+}//end e_etn_set_header
+
+static inline void e_etn_get_header(e_etn_t *etn, uint32_t *words) {
+    words[0] = etn->nodes_bits_children;
+    words[1] = etn->nodes_bits_ICANN;
+    words[2] = etn->nodes_bits_text_offset;
+    words[3] = etn->nodes_bits_text_length;
+    words[4] = etn->children_bits_wildcard;
+    words[5] = etn->children_bits_node_type;
+    words[6] = etn->children_bits_hi;
+    words[7] = etn->children_bits_lo;
+    words[8] = etn->node_type_normal;
+    words[9] = etn->node_type_exception;
+    words[10] = etn->node_type_parent_only;
+    words[11] = etn->num_TLD;
+}//end e_etn_get_header
+
+static inline e_errno_t e_etn_save_v1(e_etn_t *etn, FILE *fp) {
+    uint32_t words[E_ETN_HEADER_WORDS + 2];
+
+    words[0] = E_ETN_MAGIC;
+    e_etn_get_header(etn, words + 1);
+    words[E_ETN_HEADER_WORDS + 1] = etn->text_length;
+    if(E_UNLIKELY(e_etn_write_words(fp, words, E_ETN_HEADER_WORDS + 2, true) != E_OK)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    if(E_UNLIKELY(fwrite(etn->text, sizeof(char), etn->text_length, fp) != etn->text_length)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    if(E_UNLIKELY(e_etn_write_words(fp, &(etn->nodes_length), 1, true) != E_OK ||
+        e_etn_write_words(fp, etn->nodes, etn->nodes_length, true) != E_OK ||
+        e_etn_write_words(fp, &(etn->children_length), 1, true) != E_OK ||
+        e_etn_write_words(fp, etn->children, etn->children_length, true) != E_OK)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    return e_etn_write_metadata(etn, fp);
+}//end e_etn_save_v1
+
+static inline e_errno_t e_etn_save_v2(e_etn_t *etn, FILE *fp) {
+    size_t              end;
+    uint32_t            header[E_ETN_V2_HEADER_SIZE / sizeof(uint32_t)];
+    e_etn_header_v2_t   *hdr;
+
+    /* same layout as precompile.go -format v2, unused header words are zero */
+    memset(header, 0, sizeof(header));
+    hdr = (e_etn_header_v2_t *)header;
+    hdr->magic = E_ETN_MAGIC_V2;
+    hdr->header_size = E_ETN_V2_HEADER_SIZE;
+    e_etn_get_header(etn, &(hdr->nodes_bits_children));
+    hdr->text_offset = E_ETN_V2_HEADER_SIZE;
+    hdr->text_length = etn->text_length;
+    hdr->nodes_offset = E_ETN_V2_ROUND(hdr->text_offset + etn->text_length + 1);
+    hdr->nodes_length = etn->nodes_length;
+    hdr->children_offset = E_ETN_V2_ROUND(hdr->nodes_offset + etn->nodes_length * sizeof(uint32_t));
+    hdr->children_length = etn->children_length;
+    end = hdr->children_offset + etn->children_length * sizeof(uint32_t);
+    if(etn->metadata) {
+        hdr->metadata_offset = E_ETN_V2_ROUND(end);
+        hdr->metadata_length = etn->nodes_length;
+    }//end if
+
+    if(E_UNLIKELY(e_etn_write_words(fp, header, E_ETN_V2_HEADER_SIZE / sizeof(uint32_t), false) != E_OK)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    if(E_UNLIKELY(fwrite(etn->text, sizeof(char), etn->text_length, fp) != etn->text_length ||
+        e_etn_write_pad(fp, hdr->nodes_offset - hdr->text_offset - etn->text_length) != E_OK)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    if(E_UNLIKELY(e_etn_write_words(fp, etn->nodes, etn->nodes_length, false) != E_OK ||
+        e_etn_write_pad(fp, hdr->children_offset - hdr->nodes_offset - etn->nodes_length * sizeof(uint32_t)) != E_OK ||
+        e_etn_write_words(fp, etn->children, etn->children_length, false) != E_OK ||
+        e_etn_write_pad(fp, E_ETN_V2_ROUND(end) - end) != E_OK)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    if(etn->metadata) {
+        end = hdr->metadata_offset + etn->nodes_length * sizeof(uint32_t);
+        if(E_UNLIKELY(e_etn_write_words(fp, etn->metadata, etn->nodes_length, false) != E_OK ||
+            e_etn_write_pad(fp, E_ETN_V2_ROUND(end) - end) != E_OK)) {
+            return E_ERR_C_ERR;
+        }//end if
+    }//end if
+
+    return E_OK;
+}//end e_etn_save_v2
+
+static inline e_errno_t e_etn_save_wide(e_etn_t *etn, FILE *fp) {
+    size_t      i, k;
+    uint32_t    words[E_ETN_HEADER_WORDS + 2], buf[1024];
+    uint64_t    w;
+
+    /* narrow tables are written with their own widths, the words zero extended */
+    words[0] = E_ETN_MAGIC_WIDE;
+    e_etn_get_header(etn, words + 1);
+    words[E_ETN_HEADER_WORDS + 1] = etn->text_length;
+    if(E_UNLIKELY(e_etn_write_words(fp, words, E_ETN_HEADER_WORDS + 2, true) != E_OK ||
+        fwrite(etn->text, sizeof(char), etn->text_length, fp) != etn->text_length ||
+        e_etn_write_words(fp, &(etn->nodes_length), 1, true) != E_OK)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    for(i = 0 ; i < etn->nodes_length ; i += k / 2) {
+        for(k = 0 ; k < E_N_ELEMENTS(buf) && i + k / 2 < etn->nodes_length ; k += 2) {
+            w = etn->wide ? etn->nodes_wide[i + k / 2] : etn->nodes[i + k / 2];
+            buf[k] = htonl((uint32_t)(w >> 32));
+            buf[k + 1] = htonl((uint32_t)w);
+        }//end for
+        if(E_UNLIKELY(fwrite(buf, sizeof(uint32_t), k, fp) != k)) {
+            return E_ERR_C_ERR;
+        }//end if
+    }//end for
+
+    if(E_UNLIKELY(e_etn_write_words(fp, &(etn->children_length), 1, true) != E_OK)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    for(i = 0 ; i < etn->children_length ; i += k / 2) {
+        for(k = 0 ; k < E_N_ELEMENTS(buf) && i + k / 2 < etn->children_length ; k += 2) {
+            w = etn->wide ? etn->children_wide[i + k / 2] : etn->children[i + k / 2];
+            buf[k] = htonl((uint32_t)(w >> 32));
+            buf[k + 1] = htonl((uint32_t)w);
+        }//end for
+        if(E_UNLIKELY(fwrite(buf, sizeof(uint32_t), k, fp) != k)) {
+            return E_ERR_C_ERR;
+        }//end if
+    }//end for
+
+    return e_etn_write_metadata(etn, fp);
+}//end e_etn_save_wide
+
+static inline e_errno_t e_etn_write_words(FILE *fp, const uint32_t *words, size_t n, bool big_endian) {
+    size_t      i, k;
+    uint32_t    buf[1024];
+
+    if(!big_endian) {
+        return fwrite(words, sizeof(uint32_t), n, fp) == n ? E_OK : E_ERR_C_ERR;
+    }//end if
+
+    for(i = 0 ; i < n ; i += k) {
+        for(k = 0 ; k < E_N_ELEMENTS(buf) && i + k < n ; k++) {
+            buf[k] = htonl(words[i + k]);
+        }//end for
+        if(E_UNLIKELY(fwrite(buf, sizeof(uint32_t), k, fp) != k)) {
+            return E_ERR_C_ERR;
+        }//end if
+    }//end for
+
+    return E_OK;
+}//end e_etn_write_words
+
+static inline e_errno_t e_etn_write_pad(FILE *fp, size_t n) {
+    static const char zeros[E_ETN_V2_ALIGN + 1];
+
+    /* the text pad includes its NUL terminator */
+    if(E_UNLIKELY(n > sizeof(zeros) || fwrite(zeros, sizeof(char), n, fp) != n)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    return E_OK;
+}//end e_etn_write_pad
+
+static inline e_errno_t e_etn_check_bits(e_etn_t *etn) {
+    if(etn->wide) {
+        /* any widths up to 32 bits each, as long as a word holds them */
+        if(E_UNLIKELY(etn->nodes_bits_children - 1 >= 32 || etn->nodes_bits_ICANN != 1 ||
+            etn->nodes_bits_text_offset - 1 >= 32 || etn->nodes_bits_text_length - 1 >= 32 ||
+            etn->children_bits_wildcard != 1 || etn->children_bits_node_type - 1 >= 32 ||
+            etn->children_bits_hi - 1 >= 32 || etn->children_bits_lo - 1 >= 32)) {
+            return E_ERR_INVAL;
+        }//end if
+
+        if(E_UNLIKELY(etn->nodes_bits_text_length + etn->nodes_bits_text_offset + etn->nodes_bits_ICANN + etn->nodes_bits_children > 64 ||
+            etn->children_bits_lo + etn->children_bits_hi + etn->children_bits_node_type + etn->children_bits_wildcard > 64)) {
+            return E_ERR_INVAL;
+        }//end if
+
+        if(E_UNLIKELY(etn->node_type_normal != E_ETN_TYPE_NORMAL ||
+            etn->node_type_exception != E_ETN_TYPE_EXCEPTION ||
+            etn->node_type_parent_only != E_ETN_TYPE_PARENT_ONLY)) {
+            return E_ERR_INVAL;
+        }//end if
+
+        return E_OK;
+    }//end if
+
+    if(E_UNLIKELY(etn->nodes_bits_text_length + etn->nodes_bits_text_offset + etn->nodes_bits_ICANN + etn->nodes_bits_children > 32)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    if(E_UNLIKELY(etn->children_bits_lo + etn->children_bits_hi + etn->children_bits_node_type + etn->children_bits_wildcard > 32)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    if(E_UNLIKELY(etn->nodes_bits_children != 10 ||
+        etn->nodes_bits_ICANN != 1 ||
+        etn->nodes_bits_text_offset != 15 ||
+        etn->nodes_bits_text_length != 6 ||
+        etn->children_bits_wildcard != 1 ||
+        etn->children_bits_node_type != 2 ||
+        etn->children_bits_hi != 14 ||
+        etn->children_bits_lo != 14||
+        etn->node_type_normal != 0 ||
+        etn->node_type_exception != 1 ||
+        etn->node_type_parent_only != 2)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    return E_OK;
+}//end e_etn_check_bits
+
+static inline e_errno_t e_etn_root_build(e_etn_t *etn) {
+    size_t      i, len;
+    uint8_t     *used;
+    uint32_t    n, *order;
+    uint64_t    *hashes;
+    const char  *s;
+
+    n = etn->num_TLD;
+    if(E_UNLIKELY(n == 0 || n > etn->nodes_length)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    hashes = e_malloc(n * sizeof(uint64_t));
+    order = e_malloc(n * sizeof(uint32_t));
+    used = e_malloc(n);
+    if(E_UNLIKELY(!hashes || !order || !used)) {
+        e_free(hashes);
+        e_free(order);
+        e_free(used);
+        return E_ERR_FAMEM;
+    }//end if
+
+    for(i = 0 ; i < n ; i++) {
+        s = e_etn_node_label(etn, i, &len, etn->wide);
+        hashes[i] = e_etn_root_hash(s, len);
+    }//end for
+
+    /* fewer labels per bucket make displacements easier to find */
+    for(etn->root_buckets = (n + E_ETN_ROOT_BUCKET_SIZE - 1) / E_ETN_ROOT_BUCKET_SIZE ;
+        etn->root_buckets <= n ; etn->root_buckets *= 2) {
+        etn->root_disp = e_calloc(etn->root_buckets + n, sizeof(uint32_t));
+        if(E_UNLIKELY(!etn->root_disp)) {
+            e_free(hashes);
+            e_free(order);
+            e_free(used);
+            return E_ERR_FAMEM;
+        }//end if
+        etn->root_table = etn->root_disp + etn->root_buckets;
+
+        if(e_etn_root_try(etn, hashes, order, used)) {
+            break;
+        }//end if
+
+        e_free(etn->root_disp);
+        etn->root_disp = etn->root_table = NULL;
+    }//end for
+
+    /* without a root table the root is binary searched as any other node */
+    e_free(hashes);
+    e_free(order);
+    e_free(used);
+    return E_OK;
+}//end e_etn_root_build
+
+static inline bool e_etn_root_try(e_etn_t *etn, const uint64_t *hashes, uint32_t *order, uint8_t *used) {
+    bool        ok;
+    uint32_t    n, b, i, j, k, d, size, max_size, *start, slots[E_ETN_ROOT_BUCKET_SIZE * 64];
+
+    n = etn->num_TLD;
+
+    /* counting sort the labels by bucket */
+    start = e_calloc(etn->root_buckets + 1, sizeof(uint32_t));
+    if(E_UNLIKELY(!start)) {
+        return false;
+    }//end if
+    for(i = 0 ; i < n ; i++) {
+        start[(uint32_t)(((hashes[i] >> 32) * etn->root_buckets) >> 32) + 1]++;
+    }//end for
+    max_size = 0;
+    for(b = 0 ; b < etn->root_buckets ; b++) {
+        max_size = E_MAX(max_size, start[b + 1]);
+        start[b + 1] += start[b];
+    }//end for
+    if(max_size > E_N_ELEMENTS(slots)) {
+        e_free(start);
+        return false;
+    }//end if
+    for(i = 0 ; i < n ; i++) {
+        b = (uint32_t)(((hashes[i] >> 32) * etn->root_buckets) >> 32);
+        order[start[b]++] = i;
+    }//end for
+    for(b = etn->root_buckets ; b > 0 ; b--) {
+        start[b] = start[b - 1];
+    }//end for
+    start[0] = 0;
+
+    /* place the largest buckets first, they are the hardest */
+    memset(used, 0, n);
+    for(size = max_size ; size > 0 ; size--) {
+        for(b = 0 ; b < etn->root_buckets ; b++) {
+            if(start[b + 1] - start[b] != size) {
+                continue;
+            }//end if
+
+            for(d = 0 ; d < E_ETN_ROOT_MAX_DISP ; d++) {
+                ok = true;
+                for(j = 0 ; j < size && ok ; j++) {
+                    slots[j] = e_etn_root_slot(hashes[order[start[b] + j]], d, n);
+                    if(used[slots[j]]) {
+                        ok = false;
+                    }//end if
+                    for(k = 0 ; k < j && ok ; k++) {
+                        if(slots[k] == slots[j]) {
+                            ok = false;
+                        }//end if
+                    }//end for
+                }//end for
+                if(ok) {
+                    break;
+                }//end if
+            }//end for
+
+            if(d == E_ETN_ROOT_MAX_DISP) {
+                e_free(start);
+                return false;
+            }//end if
+
+            etn->root_disp[b] = d;
+            for(j = 0 ; j < size ; j++) {
+                used[slots[j]] = 1;
+                etn->root_table[slots[j]] = order[start[b] + j];
+            }//end for
+        }//end for
+    }//end for
+
+    e_free(start);
+    return true;
+}//end e_etn_root_try
+
+static inline uint64_t e_etn_root_hash(const char *label, size_t len) {
+    size_t      i;
+    uint64_t    h;
+
+    /* FNV-1a over the folded label */
+    h = 0xcbf29ce484222325ULL;
+    for(i = 0 ; i < len ; i++) {
+        h ^= (u_char)e_ascii_tolower(label[i]);
+        h *= 0x100000001b3ULL;
+    }//end for
+
+    return h;
+}//end e_etn_root_hash
+
+static inline uint32_t e_etn_root_slot(uint64_t h, uint32_t disp, uint32_t n) {
+    /* murmur3 finalizer, then map onto [0, n) without a division */
+    h += disp * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return (uint32_t)(((h & 0xffffffff) * n) >> 32);
+}//end e_etn_root_slot
+
+static inline uint32_t e_etn_find_root(e_etn_t *etn, const char *label, size_t label_len, bool wide) {
+    size_t      len;
+    uint32_t    i;
+    uint64_t    h;
+    const char  *s;
+
+    h = e_etn_root_hash(label, label_len);
+    i = etn->root_table[e_etn_root_slot(h, etn->root_disp[((h >> 32) * etn->root_buckets) >> 32], etn->num_TLD)];
+
+    /* every slot holds some TLD, verify it is this one */
+    s = e_etn_node_label(etn, i, &len, wide);
+    if(len != label_len || e_etn_strncmp(s, len, label, label_len) != 0) {
+        return E_ETN_NOT_FOUND;
+    }//end if
+
+    return i;
+}//end e_etn_find_root
+
+static inline e_errno_t e_etn_bloom_build(e_etn_t *etn) {
+    size_t      len;
+    uint32_t    i, j, k, lo, hi, type, b, n;
+    uint64_t    h, *block;
+    bool        wildcard;
+    const char  *s;
+
+    /* the root is only searched through the filter when it has no root table */
+    n = etn->root_table || etn->num_TLD < E_ETN_BLOOM_MIN_RANGE ? 0 : etn->num_TLD;
+    for(i = 0 ; i < etn->children_length ; i++) {
+        e_etn_children_decode(etn, i, &lo, &hi, &type, &wildcard, etn->wide);
+        if(hi - lo >= E_ETN_BLOOM_MIN_RANGE) {
+            n += hi - lo;
+        }//end if
+    }//end for
+    if(n == 0) {
+        return E_OK;
+    }//end if
+
+    etn->bloom_blocks = (uint32_t)(((uint64_t)n * E_ETN_BLOOM_BITS + 511) / 512);
+    if(E_UNLIKELY(posix_memalign((void **)&etn->bloom, E_ETN_BLOOM_BLOCK * sizeof(uint64_t),
+        (size_t)etn->bloom_blocks * E_ETN_BLOOM_BLOCK * sizeof(uint64_t)) != 0)) {
+        etn->bloom = NULL;
+        return E_ERR_FAMEM;
+    }//end if
+    memset(etn->bloom, 0, (size_t)etn->bloom_blocks * E_ETN_BLOOM_BLOCK * sizeof(uint64_t));
+
+    for(i = 0 ; i <= etn->children_length ; i++) {
+        if(i < etn->children_length) {
+            e_etn_children_decode(etn, i, &lo, &hi, &type, &wildcard, etn->wide);
+            if(hi - lo < E_ETN_BLOOM_MIN_RANGE) {
+                continue;
+            }//end if
+        }//end if
+        else if(!etn->root_table && etn->num_TLD >= E_ETN_BLOOM_MIN_RANGE) {
+            lo = 0;
+            hi = etn->num_TLD;
+        }//end if
+        else {
+            break;
+        }//end else
+
+        for(j = lo ; j < hi ; j++) {
+            s = e_etn_node_label(etn, j, &len, etn->wide);
+            h = e_etn_hash(s, len, lo);
+            block = etn->bloom + (((h >> 36) * etn->bloom_blocks) >> 28) * E_ETN_BLOOM_BLOCK;
+            for(k = 0 ; k < E_ETN_BLOOM_K ; k++) {
+                b = (h >> (9 * k)) & 511;
+                block[b >> 6] |= (uint64_t)1 << (b & 63);
+            }//end for
+        }//end for
+    }//end for
+
+    return E_OK;
+}//end e_etn_bloom_build
+
+static inline uint64_t e_etn_hash(const char *s, size_t len, uint32_t seed) {
+    return e_etn_hash_final(e_etn_hash_update(e_etn_hash_init(seed), s, len));
+}//end e_etn_hash
+
+/*
+ * A name is hashed a label at a time from the right, the length every label
+ * is mixed in with stands for its dot. So the labels can be fed from wherever
+ * they are, a message or the segments of an iovec, without a copy in one piece.
+ */
+static inline uint64_t e_etn_hash_init(uint32_t seed) {
+    return (uint64_t)seed * 0x9e3779b97f4a7c15ULL;
+}//end e_etn_hash_init
+
+static inline uint64_t e_etn_hash_update(uint64_t h, const char *s, size_t len) {
+    size_t      i;
+    uint32_t    w32[2];
+    uint64_t    w;
+
+    /* whole words with the last one overlapping, s is never read past its end */
+    if(len >= sizeof(uint64_t)) {
+        for(i = 0 ; i + sizeof(uint64_t) < len ; i += sizeof(uint64_t)) {
+            memcpy(&w, s + i, sizeof(uint64_t));
+            h = (h ^ e_etn_hash_fold(w)) * 0xff51afd7ed558ccdULL;
+            h ^= h >> 32;
+        }//end for
+        memcpy(&w, s + len - sizeof(uint64_t), sizeof(uint64_t));
+    }//end if
+    else if(len >= sizeof(uint32_t)) {
+        memcpy(&w32[0], s, sizeof(uint32_t));
+        memcpy(&w32[1], s + len - sizeof(uint32_t), sizeof(uint32_t));
+        w = ((uint64_t)w32[0] << 32) | w32[1];
+    }//end if
+    else if(len > 0) {
+        w = ((uint64_t)(u_char)s[0] << 16) | ((uint64_t)(u_char)s[len / 2] << 8) | (u_char)s[len - 1];
+    }//end if
+    else {
+        w = 0;
+    }//end else
+
+    /* the length goes in after the multiply, next to the bytes it could cancel one out, "me" and "med" */
+    return ((h ^ e_etn_hash_fold(w)) * 0xff51afd7ed558ccdULL) ^ len;
+}//end e_etn_hash_update
+
+static inline uint64_t e_etn_hash_final(uint64_t h) {
+    /* the murmur3 finalizer */
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return h;
+}//end e_etn_hash_final
+
+static inline uint64_t e_etn_hash_labels(const char *domain, size_t start, size_t end) {
+    size_t      pos, i;
+    uint64_t    h;
+
+    /* the labels of domain[start, end) from the right, as a walk reads them */
+    h = e_etn_hash_init(0);
+    for(pos = end ; ; pos = i - 1) {
+        for(i = pos ; i > start && domain[i - 1] != '.' ; i--);
+        h = e_etn_hash_update(h, domain + i, pos - i);
+        if(i == start) {
+            break;
+        }//end if
+    }//end for
+
+    return h;
+}//end e_etn_hash_labels
+
+static inline void e_etn_walk_hash(const char *domain, size_t end, e_etn_walk_t *w) {
+    /* for walks that do not hash as they go, e_etn_lookup_finish() hashes a default suffix itself */
+    if(w->rule != E_ETN_RULE_DEFAULT && w->suffix < end) {
+        w->hash = e_etn_hash_labels(domain, w->suffix, end);
+    }//end if
+}//end e_etn_walk_hash
+
+static inline uint64_t e_etn_hash_fold(uint64_t w) {
+    uint64_t x, upper;
+
+    /* 'A' to 'Z' in every byte below 0x80 to lower case, as e_ascii_tolower() */
+    x = w & 0x7f7f7f7f7f7f7f7fULL;
+    upper = (x + 0x3f3f3f3f3f3f3f3fULL) & ~(x + 0x2525252525252525ULL) & ~w & 0x8080808080808080ULL;
+
+    return w | (upper >> 2);
+}//end e_etn_hash_fold
+
+static inline bool e_etn_bloom_check(e_etn_t *etn, const char *label, size_t len, uint32_t lo) {
+    uint32_t        k, b;
+    uint64_t        h;
+    const uint64_t  *block;
+
+    /* 28 high bits pick the block, 36 low bits the bits in it */
+    h = e_etn_hash(label, len, lo);
+    block = etn->bloom + (((h >> 36) * etn->bloom_blocks) >> 28) * E_ETN_BLOOM_BLOCK;
+    for(k = 0 ; k < E_ETN_BLOOM_K ; k++) {
+        b = (h >> (9 * k)) & 511;
+        if(!(block[b >> 6] & ((uint64_t)1 << (b & 63)))) {
+            return false;
+        }//end if
+    }//end for
+
+    return true;
+}//end e_etn_bloom_check
+
+static inline e_errno_t e_etn_inline_build(e_etn_t *etn) {
+    size_t      len;
+    uint32_t    i, lo, hi, type, *owner;
+    bool        wildcard;
+    e_errno_t   err;
+    e_etn_key_t *tmp;
+    const char  *s;
+
+    etn->keys = e_malloc(etn->nodes_length * sizeof(e_etn_key_t));
+    tmp = e_malloc(etn->nodes_length * sizeof(e_etn_key_t));
+    owner = e_malloc(etn->nodes_length * sizeof(uint32_t));
+    if(E_UNLIKELY(!etn->keys || !tmp || !owner)) {
+        err = E_ERR_FAMEM;
+        goto error;
+    }//end if
+
+    for(i = 0 ; i < etn->nodes_length ; i++) {
+        s = e_etn_node_label(etn, i, &len, etn->wide);
+        etn->keys[i].prefix = e_etn_inline_prefix(s, len);
+        etn->keys[i].len = len;
+        etn->keys[i].node = i;
+        owner[i] = E_ETN_NOT_FOUND;
+    }//end for
+
+    /* every children range is laid out on its own, they must not overlap */
+    err = e_etn_inline_range(etn, 0, etn->num_TLD, owner, tmp);
+    for(i = 0 ; i < etn->children_length && err == E_OK ; i++) {
+        e_etn_children_decode(etn, i, &lo, &hi, &type, &wildcard, etn->wide);
+        err = e_etn_inline_range(etn, lo, hi, owner, tmp);
+    }//end for
+    if(E_UNLIKELY(err != E_OK)) {
+        goto error;
+    }//end if
+
+    e_free(tmp);
+    e_free(owner);
+    return E_OK;
+
+error:
+    e_free(etn->keys);
+    etn->keys = NULL;
+    e_free(tmp);
+    e_free(owner);
+    return err;
+}//end e_etn_inline_build
+
+static inline e_errno_t e_etn_inline_range(e_etn_t *etn, uint32_t lo, uint32_t hi, uint32_t *owner, e_etn_key_t *tmp) {
+    uint32_t i, next;
+
+    if(E_UNLIKELY(lo > hi || hi > etn->nodes_length)) {
+        return E_ERR_INVAL;
+    }//end if
+    if(lo == hi || (owner[lo] == lo && owner[hi - 1] == lo && (hi == etn->nodes_length || owner[hi] != lo))) {
+        /* empty or shared by several children records */
+        return E_OK;
+    }//end if
+
+    for(i = lo ; i < hi ; i++) {
+        if(E_UNLIKELY(owner[i] != E_ETN_NOT_FOUND)) {
+            return E_ERR_INVAL;
+        }//end if
+        owner[i] = lo;
+    }//end for
+
+    if(hi - lo <= E_ETN_INLINE_SCAN_MAX) {
+        return E_OK;
+    }//end if
+
+    memcpy(tmp, etn->keys + lo, (hi - lo) * sizeof(e_etn_key_t));
+    next = 0;
+    e_etn_inline_fill(etn->keys + lo - 1, hi - lo, 1, tmp, &next);
+
+    return E_OK;
+}//end e_etn_inline_range
+
+static inline void e_etn_inline_fill(e_etn_key_t *dst, uint32_t k, uint32_t i, const e_etn_key_t *src, uint32_t *next) {
+    /* an in-order walk of the implicit tree takes the sorted keys in order, dst is 1-based */
+    if(i <= k) {
+        e_etn_inline_fill(dst, k, 2 * i, src, next);
+        dst[i] = src[(*next)++];
+        e_etn_inline_fill(dst, k, 2 * i + 1, src, next);
+    }//end if
+}//end e_etn_inline_fill
+
+static inline uint64_t e_etn_inline_prefix(const char *label, size_t len) {
+    size_t      i;
+    uint64_t    prefix;
+
+    prefix = 0;
+    for(i = 0 ; i < sizeof(prefix) ; i++) {
+        prefix <<= 8;
+        if(i < len) {
+            prefix |= (u_char)e_ascii_tolower(label[i]);
+        }//end if
+    }//end for
+
+    return prefix;
+}//end e_etn_inline_prefix
+
+static inline int e_etn_inline_cmp(e_etn_t *etn, const e_etn_key_t *key, uint64_t prefix, const char *label, size_t label_len) {
+    size_t      len;
+    const char  *s;
+
+    if(key->prefix != prefix) {
+        return key->prefix < prefix ? -1 : 1;
+    }//end if
+
+    /* the prefixes hold all of the shorter label, only the lengths are left */
+    if(key->len <= sizeof(prefix) || label_len <= sizeof(prefix)) {
+        return (int)key->len - (int)label_len;
+    }//end if
+
+    s = e_etn_node_label(etn, key->node, &len, etn->wide);
+    return e_etn_strncmp(s + sizeof(prefix), len - sizeof(prefix), label + sizeof(prefix), label_len - sizeof(prefix));
+}//end e_etn_inline_cmp
+
+static inline uint32_t e_etn_find_inline(e_etn_t *etn, const char *label, size_t label_len, uint32_t lo, uint32_t hi) {
+    int                 ret;
+    uint32_t            i, k;
+    uint64_t            prefix;
+    const e_etn_key_t   *keys;
+
+    prefix = e_etn_inline_prefix(label, label_len);
+    k = hi - lo;
+    ret = 0;
+
+    if(k <= E_ETN_INLINE_SCAN_MAX) {
+        for(i = lo ; i < hi ; i++) {
+            ret = e_etn_inline_cmp(etn, &etn->keys[i], prefix, label, label_len);
+            if(ret == 0) {
+                return etn->keys[i].node;
+            }//end if
+            if(ret > 0) {
+                break;
+            }//end if
+        }//end for
+        return E_ETN_NOT_FOUND;
+    }//end if
+
+    keys = etn->keys + lo - 1;
+    for(i = 1 ; i <= k ; i = 2 * i + (ret < 0)) {
+        /* the grandchildren of i share a cache line, fetch them while i is compared */
+        if(4 * i <= k) {
+            E_PREFETCH(&keys[4 * i]);
+        }//end if
+        ret = e_etn_inline_cmp(etn, &keys[i], prefix, label, label_len);
+        if(ret == 0) {
+            return keys[i].node;
+        }//end if
+    }//end for
+
+    return E_ETN_NOT_FOUND;
+}//end e_etn_find_inline
+
+static inline void e_etn_walk_search(e_etn_t *etn, const char *domain, size_t end, e_etn_walk_t *w, bool wide) {
+    bool        wildcard;
+    size_t      start, pos;
+    uint32_t    lo, hi, f, u, type, parent;
+    uint64_t    h, prev;
+
+    pos = end;
+    lo = 0;
+    hi = etn->num_TLD;
+    wildcard = false;
+    parent = E_ETN_NOT_FOUND;
+    h = e_etn_hash_init(0);
+
+    /* the current label is domain[start, pos), it is the depth-th from the right, h hashes those right of it */
+    while(true) {
+        for(start = pos ; start > 0 && domain[start - 1] != '.' ; start--);
+        w->depth++;
+        if(pos == end) {
+            w->tld = start;
+        }//end if
+
+        /* only a label that can be part of the suffix is hashed */
+        prev = h;
+        if(wildcard) {
+            h = e_etn_hash_update(h, domain + start, pos - start);
+            w->hash = h;
+            w->suffix = start;
+            w->suffix_labels = w->depth;
+            w->suffix_id = parent;
+            w->rule = E_ETN_RULE_WILDCARD;
+        }//end if
+        if(lo == hi) {
+            break;
+        }//end if
+
+        f = e_etn_find(etn, domain + start, pos - start, lo, hi, wide);
+        if(f == E_ETN_NOT_FOUND) {
+            break;
+        }//end if
+        if(!wildcard) {
+            h = e_etn_hash_update(h, domain + start, pos - start);
+        }//end if
+
+        u = e_etn_node_children(etn, f, &w->icann, wide);
+        e_etn_children_decode(etn, u, &lo, &hi, &type, &wildcard, wide);
+        if(type == etn->node_type_normal) {
+            w->suffix = start;
+            w->suffix_labels = w->depth;
+            w->suffix_id = f;
+            w->hash = h;
+            w->rule = E_ETN_RULE_NORMAL;
+        }//end if
+        else if(type == etn->node_type_exception) {
+            w->suffix = pos + 1;
+            w->suffix_labels = w->depth - 1;
+            w->suffix_id = parent;
+            w->hash = prev;
+            w->rule = E_ETN_RULE_EXCEPTION;
+            break;
+        }//end if
+
+        if(start == 0) {
+            break;
+        }//end if
+        pos = start - 1;
+        parent = f;
+    }//end while
+
+    w->start = start;
+}//end e_etn_walk_search
+
+static inline void e_etn_walk_cursor(e_etn_cursor_t *cursor, const char *domain, size_t end, e_etn_walk_t *w, bool wide) {
+    bool            wildcard;
+    char            c;
+    size_t          a, b, start, pos;
+    uint32_t        m, lo, hi, f, u, type, from, parent;
+    e_etn_t         *etn;
+    e_etn_frame_t   *frame;
+    char            *prev;
+
+    /* the trailing labels this domain shares with the previous one */
+    prev = cursor->prev + E_ETN_DOMAIN_MAX - cursor->len;
+    m = 0;
+    for(a = end, b = cursor->len ; a > 0 && b > 0 ; a--, b--) {
+        c = e_ascii_tolower(domain[a - 1]);
+        if(c != prev[b - 1]) {
+            break;
+        }//end if
+        if(c == '.') {
+            m++;
+        }//end if
+    }//end for
+    if(a == 0 ? b == 0 || prev[b - 1] == '.' : b == 0 && domain[a - 1] == '.') {
+        m++;
+    }//end if
+    if(!cursor->stopped && m > cursor->depth) {
+        /* only a new cursor has walked fewer labels than its domain has */
+        m = cursor->depth;
+    }//end if
+
+    /* keep the previous domain for the next one, the shared tail is already there */
+    cursor->len = end;
+    prev = cursor->prev + E_ETN_DOMAIN_MAX - end;
+    for(b = 0 ; b < a ; b++) {
+        prev[b] = e_ascii_tolower(domain[b]);
+    }//end for
+
+    w->tld = end - cursor->tld_back;
+    if(cursor->stopped && m >= cursor->depth) {
+        /* the previous walk broke off within the shared labels, so does this one */
+        e_etn_cursor_restore(&(cursor->last), w, end);
+        w->depth = cursor->depth;
+        w->start = end - cursor->last.pos_back;
+        return;
+    }//end if
+
+    frame = &(cursor->frames[m]);
+    e_etn_cursor_restore(frame, w, end);
+    w->depth = m;
+    if(m > 0 && frame->pos_back > end) {
+        /* every label is shared, the domain ends where the previous one went on */
+        w->start = 0;
+        cursor->depth = m;
+        cursor->stopped = false;
+        cursor->last = *frame;
+        cursor->last.pos_back = end;
+        return;
+    }//end if
+
+    etn = cursor->etn;
+    lo = frame->lo;
+    hi = frame->hi;
+    wildcard = frame->wildcard;
+    from = cursor->sorted && frame->node < hi && frame->node >= lo && lo != 0 ? frame->node : E_ETN_NOT_FOUND;
+    parent = m > 0 ? cursor->frames[m - 1].node : E_ETN_NOT_FOUND;
+    pos = end - frame->pos_back;
+    cursor->stopped = true;
+
+    while(true) {
+        for(start = pos ; start > 0 && domain[start - 1] != '.' ; start--);
+        frame = &(cursor->frames[w->depth]);
+        frame->node = E_ETN_NOT_FOUND;
+        w->depth++;
+        if(pos == end) {
+            w->tld = start;
+        }//end if
+
+        if(wildcard) {
+            w->suffix = start;
+            w->suffix_labels = w->depth;
+            w->suffix_id = parent;
+            w->rule = E_ETN_RULE_WILDCARD;
+        }//end if
+        if(lo == hi) {
+            break;
+        }//end if
+
+        if(from != E_ETN_NOT_FOUND) {
+            f = e_etn_find_after(etn, domain + start, pos - start, lo, hi, from, wide);
+            from = E_ETN_NOT_FOUND;
+        }//end if
+        else {
+            f = e_etn_find(etn, domain + start, pos - start, lo, hi, wide);
+        }//end else
+        frame->node = f;
+        if(f == E_ETN_NOT_FOUND) {
+            break;
+        }//end if
+
+        u = e_etn_node_children(etn, f, &w->icann, wide);
+        e_etn_children_decode(etn, u, &lo, &hi, &type, &wildcard, wide);
+        if(type == etn->node_type_normal) {
+            w->suffix = start;
+            w->suffix_labels = w->depth;
+            w->suffix_id = f;
+            w->rule = E_ETN_RULE_NORMAL;
+        }//end if
+        else if(type == etn->node_type_exception) {
+            w->suffix = pos + 1;
+            w->suffix_labels = w->depth - 1;
+            w->suffix_id = parent;
+            w->rule = E_ETN_RULE_EXCEPTION;
+            break;
+        }//end if
+
+        /* what the next label starts from, the last one has no next label */
+        e_etn_cursor_frame(&(cursor->frames[w->depth]), w, end, end + 1 - start, lo, hi, wildcard);
+        if(start == 0) {
+            cursor->stopped = false;
+            break;
+        }//end if
+        pos = start - 1;
+        parent = f;
+    }//end while
+
+    w->start = start;
+    cursor->depth = (uint32_t)w->depth;
+    cursor->tld_back = end - w->tld;
+    e_etn_cursor_frame(&(cursor->last), w, end, end - start, 0, 0, false);
+}//end e_etn_walk_cursor
+
+static inline void e_etn_cursor_frame(e_etn_frame_t *frame, const e_etn_walk_t *w, size_t end, size_t pos_back, uint32_t lo, uint32_t hi, bool wildcard) {
+    frame->lo = lo;
+    frame->hi = hi;
+    frame->pos_back = pos_back;
+    frame->suffix_back = end + 1 - w->suffix;
+    frame->suffix_labels = w->suffix_labels;
+    frame->suffix_id = w->suffix_id;
+    frame->rule = w->rule;
+    frame->icann = w->icann;
+    frame->wildcard = wildcard;
+}//end e_etn_cursor_frame
+
+static inline void e_etn_cursor_restore(const e_etn_frame_t *frame, e_etn_walk_t *w, size_t end) {
+    w->suffix = end + 1 - frame->suffix_back;
+    w->suffix_labels = frame->suffix_labels;
+    w->suffix_id = frame->suffix_id;
+    w->rule = (e_etn_rule_t)frame->rule;
+    w->icann = frame->icann;
+}//end e_etn_cursor_restore
+
+static inline void e_etn_walk_dfa(e_etn_dfa_t *dfa, const char *domain, size_t end, e_etn_walk_t *w) {
+    bool        keyed;
+    size_t      p, pos, start;
+    uint8_t     info;
+    uint32_t    s, c;
+    uint64_t    h, prev, key;
+
+    s = dfa->start;
+    pos = end;
+    keyed = false;
+    key = 0;
+    h = e_etn_hash_init(0);
+    w->depth = 1;
+    for(p = end ; ; p--) {
+        /* the label domain[p, pos) ends here, act on what it matched */
+        c = p > 0 ? dfa->classes[(u_char)domain[p - 1]] : E_ETN_DFA_CLASS_DOT;
+        if(c == E_ETN_DFA_CLASS_DOT) {
+            if(pos == end) {
+                w->tld = p;
+            }//end if
+
+            /* only a label that can be part of the suffix is hashed */
+            info = dfa->info[s];
+            prev = h;
+            if(info & (E_ETN_DFA_WILDCARD | E_ETN_DFA_MATCH)) {
+                h = e_etn_hash_update(h, domain + p, pos - p);
+            }//end if
+            if(info & E_ETN_DFA_WILDCARD) {
+                w->suffix = p;
+                w->suffix_labels = w->depth;
+                w->hash = h;
+                w->rule = E_ETN_RULE_WILDCARD;
+
+                /* the suffix id is the parent, there is none for a wildcard at the top */
+                key = prev;
+                keyed = w->depth > 1;
+            }//end if
+            if(!(info & E_ETN_DFA_MATCH)) {
+                w->start = p;
+                break;
+            }//end if
+
+            w->icann = info & E_ETN_DFA_ICANN;
+            if(info & E_ETN_DFA_NORMAL) {
+                w->suffix = p;
+                w->suffix_labels = w->depth;
+                w->hash = h;
+                w->rule = E_ETN_RULE_NORMAL;
+                key = h;
+                keyed = true;
+            }//end if
+            else if(info & E_ETN_DFA_EXCEPTION) {
+                w->suffix = pos + 1;
+                w->suffix_labels = w->depth - 1;
+                w->hash = prev;
+                w->rule = E_ETN_RULE_EXCEPTION;
+                key = prev;
+                keyed = w->depth > 1;
+                w->start = p;
+                break;
+            }//end if
+
+            if(p == 0) {
+                w->start = 0;
+                break;
+            }//end if
+            pos = p - 1;
+            w->depth++;
+        }//end if
+
+        s = dfa->trans[s * dfa->num_classes + c];
+        if(s == E_ETN_DFA_DEAD) {
+            /* the label holding domain[p - 1] matches nothing */
+            for(start = p - 1 ; start > 0 && domain[start - 1] != '.' ; start--);
+            if(pos == end) {
+                w->tld = start;
+            }//end if
+            w->start = start;
+            break;
+        }//end if
+    }//end for
+
+    /* only the labels the automaton matched are looked up, so the node is there */
+    if(keyed) {
+        w->suffix_id = e_etn_dfa_id(dfa, key);
+    }//end if
+}//end e_etn_walk_dfa
+
+static inline e_errno_t e_etn_wire_labels(const uint8_t *msg, size_t msg_len, size_t name_off, uint16_t *offs, uint32_t *n, size_t *wire_len) {
+    bool    jumped;
+    size_t  pos, total, target;
+
+    /*
+     * offs gets the first byte of every label and of the root after them.
+     * A pointer must go back from where it is, so a chain of pointers ends, and
+     * the name must stay within E_ETN_DOMAIN_MAX, so a loop through labels ends.
+     */
+    *n = 0;
+    jumped = false;
+    total = 1;
+    for(pos = name_off ; ; ) {
+        if(E_UNLIKELY(pos >= msg_len || pos > UINT16_MAX)) {
+            return E_ERR_INVAL;
+        }//end if
+
+        if((msg[pos] & E_ETN_WIRE_POINTER) == E_ETN_WIRE_POINTER) {
+            if(E_UNLIKELY(pos + 1 >= msg_len)) {
+                return E_ERR_INVAL;
+            }//end if
+            target = ((size_t)(msg[pos] & ~E_ETN_WIRE_POINTER) << 8) | msg[pos + 1];
+            if(E_UNLIKELY(target >= pos)) {
+                return E_ERR_INVAL;
+            }//end if
+            if(!jumped) {
+                *wire_len = pos + 2 - name_off;
+                jumped = true;
+            }//end if
+            pos = target;
+            continue;
+        }//end if
+
+        /* 0x40 and 0x80 are the extended and binary label types, long obsolete */
+        if(E_UNLIKELY(msg[pos] & E_ETN_WIRE_POINTER)) {
+            return E_ERR_INVAL;
+        }//end if
+        if(msg[pos] == 0) {
+            break;
+        }//end if
+
+        total += msg[pos] + 1;
+        if(E_UNLIKELY(pos + 1 + msg[pos] > msg_len || total > E_ETN_DOMAIN_MAX + 1 || *n == E_ETN_WIRE_LABELS)) {
+            return E_ERR_INVAL;
+        }//end if
+        offs[(*n)++] = (uint16_t)pos;
+        pos += 1 + msg[pos];
+    }//end for
+
+    if(!jumped) {
+        *wire_len = pos + 1 - name_off;
+    }//end if
+
+    /* the root is where the name ends */
+    offs[*n] = (uint16_t)pos;
+    return E_OK;
+}//end e_etn_wire_labels
+
+static inline void e_etn_walk_wire(e_etn_t *etn, const uint8_t *msg, const uint16_t *offs, uint32_t n, e_etn_wire_result_t *result, bool wide) {
+    bool        wildcard;
+    uint32_t    d, lo, hi, f, u, type, parent;
+    const char  *label;
+
+    /* e_etn_walk_search() over labels that are not next to each other */
+    result->icann = false;
+    result->suffix_labels = 0;
+    result->suffix_id = E_ETN_SUFFIX_NONE;
+    result->rule = E_ETN_RULE_DEFAULT;
+    lo = 0;
+    hi = etn->num_TLD;
+    wildcard = false;
+    parent = E_ETN_NOT_FOUND;
+    for(d = 1 ; d <= n ; d++) {
+        if(wildcard) {
+            result->suffix_labels = d;
+            result->suffix_id = parent;
+            result->rule = E_ETN_RULE_WILDCARD;
+        }//end if
+        if(lo == hi) {
+            break;
+        }//end if
+
+        /* e_etn_find() folds the case of the label as it compares, 0x20 randomization is no matter */
+        label = (const char *)msg + offs[n - d] + 1;
+        f = e_etn_find(etn, label, msg[offs[n - d]], lo, hi, wide);
+        if(f == E_ETN_NOT_FOUND) {
+            break;
+        }//end if
+
+        u = e_etn_node_children(etn, f, &result->icann, wide);
+        e_etn_children_decode(etn, u, &lo, &hi, &type, &wildcard, wide);
+        if(type == etn->node_type_normal) {
+            result->suffix_labels = d;
+            result->suffix_id = f;
+            result->rule = E_ETN_RULE_NORMAL;
+        }//end if
+        else if(type == etn->node_type_exception) {
+            result->suffix_labels = d - 1;
+            result->suffix_id = parent;
+            result->rule = E_ETN_RULE_EXCEPTION;
+            break;
+        }//end if
+        parent = f;
+    }//end for
+
+    /* if no rules match, the prevailing rule is "*" */
+    if(result->suffix_labels == 0 && n > 0) {
+        result->suffix_labels = 1;
+        result->suffix_id = E_ETN_SUFFIX_NONE;
+        result->rule = E_ETN_RULE_DEFAULT;
+    }//end if
+}//end e_etn_walk_wire
+
+static inline e_errno_t e_etn_iov_labels(const struct iovec *iov, int iovcnt, char *scratch, const char **labels, uint8_t *lens, uint16_t *starts, uint32_t *n, size_t *len) {
+    int         i;
+    size_t      end, pos, start, off, seg_len, piece, label_len;
+    const char  *base, *dot;
+
+    if(E_UNLIKELY(iovcnt < 0)) {
         return E_ERR_INVAL;
     }//end if
 
-    etn->children = e_malloc(etn->children_length * sizeof(uint32_t));
-    if(E_UNLIKELY(!etn->children)) {
-        fclose(fp);
+    /* a trailing root dot is not part of any label, it is in the last segment that is not empty */
+    end = 0;
+    for(i = 0 ; i < iovcnt ; i++) {
+        if(E_UNLIKELY(iov[i].iov_len > E_ETN_DOMAIN_MAX - end)) {
+            return E_ERR_INVAL;
+        }//end if
+        end += iov[i].iov_len;
+    }//end for
+    *len = end;
+    for(i = iovcnt ; i > 0 && iov[i - 1].iov_len == 0 ; i--);
+    if(i > 0 && ((const char *)iov[i - 1].iov_base)[iov[i - 1].iov_len - 1] == '.') {
+        end--;
+    }//end if
+
+    /*
+     * Labels are split at dots with memchr() and point into their segment. A label that goes on into
+     * the next segment is gathered into scratch at its offset in the name, where no other label is.
+     */
+    *n = 0;
+    pos = start = label_len = 0;
+    labels[0] = scratch;
+    for(i = 0 ; i < iovcnt && pos < end ; i++) {
+        base = iov[i].iov_base;
+        seg_len = E_MIN(iov[i].iov_len, end - pos);
+        for(off = 0 ; off < seg_len ; ) {
+            dot = memchr(base + off, '.', seg_len - off);
+            piece = dot ? (size_t)(dot - base) - off : seg_len - off;
+            if(pos == start) {
+                labels[*n] = base + off;
+            }//end if
+            else if(piece > 0) {
+                if(labels[*n] != scratch + start) {
+                    memcpy(scratch + start, labels[*n], label_len);
+                    labels[*n] = scratch + start;
+                }//end if
+                memcpy(scratch + start + label_len, base + off, piece);
+            }//end if
+            label_len += piece;
+            pos += piece;
+            off += piece;
+            if(!dot) {
+                break;
+            }//end if
+
+            lens[*n] = (uint8_t)label_len;
+            starts[(*n)++] = (uint16_t)start;
+            start = ++pos;
+            off++;
+            label_len = 0;
+            labels[*n] = scratch;
+        }//end for
+    }//end for
+
+    if(end > 0) {
+        lens[*n] = (uint8_t)label_len;
+        starts[(*n)++] = (uint16_t)start;
+    }//end if
+    starts[*n] = (uint16_t)end;
+    return E_OK;
+}//end e_etn_iov_labels
+
+static inline void e_etn_iov_position(const struct iovec *iov, int iovcnt, size_t pos, int *seg, size_t *off) {
+    int i;
+
+    /* empty segments and the end of one are skipped to the first byte after them */
+    for(i = 0 ; i < iovcnt ; i++) {
+        if(pos < iov[i].iov_len) {
+            *seg = i;
+            *off = pos;
+            return;
+        }//end if
+        pos -= iov[i].iov_len;
+    }//end for
+
+    *seg = iovcnt;
+    *off = 0;
+}//end e_etn_iov_position
+
+static inline void e_etn_walk_iov(e_etn_t *etn, const char **labels, const uint8_t *lens, uint32_t n, e_etn_iov_result_t *result, bool wide) {
+    bool        wildcard;
+    uint32_t    d, lo, hi, f, u, type, parent;
+
+    /* e_etn_walk_wire() over labels that are each in one piece */
+    result->icann = false;
+    result->suffix_labels = 0;
+    result->suffix_id = E_ETN_SUFFIX_NONE;
+    result->rule = E_ETN_RULE_DEFAULT;
+    lo = 0;
+    hi = etn->num_TLD;
+    wildcard = false;
+    parent = E_ETN_NOT_FOUND;
+    for(d = 1 ; d <= n ; d++) {
+        if(wildcard) {
+            result->suffix_labels = d;
+            result->suffix_id = parent;
+            result->rule = E_ETN_RULE_WILDCARD;
+        }//end if
+        if(lo == hi) {
+            break;
+        }//end if
+
+        f = e_etn_find(etn, labels[n - d], lens[n - d], lo, hi, wide);
+        if(f == E_ETN_NOT_FOUND) {
+            break;
+        }//end if
+
+        u = e_etn_node_children(etn, f, &result->icann, wide);
+        e_etn_children_decode(etn, u, &lo, &hi, &type, &wildcard, wide);
+        if(type == etn->node_type_normal) {
+            result->suffix_labels = d;
+            result->suffix_id = f;
+            result->rule = E_ETN_RULE_NORMAL;
+        }//end if
+        else if(type == etn->node_type_exception) {
+            result->suffix_labels = d - 1;
+            result->suffix_id = parent;
+            result->rule = E_ETN_RULE_EXCEPTION;
+            break;
+        }//end if
+        parent = f;
+    }//end for
+
+    /* if no rules match, the prevailing rule is "*" */
+    if(result->suffix_labels == 0 && n > 0) {
+        result->suffix_labels = 1;
+        result->suffix_id = E_ETN_SUFFIX_NONE;
+        result->rule = E_ETN_RULE_DEFAULT;
+    }//end if
+}//end e_etn_walk_iov
+
+static inline uint32_t e_etn_metadata(e_etn_t *etn, uint32_t id) {
+    uint32_t                i;
+    const e_etn_stacked_t   *stacked;
+
+    if(id == E_ETN_SUFFIX_NONE) {
+        return 0;
+    }//end if
+
+    /* the id of a stack is in the range of one of its tables */
+    for(i = etn->num_stacked, stacked = etn->stacked ; i > 0 ; i--) {
+        if(id >= stacked[i - 1].id_off) {
+            etn = stacked[i - 1].etn;
+            id -= stacked[i - 1].id_off;
+            break;
+        }//end if
+    }//end for
+
+    return etn->metadata ? etn->metadata[id] : 0;
+}//end e_etn_metadata
+
+static inline void e_etn_copy_range(e_etn_t *dst, e_etn_t *src, uint32_t dst_lo, uint32_t dst_hi, uint32_t src_lo, uint32_t src_hi) {
+    bool        icann, wildcard;
+    size_t      len;
+    uint32_t    i, f, lo, hi, type, s_lo, s_hi;
+    const char  *label;
+
+    /* a word dst has from its own file is kept */
+    for(i = src_lo ; i < src_hi && dst_lo < dst_hi ; i++) {
+        label = e_etn_node_label(src, i, &len, src->wide);
+        f = e_etn_find(dst, label, len, dst_lo, dst_hi, dst->wide);
+        if(f == E_ETN_NOT_FOUND) {
+            continue;
+        }//end if
+        if(src->metadata[i] != 0 && dst->metadata_buf[f] == 0) {
+            dst->metadata_buf[f] = src->metadata[i];
+        }//end if
+
+        e_etn_children_decode(src, e_etn_node_children(src, i, &icann, src->wide), &s_lo, &s_hi, &type, &wildcard, src->wide);
+        e_etn_children_decode(dst, e_etn_node_children(dst, f, &icann, dst->wide), &lo, &hi, &type, &wildcard, dst->wide);
+        e_etn_copy_range(dst, src, lo, hi, s_lo, s_hi);
+    }//end for
+}//end e_etn_copy_range
+
+static inline uint32_t e_etn_find_node(e_etn_t *etn, const char *name, size_t len) {
+    bool        wildcard, icann;
+    size_t      start, pos;
+    uint32_t    lo, hi, f, u, type;
+
+    if(len > 0 && name[len - 1] == '.') {
+        len--;
+    }//end if
+    if(E_UNLIKELY(len == 0 || len > E_ETN_DOMAIN_MAX)) {
+        return E_ETN_NOT_FOUND;
+    }//end if
+
+    /* every label of the name down from its TLD is a node */
+    lo = 0;
+    hi = etn->num_TLD;
+    for(pos = len ; ; pos = start - 1) {
+        for(start = pos ; start > 0 && name[start - 1] != '.' ; start--);
+        f = lo == hi ? E_ETN_NOT_FOUND : e_etn_find(etn, name + start, pos - start, lo, hi, etn->wide);
+        if(f == E_ETN_NOT_FOUND || start == 0) {
+            return f;
+        }//end if
+
+        u = e_etn_node_children(etn, f, &icann, etn->wide);
+        e_etn_children_decode(etn, u, &lo, &hi, &type, &wildcard, etn->wide);
+    }//end for
+}//end e_etn_find_node
+
+static inline uint32_t e_etn_parent(e_etn_t *etn, uint32_t id, bool wide) {
+    bool        wildcard, icann;
+    uint32_t    i, lo, hi, type;
+
+    /* nodes keep no parent, find the one whose children hold id */
+    for(i = 0 ; i < etn->nodes_length ; i++) {
+        e_etn_children_decode(etn, e_etn_node_children(etn, i, &icann, wide), &lo, &hi, &type, &wildcard, wide);
+        if(lo <= id && id < hi) {
+            return i;
+        }//end if
+    }//end for
+
+    return E_ETN_NOT_FOUND;
+}//end e_etn_parent
+
+static inline e_errno_t e_etn_dfa_build(e_etn_t *etn) {
+    size_t              i, c, size;
+    uint32_t            *row;
+    e_etn_dfa_t         *dfa;
+    e_etn_dfa_builder_t b;
+
+    dfa = e_calloc(1, sizeof(e_etn_dfa_t));
+    if(E_UNLIKELY(!dfa)) {
         return E_ERR_FAMEM;
     }//end if
 
-    nread = fread(etn->children, sizeof(uint32_t), etn->children_length, fp);
-    if(nread != etn->children_length) {
-        fclose(fp);
-        return E_ERR_INVAL;
+    /* a class for every byte used in a label, the table holds lower case labels only */
+    dfa->num_classes = E_ETN_DFA_CLASS_DOT + 1;
+    dfa->classes['.'] = E_ETN_DFA_CLASS_DOT;
+    for(i = 0 ; i < etn->text_length ; i++) {
+        c = (u_char)etn->text[i];
+        if(c != '.' && dfa->classes[c] == 0) {
+            if(E_UNLIKELY(dfa->num_classes == 255)) {
+                e_etn_dfa_free(dfa);
+                return E_ERR_INVAL;
+            }//end if
+            dfa->classes[c] = dfa->num_classes++;
+        }//end if
+    }//end for
+    for(c = 'A' ; c <= 'Z' ; c++) {
+        dfa->classes[c] = dfa->classes[c - 'A' + 'a'];
+    }//end for
+
+    /* the node ids at most two thirds full */
+    for(size = 16 ; size < etn->nodes_length + etn->nodes_length / 2 ; size *= 2);
+    dfa->ids = e_malloc(size * sizeof(e_etn_dfa_id_t));
+    dfa->ids_mask = size - 1;
+
+    b.etn = etn;
+    b.dfa = dfa;
+    b.err = E_ERR_FAMEM;
+    b.hash_size = 1024;
+    b.hash = e_calloc(b.hash_size, sizeof(uint32_t));
+    row = e_malloc(dfa->num_classes * sizeof(uint32_t));
+    if(E_UNLIKELY(!dfa->ids || !b.hash || !row)) {
+        e_free(b.hash);
+        e_free(row);
+        e_etn_dfa_free(dfa);
+        return E_ERR_FAMEM;
     }//end if
+    for(i = 0 ; i < size ; i++) {
+        dfa->ids[i].key = 0;
+        dfa->ids[i].node = E_ETN_NOT_FOUND;
+    }//end for
 
-    for(i = 0 ; i < nread ; i++) {
-        etn->children[i] = htonl(etn->children[i]);
+    /* the dead state first, then any label under a wildcard, which loops until the dot */
+    for(c = 0 ; c < dfa->num_classes ; c++) {
+        row[c] = E_ETN_DFA_DEAD;
     }//end for
+    dfa->start = e_etn_dfa_state(&b, 0, row);
+    if(E_LIKELY(dfa->start == E_ETN_DFA_DEAD)) {
+        for(c = 0 ; c < dfa->num_classes ; c++) {
+            row[c] = c == E_ETN_DFA_CLASS_DOT ? E_ETN_DFA_DEAD : E_ETN_DFA_ANY;
+        }//end for
+        dfa->start = e_etn_dfa_state(&b, E_ETN_DFA_WILDCARD, row);
+    }//end if
+    if(E_LIKELY(dfa->start == E_ETN_DFA_ANY)) {
+        dfa->start = e_etn_dfa_children(&b, E_ETN_NOT_FOUND, e_etn_hash_init(0));
+    }//end if
+    e_free(row);
+    e_free(b.hash);
+    if(E_UNLIKELY(dfa->start == E_ETN_NOT_FOUND)) {
+        e_etn_dfa_free(dfa);
+        return b.err;
+    }//end if
 
-    fclose(fp);
+    etn->dfa = dfa;
     return E_OK;
-}//end e_etn_load_file
+}//end e_etn_dfa_build
+
+static inline void e_etn_dfa_free(e_etn_dfa_t *dfa) {
+    e_free(dfa->info);
+    e_free(dfa->trans);
+    e_free(dfa->ids);
+    e_free(dfa);
+}//end e_etn_dfa_free
+
+static inline uint32_t e_etn_dfa_children(e_etn_dfa_builder_t *b, uint32_t node, uint64_t h) {
+    bool        icann, wildcard;
+    uint32_t    i, lo, hi, u, type, ret, *items;
+
+    /* the root has no children record of its own */
+    lo = 0;
+    hi = b->etn->num_TLD;
+    wildcard = false;
+    if(node != E_ETN_NOT_FOUND) {
+        u = e_etn_node_children(b->etn, node, &icann, b->etn->wide);
+        e_etn_children_decode(b->etn, u, &lo, &hi, &type, &wildcard, b->etn->wide);
+    }//end if
+
+    items = e_malloc((hi - lo + 1) * sizeof(uint32_t));
+    if(E_UNLIKELY(!items)) {
+        return E_ETN_NOT_FOUND;
+    }//end if
+    for(i = lo ; i < hi ; i++) {
+        items[i - lo] = i;
+    }//end for
+
+    ret = e_etn_dfa_trie(b, items, hi - lo, 0, wildcard, h);
+    e_free(items);
+    return ret;
+}//end e_etn_dfa_children
+
+static inline uint32_t e_etn_dfa_trie(e_etn_dfa_builder_t *b, uint32_t *items, uint32_t n, size_t k, bool wildcard, uint64_t h) {
+    bool        icann, child_wildcard;
+    size_t      len;
+    uint8_t     info;
+    uint32_t    i, c, ret, u, lo, hi, type, *row, *count, *sorted;
+    uint64_t    child;
+    e_etn_dfa_t *dfa;
+    const char  *s;
+
+    /*
+     * items are the nodes whose labels end in the same k bytes, read so far.
+     * They are split by the byte before those, each group is the next state.
+     * h is the hash of the labels above them.
+     */
+    dfa = b->dfa;
+    row = e_calloc(dfa->num_classes * 2 + 1, sizeof(uint32_t));
+    sorted = e_malloc((n + 1) * sizeof(uint32_t));
+    if(E_UNLIKELY(!row || !sorted)) {
+        e_free(row);
+        e_free(sorted);
+        return E_ETN_NOT_FOUND;
+    }//end if
+    count = row + dfa->num_classes;
+
+    ret = 0;
+    info = wildcard ? E_ETN_DFA_WILDCARD : 0;
+    for(i = 0 ; i < n ; i++) {
+        s = e_etn_node_label(b->etn, items[i], &len, b->etn->wide);
+        if(len > k) {
+            count[dfa->classes[(u_char)s[len - k - 1]] + 1]++;
+            continue;
+        }//end if
+
+        /* a whole label is read, the dot goes on to its children */
+        u = e_etn_node_children(b->etn, items[i], &icann, b->etn->wide);
+        e_etn_children_decode(b->etn, u, &lo, &hi, &type, &child_wildcard, b->etn->wide);
+        info |= E_ETN_DFA_MATCH | (icann ? E_ETN_DFA_ICANN : 0);
+        if(type == b->etn->node_type_normal) {
+            info |= E_ETN_DFA_NORMAL;
+        }//end if
+        else if(type == b->etn->node_type_exception) {
+            info |= E_ETN_DFA_EXCEPTION;
+        }//end if
+        child = e_etn_hash_update(h, s, len);
+        if(E_UNLIKELY(!e_etn_dfa_id_add(dfa, child, items[i]))) {
+            b->err = E_ERR_INVAL;
+            ret = E_ETN_NOT_FOUND;
+            break;
+        }//end if
+        row[E_ETN_DFA_CLASS_DOT] = ret = e_etn_dfa_children(b, items[i], child);
+    }//end for
+
+    /* group the rest by their next byte */
+    for(c = 1 ; c <= dfa->num_classes ; c++) {
+        count[c] += count[c - 1];
+    }//end for
+    for(i = 0 ; i < n ; i++) {
+        s = e_etn_node_label(b->etn, items[i], &len, b->etn->wide);
+        if(len > k) {
+            sorted[count[dfa->classes[(u_char)s[len - k - 1]]]++] = items[i];
+        }//end if
+    }//end for
+
+    for(c = 0, i = 0 ; c < dfa->num_classes && ret != E_ETN_NOT_FOUND ; c++) {
+        if(c == E_ETN_DFA_CLASS_DOT) {
+            continue;
+        }//end if
+        if(i == count[c]) {
+            row[c] = wildcard ? E_ETN_DFA_ANY : E_ETN_DFA_DEAD;
+            continue;
+        }//end if
+        row[c] = ret = e_etn_dfa_trie(b, sorted + i, count[c] - i, k + 1, wildcard, h);
+        i = count[c];
+    }//end for
+
+    if(ret != E_ETN_NOT_FOUND) {
+        ret = e_etn_dfa_state(b, info, row);
+    }//end if
+
+    e_free(row);
+    e_free(sorted);
+    return ret;
+}//end e_etn_dfa_trie
+
+static inline uint32_t e_etn_dfa_state(e_etn_dfa_builder_t *b, uint8_t info, const uint32_t *row) {
+    size_t      c, h, size;
+    uint8_t     *new_info;
+    uint32_t    i, id, *new_trans, *new_hash;
+    e_etn_dfa_t *dfa;
+
+    /* states with the same info and rows are one state, this keeps the automaton minimal */
+    dfa = b->dfa;
+    h = (0xcbf29ce484222325ULL ^ info) * 0x100000001b3ULL;
+    for(c = 0 ; c < dfa->num_classes ; c++) {
+        h = (h ^ row[c]) * 0x100000001b3ULL;
+    }//end for
+    for(i = h & (b->hash_size - 1) ; b->hash[i] ; i = (i + 1) & (b->hash_size - 1)) {
+        id = b->hash[i] - 1;
+        if(dfa->info[id] == info && !memcmp(dfa->trans + (size_t)id * dfa->num_classes, row, dfa->num_classes * sizeof(uint32_t))) {
+            return id;
+        }//end if
+    }//end for
+
+    if(dfa->num_states == dfa->capacity) {
+        size = dfa->capacity ? dfa->capacity * 2 : 256;
+        new_info = e_realloc(dfa->info, size);
+        if(E_UNLIKELY(!new_info)) {
+            return E_ETN_NOT_FOUND;
+        }//end if
+        dfa->info = new_info;
+        new_trans = e_realloc(dfa->trans, size * dfa->num_classes * sizeof(uint32_t));
+        if(E_UNLIKELY(!new_trans)) {
+            return E_ETN_NOT_FOUND;
+        }//end if
+        dfa->trans = new_trans;
+        dfa->capacity = size;
+    }//end if
+
+    id = dfa->num_states++;
+    dfa->info[id] = info;
+    memcpy(dfa->trans + (size_t)id * dfa->num_classes, row, dfa->num_classes * sizeof(uint32_t));
+    b->hash[i] = id + 1;
+
+    /* keep the hash at most half full */
+    if(dfa->num_states * 2 > b->hash_size) {
+        new_hash = e_calloc(b->hash_size * 2, sizeof(uint32_t));
+        if(E_UNLIKELY(!new_hash)) {
+            return E_ETN_NOT_FOUND;
+        }//end if
+        for(i = 0 ; i < b->hash_size ; i++) {
+            if(b->hash[i]) {
+                id = b->hash[i] - 1;
+                for(h = (0xcbf29ce484222325ULL ^ dfa->info[id]) * 0x100000001b3ULL, c = 0 ; c < dfa->num_classes ; c++) {
+                    h = (h ^ dfa->trans[(size_t)id * dfa->num_classes + c]) * 0x100000001b3ULL;
+                }//end for
+                for(h &= b->hash_size * 2 - 1 ; new_hash[h] ; h = (h + 1) & (b->hash_size * 2 - 1));
+                new_hash[h] = b->hash[i];
+            }//end if
+        }//end for
+        e_free(b->hash);
+        b->hash = new_hash;
+        b->hash_size *= 2;
+        id = dfa->num_states - 1;
+    }//end if
+
+    return id;
+}//end e_etn_dfa_state
+
+static inline bool e_etn_dfa_id_add(e_etn_dfa_t *dfa, uint64_t h, uint32_t node) {
+    uint32_t    i;
+    uint64_t    key;
+
+    /* two nodes with one key could not be told apart, the automaton is not built then */
+    key = e_etn_hash_final(h);
+    for(i = key & dfa->ids_mask ; dfa->ids[i].node != E_ETN_NOT_FOUND ; i = (i + 1) & dfa->ids_mask) {
+        if(E_UNLIKELY(dfa->ids[i].key == key)) {
+            return false;
+        }//end if
+    }//end for
+
+    dfa->ids[i].key = key;
+    dfa->ids[i].node = node;
+    return true;
+}//end e_etn_dfa_id_add
+
+static inline uint32_t e_etn_dfa_id(const e_etn_dfa_t *dfa, uint64_t h) {
+    uint32_t    i;
+    uint64_t    key;
+
+    key = e_etn_hash_final(h);
+    for(i = key & dfa->ids_mask ; dfa->ids[i].key != key && dfa->ids[i].node != E_ETN_NOT_FOUND ; i = (i + 1) & dfa->ids_mask);
+    return dfa->ids[i].node;
+}//end e_etn_dfa_id
 
 static inline int e_etn_strncmp(const char *s1, size_t s1_len, const char *s2, size_t s2_len) {
-    size_t i, len;
+    int     c1, c2;
+    size_t  i, len;
 
     len = s1_len;
     if(len > s2_len) {
         len = s2_len;
     }//end if
 
+    /* labels in the table are lower case, s2 is folded as it is compared */
     for(i = 0; i < len; i++) {
-        if(s1[i] != s2[i]) {
-            return s1[i] - s2[i];
+        c1 = (u_char)s1[i];
+        c2 = (u_char)e_ascii_tolower(s2[i]);
+        if(c1 != c2) {
+            return c1 - c2;
         }//end if
     }//end for
 
     return s1_len - s2_len;
 }//end e_etn_strncmp
 
-static inline uint32_t e_etn_find(e_etn_t *etn, const char *label, uint32_t lo, uint32_t hi) {
+static inline uint32_t e_etn_find(e_etn_t *etn, const char *label, size_t label_len, uint32_t lo, uint32_t hi, bool wide) {
+    /* only the root has all the TLDs as children */
+    if(lo == 0 && hi == etn->num_TLD && etn->root_table) {
+        return e_etn_find_root(etn, label, label_len, wide);
+    }//end if
+
+    /* most labels of random names are in no range, see if the filter turns it away */
+    if(hi - lo >= E_ETN_BLOOM_MIN_RANGE && etn->bloom && !e_etn_bloom_check(etn, label, label_len, lo)) {
+        return E_ETN_NOT_FOUND;
+    }//end if
+
+    if(etn->keys) {
+        return e_etn_find_inline(etn, label, label_len, lo, hi);
+    }//end if
+
+    return e_etn_find_range(etn, label, label_len, lo, hi, wide);
+}//end e_etn_find
+
+static inline uint32_t e_etn_find_range(e_etn_t *etn, const char *label, size_t label_len, uint32_t lo, uint32_t hi, bool wide) {
     int         ret;
-    size_t      len, label_len;
+    size_t      len;
     uint32_t    mid;
     const char  *s;
 
-    label_len = strlen(label);
     while(lo < hi) {
         mid = lo + (hi - lo) / 2;
-        s = e_etn_node_label(etn, mid, &len);
+        s = e_etn_node_label(etn, mid, &len, wide);
         ret = e_etn_strncmp(s, len, label, label_len);
         if(ret < 0) {
             lo = mid + 1;
@@ -419,15 +3798,101 @@ static inline uint32_t e_etn_find(e_etn_t *etn, const char *label, uint32_t lo,
     }//end while
 
     return E_ETN_NOT_FOUND;
-}//end e_etn_find
+}//end e_etn_find_range
+
+static inline uint32_t e_etn_find_after(e_etn_t *etn, const char *label, size_t label_len, uint32_t lo, uint32_t hi, uint32_t from, bool wide) {
+    int         ret;
+    size_t      len;
+    uint32_t    i, step;
+    const char  *s;
+
+    /* sorted input puts the label at or after from, the label of the previous domain */
+    s = e_etn_node_label(etn, from, &len, wide);
+    ret = e_etn_strncmp(s, len, label, label_len);
+    if(ret == 0) {
+        return from;
+    }//end if
+    if(ret > 0) {
+        /* out of order after all, search the whole range */
+        return e_etn_find(etn, label, label_len, lo, hi, wide);
+    }//end if
 
-static inline const char *e_etn_node_label(e_etn_t *etn, uint32_t i, size_t *len) {
-    uint32_t x, off;
+    /* gallop forward, then search the last gap */
+    lo = from + 1;
+    for(step = 1 ; lo + step - 1 < hi ; step *= 2) {
+        i = lo + step - 1;
+        s = e_etn_node_label(etn, i, &len, wide);
+        ret = e_etn_strncmp(s, len, label, label_len);
+        if(ret == 0) {
+            return i;
+        }//end if
+        if(ret > 0) {
+            hi = i;
+            break;
+        }//end if
+        lo = i + 1;
+    }//end for
+
+    return e_etn_find_range(etn, label, label_len, lo, hi, wide);
+}//end e_etn_find_after
+
+/* the narrow words are decoded with constant shifts, wide ones with the widths in the header */
+static inline const char *e_etn_node_label(e_etn_t *etn, uint32_t i, size_t *len, bool wide) {
+    uint32_t x;
+    uint64_t w;
+
+    if(!wide) {
+        x = etn->nodes[i];
+        *len = x & E_ETN_MASK(E_ETN_BITS_TEXT_LENGTH);
+        return etn->text + ((x >> E_ETN_BITS_TEXT_LENGTH) & E_ETN_MASK(E_ETN_BITS_TEXT_OFFSET));
+    }//end if
 
-    x = etn->nodes[i];
-    *len = x & ((1 << etn->nodes_bits_text_length) - 1);
-    x >>= etn->nodes_bits_text_length;
-    off = x & ((1 << etn->nodes_bits_text_offset) - 1);
+    w = etn->nodes_wide[i];
+    *len = w & E_ETN_MASK(etn->nodes_bits_text_length);
+    w >>= etn->nodes_bits_text_length;
 
-    return etn->text + off;
+    return etn->text + (w & E_ETN_MASK(etn->nodes_bits_text_offset));
 }//end e_etn_node_label
+
+static inline uint32_t e_etn_node_children(e_etn_t *etn, uint32_t i, bool *icann, bool wide) {
+    uint32_t x;
+    uint64_t w;
+
+    if(!wide) {
+        x = etn->nodes[i] >> (E_ETN_BITS_TEXT_OFFSET + E_ETN_BITS_TEXT_LENGTH);
+        *icann = (x & E_ETN_MASK(E_ETN_BITS_ICANN)) != 0 ? true : false;
+        return (x >> E_ETN_BITS_ICANN) & E_ETN_MASK(E_ETN_BITS_CHILDREN);
+    }//end if
+
+    w = etn->nodes_wide[i] >> (etn->nodes_bits_text_offset + etn->nodes_bits_text_length);
+    *icann = (w & E_ETN_MASK(etn->nodes_bits_ICANN)) != 0 ? true : false;
+    w >>= etn->nodes_bits_ICANN;
+
+    return w & E_ETN_MASK(etn->nodes_bits_children);
+}//end e_etn_node_children
+
+static inline void e_etn_children_decode(e_etn_t *etn, uint32_t i, uint32_t *lo, uint32_t *hi, uint32_t *type, bool *wildcard, bool wide) {
+    uint32_t u;
+    uint64_t w;
+
+    if(!wide) {
+        u = etn->children[i];
+        *lo = u & E_ETN_MASK(E_ETN_BITS_LO);
+        u >>= E_ETN_BITS_LO;
+        *hi = u & E_ETN_MASK(E_ETN_BITS_HI);
+        u >>= E_ETN_BITS_HI;
+        *type = u & E_ETN_MASK(E_ETN_BITS_NODE_TYPE);
+        u >>= E_ETN_BITS_NODE_TYPE;
+        *wildcard = (u & E_ETN_MASK(E_ETN_BITS_WILDCARD)) != 0 ? true : false;
+        return;
+    }//end if
+
+    w = etn->children_wide[i];
+    *lo = w & E_ETN_MASK(etn->children_bits_lo);
+    w >>= etn->children_bits_lo;
+    *hi = w & E_ETN_MASK(etn->children_bits_hi);
+    w >>= etn->children_bits_hi;
+    *type = w & E_ETN_MASK(etn->children_bits_node_type);
+    w >>= etn->children_bits_node_type;
+    *wildcard = (w & E_ETN_MASK(etn->children_bits_wildcard)) != 0 ? true : false;
+}//end e_etn_children_decode
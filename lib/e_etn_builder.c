@@ -0,0 +1,1005 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "e_etn_builder.h"
+#include <libetn/e_idn.h>
+#include <libetn/e_mem.h>
+#include <libetn/e_strfuncs.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* a rule is at most a domain name */
+#define E_ETN_RULE_MAX          255
+
+#define E_ETN_NONE              0xFFFFFFFF
+
+/* one bit per label hash, most substrings of a label are no label and stop here */
+#define E_ETN_FILTER_BITS       (1 << 16)
+
+/* a distinct label of the list, the bytes live in the arena */
+typedef struct e_etn_blabel_s {
+    uint32_t    off;
+    uint32_t    len;
+    uint32_t    hash;
+    uint32_t    container;      /* a longer label this one is a substring of */
+    uint32_t    at;             /* where it is in the container */
+    uint32_t    piece;          /* the piece of text it starts when it has no container */
+    uint32_t    pos;            /* where it is in the text */
+} e_etn_blabel_t;
+
+/* a piece of the text being crushed, a merged piece was appended to group at offset at */
+typedef struct e_etn_piece_s {
+    char        *s;
+    uint32_t    len;
+    uint32_t    cap;
+    uint32_t    label;
+    uint32_t    group;
+    uint32_t    at;
+    uint32_t    next;           /* next piece with the same prefix */
+    uint32_t    tail;           /* last piece with the same prefix, kept by the first one */
+    uint32_t    slot;           /* where the first one is in prefix_hash */
+    uint32_t    text_off;
+    bool        merged;
+} e_etn_piece_t;
+
+typedef struct e_etn_bnode_s {
+    const char  *s;             /* the label, set once the whole list is parsed */
+    uint32_t    len;
+    uint32_t    label;
+    uint32_t    parent;
+    uint32_t    first;          /* first child in kids */
+    uint32_t    num_children;
+    uint32_t    index;
+    uint32_t    children_index;
+    uint8_t     type;
+    bool        icann;
+    bool        wildcard;
+} e_etn_bnode_t;
+
+/* a children record before the widths are known */
+typedef struct e_etn_brecord_s {
+    uint32_t    lo;
+    uint32_t    hi;
+    uint8_t     type;
+    bool        wildcard;
+} e_etn_brecord_t;
+
+/*
+ * Every rule adds at most one label and one node per dot, so labels, nodes
+ * and both hash tables are sized once from the input and never rehashed.
+ */
+typedef struct e_etn_builder_s {
+    char            *arena;
+    uint32_t        arena_len;
+    uint32_t        arena_cap;
+    uint32_t        max_items;
+    e_etn_blabel_t  *labels;
+    uint32_t        num_labels;
+    e_etn_bnode_t   *nodes;
+    uint32_t        num_nodes;
+    uint32_t        hash_size;
+    uint32_t        *label_hash;
+    uint32_t        *node_hash;
+    uint64_t        filter[E_ETN_FILTER_BITS / 64];
+    e_etn_bnode_t   **kids;
+    e_etn_piece_t   *pieces;
+    uint32_t        num_pieces;
+    uint32_t        *prefix_hash;
+    uint32_t        prefix_size;
+    uint32_t        *active;        /* pieces that take part in a round, in sorted order */
+    uint32_t        num_active;
+    uint32_t        *joining;       /* pieces by length, each joins when the prefix gets shorter */
+    uint32_t        *starts;
+    uint32_t        max_pos;
+    e_etn_brecord_t *records;
+    uint32_t        num_records;
+    uint32_t        records_cap;
+    uint32_t        max_len;
+} e_etn_builder_t;
+
+static inline e_errno_t e_etn_builder_init(e_etn_builder_t *b, const char *psl, size_t len);
+static inline void e_etn_builder_destroy(e_etn_builder_t *b);
+static inline e_errno_t e_etn_builder_parse(e_etn_builder_t *b, const char *psl, size_t len);
+static inline e_errno_t e_etn_builder_rule(e_etn_builder_t *b, const char *line, size_t len, bool icann);
+static inline e_errno_t e_etn_builder_label(e_etn_builder_t *b, const char *label, size_t len, uint32_t *id);
+static inline uint32_t e_etn_builder_find_label(e_etn_builder_t *b, const char *label, size_t len, uint32_t h);
+static inline e_errno_t e_etn_builder_child(e_etn_builder_t *b, uint32_t parent, uint32_t label, uint32_t *id);
+static inline e_errno_t e_etn_builder_sort(e_etn_builder_t *b);
+static inline e_errno_t e_etn_builder_text(e_etn_builder_t *b, e_etn_tables_t *tables);
+static inline void e_etn_builder_join(e_etn_builder_t *b, uint32_t prefix_len);
+static inline e_errno_t e_etn_builder_crush(e_etn_builder_t *b, uint32_t prefix_len);
+static inline uint32_t e_etn_builder_find_prefix(e_etn_builder_t *b, const char *s, uint32_t len);
+static inline e_errno_t e_etn_builder_index(e_etn_builder_t *b, e_etn_bnode_t *n, uint32_t *next);
+static inline e_errno_t e_etn_builder_encode(e_etn_builder_t *b, e_etn_tables_t *tables);
+static inline uint32_t e_etn_builder_mix(uint32_t parent, uint32_t label);
+static inline int e_etn_builder_strcmp(const char *s1, size_t s1_len, const char *s2, size_t s2_len);
+static int e_etn_builder_node_cmp(const void *a, const void *b);
+static int e_etn_builder_piece_cmp(const void *a, const void *b);
+
+e_errno_t e_etn_build_tables(const char *psl, size_t len, e_etn_tables_t *tables) {
+    uint32_t        i, next;
+    e_errno_t       err;
+    e_etn_builder_t b;
+
+    memset(tables, 0, sizeof(e_etn_tables_t));
+    err = e_etn_builder_init(&b, psl, len);
+    if(E_UNLIKELY(err != E_OK)) {
+        e_etn_builder_destroy(&b);
+        return err;
+    }//end if
+
+    err = e_etn_builder_parse(&b, psl, len);
+    if(E_UNLIKELY(err != E_OK)) {
+        e_etn_builder_destroy(&b);
+        return err;
+    }//end if
+
+    if(E_UNLIKELY(b.num_nodes == 1)) {
+        e_etn_builder_destroy(&b);
+        return E_ERR_EMPTY;
+    }//end if
+
+    err = e_etn_builder_sort(&b);
+    if(E_UNLIKELY(err != E_OK)) {
+        e_etn_builder_destroy(&b);
+        return err;
+    }//end if
+
+    err = e_etn_builder_text(&b, tables);
+    if(E_UNLIKELY(err != E_OK)) {
+        e_etn_builder_destroy(&b);
+        e_etn_free_tables(tables);
+        return err;
+    }//end if
+
+    /* the first records stand for leaves, one per node type with and without the wildcard bit */
+    b.records_cap = 1024;
+    b.records = e_malloc(b.records_cap * sizeof(e_etn_brecord_t));
+    if(E_UNLIKELY(!b.records)) {
+        e_etn_builder_destroy(&b);
+        e_etn_free_tables(tables);
+        return E_ERR_FAMEM;
+    }//end if
+    for(i = 0 ; i < E_ETN_NUM_TYPE * 2 ; i++) {
+        b.records[i].lo = 0;
+        b.records[i].hi = 0;
+        b.records[i].type = i % E_ETN_NUM_TYPE;
+        b.records[i].wildcard = i >= E_ETN_NUM_TYPE;
+    }//end for
+    b.num_records = E_ETN_NUM_TYPE * 2;
+
+    next = 0;
+    err = e_etn_builder_index(&b, b.nodes, &next);
+    if(E_UNLIKELY(err != E_OK)) {
+        e_etn_builder_destroy(&b);
+        e_etn_free_tables(tables);
+        return err;
+    }//end if
+
+    err = e_etn_builder_encode(&b, tables);
+    if(E_UNLIKELY(err != E_OK)) {
+        e_etn_builder_destroy(&b);
+        e_etn_free_tables(tables);
+        return err;
+    }//end if
+
+    e_etn_builder_destroy(&b);
+    return E_OK;
+}//end e_etn_build_tables
+
+void e_etn_free_tables(e_etn_tables_t *tables) {
+    if(tables->text) {
+        e_free(tables->text);
+        tables->text = NULL;
+    }//end if
+    if(tables->nodes) {
+        e_free(tables->nodes);
+        tables->nodes = NULL;
+    }//end if
+    if(tables->children) {
+        e_free(tables->children);
+        tables->children = NULL;
+    }//end if
+}//end e_etn_free_tables
+
+e_errno_t e_etn_builder_fold(const char *rule, size_t len, char *buf, size_t size, const char **s, size_t *s_len, char **encoded) {
+    bool    ascii;
+    size_t  i;
+
+    *encoded = NULL;
+    if(E_UNLIKELY(len >= size)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    ascii = true;
+    for(i = 0 ; i < len ; i++) {
+        if(E_UNLIKELY(rule[i] == '\0')) {
+            return E_ERR_INVAL;
+        }//end if
+        if((u_char)rule[i] >= 0x80) {
+            ascii = false;
+        }//end if
+    }//end for
+
+    /* only internationalized rules go through IDNA, the rest is just folded */
+    if(ascii) {
+        for(i = 0 ; i < len ; i++) {
+            buf[i] = e_ascii_tolower(rule[i]);
+        }//end for
+        *s = buf;
+        *s_len = len;
+        return E_OK;
+    }//end if
+
+    memcpy(buf, rule, len);
+    buf[len] = '\0';
+    if(E_UNLIKELY(e_idn_encode(buf, len, encoded, s_len) != E_OK || *s_len >= size)) {
+        e_free(*encoded);
+        *encoded = NULL;
+        return E_ERR_INVAL;
+    }//end if
+    for(i = 0 ; i < *s_len ; i++) {
+        (*encoded)[i] = e_ascii_tolower((*encoded)[i]);
+    }//end for
+    *s = *encoded;
+
+    return E_OK;
+}//end e_etn_builder_fold
+
+uint32_t e_etn_builder_bits(uint64_t max) {
+    uint32_t bits;
+
+    for(bits = 1 ; bits < 64 && (max >> bits) != 0 ; bits++);
+
+    return bits;
+}//end e_etn_builder_bits
+
+uint32_t e_etn_builder_hash(const char *s, size_t len) {
+    size_t      i;
+    uint32_t    h;
+
+    h = 2166136261U;
+    for(i = 0 ; i < len ; i++) {
+        h = (h ^ (u_char)s[i]) * 16777619U;
+    }//end for
+
+    return h;
+}//end e_etn_builder_hash
+
+
+
+/* ===== private function ===== */
+static inline e_errno_t e_etn_builder_init(e_etn_builder_t *b, const char *psl, size_t len) {
+    size_t      i;
+    uint64_t    max_items;
+
+    memset(b, 0, sizeof(e_etn_builder_t));
+
+    /* one node for the root, and one per label of every line */
+    max_items = 2;
+    for(i = 0 ; i < len ; i++) {
+        if(psl[i] == '.' || psl[i] == '\n') {
+            max_items++;
+        }//end if
+    }//end for
+    if(E_UNLIKELY(max_items > (1 << 24))) {
+        return E_ERR_OVERFLOW;
+    }//end if
+    b->max_items = (uint32_t)max_items;
+
+    b->hash_size = 1;
+    while(b->hash_size < b->max_items * 2) {
+        b->hash_size <<= 1;
+    }//end while
+
+    b->arena_cap = 4096;
+    b->arena = e_malloc(b->arena_cap);
+    b->labels = e_malloc(b->max_items * sizeof(e_etn_blabel_t));
+    b->nodes = e_malloc(b->max_items * sizeof(e_etn_bnode_t));
+    b->label_hash = e_calloc(b->hash_size, sizeof(uint32_t));
+    b->node_hash = e_calloc(b->hash_size, sizeof(uint32_t));
+    if(E_UNLIKELY(!b->arena || !b->labels || !b->nodes || !b->label_hash || !b->node_hash)) {
+        return E_ERR_FAMEM;
+    }//end if
+
+    /* the root */
+    memset(b->nodes, 0, sizeof(e_etn_bnode_t));
+    b->nodes[0].label = E_ETN_NONE;
+    b->nodes[0].parent = E_ETN_NONE;
+    b->nodes[0].type = E_ETN_TYPE_PARENT_ONLY;
+    b->num_nodes = 1;
+
+    return E_OK;
+}//end e_etn_builder_init
+
+static inline void e_etn_builder_destroy(e_etn_builder_t *b) {
+    uint32_t i;
+
+    if(b->pieces) {
+        for(i = 0 ; i < b->num_pieces ; i++) {
+            if(b->pieces[i].s) {
+                e_free(b->pieces[i].s);
+            }//end if
+        }//end for
+        e_free(b->pieces);
+    }//end if
+    if(b->prefix_hash) {
+        e_free(b->prefix_hash);
+    }//end if
+    if(b->active) {
+        e_free(b->active);
+    }//end if
+    if(b->records) {
+        e_free(b->records);
+    }//end if
+    if(b->kids) {
+        e_free(b->kids);
+    }//end if
+    if(b->node_hash) {
+        e_free(b->node_hash);
+    }//end if
+    if(b->label_hash) {
+        e_free(b->label_hash);
+    }//end if
+    if(b->nodes) {
+        e_free(b->nodes);
+    }//end if
+    if(b->labels) {
+        e_free(b->labels);
+    }//end if
+    if(b->arena) {
+        e_free(b->arena);
+    }//end if
+}//end e_etn_builder_destroy
+
+static inline e_errno_t e_etn_builder_parse(e_etn_builder_t *b, const char *psl, size_t len) {
+    bool        icann;
+    size_t      pos, end, n;
+    e_errno_t   err;
+    const char  *line, *eol;
+
+    icann = false;
+    for(pos = 0 ; pos < len ; pos = end + 1) {
+        eol = memchr(psl + pos, '\n', len - pos);
+        end = eol ? (size_t)(eol - psl) : len;
+
+        line = psl + pos;
+        n = end - pos;
+        while(n > 0 && e_ascii_isspace(line[0])) {
+            line++;
+            n--;
+        }//end while
+        while(n > 0 && e_ascii_isspace(line[n - 1])) {
+            n--;
+        }//end while
+
+        if(memmem(line, n, "BEGIN ICANN DOMAINS", sizeof("BEGIN ICANN DOMAINS") - 1)) {
+            icann = true;
+            continue;
+        }//end if
+        if(memmem(line, n, "END ICANN DOMAINS", sizeof("END ICANN DOMAINS") - 1)) {
+            icann = false;
+            continue;
+        }//end if
+        if(n == 0 || (n >= 2 && line[0] == '/' && line[1] == '/')) {
+            continue;
+        }//end if
+
+        err = e_etn_builder_rule(b, line, n, icann);
+        if(E_UNLIKELY(err != E_OK)) {
+            return err;
+        }//end if
+    }//end for
+
+    return E_OK;
+}//end e_etn_builder_parse
+
+static inline e_errno_t e_etn_builder_rule(e_etn_builder_t *b, const char *line, size_t len, bool icann) {
+    char            buf[E_ETN_RULE_MAX + 1], *encoded;
+    bool            wildcard;
+    size_t          i, start, dot;
+    uint8_t         type;
+    uint32_t        node, label;
+    e_errno_t       err;
+    const char      *rule;
+    e_etn_bnode_t   *n;
+
+    err = e_etn_builder_fold(line, len, buf, sizeof(buf), &rule, &len, &encoded);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    /* same as ^[a-z0-9_\!\*\-\.]+$ */
+    for(i = 0 ; i < len ; i++) {
+        if(E_UNLIKELY(!(e_ascii_islower(rule[i]) || e_ascii_isdigit(rule[i]) ||
+            rule[i] == '_' || rule[i] == '!' || rule[i] == '*' || rule[i] == '-' || rule[i] == '.'))) {
+            err = E_ERR_INVAL;
+            goto out;
+        }//end if
+    }//end for
+
+    type = E_ETN_TYPE_NORMAL;
+    wildcard = false;
+    start = 0;
+    if(len >= 2 && rule[0] == '*' && rule[1] == '.') {
+        type = E_ETN_TYPE_PARENT_ONLY;
+        wildcard = true;
+        start = 2;
+    }//end if
+    else if(len >= 1 && rule[0] == '!') {
+        type = E_ETN_TYPE_EXCEPTION;
+        start = 1;
+    }//end if
+
+    /* from the top-level label down */
+    node = 0;
+    i = len;
+    for(;;) {
+        for(dot = i ; dot > start && rule[dot - 1] != '.' ; dot--);
+        if(E_UNLIKELY(dot == i)) {
+            err = E_ERR_INVAL;
+            goto out;
+        }//end if
+
+        err = e_etn_builder_label(b, rule + dot, i - dot, &label);
+        if(E_UNLIKELY(err != E_OK)) {
+            goto out;
+        }//end if
+
+        err = e_etn_builder_child(b, node, label, &node);
+        if(E_UNLIKELY(err != E_OK)) {
+            goto out;
+        }//end if
+
+        if(dot == start) {
+            break;
+        }//end if
+        i = dot - 1;
+    }//end for
+
+    n = &(b->nodes[node]);
+    if(type != E_ETN_TYPE_PARENT_ONLY && n->type == E_ETN_TYPE_PARENT_ONLY) {
+        n->type = type;
+    }//end if
+    n->icann = n->icann && icann;
+    n->wildcard = n->wildcard || wildcard;
+    err = E_OK;
+
+out:
+    if(encoded) {
+        e_free(encoded);
+    }//end if
+    return err;
+}//end e_etn_builder_rule
+
+static inline e_errno_t e_etn_builder_label(e_etn_builder_t *b, const char *label, size_t len, uint32_t *id) {
+    char            *arena;
+    uint32_t        h, i, mask, cap;
+    e_etn_blabel_t  *l;
+
+    h = e_etn_builder_hash(label, len);
+    *id = e_etn_builder_find_label(b, label, len, h);
+    if(*id != E_ETN_NONE) {
+        return E_OK;
+    }//end if
+
+    if(E_UNLIKELY(b->num_labels >= b->max_items)) {
+        return E_ERR_OVERFLOW;
+    }//end if
+
+    if(b->arena_len + len > b->arena_cap) {
+        for(cap = b->arena_cap ; cap < b->arena_len + len ; cap *= 2);
+        arena = e_realloc(b->arena, cap);
+        if(E_UNLIKELY(!arena)) {
+            return E_ERR_FAMEM;
+        }//end if
+        b->arena = arena;
+        b->arena_cap = cap;
+    }//end if
+    memcpy(b->arena + b->arena_len, label, len);
+
+    *id = b->num_labels++;
+    l = &(b->labels[*id]);
+    l->off = b->arena_len;
+    l->len = (uint32_t)len;
+    l->hash = h;
+    l->container = E_ETN_NONE;
+    l->at = 0;
+    l->piece = E_ETN_NONE;
+    l->pos = 0;
+    b->arena_len += (uint32_t)len;
+
+    mask = b->hash_size - 1;
+    for(i = h & mask ; b->label_hash[i] ; i = (i + 1) & mask);
+    b->label_hash[i] = *id + 1;
+    b->filter[(h % E_ETN_FILTER_BITS) / 64] |= (uint64_t)1 << (h % 64);
+
+    return E_OK;
+}//end e_etn_builder_label
+
+static inline uint32_t e_etn_builder_find_label(e_etn_builder_t *b, const char *label, size_t len, uint32_t h) {
+    uint32_t        i, mask;
+    e_etn_blabel_t  *l;
+
+    mask = b->hash_size - 1;
+    for(i = h & mask ; b->label_hash[i] ; i = (i + 1) & mask) {
+        l = &(b->labels[b->label_hash[i] - 1]);
+        if(l->hash == h && l->len == len && memcmp(b->arena + l->off, label, len) == 0) {
+            return b->label_hash[i] - 1;
+        }//end if
+    }//end for
+
+    return E_ETN_NONE;
+}//end e_etn_builder_find_label
+
+static inline e_errno_t e_etn_builder_child(e_etn_builder_t *b, uint32_t parent, uint32_t label, uint32_t *id) {
+    uint32_t        i, mask;
+    e_etn_bnode_t   *n;
+
+    mask = b->hash_size - 1;
+    for(i = e_etn_builder_mix(parent, label) & mask ; b->node_hash[i] ; i = (i + 1) & mask) {
+        n = &(b->nodes[b->node_hash[i] - 1]);
+        if(n->parent == parent && n->label == label) {
+            *id = b->node_hash[i] - 1;
+            return E_OK;
+        }//end if
+    }//end for
+
+    if(E_UNLIKELY(b->num_nodes >= b->max_items)) {
+        return E_ERR_OVERFLOW;
+    }//end if
+
+    *id = b->num_nodes++;
+    b->node_hash[i] = *id + 1;
+    n = &(b->nodes[*id]);
+    memset(n, 0, sizeof(e_etn_bnode_t));
+    n->label = label;
+    n->parent = parent;
+    n->type = E_ETN_TYPE_PARENT_ONLY;
+    n->icann = true;
+    b->nodes[parent].num_children++;
+
+    return E_OK;
+}//end e_etn_builder_child
+
+static inline e_errno_t e_etn_builder_sort(e_etn_builder_t *b) {
+    uint32_t        i;
+    e_etn_bnode_t   *n;
+
+    /* sorting every node by parent then label leaves the children of a node next to each other */
+    b->kids = e_malloc((b->num_nodes - 1) * sizeof(e_etn_bnode_t *));
+    if(E_UNLIKELY(!b->kids)) {
+        return E_ERR_FAMEM;
+    }//end if
+
+    for(i = 1 ; i < b->num_nodes ; i++) {
+        n = &(b->nodes[i]);
+        n->s = b->arena + b->labels[n->label].off;
+        n->len = b->labels[n->label].len;
+        b->kids[i - 1] = n;
+    }//end for
+    qsort(b->kids, b->num_nodes - 1, sizeof(e_etn_bnode_t *), e_etn_builder_node_cmp);
+
+    for(i = 0 ; i < b->num_nodes - 1 ; i++) {
+        if(i == 0 || b->kids[i]->parent != b->kids[i - 1]->parent) {
+            b->nodes[b->kids[i]->parent].first = i;
+        }//end if
+    }//end for
+
+    return E_OK;
+}//end e_etn_builder_sort
+
+/*
+ * The text is built as ci/precompile.go does: labels found inside a longer
+ * label are dropped, then the rest are crushed by appending a label to one
+ * that ends with its prefix, longest overlaps first.
+ */
+static inline e_errno_t e_etn_builder_text(e_etn_builder_t *b, e_etn_tables_t *tables) {
+    char            *s;
+    uint32_t        i, j, k, h, id, off, text_length;
+    e_etn_blabel_t  *l;
+    e_etn_piece_t   *p;
+
+    /* every proper substring of a label that is a label itself */
+    for(i = 0 ; i < b->num_labels ; i++) {
+        l = &(b->labels[i]);
+        s = b->arena + l->off;
+        for(j = 0 ; j < l->len ; j++) {
+            h = 2166136261U;
+            for(k = j ; k < l->len ; k++) {
+                if(k - j + 1 == l->len) {
+                    break;
+                }//end if
+                h = (h ^ (u_char)s[k]) * 16777619U;
+                if(!(b->filter[(h % E_ETN_FILTER_BITS) / 64] & ((uint64_t)1 << (h % 64)))) {
+                    continue;
+                }//end if
+                id = e_etn_builder_find_label(b, s + j, k - j + 1, h);
+                if(id != E_ETN_NONE && b->labels[id].container == E_ETN_NONE) {
+                    b->labels[id].container = i;
+                    b->labels[id].at = j;
+                }//end if
+            }//end for
+        }//end for
+    }//end for
+
+    b->pieces = e_calloc(b->num_labels, sizeof(e_etn_piece_t));
+    if(E_UNLIKELY(!b->pieces)) {
+        return E_ERR_FAMEM;
+    }//end if
+
+    for(i = 0 ; i < b->num_labels ; i++) {
+        l = &(b->labels[i]);
+        if(l->container != E_ETN_NONE) {
+            continue;
+        }//end if
+        p = &(b->pieces[b->num_pieces++]);
+        p->s = e_memdup((void *)(b->arena + l->off), l->len);
+        if(E_UNLIKELY(!p->s)) {
+            return E_ERR_FAMEM;
+        }//end if
+        p->len = l->len;
+        p->cap = l->len;
+        p->label = i;
+        p->slot = E_ETN_NONE;
+        if(l->len > b->max_len) {
+            b->max_len = l->len;
+        }//end if
+    }//end for
+    qsort(b->pieces, b->num_pieces, sizeof(e_etn_piece_t), e_etn_builder_piece_cmp);
+
+    for(b->prefix_size = 1 ; b->prefix_size < b->num_pieces * 2 ; b->prefix_size <<= 1);
+    b->prefix_hash = e_calloc(b->prefix_size, sizeof(uint32_t));
+    b->active = e_malloc((b->num_pieces * 3 + b->max_len + 3) * sizeof(uint32_t));
+    if(E_UNLIKELY(!b->prefix_hash || !b->active)) {
+        return E_ERR_FAMEM;
+    }//end if
+
+    /* a piece takes part once the prefix is shorter than it, so bucket them by length */
+    b->joining = b->active + b->num_pieces * 2;
+    b->starts = b->joining + b->num_pieces;
+    memset(b->starts, 0, (b->max_len + 3) * sizeof(uint32_t));
+    for(i = 0 ; i < b->num_pieces ; i++) {
+        b->starts[b->pieces[i].len + 1]++;
+    }//end for
+    for(i = 1 ; i < b->max_len + 3 ; i++) {
+        b->starts[i] += b->starts[i - 1];
+    }//end for
+    for(i = 0 ; i < b->num_pieces ; i++) {
+        b->joining[b->starts[b->pieces[i].len]++] = i;
+    }//end for
+    memmove(b->starts + 1, b->starts, (b->max_len + 2) * sizeof(uint32_t));
+    b->starts[0] = 0;
+
+    for(k = b->max_len ; k > 0 ; k--) {
+        e_etn_builder_join(b, k);
+        if(E_UNLIKELY(e_etn_builder_crush(b, k) != E_OK)) {
+            return E_ERR_FAMEM;
+        }//end if
+    }//end for
+
+    text_length = 0;
+    for(i = 0 ; i < b->num_pieces ; i++) {
+        p = &(b->pieces[i]);
+        b->labels[p->label].piece = i;
+        if(!p->merged) {
+            p->text_off = text_length;
+            text_length += p->len;
+        }//end if
+    }//end for
+
+    tables->text = e_malloc(text_length + 1);
+    if(E_UNLIKELY(!tables->text)) {
+        return E_ERR_FAMEM;
+    }//end if
+    for(i = 0 ; i < b->num_pieces ; i++) {
+        p = &(b->pieces[i]);
+        if(!p->merged) {
+            memcpy(tables->text + p->text_off, p->s, p->len);
+        }//end if
+    }//end for
+    tables->text[text_length] = '\0';
+    tables->text_length = text_length;
+
+    /* follow containers to a piece, then merges to where the piece ended up */
+    for(i = 0 ; i < b->num_labels ; i++) {
+        off = 0;
+        for(id = i ; b->labels[id].container != E_ETN_NONE ; id = b->labels[id].container) {
+            off += b->labels[id].at;
+        }//end for
+        for(p = &(b->pieces[b->labels[id].piece]) ; p->merged ; p = &(b->pieces[p->group])) {
+            off += p->at;
+        }//end for
+        off += p->text_off;
+
+        b->labels[i].pos = off;
+        if(off > b->max_pos) {
+            b->max_pos = off;
+        }//end if
+    }//end for
+
+    return E_OK;
+}//end e_etn_builder_text
+
+static inline e_errno_t e_etn_builder_crush(e_etn_builder_t *b, uint32_t prefix_len) {
+    char            *s;
+    uint32_t        a, i, j, h, mask, head, cap;
+    e_etn_piece_t   *p, *q;
+
+    /* pieces longer than prefix_len, listed by their first prefix_len bytes */
+    mask = b->prefix_size - 1;
+    for(a = 0 ; a < b->num_active ; a++) {
+        i = b->active[a];
+        p = &(b->pieces[i]);
+        p->next = E_ETN_NONE;
+        h = e_etn_builder_hash(p->s, prefix_len);
+        for(j = h & mask ; b->prefix_hash[j] ; j = (j + 1) & mask) {
+            head = b->prefix_hash[j] - 1;
+            if(memcmp(b->pieces[head].s, p->s, prefix_len) == 0) {
+                b->pieces[b->pieces[head].tail].next = i;
+                b->pieces[head].tail = i;
+                break;
+            }//end if
+        }//end for
+        if(!b->prefix_hash[j]) {
+            b->prefix_hash[j] = i + 1;
+            p->tail = i;
+            p->slot = j;
+        }//end if
+    }//end for
+
+    for(a = 0 ; a < b->num_active ; a++) {
+        i = b->active[a];
+        p = &(b->pieces[i]);
+        if(p->merged) {
+            continue;
+        }//end if
+
+        /* the piece gets a new end after a merge, so look again */
+        while((head = e_etn_builder_find_prefix(b, p->s + p->len - prefix_len, prefix_len)) != E_ETN_NONE) {
+            for(j = head ; j != E_ETN_NONE ; j = b->pieces[j].next) {
+                if(!b->pieces[j].merged && j != i) {
+                    break;
+                }//end if
+            }//end for
+            if(j == E_ETN_NONE) {
+                break;
+            }//end if
+
+            q = &(b->pieces[j]);
+            if(p->len + q->len - prefix_len > p->cap) {
+                for(cap = p->cap * 2 ; cap < p->len + q->len - prefix_len ; cap *= 2);
+                s = e_realloc(p->s, cap);
+                if(E_UNLIKELY(!s)) {
+                    return E_ERR_FAMEM;
+                }//end if
+                p->s = s;
+                p->cap = cap;
+            }//end if
+            memcpy(p->s + p->len, q->s + prefix_len, q->len - prefix_len);
+            q->merged = true;
+            q->group = i;
+            q->at = p->len - prefix_len;
+            p->len += q->len - prefix_len;
+        }//end while
+    }//end for
+
+    /* empty again for the next length, only first pieces hold a slot */
+    for(a = 0 ; a < b->num_active ; a++) {
+        p = &(b->pieces[b->active[a]]);
+        if(p->slot != E_ETN_NONE) {
+            b->prefix_hash[p->slot] = 0;
+            p->slot = E_ETN_NONE;
+        }//end if
+    }//end for
+
+    return E_OK;
+}//end e_etn_builder_crush
+
+static inline void e_etn_builder_join(e_etn_builder_t *b, uint32_t prefix_len) {
+    uint32_t a, j, n, end, *next;
+
+    /* merge the pieces one byte longer than prefix_len into the active ones, both are sorted */
+    next = b->active + b->num_pieces;
+    j = b->starts[prefix_len + 1];
+    end = b->starts[prefix_len + 2];
+    for(a = 0, n = 0 ; a < b->num_active || j < end ; ) {
+        if(j == end || (a < b->num_active && b->active[a] < b->joining[j])) {
+            if(!b->pieces[b->active[a]].merged) {
+                next[n++] = b->active[a];
+            }//end if
+            a++;
+        }//end if
+        else {
+            next[n++] = b->joining[j++];
+        }//end else
+    }//end for
+
+    memcpy(b->active, next, n * sizeof(uint32_t));
+    b->num_active = n;
+}//end e_etn_builder_join
+
+static inline uint32_t e_etn_builder_find_prefix(e_etn_builder_t *b, const char *s, uint32_t len) {
+    uint32_t i, mask;
+
+    mask = b->prefix_size - 1;
+    for(i = e_etn_builder_hash(s, len) & mask ; b->prefix_hash[i] ; i = (i + 1) & mask) {
+        if(memcmp(b->pieces[b->prefix_hash[i] - 1].s, s, len) == 0) {
+            return b->prefix_hash[i] - 1;
+        }//end if
+    }//end for
+
+    return E_ETN_NONE;
+}//end e_etn_builder_find_prefix
+
+static inline e_errno_t e_etn_builder_index(e_etn_builder_t *b, e_etn_bnode_t *n, uint32_t *next) {
+    uint32_t        i, cap;
+    e_errno_t       err;
+    e_etn_brecord_t *records, *r;
+
+    if(n->num_children == 0) {
+        n->children_index = n->type + (n->wildcard ? E_ETN_NUM_TYPE : 0);
+        return E_OK;
+    }//end if
+
+    /* children get consecutive indexes, depth first like ci/precompile.go */
+    r = NULL;
+    if(n != b->nodes) {
+        if(b->num_records == b->records_cap) {
+            cap = b->records_cap * 2;
+            records = e_realloc(b->records, cap * sizeof(e_etn_brecord_t));
+            if(E_UNLIKELY(!records)) {
+                return E_ERR_FAMEM;
+            }//end if
+            b->records = records;
+            b->records_cap = cap;
+        }//end if
+        n->children_index = b->num_records;
+        r = &(b->records[b->num_records++]);
+        r->lo = *next;
+        r->hi = *next + n->num_children;
+        r->type = n->type;
+        r->wildcard = n->wildcard;
+    }//end if
+
+    /* the children of the root are implicit */
+    for(i = 0 ; i < n->num_children ; i++) {
+        b->kids[n->first + i]->index = (*next)++;
+    }//end for
+
+    for(i = 0 ; i < n->num_children ; i++) {
+        err = e_etn_builder_index(b, b->kids[n->first + i], next);
+        if(E_UNLIKELY(err != E_OK)) {
+            return err;
+        }//end if
+    }//end for
+
+    return E_OK;
+}//end e_etn_builder_index
+
+static inline e_errno_t e_etn_builder_encode(e_etn_builder_t *b, e_etn_tables_t *tables) {
+    uint32_t        i, max_lo, max_hi, max_len, *h;
+    e_etn_bnode_t   *n;
+    e_etn_brecord_t *r;
+
+    max_lo = max_hi = max_len = 0;
+    for(i = 0 ; i < b->num_records ; i++) {
+        max_lo = E_MAX(max_lo, b->records[i].lo);
+        max_hi = E_MAX(max_hi, b->records[i].hi);
+    }//end for
+    for(i = 0 ; i < b->num_labels ; i++) {
+        max_len = E_MAX(max_len, b->labels[i].len);
+    }//end for
+
+    h = tables->header;
+    h[0] = e_etn_builder_bits(b->num_records - 1);
+    h[1] = E_ETN_BITS_ICANN;
+    h[2] = e_etn_builder_bits(b->max_pos);
+    h[3] = e_etn_builder_bits(max_len);
+    h[4] = E_ETN_BITS_WILDCARD;
+    h[5] = E_ETN_BITS_NODE_TYPE;
+    h[6] = e_etn_builder_bits(max_hi);
+    h[7] = e_etn_builder_bits(max_lo);
+    h[8] = E_ETN_TYPE_NORMAL;
+    h[9] = E_ETN_TYPE_EXCEPTION;
+    h[10] = E_ETN_TYPE_PARENT_ONLY;
+    h[11] = b->nodes[0].num_children;
+    if(E_UNLIKELY(h[0] + h[1] + h[2] + h[3] > 64 || h[4] + h[5] + h[6] + h[7] > 64)) {
+        return E_ERR_OVERFLOW;
+    }//end if
+
+    tables->nodes = e_malloc((b->num_nodes - 1) * sizeof(uint64_t));
+    tables->children = e_malloc(b->num_records * sizeof(uint64_t));
+    if(E_UNLIKELY(!tables->nodes || !tables->children)) {
+        return E_ERR_FAMEM;
+    }//end if
+
+    tables->nodes_length = b->num_nodes - 1;
+    for(i = 1 ; i < b->num_nodes ; i++) {
+        n = &(b->nodes[i]);
+        tables->nodes[n->index] = (uint64_t)b->labels[n->label].len |
+            (uint64_t)b->labels[n->label].pos << h[3] |
+            (uint64_t)n->icann << (h[3] + h[2]) |
+            (uint64_t)n->children_index << (h[3] + h[2] + h[1]);
+    }//end for
+
+    tables->children_length = b->num_records;
+    for(i = 0 ; i < b->num_records ; i++) {
+        r = &(b->records[i]);
+        tables->children[i] = (uint64_t)r->lo |
+            (uint64_t)r->hi << h[7] |
+            (uint64_t)r->type << (h[7] + h[6]) |
+            (uint64_t)r->wildcard << (h[7] + h[6] + h[5]);
+    }//end for
+
+    return E_OK;
+}//end e_etn_builder_encode
+
+static inline uint32_t e_etn_builder_mix(uint32_t parent, uint32_t label) {
+    uint32_t h;
+
+    h = parent * 0x9E3779B1U ^ label * 0x85EBCA77U;
+    h ^= h >> 16;
+    h *= 0x7FEB352DU;
+    h ^= h >> 15;
+
+    return h;
+}//end e_etn_builder_mix
+
+static inline int e_etn_builder_strcmp(const char *s1, size_t s1_len, const char *s2, size_t s2_len) {
+    int ret;
+
+    ret = memcmp(s1, s2, s1_len < s2_len ? s1_len : s2_len);
+    if(ret != 0) {
+        return ret;
+    }//end if
+
+    return s1_len < s2_len ? -1 : (s1_len > s2_len ? 1 : 0);
+}//end e_etn_builder_strcmp
+
+static int e_etn_builder_node_cmp(const void *a, const void *b) {
+    const e_etn_bnode_t *n1, *n2;
+
+    n1 = *(const e_etn_bnode_t * const *)a;
+    n2 = *(const e_etn_bnode_t * const *)b;
+    if(n1->parent != n2->parent) {
+        return n1->parent < n2->parent ? -1 : 1;
+    }//end if
+
+    return e_etn_builder_strcmp(n1->s, n1->len, n2->s, n2->len);
+}//end e_etn_builder_node_cmp
+
+static int e_etn_builder_piece_cmp(const void *a, const void *b) {
+    const e_etn_piece_t *p1, *p2;
+
+    p1 = (const e_etn_piece_t *)a;
+    p2 = (const e_etn_piece_t *)b;
+
+    return e_etn_builder_strcmp(p1->s, p1->len, p2->s, p2->len);
+}//end e_etn_builder_piece_cmp
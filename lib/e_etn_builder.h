@@ -0,0 +1,108 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef E_ETN_BUILDER_H
+#define E_ETN_BUILDER_H
+
+#include <libetn/e_err.h>
+#include <libetn/e_etn.h>
+#include <stdio.h>
+
+/* number of header words after the magic number, the same in every format */
+#define E_ETN_HEADER_WORDS  12
+
+/* the bit widths and node types of the narrow format, as ci/precompile.go writes them */
+#define E_ETN_BITS_CHILDREN     10
+#define E_ETN_BITS_ICANN        1
+#define E_ETN_BITS_TEXT_OFFSET  15
+#define E_ETN_BITS_TEXT_LENGTH  6
+#define E_ETN_BITS_WILDCARD     1
+#define E_ETN_BITS_NODE_TYPE    2
+#define E_ETN_BITS_HI           14
+#define E_ETN_BITS_LO           14
+#define E_ETN_TYPE_NORMAL       0
+#define E_ETN_TYPE_EXCEPTION    1
+#define E_ETN_TYPE_PARENT_ONLY  2
+#define E_ETN_NUM_TYPE          3
+
+/* the tables built in memory, in wide words with the smallest widths that hold them */
+typedef struct e_etn_tables_s {
+    uint32_t    header[E_ETN_HEADER_WORDS];
+    uint32_t    text_length;
+    char        *text;          /* NUL terminated */
+    uint32_t    nodes_length;
+    uint64_t    *nodes;
+    uint32_t    children_length;
+    uint64_t    *children;
+} e_etn_tables_t;
+
+/* tables used where they are, in host byte order, 32-bit words unless wide */
+typedef struct e_etn_view_s {
+    uint32_t    header[E_ETN_HEADER_WORDS];
+    uint32_t    text_length;
+    const char  *text;          /* NUL terminated */
+    uint32_t    nodes_length;
+    const void  *nodes;
+    uint32_t    children_length;
+    const void  *children;
+    bool        wide;
+} e_etn_view_t;
+
+__BEGIN_DECLS
+
+/* psl is the text of effective_tld_names.dat, the tables are e_malloc'd */
+E_LOCAL e_errno_t e_etn_build_tables(const char *psl, size_t len, e_etn_tables_t *tables) E_NONNULL(1, 3);
+E_LOCAL void e_etn_free_tables(e_etn_tables_t *tables) E_NONNULL(1);
+
+/* a rule folded to lower case, through IDNA if it is not ASCII, *s is buf of size bytes or *encoded to e_free() */
+E_LOCAL e_errno_t e_etn_builder_fold(const char *rule, size_t len, char *buf, size_t size, const char **s, size_t *s_len, char **encoded) E_NONNULL(3, 5, 6, 7);
+/* the fewest bits that hold max */
+E_LOCAL uint32_t e_etn_builder_bits(uint64_t max);
+/* FNV-1a */
+E_LOCAL uint32_t e_etn_builder_hash(const char *s, size_t len) E_NONNULL(1);
+
+/* in e_etn.c, a table that takes the tables, freeing them if it fails, or that uses a view until it is freed */
+E_LOCAL e_etn_t *e_etn_new_tables(e_etn_tables_t *tables) E_GNUC_WARN_UNUSED_RESULT E_NONNULL(1);
+E_LOCAL e_etn_t *e_etn_new_view(const e_etn_view_t *view) E_GNUC_WARN_UNUSED_RESULT E_NONNULL(1);
+E_LOCAL void e_etn_get_view(e_etn_t *etn, e_etn_view_t *view) E_NONNULL(1, 2);
+
+/* in e_etn.c, the metadata words of src go to the same suffixes in dst where dst has none, for a reload */
+E_LOCAL e_errno_t e_etn_copy_metadata(e_etn_t *dst, e_etn_t *src) E_NONNULL(1, 2);
+
+/*
+ * in e_etn.c, a file written aside and renamed over, so a mapping of the old one stays valid. Whatever
+ * e_etn_save_begin() gives, e_etn_save_end() closes, it keeps the file only if err is E_OK.
+ */
+E_LOCAL e_errno_t e_etn_save_begin(const char *filename, FILE **fp, char **tmp) E_NONNULL(1, 2, 3);
+E_LOCAL e_errno_t e_etn_save_end(const char *filename, FILE *fp, char *tmp, e_errno_t err) E_NONNULL(1, 2, 3);
+
+__END_DECLS
+
+#endif /* E_ETN_BUILDER_H */
@@ -0,0 +1,244 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libetn/e_etn_cache.h>
+#include <libetn/e_mem.h>
+#include <string.h>
+
+#define E_ETN_CACHE_WAYS        4
+#define E_ETN_CACHE_LINE        64
+#define E_ETN_CACHE_ENTRY_SIZE  128
+#define E_ETN_CACHE_KEY_MAX     (E_ETN_CACHE_ENTRY_SIZE - 28)
+
+/* the results of a domain, its bytes are the key */
+typedef struct e_etn_cache_entry_s {
+    uint64_t    registrable_hash;
+    uint16_t    len;
+    uint16_t    suffix_off;
+    uint16_t    registrable_off;
+    uint16_t    subdomain_len;
+    uint8_t     labels;
+    uint8_t     suffix_labels;
+    uint8_t     icann;
+    uint8_t     rule;
+    uint32_t    suffix_id;
+    uint32_t    metadata;
+    char        domain[E_ETN_CACHE_KEY_MAX];
+} e_etn_cache_entry_t;
+
+/*
+ * A set is E_ETN_CACHE_WAYS entries. The tags of a set, hashes with the low bit
+ * set so that 0 is empty, share one cache line and are compared before any entry
+ * is read. Every set has a CLOCK byte: the low bits are the referenced bits of
+ * its ways and the high bits are the hand.
+ */
+struct e_etn_cache_s {
+    uint64_t            *tags;
+    e_etn_cache_entry_t *entries;
+    uint8_t             *clock;
+    uint32_t            mask;
+    uint64_t            serial;
+    e_etn_cache_stats_t stats;
+};
+
+static inline uint64_t e_etn_cache_hash(const char *s, size_t len);
+static inline void e_etn_cache_fill(e_etn_result_t *result, const e_etn_cache_entry_t *e);
+static inline uint32_t e_etn_cache_victim(e_etn_cache_t *cache, uint32_t set);
+
+e_etn_cache_t *e_etn_cache_new(size_t budget) {
+    size_t          n;
+    e_etn_cache_t   *cache;
+
+    /* the largest power of two number of sets that fits */
+    for(n = 1 ; 2 * n * (E_ETN_CACHE_WAYS * (E_ETN_CACHE_ENTRY_SIZE + sizeof(uint64_t)) + 1) + sizeof(e_etn_cache_t) <= budget &&
+        n < ((size_t)1 << 30) ; n *= 2);
+    if(n * (E_ETN_CACHE_WAYS * (E_ETN_CACHE_ENTRY_SIZE + sizeof(uint64_t)) + 1) + sizeof(e_etn_cache_t) > budget) {
+        return NULL;
+    }//end if
+
+    cache = e_calloc(1, sizeof(e_etn_cache_t));
+    if(E_UNLIKELY(!cache)) {
+        return NULL;
+    }//end if
+    cache->mask = (uint32_t)n - 1;
+    cache->stats.capacity = n * E_ETN_CACHE_WAYS;
+
+    if(E_UNLIKELY(posix_memalign((void **)&cache->tags, E_ETN_CACHE_LINE, cache->stats.capacity * sizeof(uint64_t)) != 0 ||
+        posix_memalign((void **)&cache->entries, E_ETN_CACHE_LINE, cache->stats.capacity * sizeof(e_etn_cache_entry_t)) != 0 ||
+        !(cache->clock = e_malloc(n)))) {
+        e_etn_cache_free(cache);
+        return NULL;
+    }//end if
+    e_etn_cache_clear(cache);
+
+    return cache;
+}//end e_etn_cache_new
+
+void e_etn_cache_free(e_etn_cache_t *cache) {
+    if(E_LIKELY(cache)) {
+        if(cache->clock) {
+            e_free(cache->clock);
+        }//end if
+        if(cache->entries) {
+            e_free(cache->entries);
+        }//end if
+        if(cache->tags) {
+            e_free(cache->tags);
+        }//end if
+        e_free(cache);
+    }//end if
+}//end e_etn_cache_free
+
+e_errno_t e_etn_cache_lookup(e_etn_cache_t *cache, e_etn_t *etn, const char *domain, size_t len, e_etn_result_t *result) {
+    uint32_t            set, i, w;
+    uint64_t            h, serial;
+    e_errno_t           err;
+    e_etn_cache_entry_t *e;
+
+    serial = e_etn_get_serial(etn);
+    if(E_UNLIKELY(serial != cache->serial)) {
+        e_etn_cache_clear(cache);
+        cache->serial = serial;
+    }//end if
+
+    if(E_UNLIKELY(len > E_ETN_CACHE_KEY_MAX)) {
+        cache->stats.misses++;
+        return e_etn_lookup(etn, domain, len, result);
+    }//end if
+
+    h = e_etn_cache_hash(domain, len) | 1;
+    set = (uint32_t)(h >> 32) & cache->mask;
+    i = set * E_ETN_CACHE_WAYS;
+    for(w = 0 ; w < E_ETN_CACHE_WAYS ; w++) {
+        if(cache->tags[i + w] != h) {
+            continue;
+        }//end if
+        e = &(cache->entries[i + w]);
+        if(E_LIKELY(e->len == len && memcmp(e->domain, domain, len) == 0)) {
+            cache->clock[set] |= 1 << w;
+            cache->stats.hits++;
+            e_etn_cache_fill(result, e);
+            return E_OK;
+        }//end if
+    }//end for
+
+    cache->stats.misses++;
+    err = e_etn_lookup(etn, domain, len, result);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    w = e_etn_cache_victim(cache, set);
+    cache->tags[i + w] = h;
+    e = &(cache->entries[i + w]);
+    e->len = (uint16_t)len;
+    e->suffix_off = (uint16_t)result->suffix_off;
+    e->registrable_off = (uint16_t)result->registrable_off;
+    e->subdomain_len = (uint16_t)result->subdomain_len;
+    e->labels = (uint8_t)result->labels;
+    e->suffix_labels = (uint8_t)result->suffix_labels;
+    e->icann = result->icann;
+    e->rule = (uint8_t)result->rule;
+    e->suffix_id = result->suffix_id;
+    e->metadata = result->metadata;
+    e->registrable_hash = result->registrable_hash;
+    memcpy(e->domain, domain, len);
+
+    return E_OK;
+}//end e_etn_cache_lookup
+
+void e_etn_cache_clear(e_etn_cache_t *cache) {
+    memset(cache->tags, 0, cache->stats.capacity * sizeof(uint64_t));
+    memset(cache->clock, 0, cache->mask + 1);
+}//end e_etn_cache_clear
+
+void e_etn_cache_stats(e_etn_cache_t *cache, e_etn_cache_stats_t *stats) {
+    *stats = cache->stats;
+}//end e_etn_cache_stats
+
+
+/* ===== private function ===== */
+static inline uint64_t e_etn_cache_hash(const char *s, size_t len) {
+    size_t      i;
+    uint64_t    h, w;
+
+    /* eight bytes at a time, then the finalizer of splitmix64 */
+    h = len * 0x9e3779b97f4a7c15ULL;
+    for(i = 0 ; i + sizeof(w) <= len ; i += sizeof(w)) {
+        memcpy(&w, s + i, sizeof(w));
+        h = (h ^ w) * 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 31;
+    }//end for
+    if(i < len) {
+        w = 0;
+        memcpy(&w, s + i, len - i);
+        h = (h ^ w) * 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 31;
+    }//end if
+
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}//end e_etn_cache_hash
+
+static inline void e_etn_cache_fill(e_etn_result_t *result, const e_etn_cache_entry_t *e) {
+    result->suffix_off = e->suffix_off;
+    result->registrable_off = e->registrable_off;
+    result->subdomain_len = e->subdomain_len;
+    result->labels = e->labels;
+    result->suffix_labels = e->suffix_labels;
+    result->suffix_id = e->suffix_id;
+    result->metadata = e->metadata;
+    result->registrable_hash = e->registrable_hash;
+    result->icann = e->icann;
+    result->rule = (e_etn_rule_t)e->rule;
+}//end e_etn_cache_fill
+
+static inline uint32_t e_etn_cache_victim(e_etn_cache_t *cache, uint32_t set) {
+    uint8_t     c;
+    uint32_t    i, w;
+
+    i = set * E_ETN_CACHE_WAYS;
+    for(w = 0 ; w < E_ETN_CACHE_WAYS ; w++) {
+        if(cache->tags[i + w] == 0) {
+            return w;
+        }//end if
+    }//end for
+
+    /* the hand clears referenced bits until it finds a way that was not used since */
+    c = cache->clock[set];
+    for(w = c >> E_ETN_CACHE_WAYS ; c & (1 << w) ; w = (w + 1) % E_ETN_CACHE_WAYS) {
+        c &= ~(1 << w);
+    }//end for
+    cache->clock[set] = (uint8_t)(c | ((w + 1) % E_ETN_CACHE_WAYS) << E_ETN_CACHE_WAYS);
+    cache->stats.evictions++;
+
+    return w;
+}//end e_etn_cache_victim
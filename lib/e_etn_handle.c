@@ -0,0 +1,325 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libetn/e_etn_handle.h>
+#include <libetn/e_atomic.h>
+#include <libetn/e_mem.h>
+#include <libetn/e_strfuncs.h>
+#include "e_etn_builder.h"
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+
+#define E_ETN_HANDLE_LINE   64
+
+/*
+ * Readers never write anything shared. A reader stores the epoch it entered in
+ * to its own cache line and fences before it loads the table, a writer publishes
+ * the new table, bumps the epoch and waits until no reader is left in an older
+ * one. Epoch 0 means the reader is outside.
+ */
+struct e_etn_reader_s {
+    e_atomic_uint_t     epoch;
+    e_etn_handle_t      *handle;
+} __attribute__((aligned(E_ETN_HANDLE_LINE)));
+
+struct e_etn_handle_s {
+    e_etn_t * volatile  etn;
+    e_atomic_uint_t     epoch;
+
+    /* writers, readers coming and going, on a line of their own */
+    e_atomic_t          lock __attribute__((aligned(E_ETN_HANDLE_LINE)));
+    e_etn_reader_t      **readers;
+    size_t              num_readers;
+    size_t              readers_cap;
+};
+
+struct e_etn_watch_s {
+    int                 fd;
+    e_etn_handle_t      *handle;
+    char                *filename;
+    const char          *name;
+};
+
+static inline void e_etn_handle_lock(e_etn_handle_t *handle);
+static inline void e_etn_handle_unlock(e_etn_handle_t *handle);
+
+e_etn_handle_t *e_etn_handle_new(e_etn_t *etn) {
+    e_etn_handle_t *handle;
+
+    if(E_UNLIKELY(posix_memalign((void **)&handle, E_ETN_HANDLE_LINE, sizeof(e_etn_handle_t)) != 0)) {
+        return NULL;
+    }//end if
+    memset(handle, 0, sizeof(e_etn_handle_t));
+    handle->etn = etn;
+    handle->epoch = 1;
+
+    return handle;
+}//end e_etn_handle_new
+
+void e_etn_handle_free(e_etn_handle_t *handle) {
+    if(E_LIKELY(handle)) {
+        e_etn_unref(handle->etn);
+        if(handle->readers) {
+            e_free(handle->readers);
+        }//end if
+        e_free(handle);
+    }//end if
+}//end e_etn_handle_free
+
+e_errno_t e_etn_handle_swap(e_etn_handle_t *handle, e_etn_t *etn) {
+    size_t      i;
+    uint64_t    epoch, e;
+    e_etn_t     *old;
+
+    e_etn_handle_lock(handle);
+    old = handle->etn;
+    handle->etn = etn;
+    e_atomic_memory_barrier();
+    epoch = e_atomic_get(&handle->epoch) + 1;
+    e_atomic_set(&handle->epoch, epoch);
+    e_atomic_memory_barrier();
+
+    /* the grace period, a reader that entered before the new epoch may still hold old */
+    for(i = 0 ; i < handle->num_readers ; i++) {
+        while((e = e_atomic_load_acquire(&handle->readers[i]->epoch)) != 0 && e < epoch) {
+            sched_yield();
+        }//end while
+    }//end for
+    e_etn_handle_unlock(handle);
+
+    e_etn_unref(old);
+    return E_OK;
+}//end e_etn_handle_swap
+
+e_errno_t e_etn_handle_reload(e_etn_handle_t *handle, const char *filename) {
+    e_etn_t     *etn, *old;
+    e_errno_t   err;
+
+    etn = e_etn_new(filename);
+    if(!etn) {
+        return E_ERR_INVAL;
+    }//end if
+
+    /* the current table is referenced, a swap in another thread can not free it meanwhile */
+    old = e_etn_handle_get(handle);
+    err = e_etn_set_engine(etn, e_etn_get_engine(old));
+    if(err == E_OK) {
+        err = e_etn_copy_metadata(etn, old);
+    }//end if
+    e_etn_unref(old);
+    if(E_UNLIKELY(err != E_OK)) {
+        e_etn_unref(etn);
+        return err;
+    }//end if
+
+    return e_etn_handle_swap(handle, etn);
+}//end e_etn_handle_reload
+
+e_etn_t *e_etn_handle_get(e_etn_handle_t *handle) {
+    e_etn_t *etn;
+
+    e_etn_handle_lock(handle);
+    etn = e_etn_ref(handle->etn);
+    e_etn_handle_unlock(handle);
+
+    return etn;
+}//end e_etn_handle_get
+
+e_etn_reader_t *e_etn_reader_new(e_etn_handle_t *handle) {
+    size_t          cap;
+    e_etn_reader_t  *reader, **readers;
+
+    if(E_UNLIKELY(posix_memalign((void **)&reader, E_ETN_HANDLE_LINE, sizeof(e_etn_reader_t)) != 0)) {
+        return NULL;
+    }//end if
+    reader->epoch = 0;
+    reader->handle = handle;
+
+    e_etn_handle_lock(handle);
+    if(handle->num_readers == handle->readers_cap) {
+        cap = handle->readers_cap ? handle->readers_cap * 2 : 16;
+        readers = e_realloc(handle->readers, cap * sizeof(e_etn_reader_t *));
+        if(E_UNLIKELY(!readers)) {
+            e_etn_handle_unlock(handle);
+            e_free(reader);
+            return NULL;
+        }//end if
+        handle->readers = readers;
+        handle->readers_cap = cap;
+    }//end if
+    handle->readers[handle->num_readers++] = reader;
+    e_etn_handle_unlock(handle);
+
+    return reader;
+}//end e_etn_reader_new
+
+void e_etn_reader_free(e_etn_reader_t *reader) {
+    size_t          i;
+    e_etn_handle_t  *handle;
+
+    if(E_UNLIKELY(!reader)) {
+        return;
+    }//end if
+
+    handle = reader->handle;
+    e_etn_handle_lock(handle);
+    for(i = 0 ; i < handle->num_readers ; i++) {
+        if(handle->readers[i] == reader) {
+            handle->readers[i] = handle->readers[--handle->num_readers];
+            break;
+        }//end if
+    }//end for
+    e_etn_handle_unlock(handle);
+
+    e_free(reader);
+}//end e_etn_reader_free
+
+e_etn_t *e_etn_reader_lock(e_etn_reader_t *reader) {
+    /* a plain store to our own line, the fence orders it before the table is read */
+    e_atomic_set(&reader->epoch, e_atomic_get(&reader->handle->epoch));
+    e_atomic_memory_barrier();
+
+    return reader->handle->etn;
+}//end e_etn_reader_lock
+
+void e_etn_reader_unlock(e_etn_reader_t *reader) {
+    e_atomic_store_release(&reader->epoch, 0);
+}//end e_etn_reader_unlock
+
+#ifdef HAVE_SYS_INOTIFY_H
+e_etn_watch_t *e_etn_watch_new(e_etn_handle_t *handle, const char *filename) {
+    char            *slash;
+    e_etn_watch_t   *watch;
+
+    watch = e_calloc(1, sizeof(e_etn_watch_t));
+    if(E_UNLIKELY(!watch)) {
+        return NULL;
+    }//end if
+    watch->handle = handle;
+    watch->fd = -1;
+
+    watch->filename = e_strdup(filename);
+    if(E_UNLIKELY(!watch->filename)) {
+        e_etn_watch_free(watch);
+        return NULL;
+    }//end if
+
+    watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(watch->fd == -1) {
+        e_etn_watch_free(watch);
+        return NULL;
+    }//end if
+
+    /* the directory is watched, a file renamed over has a new inode, one written in place is not reloaded */
+    slash = strrchr(watch->filename, '/');
+    if(slash) {
+        *slash = '\0';
+        watch->name = slash + 1;
+    }//end if
+    else {
+        watch->name = watch->filename;
+    }//end else
+    if(inotify_add_watch(watch->fd, slash ? (slash == watch->filename ? "/" : watch->filename) : ".", IN_MOVED_TO) == -1) {
+        e_etn_watch_free(watch);
+        return NULL;
+    }//end if
+    if(slash) {
+        *slash = '/';
+    }//end if
+
+    return watch;
+}//end e_etn_watch_new
+
+e_errno_t e_etn_watch_dispatch(e_etn_watch_t *watch) {
+    bool                        changed;
+    char                        *p;
+    ssize_t                     n;
+    const struct inotify_event  *ev;
+    char                        buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    changed = false;
+    while((n = read(watch->fd, buf, sizeof(buf))) > 0) {
+        for(p = buf ; p < buf + n ; p += sizeof(struct inotify_event) + ev->len) {
+            ev = (const struct inotify_event *)p;
+            if(ev->len > 0 && strcmp(ev->name, watch->name) == 0) {
+                changed = true;
+            }//end if
+        }//end for
+    }//end while
+
+    if(!changed) {
+        return E_OK;
+    }//end if
+
+    /* a file that does not load leaves the current table in place */
+    return e_etn_handle_reload(watch->handle, watch->filename);
+}//end e_etn_watch_dispatch
+#else
+e_etn_watch_t *e_etn_watch_new(e_etn_handle_t *handle, const char *filename) {
+    return NULL;
+}//end e_etn_watch_new
+
+e_errno_t e_etn_watch_dispatch(e_etn_watch_t *watch) {
+    return E_ERR_NOTSUP;
+}//end e_etn_watch_dispatch
+#endif
+
+int e_etn_watch_fd(e_etn_watch_t *watch) {
+    return watch->fd;
+}//end e_etn_watch_fd
+
+void e_etn_watch_free(e_etn_watch_t *watch) {
+    if(E_LIKELY(watch)) {
+        if(watch->fd != -1) {
+            close(watch->fd);
+        }//end if
+        if(watch->filename) {
+            e_free(watch->filename);
+        }//end if
+        e_free(watch);
+    }//end if
+}//end e_etn_watch_free
+
+
+/* ===== private function ===== */
+static inline void e_etn_handle_lock(e_etn_handle_t *handle) {
+    while(!e_atomic_trylock(&handle->lock)) {
+        sched_yield();
+    }//end while
+}//end e_etn_handle_lock
+
+static inline void e_etn_handle_unlock(e_etn_handle_t *handle) {
+    e_atomic_memory_barrier();
+    e_atomic_unlock(&handle->lock);
+}//end e_etn_handle_unlock
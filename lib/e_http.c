@@ -0,0 +1,647 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libetn/e_http.h>
+#include <libetn/e_mem.h>
+#include <string.h>
+
+#define E_HPACK_STATIC_ENTRIES      61
+#define E_HPACK_STATIC_AUTHORITY    1
+#define E_HPACK_STATIC_HOST         38
+#define E_HPACK_ENTRY_OVERHEAD      32
+#define E_HPACK_AUTHORITY_MAX       512
+#define E_HPACK_NAME_MAX            16
+#define E_HPACK_INTEGER_SHIFT_MAX   21
+#define E_HPACK_HUFFMAN_FAST_BITS   8
+#define E_HPACK_HUFFMAN_EOS         256
+#define E_HPACK_NAME(s)             (sizeof(s) - 1)
+
+/* what a header is to us, a higher kind wins */
+#define E_HPACK_KIND_OTHER          0
+#define E_HPACK_KIND_HOST           1
+#define E_HPACK_KIND_AUTHORITY      2
+
+/* an entry of the dynamic table, the value is kept only for :authority and host */
+typedef struct e_hpack_entry_s {
+    uint32_t    size;           /* name, value and E_HPACK_ENTRY_OVERHEAD */
+    uint32_t    name_len;
+    uint32_t    value_off;      /* into the arena */
+    uint32_t    value_len;
+    uint8_t     kind;
+} e_hpack_entry_t;
+
+/*
+ * The entries are a ring, oldest at first. Values go to the end of the arena in
+ * the order of their entries, so the live ones are [arena_head, arena_tail) and
+ * move to the front when the next does not fit.
+ */
+struct e_hpack_s {
+    e_hpack_entry_t *entries;
+    uint32_t        slots;
+    uint32_t        first;
+    uint32_t        count;
+    size_t          size;
+    size_t          capacity;       /* set by the last dynamic table size update */
+    size_t          max_size;
+    char            *arena;
+    size_t          arena_head;
+    size_t          arena_tail;
+    char            authority[E_HPACK_AUTHORITY_MAX];
+    char            scratch[E_HPACK_AUTHORITY_MAX];
+};
+
+/* the name lengths of the static table of RFC 7541 appendix A */
+static const uint8_t e_hpack_static_name_len[E_HPACK_STATIC_ENTRIES + 1] = {
+    0, E_HPACK_NAME(":authority"), E_HPACK_NAME(":method"), E_HPACK_NAME(":method"), E_HPACK_NAME(":path"),
+    E_HPACK_NAME(":path"), E_HPACK_NAME(":scheme"), E_HPACK_NAME(":scheme"), E_HPACK_NAME(":status"),
+    E_HPACK_NAME(":status"), E_HPACK_NAME(":status"), E_HPACK_NAME(":status"), E_HPACK_NAME(":status"),
+    E_HPACK_NAME(":status"), E_HPACK_NAME(":status"), E_HPACK_NAME("accept-charset"),
+    E_HPACK_NAME("accept-encoding"), E_HPACK_NAME("accept-language"), E_HPACK_NAME("accept-ranges"),
+    E_HPACK_NAME("accept"), E_HPACK_NAME("access-control-allow-origin"), E_HPACK_NAME("age"),
+    E_HPACK_NAME("allow"), E_HPACK_NAME("authorization"), E_HPACK_NAME("cache-control"),
+    E_HPACK_NAME("content-disposition"), E_HPACK_NAME("content-encoding"), E_HPACK_NAME("content-language"),
+    E_HPACK_NAME("content-length"), E_HPACK_NAME("content-location"), E_HPACK_NAME("content-range"),
+    E_HPACK_NAME("content-type"), E_HPACK_NAME("cookie"), E_HPACK_NAME("date"), E_HPACK_NAME("etag"),
+    E_HPACK_NAME("expect"), E_HPACK_NAME("expires"), E_HPACK_NAME("from"), E_HPACK_NAME("host"),
+    E_HPACK_NAME("if-match"), E_HPACK_NAME("if-modified-since"), E_HPACK_NAME("if-none-match"),
+    E_HPACK_NAME("if-range"), E_HPACK_NAME("if-unmodified-since"), E_HPACK_NAME("last-modified"),
+    E_HPACK_NAME("link"), E_HPACK_NAME("location"), E_HPACK_NAME("max-forwards"),
+    E_HPACK_NAME("proxy-authenticate"), E_HPACK_NAME("proxy-authorization"), E_HPACK_NAME("range"),
+    E_HPACK_NAME("referer"), E_HPACK_NAME("refresh"), E_HPACK_NAME("retry-after"), E_HPACK_NAME("server"),
+    E_HPACK_NAME("set-cookie"), E_HPACK_NAME("strict-transport-security"), E_HPACK_NAME("transfer-encoding"),
+    E_HPACK_NAME("user-agent"), E_HPACK_NAME("vary"), E_HPACK_NAME("via"), E_HPACK_NAME("www-authenticate"),
+};
+
+/*
+ * The Huffman code of RFC 7541 appendix B is canonical. A code of up to 8 bits is
+ * found by the first 8 bits of the input, (length << 8) | symbol, 0 if it is longer.
+ * A longer code is the first length whose limit, the end of its codes aligned to 32
+ * bits, is above the input; its symbol is at offset + code - first.
+ */
+static const uint16_t e_hpack_huffman_fast[256] = {
+    0x0530, 0x0530, 0x0530, 0x0530, 0x0530, 0x0530, 0x0530, 0x0530, 0x0531, 0x0531, 0x0531, 0x0531,
+    0x0531, 0x0531, 0x0531, 0x0531, 0x0532, 0x0532, 0x0532, 0x0532, 0x0532, 0x0532, 0x0532, 0x0532,
+    0x0561, 0x0561, 0x0561, 0x0561, 0x0561, 0x0561, 0x0561, 0x0561, 0x0563, 0x0563, 0x0563, 0x0563,
+    0x0563, 0x0563, 0x0563, 0x0563, 0x0565, 0x0565, 0x0565, 0x0565, 0x0565, 0x0565, 0x0565, 0x0565,
+    0x0569, 0x0569, 0x0569, 0x0569, 0x0569, 0x0569, 0x0569, 0x0569, 0x056f, 0x056f, 0x056f, 0x056f,
+    0x056f, 0x056f, 0x056f, 0x056f, 0x0573, 0x0573, 0x0573, 0x0573, 0x0573, 0x0573, 0x0573, 0x0573,
+    0x0574, 0x0574, 0x0574, 0x0574, 0x0574, 0x0574, 0x0574, 0x0574, 0x0620, 0x0620, 0x0620, 0x0620,
+    0x0625, 0x0625, 0x0625, 0x0625, 0x062d, 0x062d, 0x062d, 0x062d, 0x062e, 0x062e, 0x062e, 0x062e,
+    0x062f, 0x062f, 0x062f, 0x062f, 0x0633, 0x0633, 0x0633, 0x0633, 0x0634, 0x0634, 0x0634, 0x0634,
+    0x0635, 0x0635, 0x0635, 0x0635, 0x0636, 0x0636, 0x0636, 0x0636, 0x0637, 0x0637, 0x0637, 0x0637,
+    0x0638, 0x0638, 0x0638, 0x0638, 0x0639, 0x0639, 0x0639, 0x0639, 0x063d, 0x063d, 0x063d, 0x063d,
+    0x0641, 0x0641, 0x0641, 0x0641, 0x065f, 0x065f, 0x065f, 0x065f, 0x0662, 0x0662, 0x0662, 0x0662,
+    0x0664, 0x0664, 0x0664, 0x0664, 0x0666, 0x0666, 0x0666, 0x0666, 0x0667, 0x0667, 0x0667, 0x0667,
+    0x0668, 0x0668, 0x0668, 0x0668, 0x066c, 0x066c, 0x066c, 0x066c, 0x066d, 0x066d, 0x066d, 0x066d,
+    0x066e, 0x066e, 0x066e, 0x066e, 0x0670, 0x0670, 0x0670, 0x0670, 0x0672, 0x0672, 0x0672, 0x0672,
+    0x0675, 0x0675, 0x0675, 0x0675, 0x073a, 0x073a, 0x0742, 0x0742, 0x0743, 0x0743, 0x0744, 0x0744,
+    0x0745, 0x0745, 0x0746, 0x0746, 0x0747, 0x0747, 0x0748, 0x0748, 0x0749, 0x0749, 0x074a, 0x074a,
+    0x074b, 0x074b, 0x074c, 0x074c, 0x074d, 0x074d, 0x074e, 0x074e, 0x074f, 0x074f, 0x0750, 0x0750,
+    0x0751, 0x0751, 0x0752, 0x0752, 0x0753, 0x0753, 0x0754, 0x0754, 0x0755, 0x0755, 0x0756, 0x0756,
+    0x0757, 0x0757, 0x0759, 0x0759, 0x076a, 0x076a, 0x076b, 0x076b, 0x0771, 0x0771, 0x0776, 0x0776,
+    0x0777, 0x0777, 0x0778, 0x0778, 0x0779, 0x0779, 0x077a, 0x077a, 0x0826, 0x082a, 0x082c, 0x083b,
+    0x0858, 0x085a, 0x0000, 0x0000,
+};
+
+static const uint8_t e_hpack_huffman_symbols[256] = {
+    0x30, 0x31, 0x32, 0x61, 0x63, 0x65, 0x69, 0x6f, 0x73, 0x74, 0x20, 0x25, 0x2d, 0x2e, 0x2f, 0x33,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3d, 0x41, 0x5f, 0x62, 0x64, 0x66, 0x67, 0x68, 0x6c, 0x6d,
+    0x6e, 0x70, 0x72, 0x75, 0x3a, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c,
+    0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x59, 0x6a, 0x6b, 0x71, 0x76,
+    0x77, 0x78, 0x79, 0x7a, 0x26, 0x2a, 0x2c, 0x3b, 0x58, 0x5a, 0x21, 0x22, 0x28, 0x29, 0x3f, 0x27,
+    0x2b, 0x7c, 0x23, 0x3e, 0x00, 0x24, 0x40, 0x5b, 0x5d, 0x7e, 0x5e, 0x7d, 0x3c, 0x60, 0x7b, 0x5c,
+    0xc3, 0xd0, 0x80, 0x82, 0x83, 0xa2, 0xb8, 0xc2, 0xe0, 0xe2, 0x99, 0xa1, 0xa7, 0xac, 0xb0, 0xb1,
+    0xb3, 0xd1, 0xd8, 0xd9, 0xe3, 0xe5, 0xe6, 0x81, 0x84, 0x85, 0x86, 0x88, 0x92, 0x9a, 0x9c, 0xa0,
+    0xa3, 0xa4, 0xa9, 0xaa, 0xad, 0xb2, 0xb5, 0xb9, 0xba, 0xbb, 0xbd, 0xbe, 0xc4, 0xc6, 0xe4, 0xe8,
+    0xe9, 0x01, 0x87, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8f, 0x93, 0x95, 0x96, 0x97, 0x98, 0x9b, 0x9d,
+    0x9e, 0xa5, 0xa6, 0xa8, 0xae, 0xaf, 0xb4, 0xb6, 0xb7, 0xbc, 0xbf, 0xc5, 0xe7, 0xef, 0x09, 0x8e,
+    0x90, 0x91, 0x94, 0x9f, 0xab, 0xce, 0xd7, 0xe1, 0xec, 0xed, 0xc7, 0xcf, 0xea, 0xeb, 0xc0, 0xc1,
+    0xc8, 0xc9, 0xca, 0xcd, 0xd2, 0xd5, 0xda, 0xdb, 0xee, 0xf0, 0xf2, 0xf3, 0xff, 0xcb, 0xcc, 0xd3,
+    0xd4, 0xd6, 0xdd, 0xde, 0xdf, 0xf1, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe,
+    0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x0b, 0x0c, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14,
+    0x15, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x7f, 0xdc, 0xf9, 0x0a, 0x0d, 0x16,
+};
+
+static const uint32_t e_hpack_huffman_first[31] = {
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000014, 0x0000005c,
+    0x000000f8, 0x00000000, 0x000003f8, 0x000007fa, 0x00000ffa, 0x00001ff8, 0x00003ffc, 0x00007ffc,
+    0x00000000, 0x00000000, 0x00000000, 0x0007fff0, 0x000fffe6, 0x001fffdc, 0x003fffd2, 0x007fffd8,
+    0x00ffffea, 0x01ffffec, 0x03ffffe0, 0x07ffffde, 0x0fffffe2, 0x00000000, 0x3ffffffc,
+};
+
+static const uint16_t e_hpack_huffman_offset[31] = {
+    0, 0, 0, 0, 0, 0, 10, 36, 68, 0, 74, 79, 82, 84, 90, 92,
+    0, 0, 0, 95, 98, 106, 119, 145, 174, 186, 190, 205, 224, 0, 253,
+};
+
+static const uint64_t e_hpack_huffman_limit[31] = {
+    0x000000000ULL, 0x000000000ULL, 0x000000000ULL, 0x000000000ULL,
+    0x000000000ULL, 0x050000000ULL, 0x0b8000000ULL, 0x0f8000000ULL,
+    0x0fe000000ULL, 0x0fe000000ULL, 0x0ff400000ULL, 0x0ffa00000ULL,
+    0x0ffc00000ULL, 0x0fff00000ULL, 0x0fff80000ULL, 0x0fffe0000ULL,
+    0x0fffe0000ULL, 0x0fffe0000ULL, 0x0fffe0000ULL, 0x0fffe6000ULL,
+    0x0fffee000ULL, 0x0ffff4800ULL, 0x0ffffb000ULL, 0x0ffffea00ULL,
+    0x0fffff600ULL, 0x0fffff800ULL, 0x0fffffbc0ULL, 0x0fffffe20ULL,
+    0x0fffffff0ULL, 0x0fffffff0ULL, 0x100000000ULL,
+};
+
+static inline e_errno_t e_hpack_field(e_hpack_t *hpack, size_t index, uint8_t *kind, size_t *name_len, const char **value, size_t *value_len);
+static inline void e_hpack_insert(e_hpack_t *hpack, size_t name_len, uint8_t kind, const char *value, size_t value_len);
+static inline void e_hpack_evict(e_hpack_t *hpack, size_t limit);
+static inline e_errno_t e_hpack_integer(const uint8_t *block, size_t len, size_t *p, uint32_t prefix, size_t *value);
+static inline e_errno_t e_hpack_string(const uint8_t *block, size_t len, size_t *p, const uint8_t **s, size_t *n, bool *huffman);
+static inline e_errno_t e_hpack_huffman(const uint8_t *src, size_t len, char *dst, size_t size, size_t *n);
+static inline uint8_t e_hpack_kind(const char *name, size_t len);
+static inline void e_http_host_trim(const char **host, size_t *len);
+
+e_errno_t e_http_host_extract(const char *data, size_t len, const char **host, size_t *host_len) {
+    size_t      p, start, end;
+    uint32_t    w, name;
+    const char  *eol;
+
+    /* the request line, then a header a line; memchr() is vectorized by the C library */
+    memcpy(&name, "host", sizeof(name));
+    eol = memchr(data, '\n', len);
+    while(eol) {
+        p = eol - data + 1;
+        if(E_UNLIKELY(p >= len)) {
+            break;
+        }//end if
+
+        /* an empty line ends the headers */
+        if(data[p] == '\n' || (data[p] == '\r' && p + 1 < len && data[p + 1] == '\n')) {
+            return E_ERR_NOFOUND;
+        }//end if
+
+        eol = memchr(data + p, '\n', len - p);
+        if(len - p > sizeof(w)) {
+            memcpy(&w, data + p, sizeof(w));
+            if((w | 0x20202020) == name && data[p + sizeof(w)] == ':') {
+                if(E_UNLIKELY(!eol)) {
+                    break;
+                }//end if
+
+                /* the value without surrounding white space */
+                start = p + sizeof(w) + 1;
+                end = eol - data;
+                while(start < end && (data[start] == ' ' || data[start] == '\t')) {
+                    start++;
+                }//end while
+                while(end > start && (data[end - 1] == ' ' || data[end - 1] == '\t' || data[end - 1] == '\r')) {
+                    end--;
+                }//end while
+
+                *host = data + start;
+                *host_len = end - start;
+                e_http_host_trim(host, host_len);
+                return *host_len > 0 ? E_OK : E_ERR_NOFOUND;
+            }//end if
+        }//end if
+    }//end while
+
+    return E_ERR_AGAIN;
+}//end e_http_host_extract
+
+e_errno_t e_etn_classify_http_request(e_etn_t *etn, const char *data, size_t len, const char **host, size_t *host_len, e_etn_result_t *result) {
+    e_errno_t   err;
+
+    err = e_http_host_extract(data, len, host, host_len);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    return e_etn_lookup(etn, *host, *host_len, result);
+}//end e_etn_classify_http_request
+
+e_hpack_t *e_hpack_new(size_t max_size) {
+    e_hpack_t   *hpack;
+
+    if(E_UNLIKELY(max_size > UINT32_MAX)) {
+        return NULL;
+    }//end if
+
+    hpack = e_calloc(1, sizeof(e_hpack_t));
+    if(E_UNLIKELY(!hpack)) {
+        return NULL;
+    }//end if
+
+    /* an entry takes at least E_HPACK_ENTRY_OVERHEAD, values at most max_size */
+    hpack->slots = max_size / E_HPACK_ENTRY_OVERHEAD + 1;
+    hpack->max_size = max_size;
+    hpack->capacity = max_size;
+    hpack->entries = e_malloc(hpack->slots * sizeof(e_hpack_entry_t));
+    hpack->arena = e_malloc(max_size + 1);
+    if(E_UNLIKELY(!hpack->entries || !hpack->arena)) {
+        e_hpack_free(hpack);
+        return NULL;
+    }//end if
+
+    return hpack;
+}//end e_hpack_new
+
+void e_hpack_free(e_hpack_t *hpack) {
+    if(hpack) {
+        e_free(hpack->entries);
+        e_free(hpack->arena);
+        e_free(hpack);
+    }//end if
+}//end e_hpack_free
+
+e_errno_t e_hpack_authority(e_hpack_t *hpack, const uint8_t *block, size_t len, const char **authority, size_t *authority_len) {
+    bool            huffman, indexing;
+    char            name[E_HPACK_NAME_MAX];
+    size_t          p, index, n, name_len, value_len;
+    uint8_t         b, kind, found;
+    e_errno_t       err;
+    const char      *value;
+    const uint8_t   *s;
+
+    found = E_HPACK_KIND_OTHER;
+    p = 0;
+    while(p < len) {
+        b = block[p];
+        if(b & 0x80) {
+            /* an indexed field */
+            err = e_hpack_integer(block, len, &p, 7, &index);
+            if(E_LIKELY(err == E_OK)) {
+                err = e_hpack_field(hpack, index, &kind, &name_len, &value, &value_len);
+            }//end if
+            if(E_UNLIKELY(err != E_OK)) {
+                return err;
+            }//end if
+
+            if(kind > found) {
+                /* the arena moves as entries are added, the value is kept aside */
+                if(E_UNLIKELY(value_len > E_HPACK_AUTHORITY_MAX)) {
+                    return E_ERR_INVAL;
+                }//end if
+
+                memcpy(hpack->authority, value, value_len);
+                *authority = hpack->authority;
+                *authority_len = value_len;
+                found = kind;
+            }//end if
+            continue;
+        }//end if
+
+        if((b & 0xe0) == 0x20) {
+            /* a dynamic table size update */
+            err = e_hpack_integer(block, len, &p, 5, &n);
+            if(E_UNLIKELY(err != E_OK || n > hpack->max_size)) {
+                return E_ERR_INVAL;
+            }//end if
+
+            hpack->capacity = n;
+            e_hpack_evict(hpack, n);
+            continue;
+        }//end if
+
+        /* a literal, with incremental indexing, without indexing or never indexed */
+        indexing = (b & 0xc0) == 0x40;
+        err = e_hpack_integer(block, len, &p, indexing ? 6 : 4, &index);
+        if(E_UNLIKELY(err != E_OK)) {
+            return err;
+        }//end if
+
+        if(index > 0) {
+            err = e_hpack_field(hpack, index, &kind, &name_len, &value, &value_len);
+            if(E_UNLIKELY(err != E_OK)) {
+                return err;
+            }//end if
+        }//end if
+        else {
+            err = e_hpack_string(block, len, &p, &s, &n, &huffman);
+            if(E_UNLIKELY(err != E_OK)) {
+                return err;
+            }//end if
+
+            if(huffman) {
+                err = e_hpack_huffman(s, n, name, sizeof(name), &name_len);
+                if(E_UNLIKELY(err != E_OK)) {
+                    return err;
+                }//end if
+                kind = name_len <= sizeof(name) ? e_hpack_kind(name, name_len) : E_HPACK_KIND_OTHER;
+            }//end if
+            else {
+                name_len = n;
+                kind = e_hpack_kind((const char *)s, n);
+            }//end else
+        }//end else
+
+        err = e_hpack_string(block, len, &p, &s, &n, &huffman);
+        if(E_UNLIKELY(err != E_OK)) {
+            return err;
+        }//end if
+
+        value = (const char *)s;
+        value_len = n;
+        if(kind > E_HPACK_KIND_OTHER && (kind > found || indexing)) {
+            if(huffman) {
+                value = kind > found ? hpack->authority : hpack->scratch;
+                err = e_hpack_huffman(s, n, (char *)value, E_HPACK_AUTHORITY_MAX, &value_len);
+                if(E_UNLIKELY(err != E_OK)) {
+                    return err;
+                }//end if
+            }//end if
+            if(E_UNLIKELY(value_len > E_HPACK_AUTHORITY_MAX)) {
+                return E_ERR_INVAL;
+            }//end if
+
+            if(kind > found) {
+                *authority = value;
+                *authority_len = value_len;
+                found = kind;
+            }//end if
+        }//end if
+        else if(indexing && huffman) {
+            /* only the length counts */
+            err = e_hpack_huffman(s, n, NULL, 0, &value_len);
+            if(E_UNLIKELY(err != E_OK)) {
+                return err;
+            }//end if
+        }//end if
+
+        if(indexing) {
+            e_hpack_insert(hpack, name_len, kind, value, value_len);
+        }//end if
+    }//end while
+
+    if(found == E_HPACK_KIND_OTHER) {
+        return E_ERR_NOFOUND;
+    }//end if
+
+    e_http_host_trim(authority, authority_len);
+    return *authority_len > 0 ? E_OK : E_ERR_NOFOUND;
+}//end e_hpack_authority
+
+e_errno_t e_etn_classify_hpack(e_etn_t *etn, e_hpack_t *hpack, const uint8_t *block, size_t len, const char **authority, size_t *authority_len, e_etn_result_t *result) {
+    e_errno_t   err;
+
+    err = e_hpack_authority(hpack, block, len, authority, authority_len);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    return e_etn_lookup(etn, *authority, *authority_len, result);
+}//end e_etn_classify_hpack
+
+
+/* ===== private function ===== */
+static inline e_errno_t e_hpack_field(e_hpack_t *hpack, size_t index, uint8_t *kind, size_t *name_len, const char **value, size_t *value_len) {
+    e_hpack_entry_t *e;
+
+    if(index <= E_HPACK_STATIC_ENTRIES) {
+        if(E_UNLIKELY(index == 0)) {
+            return E_ERR_INVAL;
+        }//end if
+
+        /* the static :authority and host have empty values */
+        *kind = index == E_HPACK_STATIC_AUTHORITY ? E_HPACK_KIND_AUTHORITY :
+            index == E_HPACK_STATIC_HOST ? E_HPACK_KIND_HOST : E_HPACK_KIND_OTHER;
+        *name_len = e_hpack_static_name_len[index];
+        *value = "";
+        *value_len = 0;
+        return E_OK;
+    }//end if
+
+    /* the newest entry is the first after the static table */
+    index -= E_HPACK_STATIC_ENTRIES + 1;
+    if(E_UNLIKELY(index >= hpack->count)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    e = &hpack->entries[(hpack->first + hpack->count - 1 - index) % hpack->slots];
+    *kind = e->kind;
+    *name_len = e->name_len;
+    *value = hpack->arena + e->value_off;
+    *value_len = e->value_len;
+    return E_OK;
+}//end e_hpack_field
+
+static inline void e_hpack_insert(e_hpack_t *hpack, size_t name_len, uint8_t kind, const char *value, size_t value_len) {
+    size_t          size;
+    uint32_t        i;
+    e_hpack_entry_t *e;
+
+    /* an entry larger than the table empties it and is not added */
+    size = name_len + value_len + E_HPACK_ENTRY_OVERHEAD;
+    if(size > hpack->capacity) {
+        e_hpack_evict(hpack, 0);
+        return;
+    }//end if
+    e_hpack_evict(hpack, hpack->capacity - size);
+
+    e = &hpack->entries[(hpack->first + hpack->count) % hpack->slots];
+    e->size = size;
+    e->name_len = name_len;
+    e->value_off = 0;
+    e->value_len = 0;
+    e->kind = kind;
+    if(kind > E_HPACK_KIND_OTHER) {
+        if(value_len > hpack->max_size - hpack->arena_tail) {
+            memmove(hpack->arena, hpack->arena + hpack->arena_head, hpack->arena_tail - hpack->arena_head);
+            for(i = 0 ; i < hpack->count ; i++) {
+                hpack->entries[(hpack->first + i) % hpack->slots].value_off -= hpack->entries[(hpack->first + i) % hpack->slots].kind > E_HPACK_KIND_OTHER ? hpack->arena_head : 0;
+            }//end for
+            hpack->arena_tail -= hpack->arena_head;
+            hpack->arena_head = 0;
+        }//end if
+
+        memcpy(hpack->arena + hpack->arena_tail, value, value_len);
+        e->value_off = hpack->arena_tail;
+        e->value_len = value_len;
+        hpack->arena_tail += value_len;
+    }//end if
+
+    hpack->count++;
+    hpack->size += size;
+}//end e_hpack_insert
+
+static inline void e_hpack_evict(e_hpack_t *hpack, size_t limit) {
+    e_hpack_entry_t *e;
+
+    while(hpack->size > limit) {
+        e = &hpack->entries[hpack->first];
+        if(e->kind > E_HPACK_KIND_OTHER) {
+            hpack->arena_head = e->value_off + e->value_len;
+        }//end if
+
+        hpack->size -= e->size;
+        hpack->first = (hpack->first + 1) % hpack->slots;
+        hpack->count--;
+    }//end while
+
+    if(hpack->count == 0) {
+        hpack->arena_head = 0;
+        hpack->arena_tail = 0;
+    }//end if
+}//end e_hpack_evict
+
+static inline e_errno_t e_hpack_integer(const uint8_t *block, size_t len, size_t *p, uint32_t prefix, size_t *value) {
+    size_t      v, mask, shift;
+    uint8_t     b;
+
+    mask = ((size_t)1 << prefix) - 1;
+    v = block[(*p)++] & mask;
+    if(v == mask) {
+        for(shift = 0 ; ; shift += 7) {
+            if(E_UNLIKELY(*p >= len || shift > E_HPACK_INTEGER_SHIFT_MAX)) {
+                return E_ERR_INVAL;
+            }//end if
+
+            b = block[(*p)++];
+            v += (size_t)(b & 0x7f) << shift;
+            if(!(b & 0x80)) {
+                break;
+            }//end if
+        }//end for
+    }//end if
+
+    *value = v;
+    return E_OK;
+}//end e_hpack_integer
+
+static inline e_errno_t e_hpack_string(const uint8_t *block, size_t len, size_t *p, const uint8_t **s, size_t *n, bool *huffman) {
+    e_errno_t   err;
+
+    if(E_UNLIKELY(*p >= len)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    *huffman = block[*p] & 0x80;
+    err = e_hpack_integer(block, len, p, 7, n);
+    if(E_UNLIKELY(err != E_OK || *n > len - *p)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    *s = block + *p;
+    *p += *n;
+    return E_OK;
+}//end e_hpack_string
+
+static inline e_errno_t e_hpack_huffman(const uint8_t *src, size_t len, char *dst, size_t size, size_t *n) {
+    size_t          bits, out;
+    uint32_t        w, e, code_len, i;
+    uint64_t        acc;
+    const uint8_t   *end;
+
+    /* acc holds the next bits of src in its low bits, past the end they read as ones */
+    acc = 0;
+    bits = 0;
+    out = 0;
+    end = src + len;
+    for( ; ; ) {
+        while(bits <= 56 && src < end) {
+            acc = (acc << 8) | *src++;
+            bits += 8;
+        }//end while
+        if(bits == 0) {
+            break;
+        }//end if
+
+        if(bits >= 32) {
+            w = (uint32_t)(acc >> (bits - 32));
+        }//end if
+        else {
+            w = (uint32_t)(acc << (32 - bits)) | ((UINT32_C(1) << (32 - bits)) - 1);
+        }//end else
+
+        e = e_hpack_huffman_fast[w >> (32 - E_HPACK_HUFFMAN_FAST_BITS)];
+        if(E_LIKELY(e)) {
+            code_len = e >> 8;
+            i = e & 0xff;
+        }//end if
+        else {
+            for(code_len = E_HPACK_HUFFMAN_FAST_BITS + 1 ; w >= e_hpack_huffman_limit[code_len] ; code_len++);
+            i = e_hpack_huffman_offset[code_len] + ((w >> (32 - code_len)) - e_hpack_huffman_first[code_len]);
+            i = i < E_HPACK_HUFFMAN_EOS ? e_hpack_huffman_symbols[i] : E_HPACK_HUFFMAN_EOS;
+        }//end else
+
+        if(code_len > bits) {
+            /* what is left is padding, up to 7 bits of the EOS code */
+            if(E_UNLIKELY(bits > 7 || (acc & ((UINT64_C(1) << bits) - 1)) != (UINT64_C(1) << bits) - 1)) {
+                return E_ERR_INVAL;
+            }//end if
+            break;
+        }//end if
+        if(E_UNLIKELY(i == E_HPACK_HUFFMAN_EOS)) {
+            return E_ERR_INVAL;
+        }//end if
+
+        if(out < size) {
+            dst[out] = i;
+        }//end if
+        out++;
+        bits -= code_len;
+    }//end for
+
+    *n = out;
+    return E_OK;
+}//end e_hpack_huffman
+
+static inline uint8_t e_hpack_kind(const char *name, size_t len) {
+    if(len == E_HPACK_NAME(":authority") && memcmp(name, ":authority", len) == 0) {
+        return E_HPACK_KIND_AUTHORITY;
+    }//end if
+    if(len == E_HPACK_NAME("host") && memcmp(name, "host", len) == 0) {
+        return E_HPACK_KIND_HOST;
+    }//end if
+
+    return E_HPACK_KIND_OTHER;
+}//end e_hpack_kind
+
+/* drop userinfo and the port of an authority, an IPv6 literal keeps its brackets */
+static inline void e_http_host_trim(const char **host, size_t *len) {
+    size_t      i;
+    const char  *s;
+
+    s = *host;
+    for(i = *len ; i > 0 ; i--) {
+        if(s[i - 1] == '@') {
+            *host = s + i;
+            *len -= i;
+            break;
+        }//end if
+    }//end for
+
+    s = *host;
+    if(*len > 0 && s[0] == '[') {
+        s = memchr(s, ']', *len);
+        if(s) {
+            *len = s - *host + 1;
+        }//end if
+        return;
+    }//end if
+
+    s = memchr(s, ':', *len);
+    if(s) {
+        *len = s - *host;
+    }//end if
+}//end e_http_host_trim
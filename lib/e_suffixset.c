@@ -0,0 +1,758 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libetn/e_suffixset.h>
+#include <libetn/e_etn.h>
+#include <libetn/e_mem.h>
+#include <libetn/e_strfuncs.h>
+#include "e_etn_builder.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define E_SUFFIXSET_MAGIC           0x96010430
+
+/* sections start on this boundary, the header has room to grow */
+#define E_SUFFIXSET_ALIGN           64
+#define E_SUFFIXSET_HEADER_SIZE     128
+#define E_SUFFIXSET_ROUND(off)      (((off) + E_SUFFIXSET_ALIGN - 1) & ~((uint64_t)E_SUFFIXSET_ALIGN - 1))
+
+/* a rule is at most a domain name, without its root dot */
+#define E_SUFFIXSET_RULE_MAX        253
+#define E_SUFFIXSET_DEPTH           (E_SUFFIXSET_RULE_MAX / 2 + 1)
+
+/* keys are kept in blocks that never move, so rules can point at them */
+#define E_SUFFIXSET_BLOCK_SIZE      (1024 * 1024)
+
+#define E_SUFFIXSET_NONE            0xFFFFFFFF
+
+/*
+ * A rule as it was added. The key is its labels right to left joined by NUL
+ * bytes, so rules sorted by key list the trie depth first with the children
+ * of every node in the order e_etn_t searches them.
+ */
+typedef struct e_suffixset_rule_s {
+    uint64_t    prefix;         /* the first 8 bytes of the key, big endian, most compares stop here */
+    const char  *key;
+    uint32_t    len;
+    uint32_t    seq;            /* rules added later win */
+    uint32_t    payload;
+} e_suffixset_rule_t;
+
+struct e_suffixset_builder_s {
+    char                **blocks;
+    uint32_t            num_blocks;
+    uint32_t            blocks_cap;
+    uint32_t            block_len;
+    e_suffixset_rule_t  *rules;
+    uint32_t            num_rules;
+    uint32_t            rules_cap;
+};
+
+/* a node of the trie being compiled, siblings are linked in order */
+typedef struct e_suffixset_bnode_s {
+    const char  *label;
+    uint32_t    first;
+    uint32_t    next;
+    uint32_t    pos;            /* where the label is in the text */
+    uint32_t    payload;
+    uint8_t     len;
+    bool        rule;
+} e_suffixset_bnode_t;
+
+typedef struct e_suffixset_trie_s {
+    e_suffixset_bnode_t *nodes;
+    uint32_t            num_nodes;
+    uint32_t            nodes_cap;
+    uint32_t            num_parents;    /* nodes other than the root with children */
+    uint64_t            label_bytes;
+} e_suffixset_trie_t;
+
+/* the v2 header of e_etn_t with the payloads after the tables, in host byte order */
+typedef struct e_suffixset_header_s {
+    uint32_t    magic;
+    uint32_t    header_size;
+    uint32_t    words[E_ETN_HEADER_WORDS];
+    uint32_t    wide;
+    uint32_t    text_length;
+    uint32_t    nodes_length;
+    uint32_t    children_length;
+    uint64_t    text_offset;
+    uint64_t    nodes_offset;
+    uint64_t    children_offset;
+    uint64_t    payloads_offset;
+} e_suffixset_header_t;
+
+struct e_suffixset_s {
+    e_etn_t     *etn;
+    uint32_t    *payloads;      /* by node, 0 for a node no rule ends at */
+    void        *map;
+    size_t      map_length;
+};
+
+static inline e_errno_t e_suffixset_key(e_suffixset_builder_t *builder, const char *rule, size_t len, char **key, uint32_t *key_len);
+static inline e_errno_t e_suffixset_trie(e_suffixset_builder_t *builder, e_suffixset_trie_t *trie);
+static inline e_errno_t e_suffixset_node(e_suffixset_trie_t *trie, const char *label, size_t len, uint32_t *id);
+static inline e_errno_t e_suffixset_text(e_suffixset_trie_t *trie, e_etn_tables_t *tables);
+static inline e_errno_t e_suffixset_encode(e_suffixset_trie_t *trie, e_etn_tables_t *tables, uint32_t **payloads);
+static inline e_errno_t e_suffixset_write(e_suffixset_t *set, FILE *fp);
+static inline e_errno_t e_suffixset_write_pad(FILE *fp, uint64_t n);
+static inline e_errno_t e_suffixset_map(e_suffixset_t *set, const char *filename);
+static int e_suffixset_rule_cmp(const void *a, const void *b);
+
+e_suffixset_builder_t *e_suffixset_builder_new(void) {
+    return e_calloc(1, sizeof(e_suffixset_builder_t));
+}//end e_suffixset_builder_new
+
+void e_suffixset_builder_free(e_suffixset_builder_t *builder) {
+    uint32_t i;
+
+    if(E_UNLIKELY(!builder)) {
+        return;
+    }//end if
+
+    for(i = 0 ; i < builder->num_blocks ; i++) {
+        e_free(builder->blocks[i]);
+    }//end for
+    if(builder->blocks) {
+        e_free(builder->blocks);
+    }//end if
+    if(builder->rules) {
+        e_free(builder->rules);
+    }//end if
+    e_free(builder);
+}//end e_suffixset_builder_free
+
+e_errno_t e_suffixset_builder_add(e_suffixset_builder_t *builder, const char *rule, size_t len, uint32_t payload) {
+    char                *key;
+    size_t              i;
+    uint32_t            cap;
+    e_errno_t           err;
+    e_suffixset_rule_t  *rules, *r;
+
+    if(E_UNLIKELY(builder->num_rules == E_SUFFIXSET_NONE - 1)) {
+        return E_ERR_OVERFLOW;
+    }//end if
+
+    if(builder->num_rules == builder->rules_cap) {
+        cap = builder->rules_cap ? builder->rules_cap * 2 : 1024;
+        if(E_UNLIKELY(cap < builder->rules_cap)) {
+            cap = E_SUFFIXSET_NONE - 1;
+        }//end if
+        rules = e_realloc(builder->rules, (size_t)cap * sizeof(e_suffixset_rule_t));
+        if(E_UNLIKELY(!rules)) {
+            return E_ERR_FAMEM;
+        }//end if
+        builder->rules = rules;
+        builder->rules_cap = cap;
+    }//end if
+
+    /* a leading dot says the same as none, a trailing one is the root */
+    if(len > 0 && rule[0] == '.') {
+        rule++;
+        len--;
+    }//end if
+    if(len > 0 && rule[len - 1] == '.') {
+        len--;
+    }//end if
+    if(E_UNLIKELY(len == 0 || len > E_SUFFIXSET_RULE_MAX)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    r = &(builder->rules[builder->num_rules]);
+    err = e_suffixset_key(builder, rule, len, &key, &r->len);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    r->key = key;
+    r->seq = builder->num_rules++;
+    r->payload = payload;
+    r->prefix = 0;
+    for(i = 0 ; i < sizeof(r->prefix) ; i++) {
+        r->prefix = r->prefix << 8 | (i < r->len ? (u_char)key[i] : 0);
+    }//end for
+
+    return E_OK;
+}//end e_suffixset_builder_add
+
+e_suffixset_t *e_suffixset_builder_compile(e_suffixset_builder_t *builder) {
+    e_errno_t           err;
+    e_etn_tables_t      tables;
+    e_suffixset_t       *set;
+    e_suffixset_trie_t  trie;
+
+    if(E_UNLIKELY(builder->num_rules == 0)) {
+        return NULL;
+    }//end if
+
+    set = e_calloc(1, sizeof(e_suffixset_t));
+    if(E_UNLIKELY(!set)) {
+        return NULL;
+    }//end if
+
+    /* sorted by key and then by when they were added, a rule repeated comes last with the payload it keeps */
+    qsort(builder->rules, builder->num_rules, sizeof(e_suffixset_rule_t), e_suffixset_rule_cmp);
+
+    memset(&trie, 0, sizeof(e_suffixset_trie_t));
+    memset(&tables, 0, sizeof(e_etn_tables_t));
+    err = e_suffixset_trie(builder, &trie);
+    if(E_LIKELY(err == E_OK)) {
+        err = e_suffixset_text(&trie, &tables);
+    }//end if
+    if(E_LIKELY(err == E_OK)) {
+        err = e_suffixset_encode(&trie, &tables, &set->payloads);
+    }//end if
+    if(trie.nodes) {
+        e_free(trie.nodes);
+    }//end if
+    if(E_UNLIKELY(err != E_OK)) {
+        e_etn_free_tables(&tables);
+        e_suffixset_free(set);
+        return NULL;
+    }//end if
+
+    /* the table takes the tables, it searches them as it searches the public suffix list */
+    set->etn = e_etn_new_tables(&tables);
+    if(E_UNLIKELY(!set->etn)) {
+        e_suffixset_free(set);
+        return NULL;
+    }//end if
+
+    /* without the memory for its keys a set keeps searching the tables */
+    e_etn_set_engine(set->etn, E_ETN_ENGINE_INLINE);
+    return set;
+}//end e_suffixset_builder_compile
+
+e_suffixset_t *e_suffixset_new_mmap(const char *filename) {
+    e_errno_t       err;
+    e_suffixset_t   *set;
+
+    set = e_calloc(1, sizeof(e_suffixset_t));
+    if(E_UNLIKELY(!set)) {
+        return NULL;
+    }//end if
+
+    err = e_suffixset_map(set, filename);
+    if(E_UNLIKELY(err != E_OK)) {
+        e_suffixset_free(set);
+        return NULL;
+    }//end if
+
+    /* as a compiled set, the keys are built in memory, the tables stay in the mapping */
+    e_etn_set_engine(set->etn, E_ETN_ENGINE_INLINE);
+    return set;
+}//end e_suffixset_new_mmap
+
+void e_suffixset_free(e_suffixset_t *set) {
+    if(E_UNLIKELY(!set)) {
+        return;
+    }//end if
+
+    /* the table only borrows a mapping, free it first */
+    if(set->etn) {
+        e_etn_free(set->etn);
+    }//end if
+    if(set->map) {
+        munmap(set->map, set->map_length);
+    }//end if
+    else if(set->payloads) {
+        e_free(set->payloads);
+    }//end if
+    e_free(set);
+}//end e_suffixset_free
+
+e_errno_t e_suffixset_save(e_suffixset_t *set, const char *filename) {
+    char        *tmp;
+    FILE        *fp;
+    e_errno_t   err;
+
+    err = e_etn_save_begin(filename, &fp, &tmp);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    return e_etn_save_end(filename, fp, tmp, e_suffixset_write(set, fp));
+}//end e_suffixset_save
+
+e_errno_t e_suffixset_set_engine(e_suffixset_t *set, e_etn_engine_t engine) {
+    return e_etn_set_engine(set->etn, engine);
+}//end e_suffixset_set_engine
+
+e_errno_t e_suffixset_lookup(e_suffixset_t *set, const char *domain, size_t len, uint32_t *payload, size_t *match_off) {
+    e_errno_t       err;
+    e_etn_result_t  result;
+
+    err = e_etn_lookup(set->etn, domain, len, &result);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    /* every rule is a normal one, the prevailing "*" is no match */
+    if(result.rule != E_ETN_RULE_NORMAL) {
+        return E_ERR_NOFOUND;
+    }//end if
+
+    *payload = set->payloads[result.suffix_id];
+    *match_off = result.suffix_off;
+    return E_OK;
+}//end e_suffixset_lookup
+
+
+
+/* ===== private function ===== */
+static inline e_errno_t e_suffixset_key(e_suffixset_builder_t *builder, const char *rule, size_t len, char **key, uint32_t *key_len) {
+    char        buf[E_SUFFIXSET_RULE_MAX + 1], *encoded, *block, **blocks;
+    size_t      i, j, k, dot;
+    uint32_t    cap;
+    e_errno_t   err;
+    const char  *s;
+
+    /* folded as e_etn_new_from_psl() folds its rules */
+    err = e_etn_builder_fold(rule, len, buf, sizeof(buf), &s, &len, &encoded);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    /* a key and its NUL terminator never straddle two blocks */
+    if(builder->num_blocks == 0 || builder->block_len + len + 1 > E_SUFFIXSET_BLOCK_SIZE) {
+        if(builder->num_blocks == builder->blocks_cap) {
+            cap = builder->blocks_cap ? builder->blocks_cap * 2 : 16;
+            blocks = e_realloc(builder->blocks, cap * sizeof(char *));
+            if(E_UNLIKELY(!blocks)) {
+                e_free(encoded);
+                return E_ERR_FAMEM;
+            }//end if
+            builder->blocks = blocks;
+            builder->blocks_cap = cap;
+        }//end if
+        block = e_malloc(E_SUFFIXSET_BLOCK_SIZE);
+        if(E_UNLIKELY(!block)) {
+            e_free(encoded);
+            return E_ERR_FAMEM;
+        }//end if
+        builder->blocks[builder->num_blocks++] = block;
+        builder->block_len = 0;
+    }//end if
+
+    /* labels from the right, each followed by a NUL byte */
+    *key = builder->blocks[builder->num_blocks - 1] + builder->block_len;
+    for(i = len, j = 0 ; ; i = dot - 1) {
+        for(dot = i ; dot > 0 && s[dot - 1] != '.' ; dot--);
+        if(E_UNLIKELY(dot == i)) {
+            e_free(encoded);
+            return E_ERR_INVAL;
+        }//end if
+        for(k = dot ; k < i ; k++) {
+            (*key)[j++] = s[k];
+        }//end for
+        (*key)[j++] = '\0';
+        if(dot == 0) {
+            break;
+        }//end if
+    }//end for
+
+    /* the length leaves out the last NUL byte */
+    *key_len = (uint32_t)j - 1;
+    builder->block_len += (uint32_t)j;
+    e_free(encoded);
+    return E_OK;
+}//end e_suffixset_key
+
+static inline e_errno_t e_suffixset_trie(e_suffixset_builder_t *builder, e_suffixset_trie_t *trie) {
+    bool                same;
+    size_t              pos, end, len;
+    uint32_t            i, d, prev_depth, node, path[E_SUFFIXSET_DEPTH + 1], last[E_SUFFIXSET_DEPTH + 1];
+    uint32_t            prev_lens[E_SUFFIXSET_DEPTH];
+    e_errno_t           err;
+    const char          *label, *prev_labels[E_SUFFIXSET_DEPTH];
+    e_suffixset_rule_t  *r;
+
+    trie->nodes_cap = 1024;
+    trie->nodes = e_malloc(trie->nodes_cap * sizeof(e_suffixset_bnode_t));
+    if(E_UNLIKELY(!trie->nodes)) {
+        return E_ERR_FAMEM;
+    }//end if
+
+    /* the root */
+    memset(trie->nodes, 0, sizeof(e_suffixset_bnode_t));
+    trie->nodes[0].first = E_SUFFIXSET_NONE;
+    trie->nodes[0].next = E_SUFFIXSET_NONE;
+    trie->num_nodes = 1;
+
+    /*
+     * path[d] is the node the previous rule had d labels down and last[d] the
+     * last child made under it. A rule shares the labels it starts with with the
+     * one before, and whatever is new comes after every child made so far.
+     */
+    path[0] = 0;
+    last[0] = E_SUFFIXSET_NONE;
+    prev_depth = 0;
+    for(i = 0 ; i < builder->num_rules ; i++) {
+        r = &(builder->rules[i]);
+        same = true;
+        for(pos = 0, d = 0 ; pos <= r->len ; pos = end + 1, d++) {
+            label = r->key + pos;
+            len = strlen(label);
+            end = pos + len;
+            if(same && d < prev_depth && len == prev_lens[d] && memcmp(label, prev_labels[d], len) == 0) {
+                continue;
+            }//end if
+            same = false;
+
+            err = e_suffixset_node(trie, label, len, &node);
+            if(E_UNLIKELY(err != E_OK)) {
+                return err;
+            }//end if
+            if(last[d] == E_SUFFIXSET_NONE) {
+                trie->nodes[path[d]].first = node;
+                trie->num_parents += d > 0;
+            }//end if
+            else {
+                trie->nodes[last[d]].next = node;
+            }//end else
+            last[d] = node;
+            path[d + 1] = node;
+            last[d + 1] = E_SUFFIXSET_NONE;
+            prev_labels[d] = label;
+            prev_lens[d] = (uint32_t)len;
+        }//end for
+        prev_depth = d;
+
+        trie->nodes[path[d]].rule = true;
+        trie->nodes[path[d]].payload = r->payload;
+    }//end for
+
+    return E_OK;
+}//end e_suffixset_trie
+
+static inline e_errno_t e_suffixset_node(e_suffixset_trie_t *trie, const char *label, size_t len, uint32_t *id) {
+    uint32_t            cap;
+    e_suffixset_bnode_t *nodes, *n;
+
+    if(trie->num_nodes == trie->nodes_cap) {
+        if(E_UNLIKELY(trie->nodes_cap >= E_SUFFIXSET_NONE / 2)) {
+            return E_ERR_OVERFLOW;
+        }//end if
+        cap = trie->nodes_cap * 2;
+        nodes = e_realloc(trie->nodes, (size_t)cap * sizeof(e_suffixset_bnode_t));
+        if(E_UNLIKELY(!nodes)) {
+            return E_ERR_FAMEM;
+        }//end if
+        trie->nodes = nodes;
+        trie->nodes_cap = cap;
+    }//end if
+
+    *id = trie->num_nodes++;
+    n = &(trie->nodes[*id]);
+    n->label = label;
+    n->len = (uint8_t)len;
+    n->first = E_SUFFIXSET_NONE;
+    n->next = E_SUFFIXSET_NONE;
+    n->pos = 0;
+    n->payload = 0;
+    n->rule = false;
+    trie->label_bytes += len;
+
+    return E_OK;
+}//end e_suffixset_node
+
+static inline e_errno_t e_suffixset_text(e_suffixset_trie_t *trie, e_etn_tables_t *tables) {
+    char                *text;
+    uint32_t            i, j, mask, size, *hash;
+    uint64_t            len;
+    e_suffixset_bnode_t *n, *m;
+
+    /* a label used under many nodes is in the text once, labels are not crushed into each other */
+    if(E_UNLIKELY(trie->label_bytes >= E_SUFFIXSET_NONE)) {
+        return E_ERR_OVERFLOW;
+    }//end if
+    for(size = 1 ; size < trie->num_nodes * 2 ; size <<= 1);
+    hash = e_calloc(size, sizeof(uint32_t));
+    tables->text = e_malloc(trie->label_bytes + 1);
+    if(E_UNLIKELY(!hash || !tables->text)) {
+        e_free(hash);
+        return E_ERR_FAMEM;
+    }//end if
+
+    mask = size - 1;
+    len = 0;
+    for(i = 1 ; i < trie->num_nodes ; i++) {
+        n = &(trie->nodes[i]);
+        for(j = e_etn_builder_hash(n->label, n->len) & mask ; hash[j] ; j = (j + 1) & mask) {
+            m = &(trie->nodes[hash[j]]);
+            if(m->len == n->len && memcmp(m->label, n->label, n->len) == 0) {
+                break;
+            }//end if
+        }//end for
+        if(hash[j]) {
+            n->pos = trie->nodes[hash[j]].pos;
+            continue;
+        }//end if
+
+        hash[j] = i;
+        n->pos = (uint32_t)len;
+        memcpy(tables->text + len, n->label, n->len);
+        len += n->len;
+    }//end for
+    e_free(hash);
+
+    tables->text[len] = '\0';
+    tables->text_length = (uint32_t)len;
+    text = e_realloc(tables->text, len + 1);
+    if(E_LIKELY(text)) {
+        tables->text = text;
+    }//end if
+
+    return E_OK;
+}//end e_suffixset_text
+
+static inline e_errno_t e_suffixset_encode(e_suffixset_trie_t *trie, e_etn_tables_t *tables, uint32_t **payloads) {
+    uint32_t            q, tail, c, lo, hi, u, type, rec, num_nodes, num_records, max_pos, max_len, *h, *order;
+    e_suffixset_bnode_t *n;
+
+    num_nodes = trie->num_nodes - 1;
+    num_records = E_ETN_NUM_TYPE + trie->num_parents;
+    max_pos = max_len = 0;
+    for(q = 1 ; q < trie->num_nodes ; q++) {
+        max_pos = E_MAX(max_pos, trie->nodes[q].pos);
+        max_len = E_MAX(max_len, trie->nodes[q].len);
+    }//end for
+
+    /* the widths of the wide format, e_etn_t narrows the tables if they fit */
+    h = tables->header;
+    h[0] = e_etn_builder_bits(num_records - 1);
+    h[1] = E_ETN_BITS_ICANN;
+    h[2] = e_etn_builder_bits(max_pos);
+    h[3] = e_etn_builder_bits(max_len);
+    h[4] = E_ETN_BITS_WILDCARD;
+    h[5] = E_ETN_BITS_NODE_TYPE;
+    h[6] = e_etn_builder_bits(num_nodes);
+    h[7] = e_etn_builder_bits(num_nodes);
+    h[8] = E_ETN_TYPE_NORMAL;
+    h[9] = E_ETN_TYPE_EXCEPTION;
+    h[10] = E_ETN_TYPE_PARENT_ONLY;
+    if(E_UNLIKELY(h[0] + h[1] + h[2] + h[3] > 64 || h[4] + h[5] + h[6] + h[7] > 64)) {
+        return E_ERR_OVERFLOW;
+    }//end if
+
+    tables->nodes = e_malloc((size_t)num_nodes * sizeof(uint64_t));
+    tables->children = e_malloc((size_t)num_records * sizeof(uint64_t));
+    *payloads = e_malloc((size_t)num_nodes * sizeof(uint32_t));
+    order = e_malloc((size_t)trie->num_nodes * sizeof(uint32_t));
+    if(E_UNLIKELY(!tables->nodes || !tables->children || !*payloads || !order)) {
+        e_free(order);
+        return E_ERR_FAMEM;
+    }//end if
+    tables->nodes_length = num_nodes;
+    tables->children_length = num_records;
+
+    /* leaves share a record per node type */
+    for(type = 0 ; type < E_ETN_NUM_TYPE ; type++) {
+        tables->children[type] = (uint64_t)type << (h[7] + h[6]);
+    }//end for
+
+    /* breadth first, so the children of every node get consecutive indexes, the root's from 0 */
+    order[0] = 0;
+    tail = 1;
+    rec = E_ETN_NUM_TYPE;
+    for(q = 0 ; q < tail ; q++) {
+        n = &(trie->nodes[order[q]]);
+        lo = tail - 1;
+        for(c = n->first ; c != E_SUFFIXSET_NONE ; c = trie->nodes[c].next) {
+            order[tail++] = c;
+        }//end for
+        hi = tail - 1;
+        if(q == 0) {
+            h[11] = hi - lo;
+            continue;
+        }//end if
+
+        type = n->rule ? E_ETN_TYPE_NORMAL : E_ETN_TYPE_PARENT_ONLY;
+        u = type;
+        if(hi > lo) {
+            u = rec++;
+            tables->children[u] = (uint64_t)lo | (uint64_t)hi << h[7] | (uint64_t)type << (h[7] + h[6]);
+        }//end if
+        tables->nodes[q - 1] = (uint64_t)n->len | (uint64_t)n->pos << h[3] | (uint64_t)u << (h[3] + h[2] + h[1]);
+        (*payloads)[q - 1] = n->payload;
+    }//end for
+
+    e_free(order);
+    return E_OK;
+}//end e_suffixset_encode
+
+static inline e_errno_t e_suffixset_write(e_suffixset_t *set, FILE *fp) {
+    size_t                  word;
+    uint32_t                header[E_SUFFIXSET_HEADER_SIZE / sizeof(uint32_t)];
+    uint64_t                end;
+    e_etn_view_t            view;
+    e_suffixset_header_t    *hdr;
+
+    /* the tables as e_etn_t has them, narrowed or not */
+    e_etn_get_view(set->etn, &view);
+    word = view.wide ? sizeof(uint64_t) : sizeof(uint32_t);
+
+    memset(header, 0, sizeof(header));
+    hdr = (e_suffixset_header_t *)header;
+    hdr->magic = E_SUFFIXSET_MAGIC;
+    hdr->header_size = E_SUFFIXSET_HEADER_SIZE;
+    memcpy(hdr->words, view.header, sizeof(hdr->words));
+    hdr->wide = view.wide;
+    hdr->text_offset = E_SUFFIXSET_HEADER_SIZE;
+    hdr->text_length = view.text_length;
+    hdr->nodes_offset = E_SUFFIXSET_ROUND(hdr->text_offset + view.text_length + 1);
+    hdr->nodes_length = view.nodes_length;
+    hdr->children_offset = E_SUFFIXSET_ROUND(hdr->nodes_offset + (uint64_t)view.nodes_length * word);
+    hdr->children_length = view.children_length;
+    hdr->payloads_offset = E_SUFFIXSET_ROUND(hdr->children_offset + (uint64_t)view.children_length * word);
+    end = hdr->payloads_offset + (uint64_t)view.nodes_length * sizeof(uint32_t);
+
+    if(E_UNLIKELY(fwrite(header, sizeof(header), 1, fp) != 1 ||
+        fwrite(view.text, sizeof(char), view.text_length, fp) != view.text_length ||
+        e_suffixset_write_pad(fp, hdr->nodes_offset - hdr->text_offset - view.text_length) != E_OK ||
+        fwrite(view.nodes, word, view.nodes_length, fp) != view.nodes_length ||
+        e_suffixset_write_pad(fp, hdr->children_offset - hdr->nodes_offset - (uint64_t)view.nodes_length * word) != E_OK ||
+        fwrite(view.children, word, view.children_length, fp) != view.children_length ||
+        e_suffixset_write_pad(fp, hdr->payloads_offset - hdr->children_offset - (uint64_t)view.children_length * word) != E_OK ||
+        fwrite(set->payloads, sizeof(uint32_t), view.nodes_length, fp) != view.nodes_length ||
+        e_suffixset_write_pad(fp, E_SUFFIXSET_ROUND(end) - end) != E_OK)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    return E_OK;
+}//end e_suffixset_write
+
+static inline e_errno_t e_suffixset_write_pad(FILE *fp, uint64_t n) {
+    static const char zeros[E_SUFFIXSET_ALIGN + 1];
+
+    /* the text pad includes its NUL terminator */
+    if(E_UNLIKELY(n > sizeof(zeros) || fwrite(zeros, sizeof(char), n, fp) != n)) {
+        return E_ERR_C_ERR;
+    }//end if
+
+    return E_OK;
+}//end e_suffixset_write_pad
+
+static inline e_errno_t e_suffixset_map(e_suffixset_t *set, const char *filename) {
+    int                         fd;
+    void                        *map;
+    size_t                      word;
+    struct stat                 st;
+    e_etn_view_t                view;
+    const e_suffixset_header_t  *hdr;
+
+    fd = open(filename, O_RDONLY);
+    if(fd == -1) {
+        return E_ERR_INVAL;
+    }//end if
+
+    if(E_UNLIKELY(fstat(fd, &st) == -1)) {
+        close(fd);
+        return E_ERR_C_ERR;
+    }//end if
+
+    if(E_UNLIKELY((size_t)st.st_size < E_SUFFIXSET_HEADER_SIZE)) {
+        close(fd);
+        return E_ERR_INVAL;
+    }//end if
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(E_UNLIKELY(map == MAP_FAILED)) {
+        return E_ERR_C_ERR;
+    }//end if
+    set->map = map;
+    set->map_length = (size_t)st.st_size;
+
+    /* a byte-swapped magic number means a foreign host wrote it */
+    hdr = (const e_suffixset_header_t *)map;
+    if(hdr->magic != E_SUFFIXSET_MAGIC || hdr->wide > 1 ||
+        hdr->header_size < sizeof(e_suffixset_header_t) || hdr->header_size > set->map_length) {
+        return E_ERR_INVAL;
+    }//end if
+
+    /* every section inside the file and aligned, the text followed by a NUL byte */
+    word = hdr->wide ? sizeof(uint64_t) : sizeof(uint32_t);
+    if(E_UNLIKELY(hdr->text_offset >= set->map_length || hdr->text_length >= set->map_length - hdr->text_offset ||
+        hdr->nodes_offset > set->map_length || (uint64_t)hdr->nodes_length * word > set->map_length - hdr->nodes_offset ||
+        hdr->children_offset > set->map_length || (uint64_t)hdr->children_length * word > set->map_length - hdr->children_offset ||
+        hdr->payloads_offset > set->map_length ||
+        (uint64_t)hdr->nodes_length * sizeof(uint32_t) > set->map_length - hdr->payloads_offset)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    if(E_UNLIKELY(hdr->nodes_offset % E_SUFFIXSET_ALIGN != 0 || hdr->children_offset % E_SUFFIXSET_ALIGN != 0 ||
+        hdr->payloads_offset % E_SUFFIXSET_ALIGN != 0)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    memcpy(view.header, hdr->words, sizeof(view.header));
+    view.wide = hdr->wide;
+    view.text = (const char *)map + hdr->text_offset;
+    view.text_length = hdr->text_length;
+    view.nodes = (const char *)map + hdr->nodes_offset;
+    view.nodes_length = hdr->nodes_length;
+    view.children = (const char *)map + hdr->children_offset;
+    view.children_length = hdr->children_length;
+    set->payloads = (uint32_t *)((char *)map + hdr->payloads_offset);
+
+    set->etn = e_etn_new_view(&view);
+    if(E_UNLIKELY(!set->etn)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    return E_OK;
+}//end e_suffixset_map
+
+static int e_suffixset_rule_cmp(const void *a, const void *b) {
+    int                         ret;
+    const e_suffixset_rule_t    *r1, *r2;
+
+    r1 = (const e_suffixset_rule_t *)a;
+    r2 = (const e_suffixset_rule_t *)b;
+    if(r1->prefix != r2->prefix) {
+        return r1->prefix < r2->prefix ? -1 : 1;
+    }//end if
+
+    /* a label ends before a longer one and a rule before the ones under it, as NUL sorts first */
+    ret = memcmp(r1->key, r2->key, E_MIN(r1->len, r2->len));
+    if(ret != 0) {
+        return ret;
+    }//end if
+    if(r1->len != r2->len) {
+        return r1->len < r2->len ? -1 : 1;
+    }//end if
+
+    return r1->seq < r2->seq ? -1 : (r1->seq > r2->seq ? 1 : 0);
+}//end e_suffixset_rule_cmp
@@ -0,0 +1,199 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libetn/e_tls.h>
+
+#define E_TLS_CONTENT_HANDSHAKE     22
+#define E_TLS_HANDSHAKE_CLIENT_HELLO 1
+#define E_TLS_EXT_SERVER_NAME       0
+#define E_TLS_NAME_HOST             0
+#define E_TLS_RECORD_HEADER         5
+#define E_TLS_HANDSHAKE_HEADER      4
+#define E_TLS_VERSION_RANDOM        34
+#define E_TLS_SESSION_ID_MAX        32
+
+/*
+ * Return from the parser unless n bytes are left at p. Past end the lengths
+ * disagree and the message is invalid, past len it is only cut short.
+ */
+#define E_TLS_NEED(n) \
+    do { \
+        if(E_UNLIKELY((size_t)(n) > end - p)) { \
+            return E_ERR_INVAL; \
+        } \
+        if(E_UNLIKELY((size_t)(n) > len - p)) { \
+            return E_ERR_AGAIN; \
+        } \
+    } while(0)
+
+static inline e_errno_t e_tls_server_name(const uint8_t *data, size_t len, size_t p, size_t end, const char **sni, size_t *sni_len);
+static inline uint32_t e_tls_u16(const uint8_t *p) E_ALWAYS_INLINE;
+
+e_errno_t e_tls_sni_extract(const uint8_t *data, size_t len, const char **sni, size_t *sni_len) {
+    size_t      p, end, n;
+    uint32_t    type;
+
+    p = 0;
+    end = SIZE_MAX;
+    if(len > 0 && data[0] == E_TLS_CONTENT_HANDSHAKE) {
+        E_TLS_NEED(E_TLS_RECORD_HEADER);
+        if(E_UNLIKELY(data[1] != 3)) {
+            return E_ERR_INVAL;
+        }//end if
+
+        end = E_TLS_RECORD_HEADER + e_tls_u16(data + 3);
+        p = E_TLS_RECORD_HEADER;
+    }//end if
+
+    /* the handshake header */
+    E_TLS_NEED(E_TLS_HANDSHAKE_HEADER);
+    if(E_UNLIKELY(data[p] != E_TLS_HANDSHAKE_CLIENT_HELLO)) {
+        return E_ERR_INVAL;
+    }//end if
+
+    n = ((size_t)data[p + 1] << 16) | e_tls_u16(data + p + 2);
+    p += E_TLS_HANDSHAKE_HEADER;
+    if(E_UNLIKELY(n > end - p)) {
+        /* a ClientHello fragmented over records is not put back together */
+        return E_ERR_NOTSUP;
+    }//end if
+    end = p + n;
+
+    /* legacy_version and random */
+    E_TLS_NEED(E_TLS_VERSION_RANDOM);
+    p += E_TLS_VERSION_RANDOM;
+
+    /* legacy_session_id */
+    E_TLS_NEED(1);
+    n = data[p++];
+    if(E_UNLIKELY(n > E_TLS_SESSION_ID_MAX)) {
+        return E_ERR_INVAL;
+    }//end if
+    E_TLS_NEED(n);
+    p += n;
+
+    /* cipher_suites */
+    E_TLS_NEED(2);
+    n = e_tls_u16(data + p);
+    p += 2;
+    if(E_UNLIKELY(n == 0 || (n & 1))) {
+        return E_ERR_INVAL;
+    }//end if
+    E_TLS_NEED(n);
+    p += n;
+
+    /* legacy_compression_methods */
+    E_TLS_NEED(1);
+    n = data[p++];
+    if(E_UNLIKELY(n == 0)) {
+        return E_ERR_INVAL;
+    }//end if
+    E_TLS_NEED(n);
+    p += n;
+
+    /* a ClientHello may have no extensions at all */
+    if(p == end) {
+        return E_ERR_NOFOUND;
+    }//end if
+
+    E_TLS_NEED(2);
+    n = e_tls_u16(data + p);
+    p += 2;
+    if(E_UNLIKELY(n > end - p)) {
+        return E_ERR_INVAL;
+    }//end if
+    end = p + n;
+
+    while(p < end) {
+        E_TLS_NEED(4);
+        type = e_tls_u16(data + p);
+        n = e_tls_u16(data + p + 2);
+        p += 4;
+        if(type == E_TLS_EXT_SERVER_NAME) {
+            if(E_UNLIKELY(n > end - p)) {
+                return E_ERR_INVAL;
+            }//end if
+
+            return e_tls_server_name(data, len, p, p + n, sni, sni_len);
+        }//end if
+
+        E_TLS_NEED(n);
+        p += n;
+    }//end while
+
+    return E_ERR_NOFOUND;
+}//end e_tls_sni_extract
+
+e_errno_t e_etn_classify_client_hello(e_etn_t *etn, const uint8_t *data, size_t len, const char **sni, size_t *sni_len, e_etn_result_t *result) {
+    e_errno_t   err;
+
+    err = e_tls_sni_extract(data, len, sni, sni_len);
+    if(E_UNLIKELY(err != E_OK)) {
+        return err;
+    }//end if
+
+    return e_etn_lookup(etn, *sni, *sni_len, result);
+}//end e_etn_classify_client_hello
+
+
+/* ===== private function ===== */
+static inline e_errno_t e_tls_server_name(const uint8_t *data, size_t len, size_t p, size_t end, const char **sni, size_t *sni_len) {
+    size_t      n;
+    uint32_t    type;
+
+    /* server_name_list */
+    E_TLS_NEED(2);
+    n = e_tls_u16(data + p);
+    p += 2;
+    if(E_UNLIKELY(n > end - p)) {
+        return E_ERR_INVAL;
+    }//end if
+    end = p + n;
+
+    while(p < end) {
+        E_TLS_NEED(3);
+        type = data[p];
+        n = e_tls_u16(data + p + 1);
+        p += 3;
+        E_TLS_NEED(n);
+        if(type == E_TLS_NAME_HOST && n > 0) {
+            *sni = (const char *)data + p;
+            *sni_len = n;
+            return E_OK;
+        }//end if
+        p += n;
+    }//end while
+
+    return E_ERR_NOFOUND;
+}//end e_tls_server_name
+
+static inline uint32_t e_tls_u16(const uint8_t *p) {
+    return ((uint32_t)p[0] << 8) | p[1];
+}//end e_tls_u16
@@ -34,6 +34,9 @@
 #include <libetn/e_atomic.h>
 #include <libetn/e_err.h>
 #include <libetn/e_etn.h>
+#include <libetn/e_etn_cache.h>
+#include <libetn/e_etn_handle.h>
+#include <libetn/e_http.h>
 #include <libetn/e_idn.h>
 #include <libetn/e_list.h>
 #include <libetn/e_macros.h>
@@ -42,9 +45,11 @@
 #include <libetn/e_refcount.h>
 #include <libetn/e_strfuncs.h>
 #include <libetn/e_string.h>
+#include <libetn/e_suffixset.h>
 #include <libetn/e_testutils.h>
 #include <libetn/e_time.h>
 #include <libetn/e_timer.h>
+#include <libetn/e_tls.h>
 #include <libetn/e_unicode.h>
 #include <libetn/e_version.h>
 #include <libetn/e_visibility.h>
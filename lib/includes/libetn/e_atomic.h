@@ -58,6 +58,8 @@ typedef e_atomic_int_t          e_atomic_t;
 #define e_atomic_dec(atomic)                        __sync_fetch_and_sub(atomic, 1)
 #define e_atomic_dec_and_test(atomic)               (__sync_fetch_and_sub(atomic, 1) == 1)
 #define e_atomic_memory_barrier()                   __sync_synchronize()
+#define e_atomic_load_acquire(atomic)               __atomic_load_n(atomic, __ATOMIC_ACQUIRE)
+#define e_atomic_store_release(atomic, newval)      __atomic_store_n(atomic, newval, __ATOMIC_RELEASE)
 #define e_atomic_trylock(lock)                      (*(lock) == 0 && e_atomic_cmp_set(lock, 0, 1))
 #define e_atomic_unlock(lock)                       (*(lock) = 0)
 #define e_atomic_cpu_pause()                        __asm__("pause")
@@ -33,19 +33,234 @@
 #define E_ETN_H
 
 #include <libetn/e_err.h>
+#include <sys/uio.h>
 
 typedef struct e_etn_s e_etn_t;
+typedef struct e_etn_cursor_s e_etn_cursor_t;
+
+typedef enum {
+    E_ETN_RULE_DEFAULT = 0,     /* no rule matched, the prevailing rule "*" applies */
+    E_ETN_RULE_NORMAL,
+    E_ETN_RULE_WILDCARD,        /* "*.example" */
+    E_ETN_RULE_EXCEPTION        /* "!www.example" */
+} e_etn_rule_t;
+
+typedef enum {
+    E_ETN_LEVEL_SUFFIX = 0,     /* the public suffix or a name it is under, down to the TLD */
+    E_ETN_LEVEL_REGISTRABLE,    /* the eTLD+1 */
+    E_ETN_LEVEL_DEEPER          /* a name under the eTLD+1, up to the whole name */
+} e_etn_level_kind_t;
+
+typedef enum {
+    E_ETN_ENGINE_SEARCH = 0,    /* binary search over the packed nodes */
+    E_ETN_ENGINE_INLINE,        /* children in Eytzinger order with label prefixes inline */
+    E_ETN_ENGINE_DFA            /* a minimal automaton over the domain bytes read right to left */
+} e_etn_engine_t;
+
+typedef enum {
+    E_ETN_FORMAT_V1 = 1,        /* big endian, read by e_etn_new() */
+    E_ETN_FORMAT_V2,            /* host byte order and aligned, read by e_etn_new_mmap() */
+    E_ETN_FORMAT_WIDE           /* big endian 64-bit words of any widths, read by e_etn_new() */
+} e_etn_format_t;
+
+/* the suffix_id of a suffix no rule of the list decided */
+#define E_ETN_SUFFIX_NONE 0xFFFFFFFF
+
+/* the most tables e_etn_new_stack() stacks, the base included */
+#define E_ETN_STACK_MAX 16
+
+/* a table over the base of a stack */
+typedef struct e_etn_layer_s {
+    e_etn_t     *etn;
+    int         priority;           /* decides between rules of the same suffix, the base has 0 */
+    bool        icann;              /* every rule of the layer is ICANN or private, whatever etn says */
+} e_etn_layer_t;
+
+/*
+ * Offsets are into the domain passed to e_etn_lookup(), a trailing root dot is part of every suffix.
+ * suffix_id is the node of the suffix in the table, for E_ETN_RULE_WILDCARD the node the wildcard is
+ * under, so the suffix has one more label than e_etn_suffix_name() gives. Both it and registrable_hash,
+ * a hash of the eTLD+1 folded to lower case without the root dot, are stable for the table of
+ * e_etn_get_serial() and can key maps without copying the strings. metadata is the word
+ * e_etn_set_metadata() gave the node of suffix_id.
+ */
+typedef struct e_etn_result_s {
+    size_t          suffix_off;         /* public suffix is domain[suffix_off, len) */
+    size_t          registrable_off;    /* eTLD+1 is domain[registrable_off, len), len if there is none */
+    size_t          subdomain_len;      /* labels left of eTLD+1 are domain[0, subdomain_len) */
+    uint32_t        labels;
+    uint32_t        suffix_labels;
+    uint32_t        suffix_id;          /* E_ETN_SUFFIX_NONE for E_ETN_RULE_DEFAULT */
+    uint32_t        metadata;           /* 0 if the node has none */
+    uint64_t        registrable_hash;   /* 0 if there is no eTLD+1 */
+    bool            icann;
+    e_etn_rule_t    rule;               /* the rule that decided the public suffix */
+} e_etn_result_t;
+
+/*
+ * A name in DNS wire format, offsets are into the message. The suffix and the eTLD+1 are the names
+ * that start at those offsets, pointers and all, and labels are counted from the left.
+ */
+typedef struct e_etn_wire_result_s {
+    size_t          suffix_off;         /* the suffix starts with the label at msg[suffix_off] */
+    size_t          registrable_off;    /* eTLD+1 starts at msg[registrable_off], msg_len if there is none */
+    size_t          wire_len;           /* bytes the name takes at name_off, up to its first pointer */
+    uint32_t        labels;
+    uint32_t        suffix_labels;
+    uint32_t        suffix_label;       /* the first label of the suffix, labels for the root */
+    uint32_t        registrable_label;  /* the first label of eTLD+1, labels if there is none */
+    uint32_t        suffix_id;          /* as e_etn_result_t */
+    uint32_t        metadata;           /* as e_etn_result_t */
+    uint64_t        registrable_hash;   /* as e_etn_result_t */
+    bool            icann;
+    e_etn_rule_t    rule;
+} e_etn_wire_result_t;
+
+/*
+ * A name spread over the segments of an iovec, as a flow keeps it across packets. A position is a
+ * segment and an offset into it, never the end of a segment, and (iovcnt, 0) is the end of the name.
+ */
+typedef struct e_etn_iov_result_s {
+    int             suffix_seg;         /* public suffix starts at iov[suffix_seg].iov_base + suffix_off */
+    size_t          suffix_off;
+    int             registrable_seg;    /* eTLD+1 starts there, iovcnt if there is none */
+    size_t          registrable_off;
+    size_t          len;                /* bytes of the name in all segments */
+    uint32_t        labels;
+    uint32_t        suffix_labels;
+    uint32_t        suffix_id;          /* as e_etn_result_t */
+    uint32_t        metadata;           /* as e_etn_result_t */
+    uint64_t        registrable_hash;   /* as e_etn_result_t */
+    bool            icann;
+    e_etn_rule_t    rule;
+} e_etn_iov_result_t;
+
+/*
+ * An ancestor of a name, domain[off, len) with the labels at its right. The rest is what e_etn_lookup()
+ * of the ancestor alone gives, so a rollup can key every level without looking it up again.
+ */
+typedef struct e_etn_level_s {
+    size_t              off;
+    uint32_t            labels;
+    e_etn_level_kind_t  kind;           /* what the ancestor is to the whole name */
+    uint32_t            suffix_labels;  /* the ancestor is a public suffix itself if this is labels */
+    uint32_t            suffix_id;
+    uint32_t            metadata;
+    bool                icann;
+    e_etn_rule_t        rule;
+} e_etn_level_t;
 
 __BEGIN_DECLS
 
 E_EXPORT e_etn_t *e_etn_new(const char *filename) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC E_NONNULL(1);
+
+/* filename must be in the v2 compiled format, the tables are used in place from a read-only mapping */
+E_EXPORT e_etn_t *e_etn_new_mmap(const char *filename) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC E_NONNULL(1);
+
+/* the list compiled in by configure --enable-builtin, NULL if there is none */
+E_EXPORT e_etn_t *e_etn_new_builtin(void) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC;
+
+/* compile a raw effective_tld_names.dat from publicsuffix.org, no Go toolchain needed */
+E_EXPORT e_etn_t *e_etn_new_from_psl(const char *filename) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC E_NONNULL(1);
+E_EXPORT e_etn_t *e_etn_new_from_psl_buffer(const char *psl, size_t len) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC E_NONNULL(1);
+
+/*
+ * base with layers[0, n) over it, walked together as if their rules were one list: an exception wins,
+ * then the longest suffix, then the highest priority and of those the last layer. Nothing is copied and
+ * the tables are referenced until the stack is freed, so a stack is cheap to make for one request. A
+ * stack as base gives its own base and layers, a layer cannot be a stack. Suffix ids of a layer
+ * follow those of the base and the layers before it. NULL if there are more than E_ETN_STACK_MAX tables.
+ * e_etn_save() and e_etn_set_engine() are E_ERR_NOTSUP on a stack, each table keeps its own engine.
+ */
+E_EXPORT e_etn_t *e_etn_new_stack(e_etn_t *base, const e_etn_layer_t *layers, size_t n) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC E_NONNULL(1);
+
+/* write the tables of etn as ci/precompile.go would, E_ERR_NOTSUP if they only fit E_ETN_FORMAT_WIDE */
+E_EXPORT e_errno_t e_etn_save(e_etn_t *etn, const char *filename, e_etn_format_t format) E_NONNULL(1, 2);
+
 E_EXPORT void e_etn_free(e_etn_t *etn);
 E_EXPORT e_etn_t *e_etn_ref(e_etn_t *etn) E_NONNULL(1);
 E_EXPORT void e_etn_unref(e_etn_t *etn);
 
+/* engines give the same results, switch before etn is shared between threads */
+E_EXPORT e_errno_t e_etn_set_engine(e_etn_t *etn, e_etn_engine_t engine) E_NONNULL(1);
+E_EXPORT e_etn_engine_t e_etn_get_engine(e_etn_t *etn) E_NONNULL(1);
+
+/* unique to every table for the life of the process, results can be cached by it */
+E_EXPORT uint64_t e_etn_get_serial(e_etn_t *etn) E_NONNULL(1);
+
+/*
+ * a word of the caller's for the node of suffix, such as flags or an index into its own table, returned
+ * by every lookup that gives its suffix_id. For a wildcard rule that is the node the wildcard is under.
+ * E_ERR_NOFOUND if the table has no such node, E_ERR_NOTSUP on a stack whose tables have their own.
+ * The words are saved with the table in every format. Set them before etn is shared between threads,
+ * the serial changes.
+ */
+E_EXPORT e_errno_t e_etn_set_metadata(e_etn_t * __restrict etn, const char * __restrict suffix, size_t len, uint32_t metadata) E_NONNULL(1, 2);
+
+/* the name of a suffix_id, NUL terminated, E_ERR_NOBUFS if size is too small. Meant for reports, it searches the table */
+E_EXPORT e_errno_t e_etn_suffix_name(e_etn_t * __restrict etn, uint32_t id, char * __restrict buf, size_t size) E_NONNULL(1, 3);
+
 E_EXPORT void e_etn_public_suffix(e_etn_t * __restrict etn, const char * __restrict domain, const char ** __restrict ps, bool * __restrict icann) E_NONNULL(1, 2, 3, 4);
 E_EXPORT void e_etn_eTLD_plus_one(e_etn_t * __restrict etn, const char * __restrict domain, const char ** __restrict eTLD) E_NONNULL(1, 2, 3);
 
+/*
+ * whether a and b have the same eTLD+1, or are the same host if either has none. Names are folded to
+ * lower case and a trailing root dot is ignored. The labels both end with are compared first and only
+ * they are walked, so it costs about one lookup. false if either is longer than 255 bytes.
+ */
+E_EXPORT bool e_etn_same_site(e_etn_t * __restrict etn, const char * __restrict a, size_t a_len, const char * __restrict b, size_t b_len) E_NONNULL(1, 2, 4);
+
+/*
+ * whether a cookie set by host may carry the Domain attribute domain, as RFC 6265 5.2.3, 5.1.3 and 5.3
+ * decide: a leading dot is ignored, host must domain-match it, an IP address only as itself, and a
+ * public suffix is only allowed as the host itself.
+ */
+E_EXPORT bool e_etn_cookie_domain_allowed(e_etn_t * __restrict etn, const char * __restrict host, size_t host_len, const char * __restrict domain, size_t domain_len) E_NONNULL(1, 2, 4);
+
+/* domain needs no NUL terminator, upper case letters and a trailing root dot are accepted */
+E_EXPORT e_errno_t e_etn_lookup(e_etn_t * __restrict etn, const char * __restrict domain, size_t len, e_etn_result_t * __restrict result) E_NONNULL(1, 2, 4);
+
+/*
+ * e_etn_lookup() that also fills levels[0, *n) with every ancestor of domain from the TLD to the name
+ * itself, in one walk. E_ERR_NOBUFS if the name has more than max labels.
+ */
+E_EXPORT e_errno_t e_etn_lookup_levels(e_etn_t * __restrict etn, const char * __restrict domain, size_t len, e_etn_result_t * __restrict result, e_etn_level_t * __restrict levels, size_t max, size_t * __restrict n) E_NONNULL(1, 2, 4, 5, 7);
+
+/* the public suffix is domain[*suffix_off, len), as e_etn_lookup() */
+E_EXPORT e_errno_t e_etn_public_suffix_len(e_etn_t * __restrict etn, const char * __restrict domain, size_t len, size_t * __restrict suffix_off, bool * __restrict icann) E_NONNULL(1, 2, 4, 5);
+
+/*
+ * the name at msg[name_off] as it is in a DNS message, compression pointers are followed and labels are
+ * matched in place. E_ERR_INVAL if the name runs out of the message, a pointer does not go back, a label
+ * type is unknown or the name is longer than 255 bytes.
+ */
+E_EXPORT e_errno_t e_etn_public_suffix_wire(e_etn_t * __restrict etn, const uint8_t * __restrict msg, size_t msg_len, size_t name_off, e_etn_wire_result_t * __restrict result) E_NONNULL(1, 2, 5);
+
+/*
+ * the name made of iov[0, iovcnt) one after another, as e_etn_lookup() takes it. Labels are matched where
+ * they are, only one that runs across segments is gathered on the stack. E_ERR_INVAL if the name is
+ * longer than 255 bytes.
+ */
+E_EXPORT e_errno_t e_etn_lookup_iov(e_etn_t * __restrict etn, const struct iovec * __restrict iov, int iovcnt, e_etn_iov_result_t * __restrict result) E_NONNULL(1, 4);
+
+/*
+ * n lookups of e_etn_public_suffix_len(), the results go to suffix_offs[i] and icanns[i].
+ * E_ERR_INVAL is returned if any domain is too long, its suffix is then empty.
+ */
+E_EXPORT e_errno_t e_etn_public_suffix_batch(e_etn_t * __restrict etn, const char ** __restrict domains, const size_t * __restrict lens, size_t n, size_t * __restrict suffix_offs, bool * __restrict icanns) E_NONNULL(1, 2, 3, 5, 6);
+
+/*
+ * A cursor remembers the walk of the previous domain and resumes from the labels the next
+ * one ends with, for streams where many domains share a suffix. With sorted, domains that
+ * come in order of their labels read right to left are also searched from where the previous
+ * one matched; out of order input is only slower. A cursor belongs to one thread.
+ */
+E_EXPORT e_etn_cursor_t *e_etn_cursor_new(e_etn_t *etn, bool sorted) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC E_NONNULL(1);
+E_EXPORT void e_etn_cursor_free(e_etn_cursor_t *cursor);
+
+/* the same result as e_etn_lookup() on the table of the cursor */
+E_EXPORT e_errno_t e_etn_cursor_lookup(e_etn_cursor_t * __restrict cursor, const char * __restrict domain, size_t len, e_etn_result_t * __restrict result) E_NONNULL(1, 2, 4);
+
 __END_DECLS
 
 #endif /* E_ETN_H */
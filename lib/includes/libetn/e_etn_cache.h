@@ -0,0 +1,60 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef E_ETN_CACHE_H
+#define E_ETN_CACHE_H
+
+#include <libetn/e_err.h>
+#include <libetn/e_etn.h>
+
+typedef struct e_etn_cache_s e_etn_cache_t;
+
+typedef struct e_etn_cache_stats_s {
+    uint64_t    hits;
+    uint64_t    misses;         /* domains too long to cache are misses too */
+    uint64_t    evictions;
+    size_t      capacity;       /* number of entries */
+} e_etn_cache_stats_t;
+
+__BEGIN_DECLS
+
+/* a cache for one thread in at most budget bytes, NULL if budget holds no entries */
+E_EXPORT e_etn_cache_t *e_etn_cache_new(size_t budget) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC;
+E_EXPORT void e_etn_cache_free(e_etn_cache_t *cache);
+
+/* e_etn_lookup() through the cache, it is emptied whenever etn is another table */
+E_EXPORT e_errno_t e_etn_cache_lookup(e_etn_cache_t * __restrict cache, e_etn_t * __restrict etn, const char * __restrict domain, size_t len, e_etn_result_t * __restrict result) E_HOT E_NONNULL(1, 2, 3, 5);
+
+E_EXPORT void e_etn_cache_clear(e_etn_cache_t *cache) E_NONNULL(1);
+E_EXPORT void e_etn_cache_stats(e_etn_cache_t * __restrict cache, e_etn_cache_stats_t * __restrict stats) E_NONNULL(1, 2);
+
+__END_DECLS
+
+#endif /* E_ETN_CACHE_H */
@@ -0,0 +1,87 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef E_ETN_HANDLE_H
+#define E_ETN_HANDLE_H
+
+#include <libetn/e_err.h>
+#include <libetn/e_etn.h>
+
+typedef struct e_etn_handle_s e_etn_handle_t;
+typedef struct e_etn_reader_s e_etn_reader_t;
+typedef struct e_etn_watch_s e_etn_watch_t;
+
+__BEGIN_DECLS
+
+/* handle takes over the caller's reference to etn, free it after every reader is freed */
+E_EXPORT e_etn_handle_t *e_etn_handle_new(e_etn_t *etn) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC E_NONNULL(1);
+E_EXPORT void e_etn_handle_free(e_etn_handle_t *handle);
+
+/*
+ * Publish etn, taking over the caller's reference. The previous table is released
+ * once every reader that could see it has unlocked.
+ */
+E_EXPORT e_errno_t e_etn_handle_swap(e_etn_handle_t *handle, e_etn_t *etn) E_NONNULL(1, 2);
+
+/*
+ * e_etn_new() the file and swap it in with the engine of the current table. The words e_etn_set_metadata()
+ * gave suffixes of the current table go to the same suffixes of the new one, unless the file has its own.
+ * A v2 file stays mapped while the table is in use, replace it by a rename, never rewrite it in place.
+ */
+E_EXPORT e_errno_t e_etn_handle_reload(e_etn_handle_t *handle, const char *filename) E_NONNULL(1, 2);
+
+/* a reference to the current table for threads without a reader, e_etn_unref() it */
+E_EXPORT e_etn_t *e_etn_handle_get(e_etn_handle_t *handle) E_GNUC_WARN_UNUSED_RESULT E_NONNULL(1);
+
+/* one reader per thread, lookups through it write only its own cache line */
+E_EXPORT e_etn_reader_t *e_etn_reader_new(e_etn_handle_t *handle) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC E_NONNULL(1);
+E_EXPORT void e_etn_reader_free(e_etn_reader_t *reader);
+
+/*
+ * The table stays valid until e_etn_reader_unlock(), locks do not nest. A swap waits for
+ * every locked reader while it holds the handle, so a thread holding a lock must not call
+ * e_etn_handle_swap(), e_etn_handle_reload(), e_etn_handle_get() or e_etn_reader_new().
+ */
+E_EXPORT e_etn_t *e_etn_reader_lock(e_etn_reader_t *reader) E_HOT E_NONNULL(1);
+E_EXPORT void e_etn_reader_unlock(e_etn_reader_t *reader) E_HOT E_NONNULL(1);
+
+/*
+ * Reload handle when a file is renamed over filename, NULL without inotify. Writes to the
+ * file in place are not seen, they would change the pages the current table maps.
+ * Poll e_etn_watch_fd() for input and call e_etn_watch_dispatch() when it is readable.
+ */
+E_EXPORT e_etn_watch_t *e_etn_watch_new(e_etn_handle_t *handle, const char *filename) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC E_NONNULL(1, 2);
+E_EXPORT int e_etn_watch_fd(e_etn_watch_t *watch) E_NONNULL(1);
+E_EXPORT e_errno_t e_etn_watch_dispatch(e_etn_watch_t *watch) E_NONNULL(1);
+E_EXPORT void e_etn_watch_free(e_etn_watch_t *watch);
+
+__END_DECLS
+
+#endif /* E_ETN_HANDLE_H */
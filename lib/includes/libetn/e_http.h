@@ -0,0 +1,72 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef E_HTTP_H
+#define E_HTTP_H
+
+#include <libetn/e_err.h>
+#include <libetn/e_etn.h>
+
+typedef struct e_hpack_s e_hpack_t;
+
+__BEGIN_DECLS
+
+/*
+ * The Host header of an HTTP/1.x request without its port, host points into data. E_ERR_AGAIN if
+ * data ends before the header does, E_ERR_NOFOUND if the headers end without one.
+ */
+E_EXPORT e_errno_t e_http_host_extract(const char * __restrict data, size_t len, const char ** __restrict host, size_t * __restrict host_len) E_NONNULL(1, 3, 4);
+
+/* e_etn_lookup() of the Host header, offsets in result are into *host */
+E_EXPORT e_errno_t e_etn_classify_http_request(e_etn_t * __restrict etn, const char * __restrict data, size_t len, const char ** __restrict host, size_t * __restrict host_len, e_etn_result_t * __restrict result) E_NONNULL(1, 2, 4, 5, 6);
+
+/*
+ * A decoder for the header blocks one side of an HTTP/2 connection sends, max_size is the
+ * SETTINGS_HEADER_TABLE_SIZE the other side announced, 4096 by default. Only the values of
+ * :authority and host are kept in its dynamic table, other entries are counted by size.
+ */
+E_EXPORT e_hpack_t *e_hpack_new(size_t max_size) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC;
+E_EXPORT void e_hpack_free(e_hpack_t *hpack);
+
+/*
+ * Decode a whole header block, the HEADERS and CONTINUATION fragments joined, and give :authority,
+ * or host if there is none, without its port. It points into block or into hpack until the next
+ * block is decoded. Every block of the connection must be decoded in order to keep the dynamic table.
+ * E_ERR_NOFOUND if there is no authority, E_ERR_INVAL if the block is malformed or the authority is
+ * longer than 512 bytes, hpack is then out of step with the connection.
+ */
+E_EXPORT e_errno_t e_hpack_authority(e_hpack_t * __restrict hpack, const uint8_t * __restrict block, size_t len, const char ** __restrict authority, size_t * __restrict authority_len) E_NONNULL(1, 2, 4, 5);
+
+/* e_etn_lookup() of the authority of a header block, offsets in result are into *authority */
+E_EXPORT e_errno_t e_etn_classify_hpack(e_etn_t * __restrict etn, e_hpack_t * __restrict hpack, const uint8_t * __restrict block, size_t len, const char ** __restrict authority, size_t * __restrict authority_len, e_etn_result_t * __restrict result) E_NONNULL(1, 2, 3, 5, 6, 7);
+
+__END_DECLS
+
+#endif /* E_HTTP_H */
@@ -111,8 +111,12 @@
 #define E_GNUC_MALLOC           __attribute__((malloc))
 #define E_NO_RETURN             __attribute__((noreturn))
 #define E_HOT                   __attribute__((hot))
+#define E_ALWAYS_INLINE         __attribute__((always_inline))
 #define E_GNUC_PURE             __attribute__((pure))
 
+/* hint the cpu to fetch the cache line of addr for reading */
+#define E_PREFETCH(addr)        __builtin_prefetch((addr), 0, 3)
+
 /* *printf() size_t modifier */
 #ifndef PRIdSIZE
 #define PRIdSIZE "zd"
@@ -0,0 +1,78 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef E_SUFFIXSET_H
+#define E_SUFFIXSET_H
+
+#include <libetn/e_err.h>
+#include <libetn/e_etn.h>
+
+typedef struct e_suffixset_builder_s e_suffixset_builder_t;
+typedef struct e_suffixset_s e_suffixset_t;
+
+__BEGIN_DECLS
+
+/*
+ * A builder collects rules, domain suffixes with a payload each, for block and category lists of
+ * any size. Rules are folded to lower case and IDNA encoded, a leading dot and a trailing root dot
+ * are dropped. A rule added again keeps the payload it was added with last.
+ */
+E_EXPORT e_suffixset_builder_t *e_suffixset_builder_new(void) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC;
+E_EXPORT void e_suffixset_builder_free(e_suffixset_builder_t *builder);
+
+/* E_ERR_INVAL if the rule is empty, has an empty label or a NUL byte, or is longer than a domain name */
+E_EXPORT e_errno_t e_suffixset_builder_add(e_suffixset_builder_t * __restrict builder, const char * __restrict rule, size_t len, uint32_t payload) E_NONNULL(1, 2);
+
+/* the rules compiled to the tables of e_etn_t, NULL if there are none. The builder can take more rules after */
+E_EXPORT e_suffixset_t *e_suffixset_builder_compile(e_suffixset_builder_t *builder) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC E_NONNULL(1);
+
+/* a file e_suffixset_save() wrote, used in place from a read-only mapping */
+E_EXPORT e_suffixset_t *e_suffixset_new_mmap(const char *filename) E_GNUC_WARN_UNUSED_RESULT E_GNUC_MALLOC E_NONNULL(1);
+E_EXPORT void e_suffixset_free(e_suffixset_t *set);
+
+/* written in host byte order, aside and renamed over like e_etn_save() */
+E_EXPORT e_errno_t e_suffixset_save(e_suffixset_t *set, const char *filename) E_NONNULL(1, 2);
+
+/*
+ * as e_etn_set_engine(). A set starts with E_ETN_ENGINE_INLINE, whose keys take 16 bytes a node in memory
+ * even for a mapped set, or E_ETN_ENGINE_SEARCH if there was no memory for them. Sets of a million rules
+ * do not stay in cache and look up about three times slower than the public suffix list does.
+ */
+E_EXPORT e_errno_t e_suffixset_set_engine(e_suffixset_t *set, e_etn_engine_t engine) E_NONNULL(1);
+
+/*
+ * the longest rule domain ends with, as e_etn_lookup() takes domain. The rule is domain[*match_off, len),
+ * E_ERR_NOFOUND if no rule matches.
+ */
+E_EXPORT e_errno_t e_suffixset_lookup(e_suffixset_t * __restrict set, const char * __restrict domain, size_t len, uint32_t * __restrict payload, size_t * __restrict match_off) E_NONNULL(1, 2, 4, 5);
+
+__END_DECLS
+
+#endif /* E_SUFFIXSET_H */
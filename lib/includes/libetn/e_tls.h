@@ -0,0 +1,52 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef E_TLS_H
+#define E_TLS_H
+
+#include <libetn/e_err.h>
+#include <libetn/e_etn.h>
+
+__BEGIN_DECLS
+
+/*
+ * The server name of a ClientHello, in a TLS record or as the bare handshake message QUIC carries.
+ * sni points into data, nothing is copied. E_ERR_AGAIN if data ends before the server name does,
+ * E_ERR_NOFOUND if there is none, E_ERR_NOTSUP if the ClientHello goes on in another record and
+ * E_ERR_INVAL for anything else that is not a ClientHello.
+ */
+E_EXPORT e_errno_t e_tls_sni_extract(const uint8_t * __restrict data, size_t len, const char ** __restrict sni, size_t * __restrict sni_len) E_NONNULL(1, 3, 4);
+
+/* e_etn_lookup() of the server name, offsets in result are into *sni */
+E_EXPORT e_errno_t e_etn_classify_client_hello(e_etn_t * __restrict etn, const uint8_t * __restrict data, size_t len, const char ** __restrict sni, size_t * __restrict sni_len, e_etn_result_t * __restrict result) E_NONNULL(1, 2, 4, 5, 6);
+
+__END_DECLS
+
+#endif /* E_TLS_H */
@@ -58,6 +58,9 @@ int main(int argc, char *argv[]) {
     e_assert_true(i == 1);
     e_assert_true(e_atomic_dec_and_test(&i));
 
+    e_atomic_store_release(&i, 5);
+    e_assert_true(e_atomic_load_acquire(&i) == 5);
+
     e_atomic_memory_barrier();
     e_atomic_cpu_pause();
 
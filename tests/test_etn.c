@@ -30,8 +30,21 @@
 
 #include <libetn.h>
 #include <getopt.h>
+#include <unistd.h>
 
-#define DATA_FILE "public_suffix_compiled.dat"
+#define DATA_FILE       "public_suffix_compiled.dat"
+#define DATA_FILE_V2    "public_suffix_compiled_v2.dat"
+#define PSL_FILE        "effective_tld_names.dat"
+#define SAVED_FILE      "public_suffix_saved.dat"
+#define SAVED_FILE_V2   "public_suffix_saved_v2.dat"
+#define SAVED_FILE_WIDE "public_suffix_saved_wide.dat"
+#define CORRUPT_FILE    "public_suffix_corrupt_v2.dat"
+
+/* larger than the L2 cache of most hosts */
+#define E_ETN_JUNK_SIZE (8 * 1024 * 1024)
+
+/* the most test domains a cursor walks through */
+#define E_ETN_CURSOR_CASES  (64 * 1024)
 
 struct {
     const char *domain;
@@ -271,24 +284,75 @@ struct {
     { "xn--fiqs8s", "" },
 };
 
+/* most real traffic ends in one of a few popular TLDs */
+static const char *com_heavy_cases[] = {
+    "www.google.com", "api.example.com", "cdn.example.net", "mail.example.org",
+    "static.example.com", "img.example.com", "news.example.co.uk", "shop.example.de",
+    "a.b.example.com", "login.example.com", "www.example.jp", "video.example.com",
+    "ads.example.net", "www.example.io", "m.example.com", "www.example.cn",
+};
+
 static inline void usage(const char *cmd) E_NO_RETURN;
 static inline void test_load(const char *filename);
 static inline void test_ICANN(const char *filename);
 static inline void test_public_suffix(const char *filename);
 static inline void test_eTLD_plus_one(const char *filename);
+static inline void test_mmap(const char *filename, const char *filename_v2);
+static inline void test_builtin(void);
+static inline void test_from_psl_buffer(void);
+static inline void test_from_psl(const char *filename, const char *filename_v2, const char *psl);
+static inline void test_wide(void);
+static inline void test_same_file(const char *a, const char *b);
+static inline void test_public_suffix_len(const char *filename);
+static inline void test_public_suffix_batch(const char *filename);
+static inline void test_lookup(const char *filename);
+static inline void test_engine(const char *filename);
+static inline void test_engine_cases(e_etn_t *search, e_etn_t *other);
+static inline void test_engine_same(e_etn_t *a, e_etn_t *b, const char *domain, size_t len);
+static inline void test_cursor(const char *filename);
+static inline void test_suffix_id(const char *filename);
+static inline void test_wire(const char *filename);
+static inline void test_wire_same(e_etn_t *etn, const char *domain, size_t len);
+static inline size_t wire_encode(const char *domain, size_t len, uint8_t *buf);
+static inline size_t wire_decode(const uint8_t *msg, size_t off, char *buf);
+static inline void test_iov(const char *filename);
+static inline void test_stack(const char *filename);
+static inline void test_metadata(const char *filename);
+static inline void test_stack_same(e_etn_t *base, e_etn_t *stack);
+static inline void test_same_site(const char *filename);
+static inline void test_same_site_same(e_etn_t *etn);
+static inline bool same_site(e_etn_t *etn, const char *a, size_t a_len, const char *b, size_t b_len);
+static inline void test_cookie_domain(const char *filename);
+static inline void test_levels(const char *filename);
+static inline void test_levels_same(e_etn_t *etn, const char *domain, size_t len);
+static inline void test_iov_same(e_etn_t *etn, const char *domain, size_t len, size_t seed);
+static inline size_t iov_flat(const struct iovec *iov, int seg, size_t off);
+static inline void test_cursor_same(e_etn_t *etn, char (*domains)[E_STRBUF], size_t n, bool sorted);
+static inline size_t cursor_cases(char (*domains)[E_STRBUF], size_t max);
+static inline int cursor_cmp(const void *a, const void *b);
+static inline size_t random_domain(char *buf, size_t i);
 static inline void benchmark(const char *filename);
+static inline void benchmark_load(const char *filename, const char *filename_v2);
 
 int main(int argc, char *argv[]) {
     int         c;
-    const char  *file;
+    const char  *file, *file_v2, *psl;
 
     opterr = 0;
     file = DATA_FILE;
-    while((c = getopt(argc, argv, "d:")) != EOF) {
+    file_v2 = DATA_FILE_V2;
+    psl = PSL_FILE;
+    while((c = getopt(argc, argv, "d:m:p:")) != EOF) {
         switch(c) {
             case 'd':
                 file = optarg;
                 break;
+            case 'm':
+                file_v2 = optarg;
+                break;
+            case 'p':
+                psl = optarg;
+                break;
             default:
                 usage(argv[0]);
         }//end switch
@@ -298,7 +362,26 @@ int main(int argc, char *argv[]) {
     test_ICANN(file);
     test_public_suffix(file);
     test_eTLD_plus_one(file);
+    test_mmap(file, file_v2);
+    test_builtin();
+    test_from_psl_buffer();
+    test_from_psl(file, file_v2, psl);
+    test_wide();
+    test_public_suffix_len(file);
+    test_public_suffix_batch(file);
+    test_lookup(file);
+    test_engine(file);
+    test_cursor(file);
+    test_suffix_id(file);
+    test_wire(file);
+    test_iov(file);
+    test_stack(file);
+    test_metadata(file);
+    test_same_site(file);
+    test_cookie_domain(file);
+    test_levels(file);
     benchmark(file);
+    benchmark_load(file, file_v2);
 
     return 0;
 }//end main
@@ -306,7 +389,7 @@ int main(int argc, char *argv[]) {
 
 /* ===== private function ===== */
 static inline void usage(const char *cmd) {
-    fprintf(stderr, "%s [-d public suffix compiled file]\n", cmd);
+    fprintf(stderr, "%s [-d public suffix compiled file] [-m public suffix compiled v2 file] [-p public suffix list]\n", cmd);
     exit(1);
 }//end usage
 
@@ -381,14 +464,1531 @@ static inline void test_eTLD_plus_one(const char *filename) {
     e_etn_free(etn);
 }//end test_eTLD_plus_one
 
-static inline void benchmark(const char *filename) {
+static inline void test_mmap(const char *filename, const char *filename_v2) {
     bool        icann;
-    size_t      i, j;
-    double      spent;
+    size_t      i, len;
+    char        *buf;
+    uint32_t    *words, *nodes, *children;
     e_etn_t     *etn;
-    e_timer_t   *timer;
+    FILE        *fp;
     const char  *ps, *eTLD;
 
+    /* v1 has to be byte-swapped, it can not be mapped */
+    e_assert_false(e_etn_new_mmap(filename));
+    e_assert_false(e_etn_new_mmap("/nonexistent/public_suffix_compiled_v2.dat"));
+
+    e_assert_true(etn = e_etn_new_mmap(filename_v2));
+    for(i = 0 ; i < E_N_ELEMENTS(public_suffix_cases) ; i++) {
+        e_etn_public_suffix(etn, public_suffix_cases[i].domain, &ps, &icann);
+        e_assert_true(!strcmp(public_suffix_cases[i].want, ps));
+    }//end for
+    for(i = 0 ; i < E_N_ELEMENTS(eTLD_plus_one_cases) ; i++) {
+        e_etn_eTLD_plus_one(etn, eTLD_plus_one_cases[i].domain, &eTLD);
+        e_assert_true(!strcmp(eTLD_plus_one_cases[i].want, eTLD));
+    }//end for
+    e_etn_free(etn);
+
+    /* e_etn_new() maps a v2 file too */
+    e_assert_true(etn = e_etn_new(filename_v2));
+    for(i = 0 ; i < E_N_ELEMENTS(public_suffix_cases) ; i++) {
+        e_etn_public_suffix(etn, public_suffix_cases[i].domain, &ps, &icann);
+        e_assert_true(!strcmp(public_suffix_cases[i].want, ps));
+    }//end for
+    e_etn_free(etn);
+
+    /* a node or a children record that points out of the tables is turned away, the header words are in host order */
+    e_assert_true(buf = e_malloc(1024 * 1024));
+    e_assert_true(fp = fopen(filename_v2, "rb"));
+    len = fread(buf, 1, 1024 * 1024, fp);
+    fclose(fp);
+    words = (uint32_t *)buf;
+    nodes = (uint32_t *)(buf + words[16]);
+    children = (uint32_t *)(buf + words[18]);
+    for(i = 0 ; i < 2 ; i++) {
+        if(i == 0) {
+            nodes[words[17] - 1] = 0xFFFFFFFF;
+        }//end if
+        else {
+            e_assert_true(fp = fopen(filename_v2, "rb"));
+            e_assert_true(fread(buf, 1, len, fp) == len);
+            fclose(fp);
+            children[words[19] - 1] = 0xFFFFFFFF;
+        }//end else
+        e_assert_true(fp = fopen(CORRUPT_FILE, "wb"));
+        e_assert_true(fwrite(buf, 1, len, fp) == len);
+        fclose(fp);
+        e_assert_false(e_etn_new_mmap(CORRUPT_FILE));
+    }//end for
+    e_free(buf);
+}//end test_mmap
+
+static inline void test_builtin(void) {
+    bool        icann;
+    size_t      i;
+    e_etn_t     *etn;
+    const char  *ps;
+
+    /* a library built with the list must open it */
+#ifdef HAVE_ETN_BUILTIN
+    e_assert_true(etn = e_etn_new_builtin());
+#else
+    e_assert_false(e_etn_new_builtin());
+    printf("Built without the built-in list, skipped\n");
+    return;
+#endif
+
+    for(i = 0 ; i < E_N_ELEMENTS(public_suffix_cases) ; i++) {
+        e_etn_public_suffix(etn, public_suffix_cases[i].domain, &ps, &icann);
+        e_assert_true(!strcmp(public_suffix_cases[i].want, ps));
+    }//end for
+
+    /* every handle is separate, the tables are shared */
+    e_assert_errno(E_OK, e_etn_set_engine(etn, E_ETN_ENGINE_DFA));
+    e_etn_public_suffix(etn, "www.example.co.uk", &ps, &icann);
+    e_assert_true(!strcmp("co.uk", ps));
+
+    e_etn_free(etn);
+}//end test_builtin
+
+static inline void test_from_psl_buffer(void) {
+    size_t          i;
+    e_etn_t         *etn, *saved;
+    e_etn_result_t  r;
+    const char      *psl =
+        "// comment\n"
+        "// ===BEGIN ICANN DOMAINS===\n"
+        "com\n"
+        "uk\n"
+        "  co.uk\t\r\n"
+        "\n"
+        "jp\n"
+        "*.kobe.jp\n"
+        "!city.kobe.jp\n"
+        "cn\n"
+        "\xe5\x85\xac\xe5\x8f\xb8.cn\n"
+        "// ===END ICANN DOMAINS===\n"
+        "// ===BEGIN PRIVATE DOMAINS===\n"
+        "blogspot.co.uk\n"
+        "BlogSpot.COM\n"
+        "// ===END PRIVATE DOMAINS===";
+    const char      *bad[] = {
+        "", "// comment only\n", "a..com\n", ".com\n", "com.\n", "!\n", "*.\n", "a b.com\n", "a/b.com\n",
+    };
+    struct {
+        const char      *domain;
+        const char      *suffix;
+        bool            icann;
+        e_etn_rule_t    rule;
+    } cases[] = {
+        { "www.example.co.uk",      "co.uk",            true,   E_ETN_RULE_NORMAL, },
+        { "foo.blogspot.co.uk",     "blogspot.co.uk",   false,  E_ETN_RULE_NORMAL, },
+        { "foo.blogspot.com",       "blogspot.com",     false,  E_ETN_RULE_NORMAL, },
+        { "a.b.c.kobe.jp",          "c.kobe.jp",        true,   E_ETN_RULE_WILDCARD, },
+        { "www.city.kobe.jp",       "kobe.jp",          true,   E_ETN_RULE_EXCEPTION, },
+        { "shishi.xn--55qx5d.cn",   "xn--55qx5d.cn",    true,   E_ETN_RULE_NORMAL, },
+        { "foo.nosuchtld",          "nosuchtld",        false,  E_ETN_RULE_DEFAULT, },
+    };
+
+    for(i = 0 ; i < E_N_ELEMENTS(bad) ; i++) {
+        e_assert_false(e_etn_new_from_psl_buffer(bad[i], strlen(bad[i])));
+    }//end for
+    e_assert_false(e_etn_new_from_psl("/nonexistent/effective_tld_names.dat"));
+
+    e_assert_true(etn = e_etn_new_from_psl_buffer(psl, strlen(psl)));
+    for(i = 0 ; i < E_N_ELEMENTS(cases) ; i++) {
+        e_assert_errno(E_OK, e_etn_lookup(etn, cases[i].domain, strlen(cases[i].domain), &r));
+        e_assert_true(!strcmp(cases[i].suffix, cases[i].domain + r.suffix_off));
+        e_assert_true(r.icann == cases[i].icann);
+        e_assert_true(r.rule == cases[i].rule);
+    }//end for
+
+    /* what is saved loads back the same */
+    e_assert_errno(E_ERR_INVAL, e_etn_save(etn, SAVED_FILE, (e_etn_format_t)0));
+    e_assert_errno(E_OK, e_etn_save(etn, SAVED_FILE, E_ETN_FORMAT_V1));
+    e_assert_true(saved = e_etn_new(SAVED_FILE));
+    test_engine_cases(etn, saved);
+    e_etn_free(saved);
+
+    e_assert_errno(E_OK, e_etn_save(etn, SAVED_FILE_V2, E_ETN_FORMAT_V2));
+    e_assert_true(saved = e_etn_new_mmap(SAVED_FILE_V2));
+    test_engine_cases(etn, saved);
+    e_etn_free(saved);
+
+    /* narrow tables saved wide are narrowed again when they are loaded */
+    e_assert_errno(E_OK, e_etn_save(etn, SAVED_FILE_WIDE, E_ETN_FORMAT_WIDE));
+    e_assert_true(saved = e_etn_new(SAVED_FILE_WIDE));
+    test_engine_cases(etn, saved);
+    e_assert_errno(E_OK, e_etn_save(saved, SAVED_FILE, E_ETN_FORMAT_V1));
+    e_etn_free(saved);
+
+    e_etn_free(etn);
+}//end test_from_psl_buffer
+
+static inline void test_from_psl(const char *filename, const char *filename_v2, const char *psl) {
+    double      spent;
+    e_etn_t     *etn, *compiled;
+    e_timer_t   *timer;
+
+    /* the Makefile downloads the list the compiled files are made from, without it nothing is compared */
+    e_assert_true(access(psl, R_OK) == 0);
+
+    e_assert_true(timer = e_timer_new());
+    e_assert_true(etn = e_etn_new_from_psl(psl));
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Compile '%s' spent: %f seconds\n", psl, spent);
+    e_timer_free(timer);
+
+    /* the same answers as the tables ci/precompile.go wrote */
+    e_assert_true(compiled = e_etn_new(filename));
+    test_engine_cases(compiled, etn);
+    e_etn_free(etn);
+
+    /* and the same bytes when they are saved again */
+    e_assert_errno(E_OK, e_etn_save(compiled, SAVED_FILE, E_ETN_FORMAT_V1));
+    test_same_file(filename, SAVED_FILE);
+    e_etn_free(compiled);
+
+    e_assert_true(compiled = e_etn_new_mmap(filename_v2));
+    e_assert_errno(E_OK, e_etn_save(compiled, SAVED_FILE_V2, E_ETN_FORMAT_V2));
+    test_same_file(filename_v2, SAVED_FILE_V2);
+    e_etn_free(compiled);
+}//end test_from_psl
+
+static inline void test_wide(void) {
+    char            *psl, *p, domain[E_STRBUF], label[E_STRBUF];
+    size_t          i, j, len, offs[2];
+    bool            icanns[2];
+    const char      *domains[2];
+    e_etn_t         *etn, *saved, *other;
+    e_etn_cursor_t  *cursor;
+    e_etn_result_t  r, rs;
+    e_etn_engine_t  engines[] = { E_ETN_ENGINE_INLINE, E_ETN_ENGINE_DFA };
+
+    /* more children records and longer labels than the narrow widths hold */
+    e_assert_true(psl = e_malloc(64 * 1024));
+    p = psl + sprintf(psl, "com\n");
+    for(i = 0 ; i < 1100 ; i++) {
+        p += sprintf(p, "n%zu.com\nx.n%zu.com\n", i, i);
+    }//end for
+    memset(label, 'a', 100);
+    label[100] = '\0';
+    p += sprintf(p, "%s.com\n", label);
+
+    e_assert_true(etn = e_etn_new_from_psl_buffer(psl, p - psl));
+    e_assert_errno(E_ERR_NOTSUP, e_etn_save(etn, SAVED_FILE, E_ETN_FORMAT_V1));
+    e_assert_errno(E_ERR_NOTSUP, e_etn_save(etn, SAVED_FILE_V2, E_ETN_FORMAT_V2));
+    e_assert_errno(E_OK, e_etn_save(etn, SAVED_FILE_WIDE, E_ETN_FORMAT_WIDE));
+    e_assert_true(saved = e_etn_new(SAVED_FILE_WIDE));
+    e_assert_true(other = e_etn_new(SAVED_FILE_WIDE));
+
+    for(j = 0 ; j <= E_N_ELEMENTS(engines) ; j++) {
+        for(i = 0 ; i < 1100 ; i += 7) {
+            len = snprintf(domain, sizeof(domain), "www.x.n%zu.com", i);
+            e_assert_errno(E_OK, e_etn_lookup(etn, domain, len, &r));
+            e_assert_true(!strcmp(domain + r.suffix_off, domain + 4));
+            e_assert_true(r.rule == E_ETN_RULE_NORMAL);
+            test_engine_same(etn, saved, domain, len);
+            test_engine_same(etn, other, domain, len);
+            test_engine_same(etn, other, domain + 4, len - 4);
+            test_engine_same(etn, other, domain + 2, len - 2);
+
+            /* the batch takes the wide path too */
+            domains[0] = domain;
+            domains[1] = domain + 4;
+            offs[0] = offs[1] = 0;
+            e_assert_errno(E_OK, e_etn_public_suffix_batch(other, domains, (size_t[]){ len, len - 4 }, 2, offs, icanns));
+            e_assert_true(offs[0] == r.suffix_off && offs[1] == 0);
+        }//end for
+
+        len = snprintf(domain, sizeof(domain), "www.%s.com", label);
+        e_assert_errno(E_OK, e_etn_lookup(etn, domain, len, &r));
+        e_assert_true(r.suffix_off == 4 && r.suffix_labels == 2);
+        test_engine_same(etn, other, domain, len);
+        e_assert_errno(E_OK, e_etn_lookup(other, "foo.n5.com", strlen("foo.n5.com"), &rs));
+        e_assert_true(rs.suffix_off == 4);
+
+        if(j < E_N_ELEMENTS(engines)) {
+            e_assert_errno(E_OK, e_etn_set_engine(other, engines[j]));
+        }//end if
+    }//end for
+
+    /* and so does a name in wire format */
+    for(i = 0 ; i < 1100 ; i += 7) {
+        len = snprintf(domain, sizeof(domain), "www.X.n%zu.com", i);
+        test_wire_same(other, domain, len);
+    }//end for
+
+    /* and so does one in pieces */
+    for(i = 0 ; i < 1100 ; i += 7) {
+        len = snprintf(domain, sizeof(domain), "www.X.n%zu.com", i);
+        test_iov_same(other, domain, len, i);
+    }//end for
+
+    /* a cursor walks the wide tables too */
+    e_assert_true(cursor = e_etn_cursor_new(other, true));
+    for(i = 0 ; i < 1100 ; i++) {
+        len = snprintf(domain, sizeof(domain), "www.x.n%zu.com", i);
+        e_assert_errno(E_OK, e_etn_cursor_lookup(cursor, domain, len, &r));
+        e_assert_errno(E_OK, e_etn_lookup(etn, domain, len, &rs));
+        e_assert_true(r.suffix_off == rs.suffix_off && r.registrable_off == rs.registrable_off);
+        e_assert_true(r.labels == rs.labels && r.suffix_labels == rs.suffix_labels && r.rule == rs.rule);
+    }//end for
+    e_etn_cursor_free(cursor);
+
+    e_etn_free(other);
+    e_etn_free(saved);
+    e_etn_free(etn);
+    e_free(psl);
+}//end test_wide
+
+static inline void test_same_file(const char *a, const char *b) {
+    int     ca, cb;
+    FILE    *fa, *fb;
+
+    e_assert_true(fa = fopen(a, "rb"));
+    e_assert_true(fb = fopen(b, "rb"));
+    do {
+        ca = fgetc(fa);
+        cb = fgetc(fb);
+        e_assert_true(ca == cb);
+    } while(ca != EOF);
+    fclose(fb);
+    fclose(fa);
+}//end test_same_file
+
+static inline void test_public_suffix_len(const char *filename) {
+    bool        icann;
+    char        buf[E_STRBUF];
+    size_t      i, j, len, off, want_len;
+    e_etn_t     *etn;
+    const char  *domain, *want;
+
+    e_assert_true(etn = e_etn_new(filename));
+
+    for(i = 0 ; i < E_N_ELEMENTS(public_suffix_cases) ; i++) {
+        domain = public_suffix_cases[i].domain;
+        want = public_suffix_cases[i].want;
+        len = strlen(domain);
+        want_len = strlen(want);
+
+        /* a slice without NUL terminator */
+        memset(buf, 'x', sizeof(buf));
+        memcpy(buf, domain, len);
+        e_assert_errno(E_OK, e_etn_public_suffix_len(etn, buf, len, &off, &icann));
+        e_assert_true(len - off == want_len && !memcmp(buf + off, want, want_len));
+
+        /* upper case */
+        for(j = 0 ; j < len ; j++) {
+            buf[j] = e_ascii_toupper(domain[j]);
+        }//end for
+        e_assert_errno(E_OK, e_etn_public_suffix_len(etn, buf, len, &off, &icann));
+        e_assert_true(len - off == want_len);
+
+        /* trailing root dot stays with the suffix */
+        memcpy(buf, domain, len);
+        buf[len] = '.';
+        e_assert_errno(E_OK, e_etn_public_suffix_len(etn, buf, len + 1, &off, &icann));
+        e_assert_true(len - off == want_len && !memcmp(buf + off, want, want_len) && buf[len] == '.');
+    }//end for
+
+    e_assert_errno(E_OK, e_etn_public_suffix_len(etn, "WWW.Foo.Blogspot.CO.UK", 22, &off, &icann));
+    e_assert_true(off == 8 && !icann);
+    e_assert_errno(E_OK, e_etn_public_suffix_len(etn, "foo.co.uk.", 10, &off, &icann));
+    e_assert_true(off == 4 && icann);
+
+    memset(buf, 'a', sizeof(buf));
+    e_assert_errno(E_ERR_INVAL, e_etn_public_suffix_len(etn, buf, sizeof(buf), &off, &icann));
+
+    e_etn_free(etn);
+}//end test_public_suffix_len
+
+static inline void test_public_suffix_batch(const char *filename) {
+    bool        icann, icanns[E_N_ELEMENTS(public_suffix_cases) + E_N_ELEMENTS(eTLD_plus_one_cases) + 1];
+    char        buf[E_STRBUF * 2], random[E_N_ELEMENTS(icanns)][E_STRBUF];
+    size_t      i, j, n, off;
+    size_t      lens[E_N_ELEMENTS(icanns)], offs[E_N_ELEMENTS(icanns)];
+    e_etn_t     *etn;
+    const char  *domains[E_N_ELEMENTS(icanns)];
+
+    e_assert_true(etn = e_etn_new(filename));
+
+    n = 0;
+    for(i = 0 ; i < E_N_ELEMENTS(public_suffix_cases) ; i++, n++) {
+        domains[n] = public_suffix_cases[i].domain;
+    }//end for
+    for(i = 0 ; i < E_N_ELEMENTS(eTLD_plus_one_cases) ; i++, n++) {
+        domains[n] = eTLD_plus_one_cases[i].domain;
+    }//end for
+    for(i = 0 ; i < n ; i++) {
+        lens[i] = strlen(domains[i]);
+    }//end for
+
+    /* every lane is refilled more than once */
+    e_assert_errno(E_OK, e_etn_public_suffix_batch(etn, domains, lens, n, offs, icanns));
+    for(i = 0 ; i < n ; i++) {
+        e_assert_errno(E_OK, e_etn_public_suffix_len(etn, domains[i], lens[i], &off, &icann));
+        e_assert_true(offs[i] == off && icanns[i] == icann);
+    }//end for
+
+    /* fewer domains than lanes */
+    e_assert_errno(E_OK, e_etn_public_suffix_batch(etn, domains + 3, lens + 3, 2, offs, icanns));
+    for(i = 0 ; i < 2 ; i++) {
+        e_assert_errno(E_OK, e_etn_public_suffix_len(etn, domains[3 + i], lens[3 + i], &off, &icann));
+        e_assert_true(offs[i] == off && icanns[i] == icann);
+    }//end for
+    e_assert_errno(E_OK, e_etn_public_suffix_batch(etn, domains, lens, 0, offs, icanns));
+
+    /* a domain too long does not stop the others */
+    memset(buf, 'a', sizeof(buf));
+    domains[n] = buf;
+    lens[n] = sizeof(buf);
+    e_assert_errno(E_ERR_INVAL, e_etn_public_suffix_batch(etn, domains, lens, n + 1, offs, icanns));
+    e_assert_true(offs[n] == sizeof(buf));
+    for(i = 0 ; i < n ; i++) {
+        e_assert_errno(E_OK, e_etn_public_suffix_len(etn, domains[i], lens[i], &off, &icann));
+        e_assert_true(offs[i] == off && icanns[i] == icann);
+    }//end for
+
+    /* labels the filter turns away, and a table whose engine has a walk of its own */
+    for(i = 0 ; i < n ; i++) {
+        lens[i] = random_domain(random[i], i);
+        domains[i] = random[i];
+    }//end for
+    for(j = 0 ; j < 2 ; j++) {
+        e_assert_errno(E_OK, e_etn_public_suffix_batch(etn, domains, lens, n, offs, icanns));
+        for(i = 0 ; i < n ; i++) {
+            e_assert_errno(E_OK, e_etn_public_suffix_len(etn, domains[i], lens[i], &off, &icann));
+            e_assert_true(offs[i] == off && icanns[i] == icann);
+        }//end for
+        e_assert_errno(E_OK, e_etn_set_engine(etn, E_ETN_ENGINE_INLINE));
+    }//end for
+
+    e_etn_free(etn);
+}//end test_public_suffix_batch
+
+static inline void test_lookup(const char *filename) {
+    size_t          i, len;
+    e_etn_t         *etn;
+    const char      *domain;
+    e_etn_result_t  r;
+    struct {
+        const char      *domain;
+        size_t          suffix_off;
+        size_t          registrable_off;
+        size_t          subdomain_len;
+        uint32_t        labels;
+        uint32_t        suffix_labels;
+        bool            icann;
+        e_etn_rule_t    rule;
+    } cases[] = {
+        { "",                   0,  0,  0, 0, 0, false, E_ETN_RULE_DEFAULT, },
+        { "com",                0,  3,  0, 1, 1, true,  E_ETN_RULE_NORMAL, },
+        { "example.com",        8,  0,  0, 2, 1, true,  E_ETN_RULE_NORMAL, },
+        { "a.b.example.com",    12, 4,  3, 4, 1, true,  E_ETN_RULE_NORMAL, },
+        { "a.b.example.com.",   12, 4,  3, 4, 1, true,  E_ETN_RULE_NORMAL, },
+        { "WWW.Example.CO.UK",  12, 4,  3, 4, 2, true,  E_ETN_RULE_NORMAL, },
+        { "foo.nosuchtld",      4,  0,  0, 2, 1, false, E_ETN_RULE_DEFAULT, },
+        { "c.kobe.jp",          0,  9,  0, 3, 3, true,  E_ETN_RULE_WILDCARD, },
+        { "a.b.c.kobe.jp",      4,  2,  1, 5, 3, true,  E_ETN_RULE_WILDCARD, },
+        { "www.city.kobe.jp",   9,  4,  3, 4, 2, true,  E_ETN_RULE_EXCEPTION, },
+        { "www.www.ck",         8,  4,  3, 3, 1, true,  E_ETN_RULE_EXCEPTION, },
+        { "foo.blogspot.co.uk", 4,  0,  0, 4, 3, false, E_ETN_RULE_NORMAL, },
+    };
+
+    e_assert_true(etn = e_etn_new(filename));
+
+    for(i = 0 ; i < E_N_ELEMENTS(cases) ; i++) {
+        len = strlen(cases[i].domain);
+        e_assert_errno(E_OK, e_etn_lookup(etn, cases[i].domain, len, &r));
+        e_assert_true(r.suffix_off == cases[i].suffix_off);
+        e_assert_true(r.registrable_off == cases[i].registrable_off);
+        e_assert_true(r.subdomain_len == cases[i].subdomain_len);
+        e_assert_true(r.labels == cases[i].labels);
+        e_assert_true(r.suffix_labels == cases[i].suffix_labels);
+        e_assert_true(r.icann == cases[i].icann);
+        e_assert_true(r.rule == cases[i].rule);
+    }//end for
+
+    /* one walk gives both answers */
+    for(i = 0 ; i < E_N_ELEMENTS(eTLD_plus_one_cases) ; i++) {
+        domain = eTLD_plus_one_cases[i].domain;
+        len = strlen(domain);
+        e_assert_errno(E_OK, e_etn_lookup(etn, domain, len, &r));
+        e_assert_true(!strcmp(eTLD_plus_one_cases[i].want, r.registrable_off == len ? "" : domain + r.registrable_off));
+    }//end for
+    for(i = 0 ; i < E_N_ELEMENTS(public_suffix_cases) ; i++) {
+        domain = public_suffix_cases[i].domain;
+        e_assert_errno(E_OK, e_etn_lookup(etn, domain, strlen(domain), &r));
+        e_assert_true(!strcmp(public_suffix_cases[i].want, domain + r.suffix_off));
+    }//end for
+
+    e_etn_free(etn);
+}//end test_lookup
+
+static inline void test_engine(const char *filename) {
+    char            buf[E_STRBUF];
+    size_t          i, len;
+    e_etn_t         *search, *other;
+    e_etn_engine_t  engines[] = { E_ETN_ENGINE_INLINE, E_ETN_ENGINE_DFA };
+
+    e_assert_true(search = e_etn_new(filename));
+    e_assert_true(other = e_etn_new(filename));
+    e_assert_errno(E_ERR_INVAL, e_etn_set_engine(other, (e_etn_engine_t)-1));
+
+    for(i = 0 ; i < E_N_ELEMENTS(engines) ; i++) {
+        e_assert_errno(E_OK, e_etn_set_engine(other, engines[i]));
+        test_engine_cases(search, other);
+    }//end for
+
+    /* the DFA never goes through the Bloom filter, random labels under large ranges must miss in both */
+    for(i = 0 ; i < 10000 ; i++) {
+        len = random_domain(buf, i);
+        test_engine_same(search, other, buf, len);
+    }//end for
+
+    /* switching back gives the packed search again */
+    e_assert_errno(E_OK, e_etn_set_engine(other, E_ETN_ENGINE_SEARCH));
+    test_engine_same(search, other, "www.example.co.uk", strlen("www.example.co.uk"));
+
+    e_etn_free(other);
+    e_etn_free(search);
+}//end test_engine
+
+static inline void test_engine_cases(e_etn_t *search, e_etn_t *other) {
+    size_t      i, j, k, len;
+    char        buf[512];
+    const char  *domain, *tail;
+    const char  *prefixes[] = {
+        "", "a.", "WWW.", "city.", "k12.", "com.", "co.", "blogspot.", "Blogspot.", "blogspotx.", "blogspo.",
+        "xn--85x722f.", "xn--55qx5d.", "abcdefgh.", "abcdefghi.", "abcdefghij.", "amsterdam.", "*.", "!www.",
+    };
+    const char  *odd[] = {
+        "", ".", "..", ".com", "com.", "..com", "a..com", "a.b..co.uk", ".kobe.jp", "a..kobe.jp",
+        "x.city.kobe.jp", "ck", ".ck", "www..ck", "COM", "EXAMPLE.CO.UK.", "a_b.com", "a\xff.com", "\xff",
+    };
+
+    /* every tail of every test domain, with labels that share prefixes with real ones in front */
+    for(i = 0 ; i < E_N_ELEMENTS(public_suffix_cases) + E_N_ELEMENTS(eTLD_plus_one_cases) ; i++) {
+        if(i < E_N_ELEMENTS(public_suffix_cases)) {
+            domain = public_suffix_cases[i].domain;
+        }//end if
+        else {
+            domain = eTLD_plus_one_cases[i - E_N_ELEMENTS(public_suffix_cases)].domain;
+        }//end else
+
+        for(tail = domain ; tail ; tail = strchr(tail, '.') ? strchr(tail, '.') + 1 : NULL) {
+            for(j = 0 ; j < E_N_ELEMENTS(prefixes) ; j++) {
+                len = snprintf(buf, sizeof(buf), "%s%s", prefixes[j], tail);
+                test_engine_same(search, other, buf, len);
+
+                /* and the same with the last label cut short */
+                for(k = 1 ; k < len && buf[len - k] != '.' ; k++) {
+                    test_engine_same(search, other, buf, len - k);
+                }//end for
+            }//end for
+        }//end for
+    }//end for
+
+    /* empty labels, dots at either end and bytes no label has */
+    for(i = 0 ; i < E_N_ELEMENTS(odd) ; i++) {
+        test_engine_same(search, other, odd[i], strlen(odd[i]));
+    }//end for
+}//end test_engine_cases
+
+static inline void test_engine_same(e_etn_t *a, e_etn_t *b, const char *domain, size_t len) {
+    e_etn_result_t ra, rb;
+
+    e_assert_errno(E_OK, e_etn_lookup(a, domain, len, &ra));
+    e_assert_errno(E_OK, e_etn_lookup(b, domain, len, &rb));
+    e_assert_true(ra.suffix_off == rb.suffix_off);
+    e_assert_true(ra.registrable_off == rb.registrable_off);
+    e_assert_true(ra.subdomain_len == rb.subdomain_len);
+    e_assert_true(ra.labels == rb.labels);
+    e_assert_true(ra.suffix_labels == rb.suffix_labels);
+    e_assert_true(ra.suffix_id == rb.suffix_id);
+    e_assert_true(ra.metadata == rb.metadata);
+    e_assert_true(ra.registrable_hash == rb.registrable_hash);
+    e_assert_true(ra.icann == rb.icann);
+    e_assert_true(ra.rule == rb.rule);
+}//end test_engine_same
+
+static inline void test_cursor(const char *filename) {
+    char            (*domains)[E_STRBUF], tmp[E_STRBUF];
+    size_t          i, n;
+    e_etn_t         *etn;
+    e_etn_cursor_t  *cursor;
+    e_etn_result_t  r;
+
+    e_assert_true(etn = e_etn_new(filename));
+    e_assert_true(domains = e_malloc(E_ETN_CURSOR_CASES * E_STRBUF));
+    n = cursor_cases(domains, E_ETN_CURSOR_CASES);
+
+    /* in the order they were made, neighbours share suffixes only now and then */
+    test_cursor_same(etn, domains, n, false);
+    test_cursor_same(etn, domains, n, true);
+
+    /* sorted, then backwards so every gallop goes the wrong way */
+    qsort(domains, n, E_STRBUF, cursor_cmp);
+    test_cursor_same(etn, domains, n, false);
+    test_cursor_same(etn, domains, n, true);
+    for(i = 0 ; i < n / 2 ; i++) {
+        memcpy(tmp, domains[i], E_STRBUF);
+        memcpy(domains[i], domains[n - 1 - i], E_STRBUF);
+        memcpy(domains[n - 1 - i], tmp, E_STRBUF);
+    }//end for
+    test_cursor_same(etn, domains, n, true);
+
+    /* too long for any lookup, one byte less is a single label */
+    memset(tmp, 'a', sizeof(tmp));
+    e_assert_true(cursor = e_etn_cursor_new(etn, true));
+    e_assert_errno(E_ERR_INVAL, e_etn_cursor_lookup(cursor, tmp, sizeof(tmp), &r));
+    e_assert_errno(E_OK, e_etn_cursor_lookup(cursor, tmp, sizeof(tmp) - 1, &r));
+    e_assert_true(r.suffix_off == 0 && r.labels == 1);
+    e_etn_cursor_free(cursor);
+
+    e_free(domains);
+    e_etn_free(etn);
+}//end test_cursor
+
+static inline void test_suffix_id(const char *filename) {
+    char            name[E_STRBUF];
+    size_t          i, len;
+    e_etn_t         *etn;
+    e_etn_result_t  r, rs;
+    const char      *domain, *suffix;
+
+    e_assert_true(etn = e_etn_new(filename));
+
+    /* the name of the id is the suffix, less its first label when a wildcard decided it */
+    for(i = 0 ; i < E_N_ELEMENTS(public_suffix_cases) ; i++) {
+        domain = public_suffix_cases[i].domain;
+        e_assert_errno(E_OK, e_etn_lookup(etn, domain, strlen(domain), &r));
+        if(r.rule == E_ETN_RULE_DEFAULT) {
+            e_assert_true(r.suffix_id == E_ETN_SUFFIX_NONE);
+            continue;
+        }//end if
+
+        suffix = domain + r.suffix_off;
+        if(r.rule == E_ETN_RULE_WILDCARD) {
+            suffix = strchr(suffix, '.') + 1;
+        }//end if
+        e_assert_errno(E_OK, e_etn_suffix_name(etn, r.suffix_id, name, sizeof(name)));
+        e_assert_true(!strcmp(name, suffix));
+    }//end for
+
+    e_assert_errno(E_OK, e_etn_lookup(etn, "www.city.kobe.jp", strlen("www.city.kobe.jp"), &r));
+    e_assert_true(r.rule == E_ETN_RULE_EXCEPTION);
+    e_assert_errno(E_OK, e_etn_suffix_name(etn, r.suffix_id, name, sizeof(name)));
+    e_assert_true(!strcmp(name, "kobe.jp"));
+    e_assert_errno(E_ERR_NOBUFS, e_etn_suffix_name(etn, r.suffix_id, name, strlen("kobe.jp")));
+    e_assert_errno(E_OK, e_etn_suffix_name(etn, r.suffix_id, name, strlen("kobe.jp") + 1));
+    e_assert_errno(E_ERR_INVAL, e_etn_suffix_name(etn, E_ETN_SUFFIX_NONE, name, sizeof(name)));
+
+    /* the eTLD+1 hashes the same whatever comes left of it, in any case and with a root dot */
+    e_assert_errno(E_OK, e_etn_lookup(etn, "example.co.uk", strlen("example.co.uk"), &r));
+    e_assert_true(r.registrable_hash != 0);
+    e_assert_errno(E_OK, e_etn_lookup(etn, "www.Example.CO.uk.", strlen("www.Example.CO.uk."), &rs));
+    e_assert_true(rs.registrable_hash == r.registrable_hash && rs.suffix_id == r.suffix_id);
+    e_assert_errno(E_OK, e_etn_lookup(etn, "example.org.uk", strlen("example.org.uk"), &rs));
+    e_assert_true(rs.registrable_hash != r.registrable_hash && rs.suffix_id != r.suffix_id);
+    e_assert_errno(E_OK, e_etn_lookup(etn, "co.uk", strlen("co.uk"), &rs));
+    e_assert_true(rs.registrable_hash == 0 && rs.suffix_id == r.suffix_id);
+
+    /* a label one byte longer, whose last byte differs in the bit the length does */
+    e_assert_errno(E_OK, e_etn_lookup(etn, "me.co.uk", strlen("me.co.uk"), &r));
+    e_assert_errno(E_OK, e_etn_lookup(etn, "med.co.uk", strlen("med.co.uk"), &rs));
+    e_assert_true(rs.registrable_hash != r.registrable_hash);
+
+    /* an eTLD+1 longer than a word hashes every byte */
+    len = snprintf(name, sizeof(name), "a.abcdefghijklmnopqrstuvwxyz.com");
+    e_assert_errno(E_OK, e_etn_lookup(etn, name, len, &r));
+    name[2 + 12] = 'X';
+    e_assert_errno(E_OK, e_etn_lookup(etn, name, len, &rs));
+    e_assert_true(rs.registrable_hash != r.registrable_hash);
+    name[2 + 12] = 'm';
+    e_assert_errno(E_OK, e_etn_lookup(etn, name, len, &rs));
+    e_assert_true(rs.registrable_hash == r.registrable_hash);
+
+    e_etn_free(etn);
+}//end test_suffix_id
+
+static inline void test_wire(const char *filename) {
+    char                (*domains)[E_STRBUF], name[E_STRBUF];
+    size_t              i, n, off;
+    uint8_t             msg[512];
+    e_etn_t             *etn;
+    e_etn_wire_result_t r;
+
+    e_assert_true(etn = e_etn_new(filename));
+    e_assert_true(domains = e_malloc(E_ETN_CURSOR_CASES * E_STRBUF));
+    n = cursor_cases(domains, E_ETN_CURSOR_CASES);
+    for(i = 0 ; i < n ; i++) {
+        test_wire_same(etn, domains[i], strlen(domains[i]));
+    }//end for
+    e_free(domains);
+
+    /* www. with a pointer to example.co.uk, and a pointer to that */
+    memset(msg, 0, sizeof(msg));
+    off = 12 + wire_encode("Example.CO.uk", strlen("Example.CO.uk"), msg + 12);
+    memcpy(msg + off, "\3wWw\xc0\x0c", 6);
+    msg[off + 6] = 0xc0;
+    msg[off + 7] = off;
+    e_assert_errno(E_OK, e_etn_public_suffix_wire(etn, msg, off + 8, off, &r));
+    e_assert_true(r.labels == 4 && r.suffix_labels == 2 && r.suffix_label == 2 && r.registrable_label == 1);
+    e_assert_true(r.suffix_off == 20 && r.registrable_off == 12 && r.wire_len == 6 && r.icann);
+    wire_decode(msg, r.suffix_off, name);
+    e_assert_true(!strcmp(name, "CO.uk"));
+    e_assert_errno(E_OK, e_etn_public_suffix_wire(etn, msg, off + 8, off + 6, &r));
+    e_assert_true(r.labels == 4 && r.wire_len == 2 && r.registrable_off == 12);
+
+    /* the root alone */
+    e_assert_errno(E_OK, e_etn_public_suffix_wire(etn, msg, off + 8, 11, &r));
+    e_assert_true(r.labels == 0 && r.suffix_labels == 0 && r.suffix_off == 11 && r.registrable_off == off + 8);
+
+    /* pointers that do not go back, a loop through a label and names that run out */
+    msg[off + 7] = off + 6;
+    e_assert_errno(E_ERR_INVAL, e_etn_public_suffix_wire(etn, msg, off + 8, off + 6, &r));
+    msg[off + 7] = off + 8;
+    e_assert_errno(E_ERR_INVAL, e_etn_public_suffix_wire(etn, msg, off + 9, off + 6, &r));
+    msg[off + 7] = off;
+    e_assert_errno(E_ERR_INVAL, e_etn_public_suffix_wire(etn, msg, off + 7, off + 6, &r));
+    e_assert_errno(E_ERR_INVAL, e_etn_public_suffix_wire(etn, msg, 20, 12, &r));
+    e_assert_errno(E_ERR_INVAL, e_etn_public_suffix_wire(etn, msg, off + 8, off + 8, &r));
+    memcpy(msg + off, "\3www\xc0", 5);
+    msg[off + 5] = off;
+    e_assert_errno(E_ERR_INVAL, e_etn_public_suffix_wire(etn, msg, off + 6, off, &r));
+    msg[off] = 0x43;
+    e_assert_errno(E_ERR_INVAL, e_etn_public_suffix_wire(etn, msg, off + 6, off, &r));
+
+    /* 127 labels is the most that fit in 255 bytes */
+    for(i = 0 ; i < 127 ; i++) {
+        msg[2 * i] = 1;
+        msg[2 * i + 1] = 'a';
+    }//end for
+    msg[254] = 0;
+    e_assert_errno(E_OK, e_etn_public_suffix_wire(etn, msg, 255, 0, &r));
+    e_assert_true(r.labels == 127 && r.wire_len == 255 && r.rule == E_ETN_RULE_DEFAULT);
+    msg[254] = 1;
+    msg[255] = 'a';
+    msg[256] = 0;
+    e_assert_errno(E_ERR_INVAL, e_etn_public_suffix_wire(etn, msg, 257, 0, &r));
+
+    e_etn_free(etn);
+}//end test_wire
+
+static inline void test_wire_same(e_etn_t *etn, const char *domain, size_t len) {
+    char                name[E_STRBUF];
+    size_t              n, end;
+    uint8_t             msg[E_STRBUF + 16];
+    e_etn_result_t      rt;
+    e_etn_wire_result_t rw;
+
+    /* names with empty labels have no wire format */
+    n = wire_encode(domain, len, msg + 12);
+    if(n == 0) {
+        return;
+    }//end if
+    end = len > 0 && domain[len - 1] == '.' ? len - 1 : len;
+
+    e_assert_errno(E_OK, e_etn_lookup(etn, domain, len, &rt));
+    e_assert_errno(E_OK, e_etn_public_suffix_wire(etn, msg, 12 + n, 12, &rw));
+    e_assert_true(rw.wire_len == n);
+    e_assert_true(rw.labels == rt.labels);
+    e_assert_true(rw.suffix_labels == rt.suffix_labels);
+    e_assert_true(rw.suffix_label == rt.labels - rt.suffix_labels);
+    e_assert_true(rw.suffix_id == rt.suffix_id);
+    e_assert_true(rw.metadata == rt.metadata);
+    e_assert_true(rw.registrable_hash == rt.registrable_hash);
+    e_assert_true(rw.icann == rt.icann);
+    e_assert_true(rw.rule == rt.rule);
+
+    wire_decode(msg, rw.suffix_off, name);
+    e_assert_true(strlen(name) == end - E_MIN(rt.suffix_off, end) && !memcmp(name, domain + rt.suffix_off, strlen(name)));
+    if(rt.registrable_off == len) {
+        e_assert_true(rw.registrable_off == 12 + n && rw.registrable_label == rw.labels);
+        return;
+    }//end if
+    e_assert_true(rw.registrable_label == rw.suffix_label - 1);
+    wire_decode(msg, rw.registrable_off, name);
+    e_assert_true(strlen(name) == end - rt.registrable_off && !memcmp(name, domain + rt.registrable_off, strlen(name)));
+}//end test_wire_same
+
+static inline size_t wire_encode(const char *domain, size_t len, uint8_t *buf) {
+    size_t  i, start, n;
+
+    if(len > 0 && domain[len - 1] == '.') {
+        len--;
+    }//end if
+
+    for(i = start = n = 0 ; len > 0 && i <= len ; i++) {
+        if(i < len && domain[i] != '.') {
+            continue;
+        }//end if
+        if(i == start || i - start > 63) {
+            return 0;
+        }//end if
+        buf[n++] = i - start;
+        memcpy(buf + n, domain + start, i - start);
+        n += i - start;
+        start = i + 1;
+    }//end for
+    buf[n++] = 0;
+
+    return n;
+}//end wire_encode
+
+static inline size_t wire_decode(const uint8_t *msg, size_t off, char *buf) {
+    size_t n;
+
+    for(n = 0 ; msg[off] != 0 ; ) {
+        if(msg[off] >= 0xc0) {
+            off = ((msg[off] & 0x3f) << 8) | msg[off + 1];
+            continue;
+        }//end if
+        if(n > 0) {
+            buf[n++] = '.';
+        }//end if
+        memcpy(buf + n, msg + off + 1, msg[off]);
+        n += msg[off];
+        off += 1 + msg[off];
+    }//end for
+    buf[n] = '\0';
+
+    return n;
+}//end wire_decode
+
+static inline void test_iov(const char *filename) {
+    char                name[E_STRBUF + 1], (*domains)[E_STRBUF];
+    size_t              i, j, n;
+    e_etn_t             *etn;
+    struct iovec        iov[4];
+    e_etn_result_t      rt;
+    e_etn_iov_result_t  r;
+
+    e_assert_true(etn = e_etn_new(filename));
+    e_assert_true(domains = e_malloc(E_ETN_CURSOR_CASES * E_STRBUF));
+    n = cursor_cases(domains, E_ETN_CURSOR_CASES);
+    for(i = 0 ; i < n ; i++) {
+        for(j = 0 ; j < 8 ; j++) {
+            test_iov_same(etn, domains[i], strlen(domains[i]), i * 8 + j);
+        }//end for
+    }//end for
+    e_free(domains);
+
+    /* www.Exa | mple.co | .uk, the suffix starts past the end of the middle segment */
+    iov[0] = (struct iovec){ .iov_base = "www.Exa", .iov_len = 7 };
+    iov[1] = (struct iovec){ .iov_base = "mple.co", .iov_len = 7 };
+    iov[2] = (struct iovec){ .iov_base = ".uk.", .iov_len = 4 };
+    iov[3] = (struct iovec){ .iov_base = NULL, .iov_len = 0 };
+    e_assert_errno(E_OK, e_etn_lookup_iov(etn, iov, 4, &r));
+    e_assert_true(r.len == 18 && r.labels == 4 && r.suffix_labels == 2 && r.icann && r.rule == E_ETN_RULE_NORMAL);
+    e_assert_true(r.suffix_seg == 1 && r.suffix_off == 5);
+    e_assert_true(r.registrable_seg == 0 && r.registrable_off == 4);
+    e_assert_errno(E_OK, e_etn_lookup(etn, "example.co.uk", strlen("example.co.uk"), &rt));
+    e_assert_true(r.registrable_hash == rt.registrable_hash);
+
+    /* a segment that ends with a dot puts the suffix at the start of the next */
+    iov[0] = (struct iovec){ .iov_base = "example.", .iov_len = 8 };
+    iov[1] = (struct iovec){ .iov_base = "com", .iov_len = 3 };
+    e_assert_errno(E_OK, e_etn_lookup_iov(etn, iov, 2, &r));
+    e_assert_true(r.suffix_seg == 1 && r.suffix_off == 0 && r.registrable_seg == 0 && r.registrable_off == 0);
+
+    /* nothing at all */
+    e_assert_errno(E_OK, e_etn_lookup_iov(etn, iov, 0, &r));
+    e_assert_true(r.len == 0 && r.labels == 0 && r.suffix_seg == 0 && r.registrable_seg == 0);
+    iov[0].iov_len = 0;
+    e_assert_errno(E_OK, e_etn_lookup_iov(etn, iov, 1, &r));
+    e_assert_true(r.labels == 0 && r.suffix_seg == 1 && r.registrable_seg == 1);
+
+    /* 255 bytes in all is the most */
+    memset(name, 'a', sizeof(name));
+    iov[0] = (struct iovec){ .iov_base = name, .iov_len = 200 };
+    iov[1] = (struct iovec){ .iov_base = name, .iov_len = 55 };
+    e_assert_errno(E_OK, e_etn_lookup_iov(etn, iov, 2, &r));
+    e_assert_true(r.labels == 1 && r.rule == E_ETN_RULE_DEFAULT && r.suffix_seg == 0 && r.suffix_off == 0);
+    iov[1].iov_len = 56;
+    e_assert_errno(E_ERR_INVAL, e_etn_lookup_iov(etn, iov, 2, &r));
+    iov[1].iov_len = SIZE_MAX;
+    e_assert_errno(E_ERR_INVAL, e_etn_lookup_iov(etn, iov, 2, &r));
+    e_assert_errno(E_ERR_INVAL, e_etn_lookup_iov(etn, iov, -1, &r));
+
+    e_etn_free(etn);
+}//end test_iov
+
+static inline void test_stack(const char *filename) {
+    char            name[E_STRBUF];
+    size_t          i;
+    e_etn_t         *base, *corp, *tenant, *stack, *more;
+    e_etn_layer_t   layers[E_ETN_STACK_MAX];
+    e_etn_result_t  r;
+    const char      *corp_psl =
+        "corp.example.com\n"
+        "*.tenants.example.net\n"
+        "!www.tenants.example.net\n"
+        "co.uk\n"
+        "www.ck\n";
+    struct {
+        const char      *domain;
+        const char      *suffix;
+        bool            icann;
+        e_etn_rule_t    rule;
+    } cases[] = {
+        { "a.b.corp.example.com",           "corp.example.com",             false,  E_ETN_RULE_NORMAL, },
+        { "corp.example.com",               "corp.example.com",             false,  E_ETN_RULE_NORMAL, },
+        { "x.example.com",                  "com",                          true,   E_ETN_RULE_NORMAL, },
+        { "x.t1.tenants.example.net",       "t1.tenants.example.net",       false,  E_ETN_RULE_WILDCARD, },
+        { "a.www.tenants.example.net",      "tenants.example.net",          false,  E_ETN_RULE_EXCEPTION, },
+        /* the same rule in both, the layer has the higher priority */
+        { "www.example.co.uk",              "co.uk",                        false,  E_ETN_RULE_NORMAL, },
+        /* an exception wins over a longer rule */
+        { "a.www.ck",                       "ck",                           true,   E_ETN_RULE_EXCEPTION, },
+        /* a longer rule of the base wins over a layer */
+        { "foo.blogspot.co.uk",             "blogspot.co.uk",               false,  E_ETN_RULE_NORMAL, },
+        { "foo.nosuchtld",                  "nosuchtld",                    false,  E_ETN_RULE_DEFAULT, },
+    };
+
+    e_assert_true(base = e_etn_new(filename));
+    e_assert_true(corp = e_etn_new_from_psl_buffer(corp_psl, strlen(corp_psl)));
+    e_assert_true(tenant = e_etn_new_from_psl_buffer("a.b.corp.example.com\n", strlen("a.b.corp.example.com\n")));
+
+    /* nothing on top, or layers that match none of the cases, is the base */
+    e_assert_true(stack = e_etn_new_stack(base, NULL, 0));
+    test_stack_same(base, stack);
+    e_assert_true(e_etn_get_serial(stack) != e_etn_get_serial(base));
+    e_etn_free(stack);
+    layers[0] = (e_etn_layer_t){ .etn = tenant, .priority = 1, .icann = false };
+    e_assert_true(stack = e_etn_new_stack(base, layers, 1));
+    test_stack_same(base, stack);
+    e_etn_free(stack);
+
+    layers[0] = (e_etn_layer_t){ .etn = corp, .priority = 1, .icann = false };
+    e_assert_true(stack = e_etn_new_stack(base, layers, 1));
+    for(i = 0 ; i < E_N_ELEMENTS(cases) ; i++) {
+        e_assert_errno(E_OK, e_etn_lookup(stack, cases[i].domain, strlen(cases[i].domain), &r));
+        e_assert_true(!strcmp(cases[i].domain + r.suffix_off, cases[i].suffix));
+        e_assert_true(r.icann == cases[i].icann && r.rule == cases[i].rule);
+        test_wire_same(stack, cases[i].domain, strlen(cases[i].domain));
+        test_iov_same(stack, cases[i].domain, strlen(cases[i].domain), i);
+    }//end for
+
+    /* ids of the layer come after those of the base and name its rules */
+    e_assert_errno(E_OK, e_etn_lookup(stack, "a.b.corp.example.com", strlen("a.b.corp.example.com"), &r));
+    e_assert_errno(E_OK, e_etn_suffix_name(stack, r.suffix_id, name, sizeof(name)));
+    e_assert_true(!strcmp(name, "corp.example.com"));
+    e_assert_errno(E_OK, e_etn_lookup(stack, "x.example.com", strlen("x.example.com"), &r));
+    e_assert_errno(E_OK, e_etn_suffix_name(stack, r.suffix_id, name, sizeof(name)));
+    e_assert_true(!strcmp(name, "com"));
+    e_assert_errno(E_OK, e_etn_lookup(stack, "x.t1.tenants.example.net", strlen("x.t1.tenants.example.net"), &r));
+    e_assert_errno(E_OK, e_etn_suffix_name(stack, r.suffix_id, name, sizeof(name)));
+    e_assert_true(!strcmp(name, "tenants.example.net"));
+
+    /* a layer per request on top of a stack, the lower priority loses the tie to the base */
+    layers[0] = (e_etn_layer_t){ .etn = tenant, .priority = -1, .icann = true };
+    layers[1] = (e_etn_layer_t){ .etn = base, .priority = -1, .icann = false };
+    e_assert_true(more = e_etn_new_stack(stack, layers, 2));
+    e_etn_free(stack);
+    e_assert_errno(E_OK, e_etn_lookup(more, "x.a.b.corp.example.com", strlen("x.a.b.corp.example.com"), &r));
+    e_assert_true(r.suffix_off == 2 && r.icann && r.rule == E_ETN_RULE_NORMAL);
+    e_assert_errno(E_OK, e_etn_lookup(more, "www.example.co.uk", strlen("www.example.co.uk"), &r));
+    e_assert_true(r.suffix_off == 12 && !r.icann);
+    e_assert_errno(E_OK, e_etn_lookup(more, "www.example.com", strlen("www.example.com"), &r));
+    e_assert_true(r.suffix_off == 12 && r.icann);
+    e_assert_errno(E_OK, e_etn_suffix_name(more, r.suffix_id, name, sizeof(name)));
+    e_assert_true(!strcmp(name, "com"));
+
+    /* a stack as a layer, too many tables */
+    layers[0] = (e_etn_layer_t){ .etn = more, .priority = 0, .icann = false };
+    e_assert_false(e_etn_new_stack(base, layers, 1));
+    for(i = 0 ; i < E_N_ELEMENTS(layers) ; i++) {
+        layers[i] = (e_etn_layer_t){ .etn = tenant, .priority = 0, .icann = false };
+    }//end for
+    e_assert_false(e_etn_new_stack(base, layers, E_ETN_STACK_MAX));
+    e_assert_true(stack = e_etn_new_stack(base, layers, E_ETN_STACK_MAX - 1));
+    e_assert_false(e_etn_new_stack(stack, layers, 1));
+    e_etn_free(stack);
+
+    e_assert_errno(E_ERR_NOTSUP, e_etn_set_engine(more, E_ETN_ENGINE_DFA));
+    e_assert_errno(E_ERR_NOTSUP, e_etn_save(more, "stack.dat", E_ETN_FORMAT_WIDE));
+
+    /* the stack holds its tables */
+    e_etn_free(base);
+    e_etn_free(corp);
+    e_etn_free(tenant);
+    e_assert_errno(E_OK, e_etn_lookup(more, "a.b.corp.example.com", strlen("a.b.corp.example.com"), &r));
+    e_assert_true(r.suffix_off == 0);
+    e_etn_free(more);
+}//end test_stack
+
+static inline void test_metadata(const char *filename) {
+    size_t          i, j;
+    uint64_t        serial;
+    e_etn_t         *etn, *saved, *mapped, *layer, *stack;
+    e_etn_layer_t   l;
+    e_etn_cache_t   *cache;
+    e_etn_result_t  r;
+    e_etn_format_t  formats[] = { E_ETN_FORMAT_V1, E_ETN_FORMAT_V2, E_ETN_FORMAT_WIDE };
+    const char      *files[] = { SAVED_FILE, SAVED_FILE_V2, SAVED_FILE_WIDE };
+    struct {
+        const char  *domain;
+        uint32_t    metadata;
+    } cases[] = {
+        { "www.example.com",        1, },
+        { "com",                    1, },
+        { "WWW.EXAMPLE.CO.UK.",     2, },
+        { "example.uk",             0, },
+        /* a wildcard and an exception under it both give the node above */
+        { "a.b.c.kobe.jp",          3, },
+        { "www.city.kobe.jp",       3, },
+        { "x.www.ck",               4, },
+        { "foo.nosuchtld",          0, },
+    };
+
+    e_assert_true(etn = e_etn_new(filename));
+    for(i = 0 ; i < E_N_ELEMENTS(cases) ; i++) {
+        e_assert_errno(E_OK, e_etn_lookup(etn, cases[i].domain, strlen(cases[i].domain), &r));
+        e_assert_true(r.metadata == 0);
+    }//end for
+
+    serial = e_etn_get_serial(etn);
+    e_assert_errno(E_OK, e_etn_set_metadata(etn, "com", 3, 1));
+    e_assert_errno(E_OK, e_etn_set_metadata(etn, "Co.UK", 5, 2));
+    e_assert_errno(E_OK, e_etn_set_metadata(etn, "kobe.jp.", 8, 3));
+    e_assert_errno(E_OK, e_etn_set_metadata(etn, "ck", 2, 5));
+    e_assert_errno(E_OK, e_etn_set_metadata(etn, "ck", 2, 4));
+    e_assert_true(e_etn_get_serial(etn) != serial);
+    e_assert_errno(E_ERR_NOFOUND, e_etn_set_metadata(etn, "example.com", 11, 1));
+    e_assert_errno(E_ERR_NOFOUND, e_etn_set_metadata(etn, "nosuchtld", 9, 1));
+    e_assert_errno(E_ERR_NOFOUND, e_etn_set_metadata(etn, "a..com", 6, 1));
+    e_assert_errno(E_ERR_NOFOUND, e_etn_set_metadata(etn, ".", 1, 1));
+    e_assert_errno(E_ERR_NOFOUND, e_etn_set_metadata(etn, "", 0, 1));
+
+    /* every way to look up carries the word, and every format keeps it */
+    e_assert_true(cache = e_etn_cache_new(64 * 1024));
+    for(i = 0 ; i < E_N_ELEMENTS(cases) ; i++) {
+        e_assert_errno(E_OK, e_etn_lookup(etn, cases[i].domain, strlen(cases[i].domain), &r));
+        e_assert_true(r.metadata == cases[i].metadata);
+        for(j = 0 ; j < 2 ; j++) {
+            e_assert_errno(E_OK, e_etn_cache_lookup(cache, etn, cases[i].domain, strlen(cases[i].domain), &r));
+            e_assert_true(r.metadata == cases[i].metadata);
+        }//end for
+        test_wire_same(etn, cases[i].domain, strlen(cases[i].domain));
+        test_iov_same(etn, cases[i].domain, strlen(cases[i].domain), i);
+    }//end for
+    e_etn_cache_free(cache);
+
+    for(i = 0 ; i < E_N_ELEMENTS(formats) ; i++) {
+        e_assert_errno(E_OK, e_etn_save(etn, files[i], formats[i]));
+        e_assert_true(saved = e_etn_new(files[i]));
+        test_engine_cases(etn, saved);
+        e_etn_free(saved);
+    }//end for
+
+    /* a mapped table copies its words before it changes one, the file stays as it was */
+    e_assert_true(mapped = e_etn_new_mmap(SAVED_FILE_V2));
+    e_assert_errno(E_OK, e_etn_set_metadata(mapped, "uk", 2, 6));
+    e_assert_errno(E_OK, e_etn_lookup(mapped, "example.uk", 10, &r));
+    e_assert_true(r.metadata == 6);
+    e_assert_errno(E_OK, e_etn_lookup(mapped, "example.com", 11, &r));
+    e_assert_true(r.metadata == 1);
+    e_assert_true(saved = e_etn_new_mmap(SAVED_FILE_V2));
+    test_engine_cases(etn, saved);
+    e_etn_free(saved);
+    e_etn_free(mapped);
+
+    /* files without the words are still read, a stack takes the words of the table that decided */
+    e_assert_true(layer = e_etn_new_from_psl_buffer("corp.example.com\n", 17));
+    e_assert_errno(E_OK, e_etn_set_metadata(layer, "corp.example.com", 16, 7));
+    e_assert_errno(E_OK, e_etn_save(layer, SAVED_FILE, E_ETN_FORMAT_V1));
+    e_etn_free(layer);
+    e_assert_true(layer = e_etn_new(SAVED_FILE));
+    l = (e_etn_layer_t){ .etn = layer, .priority = 1, .icann = false };
+    e_assert_true(stack = e_etn_new_stack(etn, &l, 1));
+    e_assert_errno(E_OK, e_etn_lookup(stack, "a.corp.example.com", 18, &r));
+    e_assert_true(r.metadata == 7);
+    e_assert_errno(E_OK, e_etn_lookup(stack, "a.example.com", 13, &r));
+    e_assert_true(r.metadata == 1);
+    test_wire_same(stack, "a.corp.example.com", 18);
+    test_iov_same(stack, "a.corp.example.com", 18, 0);
+    e_assert_errno(E_ERR_NOTSUP, e_etn_set_metadata(stack, "com", 3, 1));
+    e_etn_free(stack);
+    e_etn_free(layer);
+
+    e_etn_free(etn);
+}//end test_metadata
+
+static inline void test_stack_same(e_etn_t *base, e_etn_t *stack) {
+    char            buf[E_STRBUF], (*domains)[E_STRBUF];
+    bool            icann, icanns[64];
+    size_t          i, n, len, off, lens[64], offs[64];
+    const char      *batch[64];
+
+    test_engine_cases(base, stack);
+    for(i = 0 ; i < 10000 ; i++) {
+        len = random_domain(buf, i);
+        test_engine_same(base, stack, buf, len);
+    }//end for
+
+    /* every other way to look up gives what e_etn_lookup() on the stack does */
+    e_assert_true(domains = e_malloc(E_ETN_CURSOR_CASES * E_STRBUF));
+    n = cursor_cases(domains, E_ETN_CURSOR_CASES);
+    test_cursor_same(stack, domains, n, true);
+    for(i = 0 ; i < n ; i++) {
+        test_wire_same(stack, domains[i], strlen(domains[i]));
+        test_iov_same(stack, domains[i], strlen(domains[i]), i);
+    }//end for
+    for(i = 0 ; i < E_N_ELEMENTS(batch) ; i++) {
+        batch[i] = domains[i];
+        lens[i] = strlen(domains[i]);
+    }//end for
+    e_assert_errno(E_OK, e_etn_public_suffix_batch(stack, batch, lens, E_N_ELEMENTS(batch), offs, icanns));
+    for(i = 0 ; i < E_N_ELEMENTS(batch) ; i++) {
+        e_assert_errno(E_OK, e_etn_public_suffix_len(base, batch[i], lens[i], &off, &icann));
+        e_assert_true(offs[i] == off && icanns[i] == icann);
+    }//end for
+    e_free(domains);
+}//end test_stack_same
+
+static inline void test_same_site(const char *filename) {
+    size_t          i;
+    e_etn_t         *etn, *corp, *stack;
+    e_etn_layer_t   layer;
+    struct {
+        const char  *a;
+        const char  *b;
+        bool        same;
+    } cases[] = {
+        { "www.example.com",    "example.com",      true, },
+        { "a.example.com",      "b.example.com",    true, },
+        { "WWW.Example.COM.",   "example.com",      true, },
+        { "example.com",        "example.net",      false, },
+        { "example.com",        "ample.com",        false, },
+        { "com",                "com",              true, },
+        { "com",                "x.com",            false, },
+        { "a.blogspot.com",     "b.blogspot.com",   false, },
+        { "a.b.blogspot.com",   "c.b.blogspot.com", true, },
+        { "foo.kobe.jp",        "bar.kobe.jp",      false, },
+        { "www.city.kobe.jp",   "city.kobe.jp",     true, },
+        { "a.ck",               "b.ck",             false, },
+        { "a.www.ck",           "www.ck",           true, },
+        { "x.nosuchtld",        "y.x.nosuchtld",    true, },
+    };
+
+    e_assert_true(etn = e_etn_new(filename));
+    for(i = 0 ; i < E_N_ELEMENTS(cases) ; i++) {
+        e_assert_true(e_etn_same_site(etn, cases[i].a, strlen(cases[i].a), cases[i].b, strlen(cases[i].b)) == cases[i].same);
+        e_assert_true(e_etn_same_site(etn, cases[i].b, strlen(cases[i].b), cases[i].a, strlen(cases[i].a)) == cases[i].same);
+    }//end for
+    test_same_site_same(etn);
+
+    /* a layer splits a site of the base in two */
+    e_assert_true(corp = e_etn_new_from_psl_buffer("corp.example.com\n", strlen("corp.example.com\n")));
+    layer = (e_etn_layer_t){ .etn = corp, .priority = 1, .icann = false };
+    e_assert_true(stack = e_etn_new_stack(etn, &layer, 1));
+    e_assert_true(e_etn_same_site(etn, "a.corp.example.com", strlen("a.corp.example.com"), "b.corp.example.com", strlen("b.corp.example.com")));
+    e_assert_true(!e_etn_same_site(stack, "a.corp.example.com", strlen("a.corp.example.com"), "b.corp.example.com", strlen("b.corp.example.com")));
+    e_assert_true(e_etn_same_site(stack, "a.corp.example.com", strlen("a.corp.example.com"), "x.a.corp.example.com", strlen("x.a.corp.example.com")));
+    e_assert_true(!e_etn_same_site(stack, "corp.example.com", strlen("corp.example.com"), "www.example.com", strlen("www.example.com")));
+    test_same_site_same(stack);
+    e_etn_free(stack);
+    e_etn_free(corp);
+
+    e_etn_free(etn);
+}//end test_same_site
+
+/* pairs of neighbours, of a name and its parents and of random names give what two lookups do */
+static inline void test_same_site_same(e_etn_t *etn) {
+    char        (*domains)[E_STRBUF];
+    size_t      i, j, n, len;
+    uint64_t    x;
+    const char  *dot;
+
+    e_assert_true(domains = e_malloc(E_ETN_CURSOR_CASES * E_STRBUF));
+    n = cursor_cases(domains, E_ETN_CURSOR_CASES);
+    qsort(domains, n, E_STRBUF, cursor_cmp);
+    for(i = 0, x = 1 ; i < n ; i++, x = x * 6364136223846793005ULL + 1442695040888963407ULL) {
+        len = strlen(domains[i]);
+        for(j = i ; j < n && j < i + 4 ; j++) {
+            e_assert_true(e_etn_same_site(etn, domains[i], len, domains[j], strlen(domains[j])) ==
+                same_site(etn, domains[i], len, domains[j], strlen(domains[j])));
+        }//end for
+        for(dot = memchr(domains[i], '.', len) ; dot ; dot = memchr(dot + 1, '.', len - (dot + 1 - domains[i]))) {
+            e_assert_true(e_etn_same_site(etn, domains[i], len, dot + 1, len - (dot + 1 - domains[i])) ==
+                same_site(etn, domains[i], len, dot + 1, len - (dot + 1 - domains[i])));
+        }//end for
+        j = (x >> 33) % n;
+        e_assert_true(e_etn_same_site(etn, domains[i], len, domains[j], strlen(domains[j])) ==
+            same_site(etn, domains[i], len, domains[j], strlen(domains[j])));
+    }//end for
+    e_free(domains);
+}//end test_same_site_same
+
+/* the same eTLD+1, or the same host if either has none, by two lookups */
+static inline bool same_site(e_etn_t *etn, const char *a, size_t a_len, const char *b, size_t b_len) {
+    e_etn_result_t  ra, rb;
+
+    if(a_len > 0 && a[a_len - 1] == '.') {
+        a_len--;
+    }//end if
+    if(b_len > 0 && b[b_len - 1] == '.') {
+        b_len--;
+    }//end if
+    e_assert_errno(E_OK, e_etn_lookup(etn, a, a_len, &ra));
+    e_assert_errno(E_OK, e_etn_lookup(etn, b, b_len, &rb));
+    if(ra.registrable_off == a_len || rb.registrable_off == b_len) {
+        ra.registrable_off = rb.registrable_off = 0;
+    }//end if
+
+    return a_len - ra.registrable_off == b_len - rb.registrable_off &&
+        !strncasecmp(a + ra.registrable_off, b + rb.registrable_off, a_len - ra.registrable_off);
+}//end same_site
+
+static inline void test_cookie_domain(const char *filename) {
+    char            (*domains)[E_STRBUF];
+    size_t          i, n, len;
+    e_etn_t         *etn;
+    e_etn_result_t  r;
+    const char      *dot;
+    struct {
+        const char  *host;
+        const char  *domain;
+        bool        allowed;
+    } cases[] = {
+        { "www.example.com",    "example.com",      true, },
+        { "www.example.com",    ".example.com",     true, },
+        { "www.example.com",    "www.example.com",  true, },
+        { "www.Example.COM.",   "EXAMPLE.com",      true, },
+        { "www.example.com",    "com",              false, },
+        { "www.example.com",    ".com",             false, },
+        { "www.example.com",    "ample.com",        false, },
+        { "www.example.com",    "",                 false, },
+        { "www.example.com",    ".",                false, },
+        { "example.com",        "www.example.com",  false, },
+        { "com",                "com",              true, },
+        { "blogspot.com",       "blogspot.com",     true, },
+        { "a.b.blogspot.com",   "blogspot.com",     false, },
+        { "a.b.blogspot.com",   "b.blogspot.com",   true, },
+        { "foo.bar.ck",         "bar.ck",           false, },
+        { "a.www.ck",           "www.ck",           true, },
+        { "1.2.3.4",            "2.3.4",            false, },
+        { "1.2.3.4",            "1.2.3.4",          true, },
+        { "a.0x7f",             "0x7f",             false, },
+        { "a.b.0x7g",           "b.0x7g",           true, },
+        { "fe80::1.example.com","example.com",      false, },
+    };
+
+    e_assert_true(etn = e_etn_new(filename));
+    for(i = 0 ; i < E_N_ELEMENTS(cases) ; i++) {
+        e_assert_true(e_etn_cookie_domain_allowed(etn, cases[i].host, strlen(cases[i].host),
+            cases[i].domain, strlen(cases[i].domain)) == cases[i].allowed);
+    }//end for
+
+    /* a parent of the host is allowed unless it is a public suffix */
+    e_assert_true(domains = e_malloc(E_ETN_CURSOR_CASES * E_STRBUF));
+    n = cursor_cases(domains, E_ETN_CURSOR_CASES);
+    for(i = 0 ; i < n ; i++) {
+        len = strlen(domains[i]);
+        if(len == 0 || domains[i][0] == '.' || domains[i][len - 1] == '.' || strchr(domains[i], ':')) {
+            continue;
+        }//end if
+        for(dot = memchr(domains[i], '.', len) ; dot ; dot = memchr(dot + 1, '.', len - (dot + 1 - domains[i]))) {
+            if(dot + 1 == domains[i] + len || dot[1] == '.') {
+                break;
+            }//end if
+            e_assert_errno(E_OK, e_etn_lookup(etn, dot + 1, len - (dot + 1 - domains[i]), &r));
+            e_assert_true(e_etn_cookie_domain_allowed(etn, domains[i], len, dot + 1, len - (dot + 1 - domains[i])) == (r.suffix_off != 0));
+        }//end for
+        e_assert_true(e_etn_cookie_domain_allowed(etn, domains[i], len, domains[i], len));
+    }//end for
+    e_free(domains);
+
+    e_etn_free(etn);
+}//end test_cookie_domain
+
+static inline void test_levels(const char *filename) {
+    char            buf[E_STRBUF], (*domains)[E_STRBUF];
+    size_t          i, n;
+    e_etn_t         *etn, *corp, *stack;
+    e_etn_layer_t   layer;
+    e_etn_level_t   levels[E_STRBUF];
+    e_etn_result_t  r;
+    const char      *domain = "a.B.example.co.uk.";
+    struct {
+        const char          *name;
+        uint32_t            suffix_labels;
+        e_etn_level_kind_t  kind;
+    } want[] = {
+        { "uk.",                1,  E_ETN_LEVEL_SUFFIX, },
+        { "co.uk.",             2,  E_ETN_LEVEL_SUFFIX, },
+        { "example.co.uk.",     2,  E_ETN_LEVEL_REGISTRABLE, },
+        { "B.example.co.uk.",   2,  E_ETN_LEVEL_DEEPER, },
+        { "a.B.example.co.uk.", 2,  E_ETN_LEVEL_DEEPER, },
+    };
+
+    e_assert_true(etn = e_etn_new(filename));
+    e_assert_errno(E_OK, e_etn_set_metadata(etn, "co.uk", strlen("co.uk"), 7));
+    e_assert_errno(E_OK, e_etn_lookup_levels(etn, domain, strlen(domain), &r, levels, E_N_ELEMENTS(levels), &n));
+    e_assert_true(n == E_N_ELEMENTS(want));
+    for(i = 0 ; i < n ; i++) {
+        e_assert_true(!strcmp(domain + levels[i].off, want[i].name));
+        e_assert_true(levels[i].labels == i + 1);
+        e_assert_true(levels[i].suffix_labels == want[i].suffix_labels);
+        e_assert_true(levels[i].kind == want[i].kind);
+        e_assert_true(levels[i].metadata == (i > 0 ? 7 : 0));
+    }//end for
+    e_assert_errno(E_ERR_NOBUFS, e_etn_lookup_levels(etn, domain, strlen(domain), &r, levels, 4, &n));
+    e_assert_errno(E_OK, e_etn_lookup_levels(etn, "", 0, &r, levels, 0, &n));
+    e_assert_true(n == 0);
+    memset(buf, 'x', sizeof(buf));
+    e_assert_errno(E_ERR_INVAL, e_etn_lookup_levels(etn, buf, 256, &r, levels, E_N_ELEMENTS(levels), &n));
+
+    /* every level is what a lookup of it gives, on a table and on a stack */
+    e_assert_true(corp = e_etn_new_from_psl_buffer("corp.example.com\n*.t.example.net\n", strlen("corp.example.com\n*.t.example.net\n")));
+    layer = (e_etn_layer_t){ .etn = corp, .priority = 1, .icann = false };
+    e_assert_true(stack = e_etn_new_stack(etn, &layer, 1));
+    e_assert_true(domains = e_malloc(E_ETN_CURSOR_CASES * E_STRBUF));
+    n = cursor_cases(domains, E_ETN_CURSOR_CASES);
+    for(i = 0 ; i < n ; i++) {
+        test_levels_same(etn, domains[i], strlen(domains[i]));
+        test_levels_same(stack, domains[i], strlen(domains[i]));
+    }//end for
+    test_levels_same(stack, "a.b.corp.example.com", strlen("a.b.corp.example.com"));
+    test_levels_same(stack, "a.b.t.example.net.", strlen("a.b.t.example.net."));
+    e_free(domains);
+    e_etn_free(stack);
+    e_etn_free(corp);
+
+    e_etn_free(etn);
+}//end test_levels
+
+static inline void test_levels_same(e_etn_t *etn, const char *domain, size_t len) {
+    size_t          i, n;
+    e_etn_level_t   levels[E_STRBUF];
+    e_etn_result_t  ra, rb;
+
+    e_assert_errno(E_OK, e_etn_lookup_levels(etn, domain, len, &ra, levels, E_N_ELEMENTS(levels), &n));
+    e_assert_errno(E_OK, e_etn_lookup(etn, domain, len, &rb));
+    e_assert_true(ra.suffix_off == rb.suffix_off);
+    e_assert_true(ra.registrable_off == rb.registrable_off);
+    e_assert_true(ra.subdomain_len == rb.subdomain_len);
+    e_assert_true(ra.labels == rb.labels);
+    e_assert_true(ra.suffix_labels == rb.suffix_labels);
+    e_assert_true(ra.suffix_id == rb.suffix_id);
+    e_assert_true(ra.metadata == rb.metadata);
+    e_assert_true(ra.registrable_hash == rb.registrable_hash);
+    e_assert_true(ra.icann == rb.icann);
+    e_assert_true(ra.rule == rb.rule);
+    e_assert_true(n == ra.labels);
+
+    for(i = 0 ; i < n ; i++) {
+        e_assert_true(levels[i].labels == i + 1);
+        e_assert_true(i + 1 == n ? levels[i].off == 0 : domain[levels[i].off - 1] == '.');
+        if(levels[i].off >= ra.suffix_off) {
+            e_assert_true(levels[i].kind == E_ETN_LEVEL_SUFFIX);
+        }//end if
+        else {
+            e_assert_true(levels[i].kind == (levels[i].off == ra.registrable_off ? E_ETN_LEVEL_REGISTRABLE : E_ETN_LEVEL_DEEPER));
+        }//end else
+        if(levels[i].off == len || domain[levels[i].off] == '.') {
+            /* an empty label at the right is a root dot to e_etn_lookup() */
+            continue;
+        }//end if
+        e_assert_errno(E_OK, e_etn_lookup(etn, domain + levels[i].off, len - levels[i].off, &rb));
+        e_assert_true(levels[i].suffix_labels == rb.suffix_labels);
+        e_assert_true(levels[i].suffix_id == rb.suffix_id);
+        e_assert_true(levels[i].metadata == rb.metadata);
+        e_assert_true(levels[i].icann == rb.icann);
+        e_assert_true(levels[i].rule == rb.rule);
+    }//end for
+}//end test_levels_same
+
+static inline void test_iov_same(e_etn_t *etn, const char *domain, size_t len, size_t seed) {
+    int                 n;
+    size_t              i, j, cut, cuts[3];
+    uint64_t            x;
+    struct iovec        iov[7];
+    e_etn_result_t      rt;
+    e_etn_iov_result_t  ri;
+
+    /* up to three cuts anywhere, two of them at the same place leave an empty segment */
+    x = (seed + 1) * 0x9e3779b97f4a7c15ULL;
+    for(i = 0 ; i < E_N_ELEMENTS(cuts) ; i++, x = x * 6364136223846793005ULL + 1442695040888963407ULL) {
+        cuts[i] = len == 0 ? 0 : (x >> 33) % (len + 1);
+    }//end for
+    for(i = 1 ; i < E_N_ELEMENTS(cuts) ; i++) {
+        for(cut = cuts[i], j = i ; j > 0 && cuts[j - 1] > cut ; j--) {
+            cuts[j] = cuts[j - 1];
+        }//end for
+        cuts[j] = cut;
+    }//end for
+
+    n = 0;
+    for(i = 0, cut = 0 ; i <= E_N_ELEMENTS(cuts) ; i++) {
+        iov[n].iov_base = (char *)domain + cut;
+        iov[n].iov_len = (i < E_N_ELEMENTS(cuts) ? cuts[i] : len) - cut;
+        cut += iov[n++].iov_len;
+    }//end for
+    n = (int)(seed % 4) + 1;
+    if(n < 4) {
+        /* fewer segments, the last one takes the rest */
+        iov[n - 1].iov_len = len - (size_t)((char *)iov[n - 1].iov_base - domain);
+    }//end if
+
+    e_assert_errno(E_OK, e_etn_lookup(etn, domain, len, &rt));
+    e_assert_errno(E_OK, e_etn_lookup_iov(etn, iov, n, &ri));
+    e_assert_true(ri.len == len);
+    e_assert_true(iov_flat(iov, ri.suffix_seg, ri.suffix_off) == rt.suffix_off);
+    e_assert_true(iov_flat(iov, ri.registrable_seg, ri.registrable_off) == rt.registrable_off);
+    e_assert_true(ri.suffix_seg == n || ri.suffix_off < iov[ri.suffix_seg].iov_len);
+    e_assert_true(ri.registrable_seg == n || ri.registrable_off < iov[ri.registrable_seg].iov_len);
+    e_assert_true(ri.labels == rt.labels);
+    e_assert_true(ri.suffix_labels == rt.suffix_labels);
+    e_assert_true(ri.suffix_id == rt.suffix_id);
+    e_assert_true(ri.metadata == rt.metadata);
+    e_assert_true(ri.registrable_hash == rt.registrable_hash);
+    e_assert_true(ri.icann == rt.icann);
+    e_assert_true(ri.rule == rt.rule);
+}//end test_iov_same
+
+static inline size_t iov_flat(const struct iovec *iov, int seg, size_t off) {
+    int i;
+
+    for(i = 0 ; i < seg ; i++) {
+        off += iov[i].iov_len;
+    }//end for
+
+    return off;
+}//end iov_flat
+
+static inline void test_cursor_same(e_etn_t *etn, char (*domains)[E_STRBUF], size_t n, bool sorted) {
+    size_t          i, len;
+    e_etn_cursor_t  *cursor;
+    e_etn_result_t  ra, rb;
+
+    e_assert_true(cursor = e_etn_cursor_new(etn, sorted));
+    for(i = 0 ; i < n ; i++) {
+        len = strlen(domains[i]);
+        e_assert_errno(E_OK, e_etn_lookup(etn, domains[i], len, &ra));
+        e_assert_errno(E_OK, e_etn_cursor_lookup(cursor, domains[i], len, &rb));
+        e_assert_true(ra.suffix_off == rb.suffix_off);
+        e_assert_true(ra.registrable_off == rb.registrable_off);
+        e_assert_true(ra.subdomain_len == rb.subdomain_len);
+        e_assert_true(ra.labels == rb.labels);
+        e_assert_true(ra.suffix_labels == rb.suffix_labels);
+        e_assert_true(ra.suffix_id == rb.suffix_id);
+        e_assert_true(ra.metadata == rb.metadata);
+        e_assert_true(ra.registrable_hash == rb.registrable_hash);
+        e_assert_true(ra.icann == rb.icann);
+        e_assert_true(ra.rule == rb.rule);
+    }//end for
+    e_etn_cursor_free(cursor);
+}//end test_cursor_same
+
+static inline size_t cursor_cases(char (*domains)[E_STRBUF], size_t max) {
+    size_t      i, j, k, n, len;
+    const char  *domain, *tail;
+    const char  *prefixes[] = {
+        "", "a.", "WWW.", "www.", "city.", "k12.", "com.", "co.", "blogspot.", "blogspo.", "*.", "!www.",
+    };
+    const char  *odd[] = {
+        "", ".", "..", ".com", "com.", "..com", "a..com", "a.b..co.uk", ".kobe.jp", "a..kobe.jp",
+        "x.city.kobe.jp", "ck", ".ck", "www..ck", "COM", "EXAMPLE.CO.UK.", "a_b.com", "a\xff.com", "\xff",
+    };
+
+    /* every tail of every test domain with a few labels in front, and each cut short */
+    n = 0;
+    for(i = 0 ; i < E_N_ELEMENTS(public_suffix_cases) + E_N_ELEMENTS(eTLD_plus_one_cases) ; i++) {
+        if(i < E_N_ELEMENTS(public_suffix_cases)) {
+            domain = public_suffix_cases[i].domain;
+        }//end if
+        else {
+            domain = eTLD_plus_one_cases[i - E_N_ELEMENTS(public_suffix_cases)].domain;
+        }//end else
+
+        for(tail = domain ; tail ; tail = strchr(tail, '.') ? strchr(tail, '.') + 1 : NULL) {
+            for(j = 0 ; j < E_N_ELEMENTS(prefixes) ; j++) {
+                len = snprintf(domains[n], E_STRBUF, "%s%s", prefixes[j], tail);
+                for(k = 1, n++ ; k < len && domains[n - 1][len - k] != '.' && n < max ; k++, n++) {
+                    memcpy(domains[n], domains[n - 1], len - k);
+                    domains[n][len - k] = '\0';
+                }//end for
+                e_assert_true(n + E_N_ELEMENTS(odd) < max);
+            }//end for
+        }//end for
+    }//end for
+
+    for(i = 0 ; i < E_N_ELEMENTS(odd) ; i++, n++) {
+        snprintf(domains[n], E_STRBUF, "%s", odd[i]);
+    }//end for
+
+    return n;
+}//end cursor_cases
+
+/* names as scanners and generated domains query them, a random label under a suffix with many children */
+static inline size_t random_domain(char *buf, size_t i) {
+    size_t      j, len;
+    uint64_t    x;
+    const char  *suffixes[] = { "com", "jp", "co.uk", "no", "it", "us", "ck", "github.io", "blogspot.com" };
+
+    x = (i + 1) * 0x9e3779b97f4a7c15ULL;
+    len = 3 + (x >> 60);
+    for(j = 0 ; j < len ; j++, x = x * 6364136223846793005ULL + 1442695040888963407ULL) {
+        buf[j] = "abcdefghijklmnopqrstuvwxyz0123456789"[(x >> 33) % 36];
+    }//end for
+
+    return len + snprintf(buf + len, E_STRBUF - len, ".%s", suffixes[i % E_N_ELEMENTS(suffixes)]);
+}//end random_domain
+
+/* labels read right to left, as the children of a node are sorted */
+static inline int cursor_cmp(const void *a, const void *b) {
+    int         c;
+    size_t      i, j, si, sj, k;
+    const char  *x, *y;
+
+    x = a;
+    y = b;
+    i = strlen(x);
+    j = strlen(y);
+    while(true) {
+        for(si = i ; si > 0 && x[si - 1] != '.' ; si--);
+        for(sj = j ; sj > 0 && y[sj - 1] != '.' ; sj--);
+        for(k = 0 ; si + k < i && sj + k < j ; k++) {
+            c = (uint8_t)e_ascii_tolower(x[si + k]) - (uint8_t)e_ascii_tolower(y[sj + k]);
+            if(c != 0) {
+                return c;
+            }//end if
+        }//end for
+        if(i - si != j - sj) {
+            return i - si < j - sj ? -1 : 1;
+        }//end if
+        if(si == 0 || sj == 0) {
+            return (sj == 0) - (si == 0);
+        }//end if
+        i = si - 1;
+        j = sj - 1;
+    }//end while
+}//end cursor_cmp
+
+static inline void benchmark(const char *filename) {
+    bool                icann, icanns[E_N_ELEMENTS(public_suffix_cases)];
+    char                (*sorted)[E_STRBUF];
+    size_t              i, j, k, same, off, lens[E_N_ELEMENTS(public_suffix_cases)], offs[E_N_ELEMENTS(public_suffix_cases)];
+    static size_t       sorted_lens[E_ETN_CURSOR_CASES], random_lens[4096];
+    static char         random_domains[4096][E_STRBUF];
+    static uint8_t      wire[E_N_ELEMENTS(public_suffix_cases)][E_STRBUF];
+    size_t              wire_lens[E_N_ELEMENTS(public_suffix_cases)];
+    e_etn_wire_result_t wire_result;
+    struct iovec        iovs[E_N_ELEMENTS(public_suffix_cases)][2];
+    e_etn_iov_result_t  iov_result;
+    double              spent;
+    e_etn_t             *etn, *overlay, *stack;
+    e_etn_layer_t       layer;
+    e_etn_cursor_t      *cursor;
+    e_etn_result_t      result;
+    e_etn_level_t       levels[E_STRBUF];
+    e_timer_t           *timer;
+    uint8_t             *junk;
+    const char          *ps, *eTLD, *domains[E_N_ELEMENTS(public_suffix_cases)];
+
     e_assert_true(etn = e_etn_new(filename));
 
     e_assert_true(timer = e_timer_new());
@@ -402,6 +2002,90 @@ static inline void benchmark(const char *filename) {
     printf("Get public suffix %"PRIuSIZE" times, spent %f seconds\n",
         10000 * E_N_ELEMENTS(public_suffix_cases), spent);
 
+    for(j = 0 ; j < E_N_ELEMENTS(public_suffix_cases) ; j++) {
+        lens[j] = strlen(public_suffix_cases[j].domain);
+    }//end for
+    e_timer_reset(timer);
+    for(i = 0 ; i < 10000 ; i++) {
+        for(j = 0 ; j < E_N_ELEMENTS(public_suffix_cases) ; j++) {
+            e_assert_errno(E_OK, e_etn_public_suffix_len(etn, public_suffix_cases[j].domain, lens[j], &off, &icann));
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Get public suffix by length %"PRIuSIZE" times, spent %f seconds\n",
+        10000 * E_N_ELEMENTS(public_suffix_cases), spent);
+
+    /* a stack for every round, as a request would make one */
+    e_assert_true(overlay = e_etn_new_from_psl_buffer("corp.example.com\n*.tenants.example.net\n", 39));
+    layer = (e_etn_layer_t){ .etn = overlay, .priority = 1, .icann = false };
+    e_timer_reset(timer);
+    for(i = 0 ; i < 10000 ; i++) {
+        e_assert_true(stack = e_etn_new_stack(etn, &layer, 1));
+        for(j = 0 ; j < E_N_ELEMENTS(public_suffix_cases) ; j++) {
+            e_assert_errno(E_OK, e_etn_public_suffix_len(stack, public_suffix_cases[j].domain, lens[j], &off, &icann));
+        }//end for
+        e_etn_free(stack);
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Get public suffix by length with an overlay %"PRIuSIZE" times, spent %f seconds\n",
+        10000 * E_N_ELEMENTS(public_suffix_cases), spent);
+    e_etn_free(overlay);
+
+    e_assert_errno(E_OK, e_etn_set_engine(etn, E_ETN_ENGINE_INLINE));
+    e_timer_reset(timer);
+    for(i = 0 ; i < 10000 ; i++) {
+        for(j = 0 ; j < E_N_ELEMENTS(public_suffix_cases) ; j++) {
+            e_assert_errno(E_OK, e_etn_public_suffix_len(etn, public_suffix_cases[j].domain, lens[j], &off, &icann));
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Get public suffix by length with the inline engine %"PRIuSIZE" times, spent %f seconds\n",
+        10000 * E_N_ELEMENTS(public_suffix_cases), spent);
+
+    e_assert_errno(E_OK, e_etn_set_engine(etn, E_ETN_ENGINE_DFA));
+    e_timer_reset(timer);
+    for(i = 0 ; i < 10000 ; i++) {
+        for(j = 0 ; j < E_N_ELEMENTS(public_suffix_cases) ; j++) {
+            e_assert_errno(E_OK, e_etn_public_suffix_len(etn, public_suffix_cases[j].domain, lens[j], &off, &icann));
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Get public suffix by length with the DFA engine %"PRIuSIZE" times, spent %f seconds\n",
+        10000 * E_N_ELEMENTS(public_suffix_cases), spent);
+    e_assert_errno(E_OK, e_etn_set_engine(etn, E_ETN_ENGINE_SEARCH));
+
+    for(j = 0 ; j < E_N_ELEMENTS(public_suffix_cases) ; j++) {
+        domains[j] = public_suffix_cases[j].domain;
+    }//end for
+
+    /* the same with the tables evicted from the cache before every round */
+    e_assert_true(junk = e_malloc(E_ETN_JUNK_SIZE));
+    e_assert_errno(E_OK, e_timer_start(timer));
+    e_assert_errno(E_OK, e_timer_stop(timer));
+    for(i = 0 ; i < 1000 ; i++) {
+        memset(junk, (int)i, E_ETN_JUNK_SIZE);
+        e_assert_errno(E_OK, e_timer_continue(timer));
+        for(j = 0 ; j < E_N_ELEMENTS(public_suffix_cases) ; j++) {
+            e_assert_errno(E_OK, e_etn_public_suffix_len(etn, domains[j], lens[j], &offs[j], &icanns[j]));
+        }//end for
+        e_assert_errno(E_OK, e_timer_stop(timer));
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Get public suffix by length %"PRIuSIZE" times with cold cache, spent %f seconds\n",
+        1000 * E_N_ELEMENTS(public_suffix_cases), spent);
+    e_free(junk);
+
+    e_assert_errno(E_OK, e_timer_start(timer));
+    e_timer_reset(timer);
+    for(i = 0 ; i < 100000 ; i++) {
+        for(j = 0 ; j < E_N_ELEMENTS(com_heavy_cases) ; j++) {
+            e_etn_public_suffix(etn, com_heavy_cases[j], &ps, &icann);
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Get public suffix of popular TLDs %"PRIuSIZE" times, spent %f seconds\n",
+        100000 * E_N_ELEMENTS(com_heavy_cases), spent);
+
     e_timer_reset(timer);
     for(i = 0 ; i < 10000 ; i++) {
         for(j = 0 ; j < E_N_ELEMENTS(eTLD_plus_one_cases) ; j++) {
@@ -413,6 +2097,157 @@ static inline void benchmark(const char *filename) {
     printf("Get eTLD %"PRIuSIZE" times, spent %f seconds\n",
         10000 * E_N_ELEMENTS(eTLD_plus_one_cases), spent);
 
+    for(i = 0 ; i < E_N_ELEMENTS(random_lens) ; i++) {
+        random_lens[i] = random_domain(random_domains[i], i);
+    }//end for
+    e_timer_reset(timer);
+    for(i = 0 ; i < 100 ; i++) {
+        for(j = 0 ; j < E_N_ELEMENTS(random_lens) ; j++) {
+            e_assert_errno(E_OK, e_etn_public_suffix_len(etn, random_domains[j], random_lens[j], &off, &icann));
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Get public suffix of random names %"PRIuSIZE" times, spent %f seconds\n",
+        100 * E_N_ELEMENTS(random_lens), spent);
+
+    /* names nine apart share the suffix but mostly not the site */
+    same = 0;
+    e_timer_reset(timer);
+    for(i = 0 ; i < 100 ; i++) {
+        for(j = 0 ; j < E_N_ELEMENTS(random_lens) ; j++) {
+            k = (j + 9) % E_N_ELEMENTS(random_lens);
+            e_etn_eTLD_plus_one(etn, random_domains[j], &ps);
+            e_etn_eTLD_plus_one(etn, random_domains[k], &eTLD);
+            same += *ps && !strcmp(ps, eTLD);
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Compare eTLD of random names %"PRIuSIZE" times, spent %f seconds\n",
+        100 * E_N_ELEMENTS(random_lens), spent);
+
+    e_timer_reset(timer);
+    for(i = 0 ; i < 100 ; i++) {
+        for(j = 0 ; j < E_N_ELEMENTS(random_lens) ; j++) {
+            k = (j + 9) % E_N_ELEMENTS(random_lens);
+            same -= e_etn_same_site(etn, random_domains[j], random_lens[j], random_domains[k], random_lens[k]);
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    e_assert_true(same == 0);
+    printf("Check same site of random names %"PRIuSIZE" times, spent %f seconds\n",
+        100 * E_N_ELEMENTS(random_lens), spent);
+
+    e_timer_reset(timer);
+    for(i = 0 ; i < 100 ; i++) {
+        for(j = 0 ; j < E_N_ELEMENTS(random_lens) ; j++) {
+            e_assert_errno(E_OK, e_etn_lookup_levels(etn, random_domains[j], random_lens[j], &result, levels, E_N_ELEMENTS(levels), &k));
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Get every level of random names %"PRIuSIZE" times, spent %f seconds\n",
+        100 * E_N_ELEMENTS(random_lens), spent);
+
+    for(j = 0 ; j < E_N_ELEMENTS(public_suffix_cases) ; j++) {
+        wire_lens[j] = wire_encode(public_suffix_cases[j].domain, lens[j], wire[j]);
+    }//end for
+    e_timer_reset(timer);
+    for(i = 0 ; i < 10000 ; i++) {
+        for(j = 0 ; j < E_N_ELEMENTS(public_suffix_cases) ; j++) {
+            e_assert_errno(E_OK, e_etn_public_suffix_wire(etn, wire[j], wire_lens[j], 0, &wire_result));
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Get public suffix of wire names %"PRIuSIZE" times, spent %f seconds\n",
+        10000 * E_N_ELEMENTS(public_suffix_cases), spent);
+
+    /* every name cut in two in the middle, as a flow would have it over two packets */
+    for(j = 0 ; j < E_N_ELEMENTS(public_suffix_cases) ; j++) {
+        iovs[j][0].iov_base = (char *)public_suffix_cases[j].domain;
+        iovs[j][0].iov_len = lens[j] / 2;
+        iovs[j][1].iov_base = (char *)public_suffix_cases[j].domain + lens[j] / 2;
+        iovs[j][1].iov_len = lens[j] - lens[j] / 2;
+    }//end for
+    e_timer_reset(timer);
+    for(i = 0 ; i < 10000 ; i++) {
+        for(j = 0 ; j < E_N_ELEMENTS(public_suffix_cases) ; j++) {
+            e_assert_errno(E_OK, e_etn_lookup_iov(etn, iovs[j], 2, &iov_result));
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Get public suffix of names in two segments %"PRIuSIZE" times, spent %f seconds\n",
+        10000 * E_N_ELEMENTS(public_suffix_cases), spent);
+
+    /* a sorted bulk of names under a few suffixes, one by one and through a cursor */
+    e_assert_true(sorted = e_malloc(E_ETN_CURSOR_CASES * E_STRBUF));
+    for(i = 0 ; i < E_ETN_CURSOR_CASES ; i++) {
+        snprintf(sorted[i], E_STRBUF, "h%"PRIuSIZE".%s", i / E_N_ELEMENTS(com_heavy_cases), com_heavy_cases[i % E_N_ELEMENTS(com_heavy_cases)]);
+    }//end for
+    qsort(sorted, E_ETN_CURSOR_CASES, E_STRBUF, cursor_cmp);
+    for(i = 0 ; i < E_ETN_CURSOR_CASES ; i++) {
+        sorted_lens[i] = strlen(sorted[i]);
+    }//end for
+
+    e_timer_reset(timer);
+    for(i = 0 ; i < 10 ; i++) {
+        for(j = 0 ; j < E_ETN_CURSOR_CASES ; j++) {
+            e_assert_errno(E_OK, e_etn_lookup(etn, sorted[j], sorted_lens[j], &result));
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Look up %d sorted domains, spent %f seconds\n", 10 * E_ETN_CURSOR_CASES, spent);
+
+    e_assert_true(cursor = e_etn_cursor_new(etn, true));
+    e_timer_reset(timer);
+    for(i = 0 ; i < 10 ; i++) {
+        for(j = 0 ; j < E_ETN_CURSOR_CASES ; j++) {
+            e_assert_errno(E_OK, e_etn_cursor_lookup(cursor, sorted[j], sorted_lens[j], &result));
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Look up %d sorted domains through a cursor, spent %f seconds\n", 10 * E_ETN_CURSOR_CASES, spent);
+    e_etn_cursor_free(cursor);
+    e_free(sorted);
+
     e_timer_free(timer);
     e_etn_free(etn);
 }//end benchmark_public_suffix
+
+static inline void benchmark_load(const char *filename, const char *filename_v2) {
+    bool        icann;
+    size_t      i;
+    double      spent;
+    e_etn_t     *etn;
+    e_timer_t   *timer;
+    const char  *ps;
+
+    /* a cold start is a load followed by the first lookup */
+    e_assert_true(timer = e_timer_new());
+    for(i = 0 ; i < 1000 ; i++) {
+        e_assert_true(etn = e_etn_new(filename));
+        e_etn_public_suffix(etn, "www.example.com", &ps, &icann);
+        e_etn_free(etn);
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Load '%s' and look up 1000 times, spent %f seconds\n", filename, spent);
+
+    e_timer_reset(timer);
+    for(i = 0 ; i < 1000 ; i++) {
+        e_assert_true(etn = e_etn_new_mmap(filename_v2));
+        e_etn_public_suffix(etn, "www.example.com", &ps, &icann);
+        e_etn_free(etn);
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Map '%s' and look up 1000 times, spent %f seconds\n", filename_v2, spent);
+
+    e_timer_reset(timer);
+    for(i = 0 ; i < 1000 && (etn = e_etn_new_builtin()) ; i++) {
+        e_etn_public_suffix(etn, "www.example.com", &ps, &icann);
+        e_etn_free(etn);
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    if(i == 1000) {
+        printf("Open the built-in list and look up 1000 times, spent %f seconds\n", spent);
+    }//end if
+
+    e_timer_free(timer);
+}//end benchmark_load
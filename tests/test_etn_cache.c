@@ -0,0 +1,214 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libetn.h>
+
+#define DATA_FILE       "public_suffix_compiled.dat"
+
+static const char *domains[] = {
+    "www.example.co.uk", "amazon.com", "books.amazon.co.uk", "foo.blogspot.co.uk", "a.b.c.kobe.jp",
+    "www.city.kobe.jp", "EXAMPLE.COM.", "there.is.no.such-tld", "cromulent", "", ".", "a..com",
+};
+
+static inline void test_cache(void);
+static inline void test_evict(void);
+static inline void test_invalidate(void);
+static inline void test_same(e_etn_result_t *a, e_etn_result_t *b);
+static inline void benchmark(void);
+
+int main(int argc, char *argv[]) {
+    test_cache();
+    test_evict();
+    test_invalidate();
+    benchmark();
+
+    return 0;
+}//end main
+
+
+/* ===== private function ===== */
+static inline void test_cache(void) {
+    char                long_domain[256];
+    size_t              i, k;
+    e_etn_t             *etn;
+    e_etn_cache_t       *cache;
+    e_etn_result_t      r, rc;
+    e_etn_cache_stats_t stats;
+
+    e_assert_false(e_etn_cache_new(0));
+    e_assert_false(e_etn_cache_new(64));
+    e_assert_true(etn = e_etn_new(DATA_FILE));
+    e_assert_true(cache = e_etn_cache_new(64 * 1024));
+    e_etn_cache_stats(cache, &stats);
+    e_assert_true(stats.capacity > 0 && stats.capacity * 128 <= 64 * 1024);
+
+    /* the first pass misses, the rest hit and give the same results */
+    for(k = 0 ; k < 3 ; k++) {
+        for(i = 0 ; i < E_N_ELEMENTS(domains) ; i++) {
+            e_assert_errno(E_OK, e_etn_lookup(etn, domains[i], strlen(domains[i]), &r));
+            e_assert_errno(E_OK, e_etn_cache_lookup(cache, etn, domains[i], strlen(domains[i]), &rc));
+            test_same(&r, &rc);
+        }//end for
+    }//end for
+    e_etn_cache_stats(cache, &stats);
+    e_assert_true(stats.misses == E_N_ELEMENTS(domains));
+    e_assert_true(stats.hits == 2 * E_N_ELEMENTS(domains));
+    e_assert_true(stats.evictions == 0);
+
+    /* the key is every byte, a prefix of a cached domain is another domain */
+    e_assert_errno(E_OK, e_etn_cache_lookup(cache, etn, "www.example.co.uk", strlen("www.example.co"), &rc));
+    e_assert_errno(E_OK, e_etn_lookup(etn, "www.example.co.uk", strlen("www.example.co"), &r));
+    test_same(&r, &rc);
+
+    /* too long to cache, or to look up */
+    memset(long_domain, 'a', sizeof(long_domain));
+    memcpy(long_domain + 150, ".co.uk", 6);
+    e_assert_errno(E_OK, e_etn_cache_lookup(cache, etn, long_domain, 156, &rc));
+    e_assert_true(rc.suffix_off == 151);
+    e_assert_errno(E_ERR_INVAL, e_etn_cache_lookup(cache, etn, long_domain, sizeof(long_domain), &rc));
+
+    /* a cleared cache misses again */
+    e_etn_cache_stats(cache, &stats);
+    k = stats.misses;
+    e_etn_cache_clear(cache);
+    e_assert_errno(E_OK, e_etn_cache_lookup(cache, etn, domains[0], strlen(domains[0]), &rc));
+    e_etn_cache_stats(cache, &stats);
+    e_assert_true(stats.misses == k + 1);
+
+    e_etn_cache_free(cache);
+    e_etn_free(etn);
+}//end test_cache
+
+static inline void test_evict(void) {
+    char                buf[64];
+    size_t              i, len;
+    e_etn_t             *etn;
+    e_etn_cache_t       *cache;
+    e_etn_result_t      r, rc;
+    e_etn_cache_stats_t stats;
+
+    e_assert_true(etn = e_etn_new(DATA_FILE));
+    e_assert_true(cache = e_etn_cache_new(4096));
+    e_etn_cache_stats(cache, &stats);
+
+    /* many more domains than entries, every answer still right */
+    for(i = 0 ; i < 20 * stats.capacity ; i++) {
+        len = snprintf(buf, sizeof(buf), "host%zu.example%zu.co.uk", i, i % 7);
+        e_assert_errno(E_OK, e_etn_lookup(etn, buf, len, &r));
+        e_assert_errno(E_OK, e_etn_cache_lookup(cache, etn, buf, len, &rc));
+        test_same(&r, &rc);
+
+        /* one hot domain stays referenced and survives the clock */
+        e_assert_errno(E_OK, e_etn_cache_lookup(cache, etn, domains[0], strlen(domains[0]), &rc));
+    }//end for
+
+    e_etn_cache_stats(cache, &stats);
+    e_assert_true(stats.evictions > 0);
+    e_assert_true(stats.hits >= 20 * stats.capacity - 1);
+
+    e_etn_cache_free(cache);
+    e_etn_free(etn);
+}//end test_evict
+
+static inline void test_invalidate(void) {
+    e_etn_t             *etn, *small;
+    e_etn_cache_t       *cache;
+    e_etn_result_t      rc;
+    e_etn_cache_stats_t stats;
+    const char          *psl = "uk\n";
+
+    e_assert_true(etn = e_etn_new(DATA_FILE));
+    e_assert_true(small = e_etn_new_from_psl_buffer(psl, strlen(psl)));
+    e_assert_true(cache = e_etn_cache_new(64 * 1024));
+
+    e_assert_errno(E_OK, e_etn_cache_lookup(cache, etn, domains[0], strlen(domains[0]), &rc));
+    e_assert_true(rc.suffix_off == 12);
+
+    /* another table empties the cache */
+    e_assert_errno(E_OK, e_etn_cache_lookup(cache, small, domains[0], strlen(domains[0]), &rc));
+    e_assert_true(rc.suffix_off == 15);
+    e_assert_errno(E_OK, e_etn_cache_lookup(cache, etn, domains[0], strlen(domains[0]), &rc));
+    e_assert_true(rc.suffix_off == 12);
+
+    e_etn_cache_stats(cache, &stats);
+    e_assert_true(stats.misses == 3 && stats.hits == 0);
+    e_assert_true(e_etn_get_serial(etn) != e_etn_get_serial(small));
+
+    e_etn_cache_free(cache);
+    e_etn_free(small);
+    e_etn_free(etn);
+}//end test_invalidate
+
+static inline void test_same(e_etn_result_t *a, e_etn_result_t *b) {
+    e_assert_true(a->suffix_off == b->suffix_off);
+    e_assert_true(a->registrable_off == b->registrable_off);
+    e_assert_true(a->subdomain_len == b->subdomain_len);
+    e_assert_true(a->labels == b->labels);
+    e_assert_true(a->suffix_labels == b->suffix_labels);
+    e_assert_true(a->icann == b->icann);
+    e_assert_true(a->rule == b->rule);
+}//end test_same
+
+static inline void benchmark(void) {
+    double              spent;
+    size_t              i, k;
+    e_etn_t             *etn;
+    e_timer_t           *timer;
+    e_etn_cache_t       *cache;
+    e_etn_result_t      r;
+    e_etn_cache_stats_t stats;
+
+    e_assert_true(etn = e_etn_new(DATA_FILE));
+    e_assert_true(cache = e_etn_cache_new(256 * 1024));
+
+    e_assert_true(timer = e_timer_new());
+    for(k = 0 ; k < 100000 ; k++) {
+        for(i = 0 ; i < E_N_ELEMENTS(domains) ; i++) {
+            e_assert_errno(E_OK, e_etn_lookup(etn, domains[i], strlen(domains[i]), &r));
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Look up %zu times, spent %f seconds\n", k * E_N_ELEMENTS(domains), spent);
+
+    e_assert_errno(E_OK, e_timer_reset(timer));
+    for(k = 0 ; k < 100000 ; k++) {
+        for(i = 0 ; i < E_N_ELEMENTS(domains) ; i++) {
+            e_assert_errno(E_OK, e_etn_cache_lookup(cache, etn, domains[i], strlen(domains[i]), &r));
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    e_etn_cache_stats(cache, &stats);
+    printf("Look up %zu times through the cache, spent %f seconds, %" PRIu64 " hits %" PRIu64 " misses\n",
+        k * E_N_ELEMENTS(domains), spent, stats.hits, stats.misses);
+    e_timer_free(timer);
+
+    e_etn_cache_free(cache);
+    e_etn_free(etn);
+}//end benchmark
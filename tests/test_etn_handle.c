@@ -0,0 +1,212 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libetn.h>
+#include <pthread.h>
+#include <poll.h>
+
+#define DATA_FILE       "public_suffix_compiled.dat"
+#define WATCHED_FILE    "public_suffix_watched.dat"
+#define NUM_READERS     4
+#define NUM_LOOKUPS     20000
+#define NUM_SWAPS       50
+
+typedef struct test_reader_s {
+    e_etn_handle_t  *handle;
+    e_atomic_t      *done;
+    size_t          lookups;
+} test_reader_t;
+
+static inline void test_handle(void);
+static inline void test_threads(void);
+static inline void test_watch(void);
+static inline void *test_reader_main(void *arg);
+static inline size_t test_suffix_off(e_etn_t *etn, const char *domain);
+
+int main(int argc, char *argv[]) {
+    test_handle();
+    test_threads();
+    test_watch();
+
+    return 0;
+}//end main
+
+
+/* ===== private function ===== */
+static inline void test_handle(void) {
+    e_etn_t         *etn, *got;
+    e_etn_result_t  result;
+    e_etn_reader_t  *reader;
+    e_etn_handle_t  *handle;
+
+    e_assert_true(etn = e_etn_new(DATA_FILE));
+    e_assert_errno(E_OK, e_etn_set_engine(etn, E_ETN_ENGINE_DFA));
+    e_assert_errno(E_OK, e_etn_set_metadata(etn, "co.uk", strlen("co.uk"), 42));
+    e_assert_true(handle = e_etn_handle_new(etn));
+    e_assert_true(reader = e_etn_reader_new(handle));
+
+    e_assert_true(e_etn_reader_lock(reader) == etn);
+    e_assert_true(test_suffix_off(etn, "www.example.co.uk") == 12);
+    e_etn_reader_unlock(reader);
+
+    got = e_etn_handle_get(handle);
+    e_assert_true(got == etn);
+    e_etn_unref(got);
+
+    /* a reload keeps the engine and the metadata */
+    e_assert_errno(E_ERR_INVAL, e_etn_handle_reload(handle, "/nonexistent/public_suffix_compiled.dat"));
+    e_assert_errno(E_OK, e_etn_handle_reload(handle, DATA_FILE));
+    etn = e_etn_reader_lock(reader);
+    e_assert_true(e_etn_get_engine(etn) == E_ETN_ENGINE_DFA);
+    e_assert_true(test_suffix_off(etn, "www.example.co.uk") == 12);
+    e_assert_errno(E_OK, e_etn_lookup(etn, "www.example.co.uk", strlen("www.example.co.uk"), &result));
+    e_assert_true(result.metadata == 42);
+    e_assert_errno(E_OK, e_etn_lookup(etn, "www.example.com", strlen("www.example.com"), &result));
+    e_assert_true(result.metadata == 0);
+    e_etn_reader_unlock(reader);
+
+    e_etn_reader_free(reader);
+    e_etn_handle_free(handle);
+}//end test_handle
+
+static inline void test_threads(void) {
+    size_t          i;
+    e_atomic_t      done;
+    pthread_t       threads[NUM_READERS];
+    test_reader_t   readers[NUM_READERS];
+    e_etn_t         *etn;
+    e_etn_handle_t  *handle;
+
+    e_assert_true(etn = e_etn_new(DATA_FILE));
+    e_assert_true(handle = e_etn_handle_new(etn));
+
+    e_atomic_set(&done, 0);
+    for(i = 0 ; i < NUM_READERS ; i++) {
+        readers[i].handle = handle;
+        readers[i].done = &done;
+        readers[i].lookups = 0;
+        e_assert_true(pthread_create(&threads[i], NULL, test_reader_main, &readers[i]) == 0);
+    }//end for
+
+    /* every swap frees a table the readers were using a moment ago */
+    for(i = 0 ; i < NUM_SWAPS ; i++) {
+        e_assert_true(etn = e_etn_new(DATA_FILE));
+        e_assert_errno(E_OK, e_etn_handle_swap(handle, etn));
+    }//end for
+    e_atomic_set(&done, 1);
+
+    for(i = 0 ; i < NUM_READERS ; i++) {
+        e_assert_true(pthread_join(threads[i], NULL) == 0);
+        e_assert_true(readers[i].lookups > 0);
+    }//end for
+
+    e_etn_handle_free(handle);
+}//end test_threads
+
+static inline void test_watch(void) {
+    int             ret;
+    e_etn_t         *etn, *small;
+    e_etn_reader_t  *reader;
+    e_etn_handle_t  *handle;
+    e_etn_watch_t   *watch;
+    FILE            *fp;
+    struct pollfd   pfd;
+    const char      *psl = "uk\n";
+
+    e_assert_true(etn = e_etn_new(DATA_FILE));
+    e_assert_errno(E_OK, e_etn_save(etn, WATCHED_FILE, E_ETN_FORMAT_V1));
+    e_assert_true(handle = e_etn_handle_new(etn));
+    e_assert_true(reader = e_etn_reader_new(handle));
+
+    watch = e_etn_watch_new(handle, WATCHED_FILE);
+    if(!watch) {
+        printf("Built without inotify, skipped\n");
+        e_etn_reader_free(reader);
+        e_etn_handle_free(handle);
+        unlink(WATCHED_FILE);
+        return;
+    }//end if
+    e_assert_errno(E_OK, e_etn_watch_dispatch(watch));
+
+    /* a write in place is not a new file, the watch stays quiet */
+    e_assert_true(fp = fopen(WATCHED_FILE, "r+b"));
+    e_assert_true(fwrite("\0", 1, 1, fp) == 1);
+    fclose(fp);
+    pfd.fd = e_etn_watch_fd(watch);
+    pfd.events = POLLIN;
+    e_assert_true(poll(&pfd, 1, 100) == 0);
+
+    /* e_etn_save() renames over the watched file */
+    e_assert_true(small = e_etn_new_from_psl_buffer(psl, strlen(psl)));
+    e_assert_errno(E_OK, e_etn_save(small, WATCHED_FILE, E_ETN_FORMAT_V1));
+    e_etn_unref(small);
+
+    pfd.fd = e_etn_watch_fd(watch);
+    pfd.events = POLLIN;
+    ret = poll(&pfd, 1, 5000);
+    e_assert_true(ret == 1);
+    e_assert_errno(E_OK, e_etn_watch_dispatch(watch));
+
+    etn = e_etn_reader_lock(reader);
+    e_assert_true(test_suffix_off(etn, "www.example.co.uk") == 15);
+    e_etn_reader_unlock(reader);
+
+    e_etn_watch_free(watch);
+    e_etn_reader_free(reader);
+    e_etn_handle_free(handle);
+    unlink(WATCHED_FILE);
+}//end test_watch
+
+static inline void *test_reader_main(void *arg) {
+    size_t          i;
+    e_etn_t         *etn;
+    e_etn_reader_t  *reader;
+    test_reader_t   *t;
+
+    t = (test_reader_t *)arg;
+    e_assert_true(reader = e_etn_reader_new(t->handle));
+
+    for(i = 0 ; i < NUM_LOOKUPS || !e_atomic_get(t->done) ; i++) {
+        etn = e_etn_reader_lock(reader);
+        e_assert_true(test_suffix_off(etn, "www.example.co.uk") == 12);
+        e_etn_reader_unlock(reader);
+        t->lookups++;
+    }//end for
+
+    e_etn_reader_free(reader);
+    return NULL;
+}//end test_reader_main
+
+static inline size_t test_suffix_off(e_etn_t *etn, const char *domain) {
+    e_etn_result_t r;
+
+    e_assert_errno(E_OK, e_etn_lookup(etn, domain, strlen(domain), &r));
+    return r.suffix_off;
+}//end test_suffix_off
@@ -0,0 +1,360 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libetn.h>
+
+#define DATA_FILE       "public_suffix_compiled.dat"
+
+typedef struct block_s {
+    const uint8_t   *data;
+    size_t          len;
+    const char      *authority;
+} block_t;
+
+/* RFC 7541 C.3, three requests on one connection without Huffman coding */
+static const uint8_t rfc_plain_1[] = {
+    0x82, 0x86, 0x84, 0x41, 0x0f, 0x77, 0x77, 0x77, 0x2e, 0x65, 0x78, 0x61, 0x6d, 0x70, 0x6c, 0x65,
+    0x2e, 0x63, 0x6f, 0x6d,
+};
+static const uint8_t rfc_plain_2[] = {
+    0x82, 0x86, 0x84, 0xbe, 0x58, 0x08, 0x6e, 0x6f, 0x2d, 0x63, 0x61, 0x63, 0x68, 0x65,
+};
+static const uint8_t rfc_plain_3[] = {
+    0x82, 0x87, 0x85, 0xbf, 0x40, 0x0a, 0x63, 0x75, 0x73, 0x74, 0x6f, 0x6d, 0x2d, 0x6b, 0x65, 0x79,
+    0x0c, 0x63, 0x75, 0x73, 0x74, 0x6f, 0x6d, 0x2d, 0x76, 0x61, 0x6c, 0x75, 0x65,
+};
+
+/* RFC 7541 C.4, the same requests with Huffman coding */
+static const uint8_t rfc_huffman_1[] = {
+    0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4,
+    0xff,
+};
+static const uint8_t rfc_huffman_2[] = {
+    0x82, 0x86, 0x84, 0xbe, 0x58, 0x86, 0xa8, 0xeb, 0x10, 0x64, 0x9c, 0xbf,
+};
+static const uint8_t rfc_huffman_3[] = {
+    0x82, 0x87, 0x85, 0xbf, 0x40, 0x88, 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xa9, 0x7d, 0x7f, 0x89, 0x25,
+    0xa8, 0x49, 0xe9, 0x5b, 0xb8, 0xe8, 0xb4, 0xbf,
+};
+
+/*
+ * From the Python hpack encoder with a 128 byte table, so each request evicts the
+ * entries of the one before. The first starts with the size update.
+ */
+static const uint8_t evict_1[] = {
+    0x3f, 0x61, 0x82, 0x87, 0x41, 0x8b, 0x1a, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xeb, 0xdb,
+    0xd7, 0x84, 0x7a, 0x86, 0x25, 0xb6, 0x50, 0xc3, 0xcb, 0x83,
+};
+static const uint8_t evict_2[] = {
+    0x82, 0x87, 0x41, 0x12, 0x62, 0x2e, 0x45, 0x78, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2e, 0x63, 0x6f,
+    0x6d, 0x3a, 0x38, 0x34, 0x34, 0x33, 0x44, 0x02, 0x2f, 0x78, 0x60, 0x03, 0x6b, 0x3d, 0x76,
+};
+static const uint8_t evict_3[] = {
+    0x82, 0x87, 0x84, 0x66, 0x92, 0xb5, 0x05, 0xb3, 0xff, 0x44, 0x5e, 0x3a, 0x0f, 0x32, 0x2b, 0x3a,
+    0x57, 0x21, 0xd7, 0xb7, 0xad, 0xc7, 0x81,
+};
+static const uint8_t evict_4[] = {
+    0x82, 0x87, 0x84, 0xbe,
+};
+
+/* :authority without indexing, one symbol of every code length Huffman coded */
+static const uint8_t code_lengths[] = {
+    0x01, 0xae, 0x02, 0x97, 0x7e, 0x3f, 0x8f, 0xf5, 0xff, 0x5f, 0xf8, 0xff, 0xf3, 0xff, 0xe7, 0xff,
+    0xf0, 0xff, 0xfe, 0x6f, 0xff, 0xee, 0x7f, 0xff, 0xa5, 0xff, 0xff, 0x63, 0xff, 0xff, 0xab, 0xff,
+    0xff, 0xd9, 0xff, 0xff, 0xf0, 0x7f, 0xff, 0xfd, 0xef, 0xff, 0xff, 0xe2, 0xff, 0xff, 0xff, 0xf3,
+};
+static const uint8_t code_lengths_decoded[] = {
+    0x30, 0x20, 0x42, 0x26, 0x21, 0x27, 0x23, 0x00, 0x5e, 0x3c, 0x5c, 0x80, 0x99, 0x81, 0x01, 0x09,
+    0xc7, 0xc0, 0xcb, 0x02, 0x0a,
+};
+
+/* :authority as a new name, both Huffman coded */
+static const uint8_t new_name[] = {
+    0x40, 0x88, 0xb8, 0x3b, 0x53, 0x39, 0xec, 0x32, 0x7d, 0x7f, 0x8b, 0x1a, 0xe5, 0xf2, 0x3a, 0x6b,
+    0xa0, 0xab, 0x90, 0xeb, 0xdb, 0xd7,
+};
+
+static const char *request = "GET /index.html HTTP/1.1\r\n"
+    "User-Agent: curl/8.0\r\n"
+    "X-Host: nothing.example\r\n"
+    "Hostname: nothing.example\r\n"
+    "HOST: \t www.Example.co.uk:8080 \r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+static inline void test_http1(void);
+static inline void test_http1_truncated(void);
+static inline void test_hpack(void);
+static inline void test_hpack_blocks(size_t max_size, const block_t *blocks, size_t n);
+static inline void test_hpack_malformed(void);
+static inline void test_classify(void);
+static inline void benchmark(void);
+
+int main(int argc, char *argv[]) {
+    test_http1();
+    test_http1_truncated();
+    test_hpack();
+    test_hpack_malformed();
+    test_classify();
+    benchmark();
+
+    return 0;
+}//end main
+
+
+/* ===== private function ===== */
+static inline void test_http1(void) {
+    size_t      i, host_len;
+    const char  *host;
+    struct {
+        const char  *request;
+        e_errno_t   err;
+        const char  *host;
+    } cases[] = {
+        { "GET / HTTP/1.1\r\nHost: example.com\r\n\r\n", E_OK, "example.com" },
+        { "GET / HTTP/1.0\nhost:example.com.\n\n", E_OK, "example.com." },
+        { "GET / HTTP/1.1\r\nHost: [::1]:8080\r\n\r\n", E_OK, "[::1]" },
+        { "GET / HTTP/1.1\r\nHost: user@example.com:80\r\n\r\n", E_OK, "example.com" },
+        { "GET / HTTP/1.1\r\nAccept: */*\r\n\r\nHost: example.com\r\n", E_ERR_NOFOUND, NULL },
+        { "GET / HTTP/1.1\r\nHost: \r\n\r\n", E_ERR_NOFOUND, NULL },
+        { "GET / HTTP/1.1\r\nAccept: */*\r\n", E_ERR_AGAIN, NULL },
+        { "GET / HTTP/1.1", E_ERR_AGAIN, NULL },
+        { "", E_ERR_AGAIN, NULL },
+    };
+
+    e_assert_errno(E_OK, e_http_host_extract(request, strlen(request), &host, &host_len));
+    e_assert_true(host == strstr(request, "www.") && host_len == 17);
+
+    for(i = 0 ; i < E_N_ELEMENTS(cases) ; i++) {
+        e_assert_errno(cases[i].err, e_http_host_extract(cases[i].request, strlen(cases[i].request), &host, &host_len));
+        if(cases[i].host) {
+            e_assert_true(host_len == strlen(cases[i].host) && memcmp(host, cases[i].host, host_len) == 0);
+        }//end if
+    }//end for
+}//end test_http1
+
+static inline void test_http1_truncated(void) {
+    char        *copy;
+    size_t      i, len, end, host_len;
+    const char  *host;
+
+    /* every prefix is a copy of its own, so reading past it is caught by sanitizers */
+    len = strlen(request);
+    end = strstr(request, "Accept") - request;
+    for(i = 0 ; i <= len ; i++) {
+        e_assert_true(copy = e_malloc(i + 1));
+        memcpy(copy, request, i);
+        if(i < end) {
+            e_assert_errno(E_ERR_AGAIN, e_http_host_extract(copy, i, &host, &host_len));
+        }//end if
+        else {
+            e_assert_errno(E_OK, e_http_host_extract(copy, i, &host, &host_len));
+            e_assert_true(host_len == 17 && memcmp(host, "www.Example.co.uk", host_len) == 0);
+        }//end else
+        e_free(copy);
+    }//end for
+}//end test_http1_truncated
+
+static inline void test_hpack(void) {
+    size_t      authority_len;
+    e_hpack_t   *hpack;
+    const char  *authority;
+    block_t     rfc_plain[] = {
+        { rfc_plain_1, sizeof(rfc_plain_1), "www.example.com" },
+        { rfc_plain_2, sizeof(rfc_plain_2), "www.example.com" },
+        { rfc_plain_3, sizeof(rfc_plain_3), "www.example.com" },
+    };
+    block_t     rfc_huffman[] = {
+        { rfc_huffman_1, sizeof(rfc_huffman_1), "www.example.com" },
+        { rfc_huffman_2, sizeof(rfc_huffman_2), "www.example.com" },
+        { rfc_huffman_3, sizeof(rfc_huffman_3), "www.example.com" },
+    };
+    block_t     evict[] = {
+        { evict_1, sizeof(evict_1), "a.example.co.uk" },
+        { evict_2, sizeof(evict_2), "b.Example.com" },
+        { evict_1 + 2, sizeof(evict_1) - 2, "a.example.co.uk" },
+        { evict_2, sizeof(evict_2), "b.Example.com" },
+        { evict_3, sizeof(evict_3), "c.blogspot.co.uk" },
+        { evict_4, sizeof(evict_4), "c.blogspot.co.uk" },
+    };
+
+    test_hpack_blocks(4096, rfc_plain, E_N_ELEMENTS(rfc_plain));
+    test_hpack_blocks(4096, rfc_huffman, E_N_ELEMENTS(rfc_huffman));
+    test_hpack_blocks(4096, evict, E_N_ELEMENTS(evict));
+
+    /* a raw literal is not copied */
+    e_assert_true(hpack = e_hpack_new(4096));
+    e_assert_errno(E_OK, e_hpack_authority(hpack, rfc_plain_1, sizeof(rfc_plain_1), &authority, &authority_len));
+    e_assert_true(authority == (const char *)rfc_plain_1 + 5);
+
+    e_assert_errno(E_OK, e_hpack_authority(hpack, code_lengths, sizeof(code_lengths), &authority, &authority_len));
+    e_assert_true(authority_len == sizeof(code_lengths_decoded));
+    e_assert_true(memcmp(authority, code_lengths_decoded, authority_len) == 0);
+
+    e_assert_errno(E_OK, e_hpack_authority(hpack, new_name, sizeof(new_name), &authority, &authority_len));
+    e_assert_true(authority_len == 15 && memcmp(authority, "a.example.co.uk", authority_len) == 0);
+
+    /* a response has no authority */
+    e_assert_errno(E_ERR_NOFOUND, e_hpack_authority(hpack, rfc_plain_2 + 4, sizeof(rfc_plain_2) - 4, &authority, &authority_len));
+    e_hpack_free(hpack);
+
+    /* with no dynamic table, an entry that does not fit is not added */
+    e_assert_true(hpack = e_hpack_new(0));
+    e_assert_errno(E_OK, e_hpack_authority(hpack, rfc_plain_1, sizeof(rfc_plain_1), &authority, &authority_len));
+    e_assert_errno(E_ERR_INVAL, e_hpack_authority(hpack, rfc_plain_2, sizeof(rfc_plain_2), &authority, &authority_len));
+    e_hpack_free(hpack);
+}//end test_hpack
+
+static inline void test_hpack_blocks(size_t max_size, const block_t *blocks, size_t n) {
+    size_t      i, authority_len;
+    e_hpack_t   *hpack;
+    const char  *authority;
+
+    e_assert_true(hpack = e_hpack_new(max_size));
+    for(i = 0 ; i < n ; i++) {
+        e_assert_errno(E_OK, e_hpack_authority(hpack, blocks[i].data, blocks[i].len, &authority, &authority_len));
+        e_assert_true(authority_len == strlen(blocks[i].authority));
+        e_assert_true(memcmp(authority, blocks[i].authority, authority_len) == 0);
+    }//end for
+    e_hpack_free(hpack);
+}//end test_hpack_blocks
+
+static inline void test_hpack_malformed(void) {
+    size_t          i, k, authority_len;
+    uint8_t         *copy;
+    e_errno_t       err;
+    e_hpack_t       *hpack;
+    const char      *authority;
+    const uint8_t   index_zero[] = { 0x80 };
+    const uint8_t   index_past[] = { 0xbe };
+    const uint8_t   too_large[] = { 0x3f, 0xe2, 0x1f };
+    const uint8_t   overflow[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f };
+    const uint8_t   string_past[] = { 0x01, 0x05, 'a', 'b' };
+    const uint8_t   padding_zero[] = { 0x01, 0x81, 0x00 };
+    const uint8_t   padding_long[] = { 0x01, 0x82, 0x07, 0xff };
+    const uint8_t   eos[] = { 0x01, 0x84, 0xff, 0xff, 0xff, 0xff };
+    struct {
+        const uint8_t   *data;
+        size_t          len;
+    } cases[] = {
+        { index_zero, sizeof(index_zero) },
+        { index_past, sizeof(index_past) },
+        { too_large, sizeof(too_large) },
+        { overflow, sizeof(overflow) },
+        { string_past, sizeof(string_past) },
+        { padding_zero, sizeof(padding_zero) },
+        { padding_long, sizeof(padding_long) },
+        { eos, sizeof(eos) },
+    };
+    block_t         blocks[] = {
+        { evict_1, sizeof(evict_1), NULL },
+        { code_lengths, sizeof(code_lengths), NULL },
+        { new_name, sizeof(new_name), NULL },
+    };
+
+    for(i = 0 ; i < E_N_ELEMENTS(cases) ; i++) {
+        e_assert_true(hpack = e_hpack_new(4096));
+        e_assert_errno(E_ERR_INVAL, e_hpack_authority(hpack, cases[i].data, cases[i].len, &authority, &authority_len));
+        e_hpack_free(hpack);
+    }//end for
+
+    /* cut anywhere, a block is malformed or complete as far as it goes */
+    for(k = 0 ; k < E_N_ELEMENTS(blocks) ; k++) {
+        for(i = 0 ; i <= blocks[k].len ; i++) {
+            e_assert_true(hpack = e_hpack_new(4096));
+            e_assert_true(copy = e_malloc(i + 1));
+            memcpy(copy, blocks[k].data, i);
+            err = e_hpack_authority(hpack, copy, i, &authority, &authority_len);
+            e_assert_true(err == E_OK || err == E_ERR_NOFOUND || err == E_ERR_INVAL);
+            e_free(copy);
+            e_hpack_free(hpack);
+        }//end for
+    }//end for
+}//end test_hpack_malformed
+
+static inline void test_classify(void) {
+    size_t          len;
+    e_etn_t         *etn;
+    e_hpack_t       *hpack;
+    const char      *host;
+    e_etn_result_t  r, rc;
+
+    e_assert_true(etn = e_etn_new(DATA_FILE));
+    e_assert_true(hpack = e_hpack_new(4096));
+
+    e_assert_errno(E_OK, e_etn_classify_http_request(etn, request, strlen(request), &host, &len, &rc));
+    e_assert_errno(E_OK, e_etn_lookup(etn, "www.example.co.uk", 17, &r));
+    e_assert_true(rc.suffix_off == 12 && rc.registrable_off == 4 && rc.icann);
+    e_assert_true(rc.suffix_id == r.suffix_id && rc.registrable_hash == r.registrable_hash);
+
+    e_assert_errno(E_OK, e_etn_classify_hpack(etn, hpack, evict_1, sizeof(evict_1), &host, &len, &rc));
+    e_assert_true(rc.suffix_off == 10 && rc.registrable_off == 2 && rc.icann);
+    e_assert_errno(E_OK, e_etn_classify_hpack(etn, hpack, evict_2, sizeof(evict_2), &host, &len, &rc));
+    e_assert_true(rc.suffix_off == 10 && rc.registrable_off == 2 && rc.icann);
+    e_assert_errno(E_OK, e_etn_classify_hpack(etn, hpack, evict_3, sizeof(evict_3), &host, &len, &rc));
+    e_assert_true(rc.suffix_off == 2 && rc.registrable_off == 0 && !rc.icann);
+
+    e_assert_errno(E_ERR_AGAIN, e_etn_classify_http_request(etn, request, 40, &host, &len, &rc));
+
+    e_hpack_free(hpack);
+    e_etn_free(etn);
+}//end test_classify
+
+static inline void benchmark(void) {
+    double          spent;
+    size_t          i, len;
+    e_etn_t         *etn;
+    e_timer_t       *timer;
+    e_hpack_t       *hpack;
+    const char      *host;
+    e_etn_result_t  r;
+
+    e_assert_true(etn = e_etn_new(DATA_FILE));
+    e_assert_true(hpack = e_hpack_new(4096));
+    e_assert_true(timer = e_timer_new());
+
+    for(i = 0 ; i < 1000000 ; i++) {
+        e_assert_errno(E_OK, e_etn_classify_http_request(etn, request, strlen(request), &host, &len, &r));
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Classify an HTTP/1.1 request %zu times, spent %f seconds\n", i, spent);
+
+    /* the first block of C.4 again and again, every one adds the same entry */
+    e_assert_errno(E_OK, e_timer_reset(timer));
+    for(i = 0 ; i < 1000000 ; i++) {
+        e_assert_errno(E_OK, e_etn_classify_hpack(etn, hpack, rfc_huffman_1, sizeof(rfc_huffman_1), &host, &len, &r));
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Classify an HTTP/2 header block %zu times, spent %f seconds\n", i, spent);
+
+    e_timer_free(timer);
+    e_hpack_free(hpack);
+    e_etn_free(etn);
+}//end benchmark
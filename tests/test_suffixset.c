@@ -0,0 +1,316 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libetn.h>
+
+#define SAVED_FILE      "suffixset_saved.dat"
+
+/* enough rules that the tables only fit the wide format */
+#define E_SUFFIXSET_RANDOM_RULES    200000
+#define E_SUFFIXSET_BENCH_RULES     1000000
+
+static inline void test_lookup(void);
+static inline void test_add(void);
+static inline void test_engine(void);
+static inline void test_save(void);
+static inline void test_random(void);
+static inline void test_random_same(e_suffixset_t *set, size_t n);
+static inline size_t random_rule(char *buf, size_t i);
+static inline void expect(e_suffixset_t *set, const char *domain, e_errno_t err, uint32_t payload, size_t match_off);
+static inline void benchmark(void);
+
+int main(int argc, char *argv[]) {
+    test_lookup();
+    test_add();
+    test_engine();
+    test_save();
+    test_random();
+    benchmark();
+
+    return 0;
+}//end main
+
+
+/* ===== private function ===== */
+static inline e_suffixset_t *test_set(void) {
+    e_suffixset_t           *set;
+    e_suffixset_builder_t   *builder;
+
+    e_assert_true(builder = e_suffixset_builder_new());
+    e_assert_errno(E_OK, e_suffixset_builder_add(builder, "example.com", strlen("example.com"), 1));
+    e_assert_errno(E_OK, e_suffixset_builder_add(builder, "com", strlen("com"), 2));
+    e_assert_errno(E_OK, e_suffixset_builder_add(builder, "ads.example.com", strlen("ads.example.com"), 3));
+    e_assert_errno(E_OK, e_suffixset_builder_add(builder, ".Tracker.NET", strlen(".Tracker.NET"), 4));
+    e_assert_errno(E_OK, e_suffixset_builder_add(builder, "b.c.d.e.", strlen("b.c.d.e."), 5));
+    e_assert_errno(E_OK, e_suffixset_builder_add(builder, "\xe4\xbe\x8b\xe3\x81\x88.jp", strlen("\xe4\xbe\x8b\xe3\x81\x88.jp"), 6));
+    e_assert_errno(E_OK, e_suffixset_builder_add(builder, "dup.org", strlen("dup.org"), 7));
+    e_assert_errno(E_OK, e_suffixset_builder_add(builder, "DUP.org", strlen("DUP.org"), 8));
+    e_assert_errno(E_OK, e_suffixset_builder_add(builder, "a-b.example.co", strlen("a-b.example.co"), 9));
+    e_assert_errno(E_OK, e_suffixset_builder_add(builder, "a.example.co", strlen("a.example.co"), 10));
+    e_assert_true(set = e_suffixset_builder_compile(builder));
+
+    /* the builder can go on and compile again */
+    e_assert_errno(E_OK, e_suffixset_builder_add(builder, "more.com", strlen("more.com"), 11));
+    e_suffixset_builder_free(builder);
+
+    return set;
+}//end test_set
+
+static inline void test_lookup(void) {
+    e_suffixset_t *set;
+
+    set = test_set();
+    expect(set, "www.example.com", E_OK, 1, 4);
+    expect(set, "example.com", E_OK, 1, 0);
+    expect(set, "WWW.EXAMPLE.COM", E_OK, 1, 4);
+    expect(set, "ads.example.com", E_OK, 3, 0);
+    expect(set, "x.ads.example.com.", E_OK, 3, 2);
+    expect(set, "xads.example.com", E_OK, 1, 5);
+    expect(set, "foo.com", E_OK, 2, 4);
+    expect(set, "com", E_OK, 2, 0);
+    expect(set, "tracker.net", E_OK, 4, 0);
+    expect(set, "a.b.c.d.e", E_OK, 5, 2);
+    expect(set, "xn--r8jz45g.jp", E_OK, 6, 0);
+    expect(set, "dup.org", E_OK, 8, 0);
+    expect(set, "a-b.example.co", E_OK, 9, 0);
+    expect(set, "x.a.example.co", E_OK, 10, 2);
+
+    /* labels that only lead to rules match nothing */
+    expect(set, "net", E_ERR_NOFOUND, 0, 0);
+    expect(set, "c.d.e", E_ERR_NOFOUND, 0, 0);
+    expect(set, "example.co", E_ERR_NOFOUND, 0, 0);
+    expect(set, "examplecom", E_ERR_NOFOUND, 0, 0);
+    expect(set, "org", E_ERR_NOFOUND, 0, 0);
+    expect(set, "", E_ERR_NOFOUND, 0, 0);
+    expect(set, ".", E_ERR_NOFOUND, 0, 0);
+    expect(set, "more.com", E_OK, 2, 5);
+
+    e_suffixset_free(set);
+}//end test_lookup
+
+static inline void test_engine(void) {
+    size_t          i;
+    e_suffixset_t   *set;
+    e_etn_engine_t  engines[] = { E_ETN_ENGINE_SEARCH, E_ETN_ENGINE_DFA, E_ETN_ENGINE_INLINE };
+
+    /* every engine matches the same rules */
+    set = test_set();
+    e_assert_errno(E_ERR_INVAL, e_suffixset_set_engine(set, (e_etn_engine_t)-1));
+    for(i = 0 ; i < E_N_ELEMENTS(engines) ; i++) {
+        e_assert_errno(E_OK, e_suffixset_set_engine(set, engines[i]));
+        expect(set, "x.ads.example.com.", E_OK, 3, 2);
+        expect(set, "xads.example.com", E_OK, 1, 5);
+        expect(set, "xn--r8jz45g.jp", E_OK, 6, 0);
+        expect(set, "x.a.example.co", E_OK, 10, 2);
+        expect(set, "c.d.e", E_ERR_NOFOUND, 0, 0);
+        expect(set, "examplecom", E_ERR_NOFOUND, 0, 0);
+    }//end for
+
+    e_suffixset_free(set);
+}//end test_engine
+
+static inline void test_add(void) {
+    char                    rule[300];
+    e_suffixset_builder_t   *builder;
+
+    e_assert_true(builder = e_suffixset_builder_new());
+    e_assert_false(e_suffixset_builder_compile(builder));
+    e_assert_errno(E_ERR_INVAL, e_suffixset_builder_add(builder, "", 0, 1));
+    e_assert_errno(E_ERR_INVAL, e_suffixset_builder_add(builder, ".", 1, 1));
+    e_assert_errno(E_ERR_INVAL, e_suffixset_builder_add(builder, "..", 2, 1));
+    e_assert_errno(E_ERR_INVAL, e_suffixset_builder_add(builder, "a..com", 6, 1));
+    e_assert_errno(E_ERR_INVAL, e_suffixset_builder_add(builder, "..com", 5, 1));
+    e_assert_errno(E_ERR_INVAL, e_suffixset_builder_add(builder, "a\0b.com", 7, 1));
+    e_assert_errno(E_ERR_INVAL, e_suffixset_builder_add(builder, "a.com..", 7, 1));
+
+    /* a domain name is at most 253 bytes without its root dot */
+    memset(rule, 'a', sizeof(rule));
+    rule[63] = rule[127] = rule[191] = '.';
+    e_assert_errno(E_OK, e_suffixset_builder_add(builder, rule, 253, 1));
+    rule[253] = '.';
+    e_assert_errno(E_OK, e_suffixset_builder_add(builder, rule, 254, 1));
+    rule[253] = 'a';
+    e_assert_errno(E_ERR_INVAL, e_suffixset_builder_add(builder, rule, 254, 1));
+    e_assert_errno(E_ERR_INVAL, e_suffixset_builder_add(builder, rule, sizeof(rule), 1));
+
+    /* rules that failed are not there */
+    e_suffixset_builder_free(builder);
+    e_suffixset_builder_free(NULL);
+    e_suffixset_free(NULL);
+}//end test_add
+
+static inline void test_save(void) {
+    FILE            *fp;
+    e_suffixset_t   *set, *mapped;
+
+    set = test_set();
+    e_assert_errno(E_OK, e_suffixset_save(set, SAVED_FILE));
+    e_assert_true(mapped = e_suffixset_new_mmap(SAVED_FILE));
+    e_suffixset_free(set);
+
+    expect(mapped, "www.example.com", E_OK, 1, 4);
+    expect(mapped, "x.ads.example.com.", E_OK, 3, 2);
+    expect(mapped, "xn--r8jz45g.jp", E_OK, 6, 0);
+    expect(mapped, "dup.org", E_OK, 8, 0);
+    expect(mapped, "c.d.e", E_ERR_NOFOUND, 0, 0);
+    e_suffixset_free(mapped);
+
+    /* not a suffix set, and not there at all */
+    e_assert_true(fp = fopen(SAVED_FILE, "r+b"));
+    e_assert_true(fwrite("XXXX", 1, 4, fp) == 4);
+    fclose(fp);
+    e_assert_false(e_suffixset_new_mmap(SAVED_FILE));
+    e_assert_true(fp = fopen(SAVED_FILE, "wb"));
+    fclose(fp);
+    e_assert_false(e_suffixset_new_mmap(SAVED_FILE));
+    unlink(SAVED_FILE);
+    e_assert_false(e_suffixset_new_mmap(SAVED_FILE));
+}//end test_save
+
+static inline void test_random(void) {
+    char                    rule[E_STRBUF];
+    size_t                  i, len;
+    e_suffixset_t           *set, *mapped;
+    e_suffixset_builder_t   *builder;
+
+    /* added in no order, the rule of every fifth one is under the one before */
+    e_assert_true(builder = e_suffixset_builder_new());
+    for(i = 0 ; i < E_SUFFIXSET_RANDOM_RULES ; i++) {
+        len = random_rule(rule, i);
+        e_assert_errno(E_OK, e_suffixset_builder_add(builder, rule, len, (uint32_t)i));
+    }//end for
+    e_assert_true(set = e_suffixset_builder_compile(builder));
+    e_suffixset_builder_free(builder);
+    test_random_same(set, E_SUFFIXSET_RANDOM_RULES);
+
+    e_assert_errno(E_OK, e_suffixset_save(set, SAVED_FILE));
+    e_suffixset_free(set);
+    e_assert_true(mapped = e_suffixset_new_mmap(SAVED_FILE));
+    test_random_same(mapped, E_SUFFIXSET_RANDOM_RULES);
+    e_suffixset_free(mapped);
+    unlink(SAVED_FILE);
+}//end test_random
+
+static inline void test_random_same(e_suffixset_t *set, size_t n) {
+    char        rule[E_STRBUF], domain[E_STRBUF];
+    size_t      i, len, off;
+    uint32_t    payload;
+
+    for(i = 0 ; i < n ; i++) {
+        len = random_rule(rule, i);
+        e_assert_errno(E_OK, e_suffixset_lookup(set, rule, len, &payload, &off));
+        e_assert_true(payload == i && off == 0);
+
+        /* no rule has a dash, so the longest match is the rule itself */
+        len = snprintf(domain, sizeof(domain), "w-w.%s", rule);
+        e_assert_errno(E_OK, e_suffixset_lookup(set, domain, len, &payload, &off));
+        e_assert_true(payload == i && off == 4);
+
+        /* a rule with its first label changed matches the one it is under, if any */
+        domain[4] ^= 0x20;
+        domain[5] = '-';
+        e_assert_errno(i % 5 == 0 && i > 0 ? E_OK : E_ERR_NOFOUND, e_suffixset_lookup(set, domain + 4, len - 4, &payload, &off));
+        e_assert_true(i % 5 != 0 || i == 0 || payload == i - 1);
+    }//end for
+}//end test_random_same
+
+static inline size_t random_rule(char *buf, size_t i) {
+    size_t      j, len;
+    uint64_t    x;
+    const char  *tlds[] = { "com", "net", "org", "co.uk", "io", "ru", "cn", "de", "jp", "info" };
+
+    if(i % 5 == 0 && i > 0) {
+        len = random_rule(buf + 4, i - 1);
+        memcpy(buf, "sub", 3);
+        buf[3] = '.';
+        return len + 4;
+    }//end if
+
+    /* the index in the first label keeps every rule apart */
+    x = (i + 1) * 0x9e3779b97f4a7c15ULL;
+    len = 2 + (x >> 61);
+    for(j = 0 ; j < len ; j++, x = x * 6364136223846793005ULL + 1442695040888963407ULL) {
+        buf[j] = "abcdefghijklmnopqrstuvwxyz0123456789"[(x >> 33) % 36];
+    }//end for
+
+    return len + snprintf(buf + len, E_STRBUF - len, "%zu.%s", i, tlds[(x >> 40) % E_N_ELEMENTS(tlds)]);
+}//end random_rule
+
+static inline void expect(e_suffixset_t *set, const char *domain, e_errno_t err, uint32_t payload, size_t match_off) {
+    size_t      off;
+    uint32_t    p;
+
+    e_assert_errno(err, e_suffixset_lookup(set, domain, strlen(domain), &p, &off));
+    if(err == E_OK) {
+        e_assert_true(p == payload && off == match_off);
+    }//end if
+}//end expect
+
+static inline void benchmark(void) {
+    char                    rule[E_STRBUF];
+    size_t                  i, j, off, *lens;
+    double                  spent;
+    uint32_t                payload;
+    char                    (*domains)[E_STRBUF];
+    e_timer_t               *timer;
+    e_suffixset_t           *set;
+    e_suffixset_builder_t   *builder;
+
+    e_assert_true(timer = e_timer_new());
+    e_assert_true(builder = e_suffixset_builder_new());
+    for(i = 0 ; i < E_SUFFIXSET_BENCH_RULES ; i++) {
+        e_assert_errno(E_OK, e_suffixset_builder_add(builder, rule, random_rule(rule, i), (uint32_t)i));
+    }//end for
+    e_assert_true(set = e_suffixset_builder_compile(builder));
+    e_suffixset_builder_free(builder);
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Add and compile %d rules, spent %f seconds\n", E_SUFFIXSET_BENCH_RULES, spent);
+
+    /* names under rules spread over the whole set, and names under none */
+    e_assert_true(domains = e_malloc(4096 * E_STRBUF));
+    e_assert_true(lens = e_malloc(4096 * sizeof(size_t)));
+    for(i = 0 ; i < 4096 ; i++) {
+        random_rule(rule, (i * 7919) % E_SUFFIXSET_BENCH_RULES);
+        lens[i] = snprintf(domains[i], E_STRBUF, i % 2 ? "www.%s" : "www.%s-x", rule);
+    }//end for
+    e_timer_reset(timer);
+    for(j = 0 ; j < 100 ; j++) {
+        for(i = 0 ; i < 4096 ; i++) {
+            e_suffixset_lookup(set, domains[i], lens[i], &payload, &off);
+        }//end for
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Look up %d names in %d rules, spent %f seconds\n", 100 * 4096, E_SUFFIXSET_BENCH_RULES, spent);
+
+    e_free(lens);
+    e_free(domains);
+    e_suffixset_free(set);
+    e_timer_free(timer);
+}//end benchmark
@@ -0,0 +1,277 @@
+/**
+ * Copyright 2020 PacketX Technology
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libetn.h>
+
+#define DATA_FILE       "public_suffix_compiled.dat"
+
+/* captured from OpenSSL 3 with TLS 1.2 at most, the server name is "www.Example.co.uk" at 89 */
+static const uint8_t hello_tls12[] = {
+    0x16, 0x03, 0x01, 0x00, 0xb7, 0x01, 0x00, 0x00, 0xb3, 0x03, 0x03, 0x6c, 0x2a, 0x71, 0xce, 0xc8,
+    0x68, 0x05, 0x5d, 0x12, 0xe3, 0x0b, 0x6d, 0x61, 0x09, 0xc6, 0xa7, 0x86, 0x72, 0x08, 0x4a, 0xa0,
+    0xa6, 0x9e, 0xb7, 0x11, 0xdd, 0x18, 0xcb, 0xf4, 0x61, 0xc9, 0x0d, 0x00, 0x00, 0x1e, 0xc0, 0x2c,
+    0xc0, 0x30, 0xc0, 0x2b, 0xc0, 0x2f, 0xcc, 0xa9, 0xcc, 0xa8, 0xc0, 0x24, 0xc0, 0x28, 0xc0, 0x23,
+    0xc0, 0x27, 0x00, 0x9f, 0x00, 0x9e, 0x00, 0x6b, 0x00, 0x67, 0x00, 0xff, 0x01, 0x00, 0x00, 0x6c,
+    0x00, 0x00, 0x00, 0x16, 0x00, 0x14, 0x00, 0x00, 0x11, 0x77, 0x77, 0x77, 0x2e, 0x45, 0x78, 0x61,
+    0x6d, 0x70, 0x6c, 0x65, 0x2e, 0x63, 0x6f, 0x2e, 0x75, 0x6b, 0x00, 0x0b, 0x00, 0x04, 0x03, 0x00,
+    0x01, 0x02, 0x00, 0x0a, 0x00, 0x0c, 0x00, 0x0a, 0x00, 0x1d, 0x00, 0x17, 0x00, 0x1e, 0x00, 0x19,
+    0x00, 0x18, 0x00, 0x23, 0x00, 0x00, 0x00, 0x16, 0x00, 0x00, 0x00, 0x17, 0x00, 0x00, 0x00, 0x0d,
+    0x00, 0x2a, 0x00, 0x28, 0x04, 0x03, 0x05, 0x03, 0x06, 0x03, 0x08, 0x07, 0x08, 0x08, 0x08, 0x09,
+    0x08, 0x0a, 0x08, 0x0b, 0x08, 0x04, 0x08, 0x05, 0x08, 0x06, 0x04, 0x01, 0x05, 0x01, 0x06, 0x01,
+    0x03, 0x03, 0x03, 0x01, 0x03, 0x02, 0x04, 0x02, 0x05, 0x02, 0x06, 0x02,
+};
+
+/* captured from OpenSSL 3 with TLS 1.3, key shares and padding, the server name is "foo.blogspot.co.uk" at 127 */
+static const uint8_t hello_tls13[] = {
+    0x16, 0x03, 0x01, 0x02, 0x00, 0x01, 0x00, 0x01, 0xfc, 0x03, 0x03, 0xbd, 0x5d, 0x05, 0x02, 0xec,
+    0xb7, 0x3c, 0xec, 0x9c, 0xdb, 0x52, 0xcc, 0x88, 0x60, 0x92, 0x6b, 0x0d, 0x81, 0x6b, 0x90, 0xb9,
+    0xa6, 0xb1, 0x2d, 0xe5, 0x6f, 0x1d, 0x4d, 0x31, 0xb8, 0x24, 0x6e, 0x20, 0xb1, 0x54, 0x9e, 0x1b,
+    0x34, 0xda, 0x28, 0x7d, 0x61, 0xa4, 0x63, 0xec, 0xf0, 0x23, 0x13, 0xaa, 0x5d, 0xda, 0xc2, 0x5b,
+    0xf4, 0x77, 0xcf, 0xeb, 0xe7, 0xed, 0xa0, 0xe1, 0xda, 0xd1, 0xe3, 0xf6, 0x00, 0x24, 0x13, 0x02,
+    0x13, 0x03, 0x13, 0x01, 0xc0, 0x2c, 0xc0, 0x30, 0xc0, 0x2b, 0xc0, 0x2f, 0xcc, 0xa9, 0xcc, 0xa8,
+    0xc0, 0x24, 0xc0, 0x28, 0xc0, 0x23, 0xc0, 0x27, 0x00, 0x9f, 0x00, 0x9e, 0x00, 0x6b, 0x00, 0x67,
+    0x00, 0xff, 0x01, 0x00, 0x01, 0x8f, 0x00, 0x00, 0x00, 0x17, 0x00, 0x15, 0x00, 0x00, 0x12, 0x66,
+    0x6f, 0x6f, 0x2e, 0x62, 0x6c, 0x6f, 0x67, 0x73, 0x70, 0x6f, 0x74, 0x2e, 0x63, 0x6f, 0x2e, 0x75,
+    0x6b, 0x00, 0x0b, 0x00, 0x04, 0x03, 0x00, 0x01, 0x02, 0x00, 0x0a, 0x00, 0x16, 0x00, 0x14, 0x00,
+    0x1d, 0x00, 0x17, 0x00, 0x1e, 0x00, 0x19, 0x00, 0x18, 0x01, 0x00, 0x01, 0x01, 0x01, 0x02, 0x01,
+    0x03, 0x01, 0x04, 0x00, 0x23, 0x00, 0x00, 0x00, 0x16, 0x00, 0x00, 0x00, 0x17, 0x00, 0x00, 0x00,
+    0x0d, 0x00, 0x2a, 0x00, 0x28, 0x04, 0x03, 0x05, 0x03, 0x06, 0x03, 0x08, 0x07, 0x08, 0x08, 0x08,
+    0x09, 0x08, 0x0a, 0x08, 0x0b, 0x08, 0x04, 0x08, 0x05, 0x08, 0x06, 0x04, 0x01, 0x05, 0x01, 0x06,
+    0x01, 0x03, 0x03, 0x03, 0x01, 0x03, 0x02, 0x04, 0x02, 0x05, 0x02, 0x06, 0x02, 0x00, 0x2b, 0x00,
+    0x05, 0x04, 0x03, 0x04, 0x03, 0x03, 0x00, 0x2d, 0x00, 0x02, 0x01, 0x01, 0x00, 0x33, 0x00, 0x26,
+    0x00, 0x24, 0x00, 0x1d, 0x00, 0x20, 0x94, 0xda, 0xc8, 0xf4, 0xe2, 0x75, 0xc7, 0x79, 0x41, 0xba,
+    0xbb, 0xef, 0x91, 0xd7, 0xc1, 0xbf, 0x97, 0x18, 0xe4, 0x54, 0xe5, 0xb2, 0x96, 0x07, 0x4b, 0x4c,
+    0x8f, 0x99, 0x53, 0x56, 0x20, 0x1e, 0x00, 0x15, 0x00, 0xdb, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static inline void test_extract(void);
+static inline void test_truncated(const uint8_t *hello, size_t len, size_t sni_end);
+static inline void test_malformed(void);
+static inline void test_classify(void);
+static inline size_t client_hello(uint8_t *buf, const uint8_t *ext, size_t ext_len);
+static inline void benchmark(void);
+
+int main(int argc, char *argv[]) {
+    test_extract();
+    test_truncated(hello_tls12, sizeof(hello_tls12), 106);
+    test_truncated(hello_tls13, sizeof(hello_tls13), 145);
+    test_malformed();
+    test_classify();
+    benchmark();
+
+    return 0;
+}//end main
+
+
+/* ===== private function ===== */
+static inline void test_extract(void) {
+    uint8_t     buf[128];
+    size_t      sni_len, len;
+    const char  *sni;
+    uint8_t     no_sni[] = { 0x00, 0x0b, 0x00, 0x02, 0x01, 0x00 };
+    uint8_t     ip_only[] = { 0x00, 0x00, 0x00, 0x07, 0x00, 0x05, 0x01, 0x00, 0x02, 0x0a, 0x0b };
+
+    e_assert_errno(E_OK, e_tls_sni_extract(hello_tls12, sizeof(hello_tls12), &sni, &sni_len));
+    e_assert_true(sni == (const char *)hello_tls12 + 89 && sni_len == 17);
+    e_assert_true(memcmp(sni, "www.Example.co.uk", sni_len) == 0);
+
+    e_assert_errno(E_OK, e_tls_sni_extract(hello_tls13, sizeof(hello_tls13), &sni, &sni_len));
+    e_assert_true(sni == (const char *)hello_tls13 + 127 && sni_len == 18);
+
+    /* the bare handshake message, as in a QUIC CRYPTO frame */
+    e_assert_errno(E_OK, e_tls_sni_extract(hello_tls13 + 5, sizeof(hello_tls13) - 5, &sni, &sni_len));
+    e_assert_true(sni == (const char *)hello_tls13 + 127 && sni_len == 18);
+
+    /* no extensions, other extensions, a server name of an unknown type */
+    len = client_hello(buf, NULL, 0);
+    e_assert_errno(E_ERR_NOFOUND, e_tls_sni_extract(buf, len, &sni, &sni_len));
+    len = client_hello(buf, no_sni, sizeof(no_sni));
+    e_assert_errno(E_ERR_NOFOUND, e_tls_sni_extract(buf, len, &sni, &sni_len));
+    len = client_hello(buf, ip_only, sizeof(ip_only));
+    e_assert_errno(E_ERR_NOFOUND, e_tls_sni_extract(buf, len, &sni, &sni_len));
+}//end test_extract
+
+static inline void test_truncated(const uint8_t *hello, size_t len, size_t sni_end) {
+    size_t      i, sni_len;
+    uint8_t     *copy;
+    const char  *sni;
+
+    /* every prefix is a copy of its own, so reading past it is caught by sanitizers */
+    for(i = 0 ; i <= len ; i++) {
+        e_assert_true(copy = e_malloc(i + 1));
+        memcpy(copy, hello, i);
+        if(i < sni_end) {
+            e_assert_errno(E_ERR_AGAIN, e_tls_sni_extract(copy, i, &sni, &sni_len));
+        }//end if
+        else {
+            e_assert_errno(E_OK, e_tls_sni_extract(copy, i, &sni, &sni_len));
+            e_assert_true(sni == (const char *)copy + sni_end - sni_len);
+        }//end else
+        e_free(copy);
+    }//end for
+}//end test_truncated
+
+static inline void test_malformed(void) {
+    uint8_t     buf[sizeof(hello_tls12)];
+    size_t      sni_len;
+    const char  *sni;
+
+    /* not a handshake record, not a ClientHello, not TLS */
+    memcpy(buf, hello_tls12, sizeof(buf));
+    buf[0] = 23;
+    e_assert_errno(E_ERR_INVAL, e_tls_sni_extract(buf, sizeof(buf), &sni, &sni_len));
+    memcpy(buf, hello_tls12, sizeof(buf));
+    buf[5] = 2;
+    e_assert_errno(E_ERR_INVAL, e_tls_sni_extract(buf, sizeof(buf), &sni, &sni_len));
+    memcpy(buf, hello_tls12, sizeof(buf));
+    buf[1] = 2;
+    e_assert_errno(E_ERR_INVAL, e_tls_sni_extract(buf, sizeof(buf), &sni, &sni_len));
+
+    /* the ClientHello goes on in the next record */
+    memcpy(buf, hello_tls12, sizeof(buf));
+    buf[4] = 0x40;
+    e_assert_errno(E_ERR_NOTSUP, e_tls_sni_extract(buf, sizeof(buf), &sni, &sni_len));
+
+    /* a session id too long */
+    memcpy(buf, hello_tls12, sizeof(buf));
+    buf[43] = 33;
+    e_assert_errno(E_ERR_INVAL, e_tls_sni_extract(buf, sizeof(buf), &sni, &sni_len));
+
+    /* inner lengths past the ClientHello, all bytes present */
+    memcpy(buf, hello_tls12, sizeof(buf));
+    buf[44] = 0xff;
+    e_assert_errno(E_ERR_INVAL, e_tls_sni_extract(buf, sizeof(buf), &sni, &sni_len));
+    memcpy(buf, hello_tls12, sizeof(buf));
+    buf[83] = 0xff;
+    e_assert_errno(E_ERR_INVAL, e_tls_sni_extract(buf, sizeof(buf), &sni, &sni_len));
+    memcpy(buf, hello_tls12, sizeof(buf));
+    buf[78] = 0xff;
+    e_assert_errno(E_ERR_INVAL, e_tls_sni_extract(buf, sizeof(buf), &sni, &sni_len));
+    memcpy(buf, hello_tls12, sizeof(buf));
+    buf[85] = 0xff;
+    e_assert_errno(E_ERR_INVAL, e_tls_sni_extract(buf, sizeof(buf), &sni, &sni_len));
+}//end test_malformed
+
+static inline void test_classify(void) {
+    size_t          sni_len;
+    e_etn_t         *etn;
+    const char      *sni;
+    e_etn_result_t  r, rc;
+
+    e_assert_true(etn = e_etn_new(DATA_FILE));
+
+    e_assert_errno(E_OK, e_etn_classify_client_hello(etn, hello_tls12, sizeof(hello_tls12), &sni, &sni_len, &rc));
+    e_assert_errno(E_OK, e_etn_lookup(etn, "www.example.co.uk", 17, &r));
+    e_assert_true(rc.suffix_off == 12 && rc.registrable_off == 4 && rc.icann);
+    e_assert_true(rc.suffix_id == r.suffix_id && rc.registrable_hash == r.registrable_hash);
+
+    e_assert_errno(E_OK, e_etn_classify_client_hello(etn, hello_tls13, sizeof(hello_tls13), &sni, &sni_len, &rc));
+    e_assert_true(rc.suffix_off == 4 && rc.registrable_off == 0 && !rc.icann);
+    e_assert_true(rc.rule == E_ETN_RULE_NORMAL);
+
+    e_assert_errno(E_ERR_AGAIN, e_etn_classify_client_hello(etn, hello_tls13, 100, &sni, &sni_len, &rc));
+
+    e_etn_free(etn);
+}//end test_classify
+
+/* a record with a ClientHello of one cipher suite, ext are its extensions, none if NULL */
+static inline size_t client_hello(uint8_t *buf, const uint8_t *ext, size_t ext_len) {
+    size_t      len;
+
+    memset(buf, 0, 5 + 4 + 34);
+    buf[0] = 22;
+    buf[1] = 3;
+    buf[2] = 1;
+    buf[5] = 1;
+    buf[9] = 3;
+    buf[10] = 3;
+    len = 5 + 4 + 34;
+    buf[len++] = 0;     /* legacy_session_id */
+    buf[len++] = 0;
+    buf[len++] = 2;
+    buf[len++] = 0x13;
+    buf[len++] = 0x01;
+    buf[len++] = 1;
+    buf[len++] = 0;     /* the null compression method */
+    if(ext) {
+        buf[len++] = ext_len >> 8;
+        buf[len++] = ext_len & 0xff;
+        memcpy(buf + len, ext, ext_len);
+        len += ext_len;
+    }//end if
+
+    buf[3] = (len - 5) >> 8;
+    buf[4] = (len - 5) & 0xff;
+    buf[7] = (len - 9) >> 8;
+    buf[8] = (len - 9) & 0xff;
+    return len;
+}//end client_hello
+
+static inline void benchmark(void) {
+    double          spent;
+    size_t          i, sni_len;
+    e_etn_t         *etn;
+    e_timer_t       *timer;
+    const char      *sni;
+    e_etn_result_t  r;
+
+    e_assert_true(etn = e_etn_new(DATA_FILE));
+    e_assert_true(timer = e_timer_new());
+
+    for(i = 0 ; i < 1000000 ; i++) {
+        e_assert_errno(E_OK, e_tls_sni_extract(hello_tls13, sizeof(hello_tls13), &sni, &sni_len));
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Extract the server name %zu times, spent %f seconds\n", i, spent);
+
+    e_assert_errno(E_OK, e_timer_reset(timer));
+    for(i = 0 ; i < 1000000 ; i++) {
+        e_assert_errno(E_OK, e_etn_classify_client_hello(etn, hello_tls13, sizeof(hello_tls13), &sni, &sni_len, &r));
+    }//end for
+    e_assert_errno(E_OK, e_timer_elapsed(timer, &spent, NULL));
+    printf("Classify a ClientHello %zu times, spent %f seconds\n", i, spent);
+
+    e_timer_free(timer);
+    e_etn_free(etn);
+}//end benchmark